@@ -1,13 +1,22 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <fstream>
 #include <thread>
 
 #include "api.h"
 #include "bench_utils.h"
+#include "blockchain_decrypt.h"
+#include "filehandler.h"
+#include "hash_modes.h"
 #include "rng.h"
+#include "rotation_job.h"
 #include "timer.h"
 #include "utility.h"
+#include "vault_agent.h"
+#include "vault_autosave.h"
+#include "vault_manager.h"
+#include "vault_scanner.h"
 
 const constexpr u_int64_t CITERS = 1000000;
 const constexpr u_int64_t CITERS_SMALL = 1;
@@ -32,7 +41,6 @@ void MemoryThread() {
     _memory_max = 0;
     _memory_min = 0;
     _memory_base = getPhysicalMem();
-    _terminateMeasurementThread = false;
     u_int64_t memory = 0;
     u_int64_t memory_max = 0;
     u_int64_t memory_min = 0;
@@ -59,6 +67,8 @@ void MemoryThread() {
     _memory_max = memory_max;
     _memory_min = memory_min;
     _memory_avg = memory_avg;
+    // the flag is reset when the thread stops, a very short measurement can request the stop before the thread started
+    _terminateMeasurementThread = false;
 }
 
 void filing(std::string op, u_int64_t iters, u_int64_t size, u_int64_t avg, u_int64_t slowest) {
@@ -671,6 +681,47 @@ TEST(Benchmark_write, large_sha512_nochain) {
     filing("large_sha512_nochain", CITERS_SMALL, DATA_SIZE_LARGE_MB, timer.getAverageTime(), timer.getSlowest());
 }
 
+TEST(Benchmark_write, large_write_only) {
+    // measures only writeToFile for a 1GB payload (the encryption is not part of the measurement)
+    // the memory columns show the RSS while the header and the payload are written (base is the RSS with the encrypted payload in memory)
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    ds.setCipherMode(CIPHERMODE_AES256GCM);
+    u_int64_t sum = 0;
+    u_int64_t slowest = 0;
+    u_int64_t memory_max = 0;
+    for (u_int64_t i = 0; i < ITERS; i++) {
+        API api{FILEMODE_PASSWORD};
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(DATA_SIZE_LARGE);
+        fds->dec_data->fillrandom();
+        api.encryptData(std::move(fds));
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        assert(api.writeToFile().isSuccess());
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        sum += timer.getTime();
+        slowest = std::max(slowest, timer.getTime());
+        memory_max = std::max<u_int64_t>(memory_max, _memory_max);
+        api.logout();
+        std::filesystem::remove(file);
+    }
+    _memory_max = memory_max;
+    filing("large_write_only", CITERS_SMALL, DATA_SIZE_LARGE_MB, sum / ITERS, slowest);
+}
+
 TEST(Benchmark_read1, sha256) {
     std::filesystem::path files[FILES];
     for (int i = 0; i < FILES; i++) {
@@ -932,4 +983,1049 @@ TEST(Benchmark_read2, sha512) {
     _terminateMeasurementThread = true;
     memoryThread.join();
     filing("read_medium_sha512", CITERS, DATA_SIZE_MEDIUM_MB, timer.getAverageTime(), timer.getSlowest());
-}
\ No newline at end of file
+}
+void benchMappedRead(HModes hmode, std::string name) {
+    // compares the buffered stream decryption with the mapped decryption of a large file
+    // every read is done with a cold page cache (file evicted) and a warm page cache (file read before)
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    {
+        Bytes data(DATA_SIZE_LARGE);
+        data.fillrandom();
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(data);
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+    }
+    FileHandler fh{file};
+    std::unique_ptr<DataHeader> dh = fh.getDataHeader().returnMove();
+    // the decryption costs the same for every password hash, the plain text is not checked
+    Bytes pwhash(dh->getDataHeaderParts().getEncSalt().getLen());
+    pwhash.fillrandom();
+
+    for (bool cold : {true, false}) {
+        for (bool mapped : {false, true}) {
+            std::thread memoryThread(MemoryThread);
+            u_int64_t sum = 0;
+            u_int64_t slowest = 0;
+            for (u_int64_t i = 0; i < ITERS; i++) {
+                // evicting the file is not part of the measurement
+                if (cold) dropFileCache(file.c_str());
+                Timer timer;
+                timer.start();
+                DecryptBlockChain dbc{HashModes::getHash(hmode), pwhash, dh->getDataHeaderParts().getEncSalt()};
+                if (mapped) {
+                    std::unique_ptr<FileMapping> mapping = fh.getDataMapping().returnMove();
+                    dbc.addData(mapping->getData(), mapping->getLen());
+                } else {
+                    dbc.addData(fh.getDataStream(), fh.getDataSize());
+                }
+                assert(dbc.getResult()->getLen() == fh.getDataSize());
+                timer.stop();
+                sum += timer.getTime();
+                slowest = std::max(slowest, timer.getTime());
+            }
+            _terminateMeasurementThread = true;
+            memoryThread.join();
+            std::string op = std::string("read_large_") + (mapped ? "mmap_" : "stream_") + (cold ? "cold_" : "warm_") + name;
+            filing(op, CITERS_SMALL, DATA_SIZE_LARGE_MB, sum / ITERS, slowest);
+        }
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_read_mmap, sha256) { benchMappedRead(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_read_mmap, sha384) { benchMappedRead(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_read_mmap, sha512) { benchMappedRead(HASHMODE_SHA512, "sha512"); }
+
+void benchRangeRead(HModes hmode, std::string name) {
+    // compares reading one record (64 Bytes at the end of the content) with decryptRange against decrypting the whole file
+    const constexpr u_int64_t RECORD_SIZE = 64;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(DATA_SIZE_LARGE);
+    data.fillrandom();
+    {
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(data);
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+    }
+    for (bool range : {true, false}) {
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            api.selectFile(file);
+            api.verifyPassword(password);
+            if (range) {
+                std::unique_ptr<Bytes> record = api.decryptRange(DATA_SIZE_LARGE - RECORD_SIZE, RECORD_SIZE).returnMove();
+                assert(*record == data.copySubBytes(DATA_SIZE_LARGE - RECORD_SIZE, DATA_SIZE_LARGE));
+            } else {
+                std::unique_ptr<FileDataStruct> fds = api.getDecryptedData().returnMove();
+                assert(fds->dec_data->copySubBytes(DATA_SIZE_LARGE - RECORD_SIZE, DATA_SIZE_LARGE) == data.copySubBytes(DATA_SIZE_LARGE - RECORD_SIZE, DATA_SIZE_LARGE));
+            }
+            api.logout();
+            if (i != ITERS - 1) {
+                timer.recordTime();
+            }
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        filing(std::string("read_large_") + (range ? "range_" : "full_") + name, CITERS_SMALL, DATA_SIZE_LARGE_MB, timer.getAverageTime(), timer.getSlowest());
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_read_range, sha256) { benchRangeRead(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_read_range, sha384) { benchRangeRead(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_read_range, sha512) { benchRangeRead(HASHMODE_SHA512, "sha512"); }
+
+void benchStreamRead(HModes hmode, std::string name) {
+    // compares reading the large file with a DecryptedReader against getDecryptedData (in microseconds)
+    // the average column stores the time to the first Byte (first chunk or whole content), the slowest column the time to the last Byte
+    // the reader only holds one chunk, so the peak memory stays near the base memory while getDecryptedData holds the whole content
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    {
+        std::unique_ptr<Bytes> data = std::make_unique<Bytes>(DATA_SIZE_LARGE);
+        data->fillrandom();
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data)));
+        api.writeToFile();
+    }
+    for (bool stream : {true, false}) {
+        u_int64_t first = 0;
+        u_int64_t last = 0;
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            api.selectFile(file);
+            api.verifyPassword(password);
+            // selectFile maps the whole file to verify the checksum, so the memory is only measured while the content is read (the last iteration is filed)
+            std::thread memoryThread(MemoryThread);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            u_int64_t read = 0;
+            if (stream) {
+                std::unique_ptr<DecryptedReader> reader = api.getDecryptedReader().returnMove();
+                read += reader->next().returnRef()->getLen();
+                first += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                while (!reader->isDone()) read += reader->next().returnRef()->getLen();
+            } else {
+                read = api.getDecryptedData().returnRef()->dec_data->getLen();
+                first += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+            last += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            _terminateMeasurementThread = true;
+            memoryThread.join();
+            assert(read == DATA_SIZE_LARGE);
+        }
+        filing(std::string("read_large_") + (stream ? "stream_" : "full_") + name, CITERS_SMALL, DATA_SIZE_LARGE_MB, first / ITERS, last / ITERS);
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_read_stream, sha256) { benchStreamRead(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_read_stream, sha512) { benchStreamRead(HASHMODE_SHA512, "sha512"); }
+
+void benchAppend(HModes hmode, std::string name) {
+    // compares appending one record (1 KiB) with appendData against decrypting, re-encrypting and rewriting the whole file
+    const constexpr u_int64_t RECORD_SIZE = 1024;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    Bytes data(DATA_SIZE_LARGE);
+    data.fillrandom();
+    Bytes record(RECORD_SIZE);
+    record.fillrandom();
+    for (bool append : {true, false}) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        {
+            API api{FILEMODE_PASSWORD};
+            api.createFile(file);
+            api.selectFile(file);
+            api.createDataHeader(password, ds);
+            std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+            fds->dec_data = std::make_unique<Bytes>(data);
+            api.encryptData(std::move(fds));
+            api.writeToFile();
+            api.logout();
+        }
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            api.selectFile(file);
+            api.verifyPassword(password);
+            if (append) {
+                ErrorStruct<bool> err = api.appendData(record);
+                assert(err.isSuccess());
+            } else {
+                std::unique_ptr<FileDataStruct> fds = api.getDecryptedData().returnMove();
+                std::unique_ptr<Bytes> dec_data = std::make_unique<Bytes>(fds->dec_data->getLen() + RECORD_SIZE);
+                fds->dec_data->addcopyToBytes(dec_data);
+                record.addcopyToBytes(dec_data);
+                fds->dec_data = std::move(dec_data);
+                api.encryptData(std::move(fds));
+                api.writeToFile();
+            }
+            api.logout();
+            if (i != ITERS - 1) {
+                timer.recordTime();
+            }
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        filing(std::string("append_large_") + (append ? "resume_" : "rewrite_") + name, CITERS_SMALL, DATA_SIZE_LARGE_MB, timer.getAverageTime(), timer.getSlowest());
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(Benchmark_append, sha256) { benchAppend(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_append, sha384) { benchAppend(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_append, sha512) { benchAppend(HASHMODE_SHA512, "sha512"); }
+
+void benchEditPosition(HModes hmode, std::string name) {
+    // measures editing one record (64 Bytes) with editData at different positions of the content
+    // only the suffix behind the record is encrypted again, so the cost should fall with the position
+    const constexpr u_int64_t RECORD_SIZE = 64;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(DATA_SIZE_LARGE);
+    data.fillrandom();
+    Bytes record(RECORD_SIZE);
+    record.fillrandom();
+    {
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(data);
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+    }
+    for (u_int64_t percent : {0, 50, 90, 99, 100}) {
+        u_int64_t offset = (DATA_SIZE_LARGE - RECORD_SIZE) / 100 * percent;
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            api.selectFile(file);
+            api.verifyPassword(password);
+            ErrorStruct<bool> err = api.editData(offset, RECORD_SIZE, record);
+            assert(err.isSuccess());
+            api.logout();
+            if (i != ITERS - 1) {
+                timer.recordTime();
+            }
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        filing("edit_large_at" + std::to_string(percent) + "_" + name, CITERS_SMALL, DATA_SIZE_LARGE_MB, timer.getAverageTime(), timer.getSlowest());
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_edit, sha256) { benchEditPosition(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_edit, sha384) { benchEditPosition(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_edit, sha512) { benchEditPosition(HASHMODE_SHA512, "sha512"); }
+
+void benchShardedDecrypt(HModes hmode, std::string name) {
+    // decrypts the large data with one chain and with 2, 4 and 8 shards (the shards are decrypted in parallel)
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    Bytes data(DATA_SIZE_LARGE);
+    data.fillrandom();
+    for (u_int64_t shard_count : {0, 2, 4, 8}) {
+        if (shard_count != 0) ds.setShardCount(shard_count);
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        {
+            API api{FILEMODE_PASSWORD};
+            api.createFile(file);
+            api.selectFile(file);
+            api.createDataHeader(password, ds);
+            std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+            fds->dec_data = std::make_unique<Bytes>(data);
+            api.encryptData(std::move(fds));
+            api.writeToFile();
+            api.logout();
+        }
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            api.selectFile(file);
+            api.verifyPassword(password);
+            std::unique_ptr<FileDataStruct> fds = api.getDecryptedData().returnMove();
+            assert(fds->dec_data->getLen() == DATA_SIZE_LARGE);
+            api.logout();
+            if (i != ITERS - 1) {
+                timer.recordTime();
+            }
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        filing("read_large_shards" + std::to_string(shard_count) + "_" + name, CITERS_SMALL, DATA_SIZE_LARGE_MB, timer.getAverageTime(), timer.getSlowest());
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(Benchmark_read_shards, sha256) { benchShardedDecrypt(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_read_shards, sha384) { benchShardedDecrypt(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_read_shards, sha512) { benchShardedDecrypt(HASHMODE_SHA512, "sha512"); }
+void benchIntegrity(HModes hmode, std::string name) {
+    // verifies the integrity tree of small, medium and large files with 1, 2, 4 and 8 threads (no password is needed)
+    // the files are written with AES-256-GCM, the tree only depends on the encrypted Bytes
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    ds.setCipherMode(CIPHERMODE_AES256GCM);
+    ds.setIntegrityLeafLen(INTEGRITY_LEAF_LEN);
+    std::vector<std::pair<std::string, u_int64_t>> sizes = {{"small", DATA_SIZE_SMALL}, {"medium", DATA_SIZE_MEDIUM}, {"large", DATA_SIZE_LARGE}};
+    for (const std::pair<std::string, u_int64_t>& size : sizes) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        {
+            Bytes data(size.second);
+            data.fillrandom();
+            API api{FILEMODE_PASSWORD};
+            api.createFile(file);
+            api.selectFile(file);
+            api.createDataHeader(password, ds);
+            std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+            fds->dec_data = std::make_unique<Bytes>(data);
+            api.encryptData(std::move(fds));
+            api.writeToFile();
+            api.logout();
+        }
+        for (size_t threads : {1, 2, 4, 8}) {
+            std::thread memoryThread(MemoryThread);
+            Timer timer;
+            timer.start();
+            for (u_int64_t i = 0; i < ITERS; i++) {
+                FileHandler file_handler(file);
+                ErrorStruct<IntegrityReport> err = file_handler.verifyIntegrity(threads);
+                assert(err.isSuccess() && err.returnRef().valid);
+                if (i != ITERS - 1) {
+                    timer.recordTime();
+                }
+            }
+            timer.stop();
+            _terminateMeasurementThread = true;
+            memoryThread.join();
+            filing("integrity_" + size.first + "_threads" + std::to_string(threads) + "_" + name, CITERS_SMALL, size.second / (1024 * 1024), timer.getAverageTime(), timer.getSlowest());
+        }
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(Benchmark_integrity, sha256) { benchIntegrity(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_integrity, sha384) { benchIntegrity(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_integrity, sha512) { benchIntegrity(HASHMODE_SHA512, "sha512"); }
+
+void benchChecksumReject(HModes hmode, std::string name) {
+    // rejects a file with one damaged Byte of data: with the checksum selectFile fails, without it (type Byte of the datablock cleared,
+    // like a file without a checksum) the damage is only found after verifyPassword and a full decryption
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(hmode);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS);
+    ds.setChainHash2Iters(CITERS);
+    ds.setCipherMode(CIPHERMODE_AES256GCM);
+    std::vector<std::pair<std::string, u_int64_t>> sizes = {{"small", DATA_SIZE_SMALL}, {"medium", DATA_SIZE_MEDIUM}, {"large", DATA_SIZE_LARGE}};
+    for (const std::pair<std::string, u_int64_t>& size : sizes) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        std::filesystem::path file_unchecked = RNG::get_random_string(10) + ".enc";
+        {
+            Bytes data(size.second);
+            data.fillrandom();
+            API api{FILEMODE_PASSWORD};
+            api.createFile(file);
+            api.selectFile(file);
+            api.createDataHeader(password, ds);
+            std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+            fds->dec_data = std::make_unique<Bytes>(data);
+            api.encryptData(std::move(fds));
+            api.writeToFile();
+            api.logout();
+        }
+        {
+            // damage the last Byte of the data and create the copy without the checksum
+            FileHandler file_handler(file);
+            Bytes header = file_handler.getFirstBytes(file_handler.getHeaderSize());
+            size_t pos = DataHeader::getChecksumPos(header.getBytes(), header.getLen());
+            std::ofstream stream = file_handler.getUpdateStream().returnMove();
+            stream.seekp(file_handler.getFileSize() - 1, std::ios::beg);
+            stream << (unsigned char)0xFF;
+            stream.close();
+            std::filesystem::copy_file(file, file_unchecked);
+            stream = std::ofstream(file_unchecked, std::ios::binary | std::ios::in | std::ios::out);
+            stream.seekp(pos - 2, std::ios::beg);
+            stream << (unsigned char)DatablockType::DEFAULT;
+            stream.close();
+        }
+        for (bool checked : {true, false}) {
+            std::thread memoryThread(MemoryThread);
+            Timer timer;
+            timer.start();
+            for (u_int64_t i = 0; i < ITERS; i++) {
+                API api{FILEMODE_PASSWORD};
+                ErrorStruct<bool> err = api.selectFile(checked ? file : file_unchecked);
+                if (checked) {
+                    assert(err.errorCode == ERR_CHECKSUM_MISMATCH);
+                } else {
+                    api.verifyPassword(password);
+                    assert(!api.getDecryptedData().isSuccess());
+                }
+                if (i != ITERS - 1) {
+                    timer.recordTime();
+                }
+            }
+            timer.stop();
+            _terminateMeasurementThread = true;
+            memoryThread.join();
+            filing("reject_" + size.first + (checked ? "_checksum_" : "_unlock_") + name, CITERS, size.second / (1024 * 1024), timer.getAverageTime(), timer.getSlowest());
+        }
+        std::filesystem::remove(file);
+        std::filesystem::remove(file_unchecked);
+    }
+}
+
+TEST(Benchmark_reject, sha256) { benchChecksumReject(HASHMODE_SHA256, "sha256"); }
+
+TEST(Benchmark_reject, sha384) { benchChecksumReject(HASHMODE_SHA384, "sha384"); }
+
+TEST(Benchmark_reject, sha512) { benchChecksumReject(HASHMODE_SHA512, "sha512"); }
+
+TEST(Benchmark_scan, vaults) {
+    // lists the relevant vaults of a directory with many vaults: full header parsing with a FileHandler per file (the old getRelevantFileNames),
+    // a scan of the header prefixes without a cache and a rescan of the unchanged directory (only stat calls)
+    const constexpr u_int64_t VAULTS = 2000;
+    std::filesystem::path dir = RNG::get_random_string(10);
+    std::filesystem::create_directory(dir);
+    {
+        DataHeaderSettingsIters ds;
+        ds.setFileDataMode(FILEMODE_PASSWORD);
+        ds.setHashMode(HASHMODE_SHA512);
+        ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+        ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+        ds.setChainHash1Iters(CITERS_SMALL);
+        ds.setChainHash2Iters(CITERS_SMALL);
+        API api{FILEMODE_PASSWORD};
+        api.createFile(dir / "vault0.enc");
+        api.selectFile(dir / "vault0.enc");
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(1024);
+        fds->dec_data->fillrandom();
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+        for (u_int64_t i = 1; i < VAULTS; i++) std::filesystem::copy_file(dir / "vault0.enc", dir / ("vault" + std::to_string(i) + ".enc"));
+    }
+    for (std::string op : {"filehandler", "cold", "warm"}) {
+        std::thread memoryThread(MemoryThread);
+        Timer timer;
+        timer.start();
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            size_t relevant = 0;
+            if (op == "filehandler") {
+                for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) {
+                    if (entry.path().extension() != FileHandler::extension) continue;
+                    FileHandler file_handler(entry.path());
+                    if (file_handler.isEmtpy() || file_handler.isDataHeader(FILEMODE_PASSWORD).isSuccess()) relevant++;
+                }
+            } else {
+                if (op == "cold") std::filesystem::remove(dir / VaultScanner::cache_name);
+                VaultScanner scanner{dir};
+                for (const VaultInfo& info : scanner.scan().returnRef()) {
+                    if (info.empty || (info.valid && info.file_mode == FILEMODE_PASSWORD)) relevant++;
+                }
+            }
+            assert(relevant == VAULTS);
+            if (i != ITERS - 1) {
+                timer.recordTime();
+            }
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memoryThread.join();
+        filing("scan_" + op, ITERS, VAULTS, timer.getAverageTime(), timer.getSlowest());
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(Benchmark_workflow, steps) {
+    // measures every step of the select -> verify -> decrypt workflow of a small vault (cheap chainhashes, so the file access dominates)
+    // the average and slowest times are in microseconds, the syscalls are the read and write syscalls of the step (from /proc/self/io)
+    const constexpr u_int64_t RUNS = 200;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    {
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(DATA_SIZE_SMALL);
+        fds->dec_data->fillrandom();
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+    }
+    const std::vector<std::string> steps = {"select", "verify", "decrypt"};
+    std::vector<u_int64_t> time_sum(steps.size(), 0), time_max(steps.size(), 0), calls_sum(steps.size(), 0), calls_max(steps.size(), 0);
+    std::thread memoryThread(MemoryThread);
+    for (u_int64_t i = 0; i < RUNS; i++) {
+        API api{FILEMODE_PASSWORD};
+        for (size_t step = 0; step < steps.size(); step++) {
+            u_int64_t calls = getIOSyscalls();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool success = false;
+            if (step == 0)
+                success = api.selectFile(file).isSuccess();
+            else if (step == 1)
+                success = api.verifyPassword(password).isSuccess();
+            else
+                success = api.getDecryptedData().isSuccess();
+            u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            calls = getIOSyscalls() - calls;
+            assert(success);
+            time_sum[step] += time;
+            time_max[step] = std::max(time_max[step], time);
+            calls_sum[step] += calls;
+            calls_max[step] = std::max(calls_max[step], calls);
+        }
+        api.logout();
+    }
+    _terminateMeasurementThread = true;
+    memoryThread.join();
+    for (size_t step = 0; step < steps.size(); step++) {
+        filing("workflow_" + steps[step], RUNS, DATA_SIZE_SMALL_MB, time_sum[step] / RUNS, time_max[step]);
+        filing("workflow_" + steps[step] + "_syscalls", RUNS, DATA_SIZE_SMALL_MB, calls_sum[step] / RUNS, calls_max[step]);
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_session, reopen) {
+    // measures repeated opens of the same vault (select -> unlock) in microseconds
+    // cold: every API object derives the password hash with the chainhashes, warm: the API objects share a session cache and skip the chainhashes
+    const constexpr u_int64_t RUNS_COLD = 5;
+    const constexpr u_int64_t RUNS_WARM = 200;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS);
+    ds.setChainHash2Iters(CITERS);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    std::shared_ptr<SessionCache> cache = std::make_shared<SessionCache>();
+    {
+        API api{FILEMODE_PASSWORD, cache};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        std::unique_ptr<FileDataStruct> fds = api.getFileData().returnMove();
+        fds->dec_data = std::make_unique<Bytes>(DATA_SIZE_SMALL);
+        fds->dec_data->fillrandom();
+        api.encryptData(std::move(fds));
+        api.writeToFile();
+        api.logout();
+    }
+    for (bool warm : {false, true}) {
+        u_int64_t runs = warm ? RUNS_WARM : RUNS_COLD;
+        u_int64_t time_sum = 0, time_max = 0;
+        for (u_int64_t i = 0; i < runs; i++) {
+            API api{FILEMODE_PASSWORD, warm ? cache : nullptr};
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool success = api.selectFile(file).isSuccess();
+            success = success && (warm ? api.unlockFromSession() : api.verifyPassword(password)).isSuccess();
+            success = success && api.getDecryptedData().isSuccess();
+            u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            assert(success);
+            time_sum += time;
+            time_max = std::max(time_max, time);
+            api.logout();
+        }
+        filing(warm ? "session_reopen_warm" : "session_reopen_cold", runs, DATA_SIZE_SMALL_MB, time_sum / runs, time_max);
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(Benchmark_agent, load) {
+    // load generator for the vault agent: many clients send get, search and add requests over the unix socket at the same time
+    // agent_throughput stores the requests per second, agent_latency the average and the 99th percentile latency in microseconds (size column: clients)
+    // agent_baseline_lookup is one lookup without the agent (select -> verify -> decrypt -> parse) in microseconds
+    const constexpr u_int64_t SITES = 1000;
+    const constexpr u_int64_t CLIENTS = 16;
+    const constexpr u_int64_t REQUESTS = 2000;  // per client
+    const constexpr u_int64_t BASELINE_RUNS = 20;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    std::filesystem::path socket_path = RNG::get_random_string(10) + ".sock";
+    {
+        PasswordData data;
+        for (u_int64_t i = 0; i < SITES; i++) data.addPw(PasswordSet{"site" + std::to_string(i) + ".com", "user" + std::to_string(i), "user@mail.com", RNG::get_random_string(20)});
+        API api{FILEMODE_PASSWORD};
+        api.createFile(file);
+        api.selectFile(file);
+        api.createDataHeader(password, ds);
+        api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data.getFileData().dec_data)));
+        api.writeToFile();
+    }
+    u_int64_t baseline_sum = 0, baseline_max = 0;
+    for (u_int64_t i = 0; i < BASELINE_RUNS; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        API api{FILEMODE_PASSWORD};
+        api.selectFile(file);
+        api.verifyPassword(password);
+        PasswordData data;
+        bool success = data.constructFileData(*api.getDecryptedData().returnRef()).isSuccess() && data.getSiteSets("site7.com").size() == 1;
+        u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        assert(success);
+        baseline_sum += time;
+        baseline_max = std::max(baseline_max, time);
+    }
+    filing("agent_baseline_lookup", BASELINE_RUNS, 1, baseline_sum / BASELINE_RUNS, baseline_max);
+
+    VaultAgent agent{file, socket_path};
+    ASSERT_TRUE(agent.unlock(password).isSuccess());
+    ASSERT_TRUE(agent.start().isSuccess());
+    std::vector<std::vector<u_int64_t>> latencies(CLIENTS);
+    std::vector<std::thread> clients;
+    std::thread memoryThread(MemoryThread);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (u_int64_t c = 0; c < CLIENTS; c++) {
+        clients.emplace_back([&socket_path, &latencies, c]() {
+            // 5% add, 15% search, 80% get
+            AgentClient client{socket_path};
+            latencies[c].reserve(REQUESTS);
+            for (u_int64_t i = 0; i < REQUESTS; i++) {
+                std::string site = "site" + std::to_string((c * REQUESTS + i) * 7919 % SITES) + ".com";
+                std::chrono::steady_clock::time_point request_start = std::chrono::steady_clock::now();
+                bool success;
+                if (i % 20 == 0)
+                    success = client.add(PasswordSet{site, "client" + std::to_string(c), "", "pw" + std::to_string(i)}).isSuccess();
+                else if (i % 20 < 4)
+                    success = client.search(site.substr(0, 6)).isSuccess();
+                else
+                    success = client.get(site).isSuccess();
+                latencies[c].push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request_start).count());
+                assert(success);
+            }
+        });
+    }
+    for (std::thread& client : clients) client.join();
+    u_int64_t wall = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    _terminateMeasurementThread = true;
+    memoryThread.join();
+    ASSERT_TRUE(agent.flush().isSuccess());
+    agent.stop();
+    std::vector<u_int64_t> all;
+    for (const std::vector<u_int64_t>& client_latencies : latencies) all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+    std::sort(all.begin(), all.end());
+    u_int64_t sum = 0;
+    for (u_int64_t latency : all) sum += latency;
+    filing("agent_throughput", all.size(), CLIENTS, all.size() * 1000000 / std::max<u_int64_t>(1, wall), 0);
+    filing("agent_latency", all.size(), CLIENTS, sum / all.size(), all[all.size() * 99 / 100]);
+    std::filesystem::remove(file);
+}
+
+
+TEST(Benchmark_manager, vaults) {
+    // throughput of a VaultManager with 1 to 1000 independent vaults (size column: vaults)
+    // manager_create: createDataHeader -> encryptData -> writeToFile, manager_unlock: open -> verifyPassword -> getDecryptedData
+    // manager_unlock_sequential runs the unlocks one after another on the calling thread without the manager
+    // the average column stores the vault operations per second, the slowest column the longest time (in microseconds) until one vault was done
+    const constexpr u_int64_t ITERS = 2000;
+    const constexpr u_int64_t DATA_SIZE = 4 * 1024;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(ITERS);
+    ds.setChainHash2Iters(ITERS);
+    ds.setCipherMode(CIPHERMODE_AES256GCM);
+    for (u_int64_t vaults : {1, 10, 100, 1000}) {
+        std::vector<std::filesystem::path> files;
+        for (u_int64_t i = 0; i < vaults; i++) files.push_back(RNG::get_random_string(10) + ".enc");
+        VaultManager manager;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<VaultSession>> sessions;
+        std::vector<std::future<ErrorStruct<bool>>> writes;
+        for (const std::filesystem::path& file : files) {
+            sessions.push_back(manager.open(file, FILEMODE_PASSWORD, true).returnValue());
+            std::unique_ptr<Bytes> data = std::make_unique<Bytes>(DATA_SIZE);
+            data->fillrandom();
+            sessions.back()->createDataHeader(password, ds);
+            sessions.back()->encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data)));
+            writes.push_back(sessions.back()->writeToFile());
+        }
+        u_int64_t slowest = 0;
+        for (std::future<ErrorStruct<bool>>& write : writes) {
+            assert(write.get().isSuccess());
+            slowest = std::max<u_int64_t>(slowest, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+        filing("manager_create", vaults, vaults, vaults * 1000000 / std::max<u_int64_t>(1, slowest), slowest);
+        sessions.clear();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<std::future<ErrorStruct<std::unique_ptr<FileDataStruct>>>> decrypted;
+        for (const std::filesystem::path& file : files) {
+            sessions.push_back(manager.open(file, FILEMODE_PASSWORD).returnValue());
+            sessions.back()->verifyPassword(password);
+            decrypted.push_back(sessions.back()->getDecryptedData());
+        }
+        slowest = 0;
+        for (std::future<ErrorStruct<std::unique_ptr<FileDataStruct>>>& data : decrypted) {
+            assert(data.get().isSuccess());
+            slowest = std::max<u_int64_t>(slowest, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+        filing("manager_unlock", vaults, vaults, vaults * 1000000 / std::max<u_int64_t>(1, slowest), slowest);
+        sessions.clear();
+
+        start = std::chrono::steady_clock::now();
+        for (const std::filesystem::path& file : files) {
+            API api{FILEMODE_PASSWORD};
+            bool success = api.selectFile(file).isSuccess();
+            success = success && api.verifyPassword(password).isSuccess();
+            success = success && api.getDecryptedData().isSuccess();
+            assert(success);
+        }
+        u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        filing("manager_unlock_sequential", vaults, vaults, vaults * 1000000 / std::max<u_int64_t>(1, time), time);
+        for (const std::filesystem::path& file : files) std::filesystem::remove(file);
+    }
+}
+
+TEST(Benchmark_unlock, batch) {
+    // unlocks FILES vaults with the same master password and the same first chainhash (in microseconds, size column: vaults)
+    // unlock_sequential: verifyPassword per vault (both chainhashes every time), unlock_batch: VaultManager::unlockAll (one first chainhash, parallel second chainhashes)
+    // the average column stores the time per vault, the slowest column the time for all vaults
+    const constexpr u_int64_t ITERS = CITERS / 10;
+    std::shared_ptr<ChainHashData> chainhash1_data = std::make_shared<ChainHashData>(Format{CHAINHASH_CONSTANT_COUNT_SALT});
+    chainhash1_data->generateRandomData();
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(ITERS);
+    ds.setChainHash2Iters(ITERS);
+    ds.setChainHash1Data(chainhash1_data);
+    std::vector<std::filesystem::path> files;
+    {
+        VaultManager manager;
+        std::vector<std::future<ErrorStruct<bool>>> writes;
+        for (u_int64_t i = 0; i < FILES; i++) {
+            files.push_back(RNG::get_random_string(10) + ".enc");
+            std::shared_ptr<VaultSession> session = manager.open(files.back(), FILEMODE_PASSWORD, true).returnValue();
+            std::unique_ptr<Bytes> data = std::make_unique<Bytes>(1024);
+            data->fillrandom();
+            session->createDataHeader(password, ds);
+            session->encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data)));
+            writes.push_back(session->writeToFile());
+        }
+        for (std::future<ErrorStruct<bool>>& write : writes) assert(write.get().isSuccess());
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (const std::filesystem::path& file : files) {
+        API api{FILEMODE_PASSWORD};
+        bool success = api.selectFile(file).isSuccess() && api.verifyPassword(password).isSuccess();
+        assert(success);
+    }
+    u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    filing("unlock_sequential", ITERS, FILES, time / FILES, time);
+
+    VaultManager manager;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<VaultSession>> sessions;
+    for (const std::filesystem::path& file : files) sessions.push_back(manager.open(file, FILEMODE_PASSWORD).returnValue());
+    std::vector<ErrorStruct<bool>> results = manager.unlockAll(sessions, password);
+    time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    for (ErrorStruct<bool>& result : results) assert(result.isSuccess());
+    filing("unlock_batch", ITERS, FILES, time / FILES, time);
+    for (const std::filesystem::path& file : files) std::filesystem::remove(file);
+}
+
+TEST(Benchmark_rotate, password) {
+    // changes the password of a vault with key slots (in microseconds, size column: MB of content)
+    // rotate_keyslot: changePassword rewrites the key slot of the old password, only the header is written (the checksum reads the content once)
+    // rotate_reencrypt: the content is decrypted and encrypted again with a new header for the new password (the way without key slots)
+    // the chainhashes use one iteration, so only the part of the time that depends on the content is measured
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_NORMAL);
+    ds.setChainHash2Mode(CHAINHASH_NORMAL);
+    ds.setChainHash1Iters(1);
+    ds.setChainHash2Iters(1);
+    ds.setKeySlotCount(2);
+    for (std::pair<u_int64_t, u_int64_t> size : {std::make_pair(DATA_SIZE_SMALL, DATA_SIZE_SMALL_MB), std::make_pair(DATA_SIZE_MEDIUM, DATA_SIZE_MEDIUM_MB),
+                                                 std::make_pair(DATA_SIZE_LARGE, DATA_SIZE_LARGE_MB)}) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        {
+            API api{FILEMODE_PASSWORD};
+            std::unique_ptr<Bytes> data = std::make_unique<Bytes>(size.first);
+            data->fillrandom();
+            bool success = api.createFile(file).isSuccess() && api.selectFile(file).isSuccess() && api.createDataHeader(password, ds).isSuccess() &&
+                           api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data))).isSuccess() && api.writeToFile().isSuccess();
+            assert(success);
+        }
+        // the passwords are swapped in every iteration
+        std::string passwords[2] = {password, "new_password"};
+        u_int64_t total = 0;
+        u_int64_t slowest = 0;
+        {
+            API api{FILEMODE_PASSWORD};
+            bool success = api.selectFile(file).isSuccess() && api.verifyPassword(password).isSuccess();
+            assert(success);
+            for (u_int64_t i = 0; i < ITERS; i++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                success = api.changePassword(passwords[i % 2], passwords[(i + 1) % 2]).isSuccess();
+                u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                assert(success);
+                total += time;
+                slowest = std::max(slowest, time);
+            }
+        }
+        filing("rotate_keyslot", ITERS, size.second, total / ITERS, slowest);
+
+        total = 0;
+        slowest = 0;
+        for (u_int64_t i = 0; i < ITERS; i++) {
+            API api{FILEMODE_PASSWORD};
+            bool success = api.selectFile(file).isSuccess() && api.verifyPassword(passwords[(ITERS + i) % 2]).isSuccess();
+            assert(success);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ErrorStruct<std::unique_ptr<FileDataStruct>> decrypted = api.getDecryptedData();
+            success = decrypted.isSuccess() && api.createDataHeader(passwords[(ITERS + i + 1) % 2], ds).isSuccess() && api.encryptData(decrypted.returnMove()).isSuccess() &&
+                      api.writeToFile().isSuccess();
+            u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            assert(success);
+            total += time;
+            slowest = std::max(slowest, time);
+        }
+        filing("rotate_reencrypt", ITERS, size.second, total / ITERS, slowest);
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(Benchmark_rotation, fleet) {
+    // re-keys a synthetic fleet of FILES vaults with 1MB of content each (in microseconds, size column: vaults)
+    // rotation_sequential: select -> verifyPassword -> getDecryptedData -> createDataHeader -> encryptData -> writeToFile in place, one vault after another
+    // rotation_job_single: a RotationJob with one thread (temporary file, fsync and rename per vault), rotation_job: a RotationJob with one thread per core
+    // the average column stores the time per vault, the slowest column the time for all vaults
+    const constexpr u_int64_t ITERS = 2000;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    ds.setChainHash2Mode(CHAINHASH_QUADRATIC);
+    ds.setChainHash1Iters(ITERS);
+    ds.setChainHash2Iters(ITERS);
+    std::vector<std::filesystem::path> files;
+    for (u_int64_t i = 0; i < FILES; i++) {
+        files.push_back(RNG::get_random_string(10) + ".enc");
+        API api{FILEMODE_PASSWORD};
+        std::unique_ptr<Bytes> data = std::make_unique<Bytes>(DATA_SIZE_SMALL);
+        data->fillrandom();
+        bool success = api.createFile(files.back()).isSuccess() && api.selectFile(files.back()).isSuccess() && api.createDataHeader(password, ds).isSuccess() &&
+                       api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data))).isSuccess() && api.writeToFile().isSuccess();
+        assert(success);
+    }
+    // the passwords are swapped by every rotation of the fleet
+    std::string passwords[2] = {password, "new_password"};
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (const std::filesystem::path& file : files) {
+        API api{FILEMODE_PASSWORD};
+        bool success = api.selectFile(file).isSuccess() && api.verifyPassword(passwords[0]).isSuccess();
+        ErrorStruct<std::unique_ptr<FileDataStruct>> decrypted = api.getDecryptedData();
+        success = success && decrypted.isSuccess() && api.createDataHeader(passwords[1], ds).isSuccess() && api.encryptData(decrypted.returnMove()).isSuccess() &&
+                  api.writeToFile().isSuccess();
+        assert(success);
+    }
+    u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    filing("rotation_sequential", 1, FILES, time / FILES, time);
+
+    for (size_t threads : {1, 0}) {
+        RotationSettings settings;
+        settings.password = passwords[threads == 1 ? 1 : 0];
+        settings.new_password = passwords[threads == 1 ? 0 : 1];
+        settings.settings = ds;
+        RotationJob job{files, settings, "", threads};
+        start = std::chrono::steady_clock::now();
+        std::vector<RotationReport> reports = job.run();
+        time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        for (const RotationReport& report : reports) assert(report.result.success == SUCCESS);
+        filing(threads == 1 ? "rotation_job_single" : "rotation_job", 1, FILES, time / FILES, time);
+    }
+    for (const std::filesystem::path& file : files) std::filesystem::remove(file);
+}
+
+TEST(Benchmark_autosave, burst) {
+    // a burst of EDITS edits (adds, every tenth edit changes the password of the set added before) on a vault with SETS password sets (size column: edits)
+    // autosave_rewrite: every edit decrypts, encrypts and writes the whole vault (getDecryptedData -> changeSalt -> encryptData -> writeToFile)
+    // autosave_each: a VaultAutosave that writes every edit on its own (max_edits 1 and a flush after every edit, the adds are appended)
+    // autosave_burst: a VaultAutosave with the default delays, the burst is merged and written once by the flush at the end
+    // the _bytes rows store the Bytes passed to write syscalls per edit (average column) and of the burst (slowest column)
+    // the _cpu rows store the CPU time (in microseconds, all threads) per edit (average column) and of the burst (slowest column)
+    const constexpr u_int64_t SETS = 2000;
+    const constexpr u_int64_t EDITS = 200;
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_NORMAL);
+    ds.setChainHash2Mode(CHAINHASH_NORMAL);
+    ds.setChainHash1Iters(CITERS_SMALL);
+    ds.setChainHash2Iters(CITERS_SMALL);
+    PasswordData initial;
+    for (u_int64_t i = 0; i < SETS; i++) initial.addPw(PasswordSet{"site" + std::to_string(i), "user" + std::to_string(i), "user@mail.com", RNG::get_random_string(20)});
+    auto getEdit = [](const u_int64_t i) {
+        // the edit i of the burst
+        if (i % 10 == 9) return PasswordSet{"new" + std::to_string(i - 1), "user", "", "changed"};
+        return PasswordSet{"new" + std::to_string(i), "user", "user@mail.com", RNG::get_random_string(20)};
+    };
+    for (std::string op : {"autosave_rewrite", "autosave_each", "autosave_burst"}) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        {
+            API api{FILEMODE_PASSWORD};
+            bool success = api.createFile(file).isSuccess() && api.selectFile(file).isSuccess() && api.createDataHeader(password, ds).isSuccess() &&
+                           api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(initial.getFileData().dec_data))).isSuccess() &&
+                           api.writeToFile().isSuccess();
+            assert(success);
+        }
+        u_int64_t bytes = 0;
+        u_int64_t cpu = 0;
+        if (op == "autosave_rewrite") {
+            std::shared_ptr<SessionCache> cache = std::make_shared<SessionCache>();
+            PasswordData data = initial;
+            std::unique_ptr<API> api = std::make_unique<API>(FILEMODE_PASSWORD, cache);
+            bool success = api->selectFile(file).isSuccess() && api->verifyPassword(password).isSuccess();
+            bytes = getWrittenBytes();
+            cpu = getCPUTime();
+            for (u_int64_t i = 0; i < EDITS; i++) {
+                PasswordSet edit = getEdit(i);
+                if (i % 10 == 9)
+                    data.editPw(edit);
+                else
+                    data.addPw(edit);
+                success = success && api->getDecryptedData().isSuccess() && api->changeSalt().isSuccess() &&
+                          api->encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(data.getFileData().dec_data))).isSuccess() &&
+                          api->writeToFile().isSuccess();
+                // the next edit unlocks the written vault from the session
+                api = std::make_unique<API>(FILEMODE_PASSWORD, cache);
+                success = success && api->selectFile(file).isSuccess() && api->unlockFromSession().isSuccess();
+            }
+            bytes = getWrittenBytes() - bytes;
+            cpu = getCPUTime() - cpu;
+            assert(success);
+        } else {
+            bool each = op == "autosave_each";
+            VaultAutosave autosave{file, AUTOSAVE_DELAY, AUTOSAVE_MAX_DELAY, each ? 1 : AUTOSAVE_MAX_EDITS};
+            bool success = autosave.unlock(password).isSuccess();
+            bytes = getWrittenBytes();
+            cpu = getCPUTime();
+            for (u_int64_t i = 0; i < EDITS; i++) {
+                PasswordSet edit = getEdit(i);
+                success = success && (i % 10 == 9 ? autosave.editPw(edit) : autosave.addPw(edit)).isSuccess();
+                if (each) success = success && autosave.flush().isSuccess();
+            }
+            success = success && autosave.flush().isSuccess();
+            bytes = getWrittenBytes() - bytes;
+            cpu = getCPUTime() - cpu;
+            assert(success);
+        }
+        filing(op + "_bytes", EDITS, EDITS, bytes / EDITS, bytes);
+        filing(op + "_cpu", EDITS, EDITS, cpu / EDITS, cpu);
+        std::filesystem::remove(file);
+    }
+}
@@ -1,4 +1,6 @@
+#include <fcntl.h>
 #include <sys/resource.h>
+#include <unistd.h>
 
 #include <iostream>
 
@@ -61,4 +63,44 @@ int getPhysicalMem() {  // Note: this value is in KB!
     }
     fclose(file);
     return result;
-}
\ No newline at end of file
+}
+// Function to evict the pages of a file from the page cache (cold cache measurements)
+// Note: works without root privileges because it only affects clean pages of the given file
+bool dropFileCache(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    fdatasync(fd);
+    bool ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ret;
+}
+// Function to get the number of read and write syscalls of the process (syscr + syscw)
+u_int64_t getIOSyscalls() {
+    FILE* file = fopen("/proc/self/io", "r");
+    if (file == NULL) return 0;
+    u_int64_t result = 0;
+    char line[128];
+    while (fgets(line, 128, file) != NULL) {
+        if (strncmp(line, "syscr:", 6) == 0 || strncmp(line, "syscw:", 6) == 0) result += strtoull(line + 6, NULL, 10);
+    }
+    fclose(file);
+    return result;
+}
+// Function to get the number of Bytes the process passed to write syscalls (wchar, includes the page cache writes)
+u_int64_t getWrittenBytes() {
+    FILE* file = fopen("/proc/self/io", "r");
+    if (file == NULL) return 0;
+    u_int64_t result = 0;
+    char line[128];
+    while (fgets(line, 128, file) != NULL) {
+        if (strncmp(line, "wchar:", 6) == 0) result = strtoull(line + 6, NULL, 10);
+    }
+    fclose(file);
+    return result;
+}
+// Function to get the CPU time (user + system) of all threads of the process in microseconds
+u_int64_t getCPUTime() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
@@ -3,10 +3,12 @@
 #include <fstream>
 #include <thread>
 
+#include "aead_chain.h"
 #include "bench_utils.h"
 #include "blockchain_decrypt.h"
 #include "blockchain_encrypt.h"
 #include "hash_modes.h"
+#include "settings.h"
 #include "timer.h"
 
 const constexpr int ITERS = 10;
@@ -278,4 +280,111 @@ TEST(BlockChain, codec_sha512) {
     _terminateMeasurementThread = true;
     memory_thread.join();
     filing("codec_sha512", NUM_BYTES, timer.getAverageTime(), timer.getSlowest());
-}
\ No newline at end of file
+}
+void benchBlockLen(HModes hmode, std::string name) {
+    // encrypts NUM_BYTES with the legacy format (block length 0 = hash size) and the keystream format with several block lengths
+    // the throughput in MB/s is NUM_BYTES / average time
+    std::shared_ptr<Hash> hash = std::move(HashModes::getHash(hmode));
+    Bytes pwhash{hash->getHashSize()};
+    Bytes enc_salt{hash->getHashSize()};
+    Bytes data{NUM_BYTES};
+    pwhash.fillrandom();
+    enc_salt.fillrandom();
+    data.fillrandom();
+    for (size_t block_len : {0, 256, 1024, 4096, 16384, 65536}) {
+        for (bool encrypt : {true, false}) {
+            EncryptBlockChain enc_data_chain{std::move(HashModes::getHash(hmode)), pwhash, enc_salt, block_len};
+            enc_data_chain.addData(data);
+            std::unique_ptr<Bytes> enc_data = enc_data_chain.getResult();
+            Timer timer;
+
+            std::thread memory_thread(MemoryThread);
+            timer.start();
+            for (int i = 0; i < ITERS; i++) {
+                if (encrypt) {
+                    EncryptBlockChain ebc{std::move(HashModes::getHash(hmode)), pwhash, enc_salt, block_len};
+                    ebc.addData(data);
+                    std::unique_ptr<Bytes> res = ebc.getResult();
+                } else {
+                    DecryptBlockChain dbc{std::move(HashModes::getHash(hmode)), pwhash, enc_salt, block_len};
+                    dbc.addData(*enc_data);
+                    std::unique_ptr<Bytes> res = dbc.getResult();
+                }
+                if (i != ITERS - 1) timer.recordTime();
+            }
+            timer.stop();
+            _terminateMeasurementThread = true;
+            memory_thread.join();
+            filing(std::string(encrypt ? "encrypt_" : "decrypt_") + name + "_block" + std::to_string(block_len), NUM_BYTES, timer.getAverageTime(), timer.getSlowest());
+        }
+    }
+}
+
+TEST(BlockChain, block_len_sha256) { benchBlockLen(HModes::HASHMODE_SHA256, "sha256"); }
+
+TEST(BlockChain, block_len_sha384) { benchBlockLen(HModes::HASHMODE_SHA384, "sha384"); }
+
+TEST(BlockChain, block_len_sha512) { benchBlockLen(HModes::HASHMODE_SHA512, "sha512"); }
+
+void benchCipherMode(CModes cipher_mode, std::string name) {
+    // encrypts and decrypts with the hash chain (sha256, legacy format) and an AEAD cipher mode in one thread
+    // the AEAD modes are measured with 64 times more data, the throughput is the filed Bytes / average time
+    std::shared_ptr<Hash> hash = std::move(HashModes::getHash(HModes::HASHMODE_SHA256));
+    const size_t num_bytes = cipher_mode == CIPHERMODE_HASHCHAIN ? NUM_BYTES : 64 * NUM_BYTES;
+    Bytes pwhash{hash->getHashSize()};
+    Bytes enc_salt{hash->getHashSize()};
+    Bytes key_salt{AEAD_KEY_SALT_LEN};
+    Bytes data{static_cast<int64_t>(num_bytes)};
+    pwhash.fillrandom();
+    enc_salt.fillrandom();
+    key_salt.fillrandom();
+    data.fillrandom();
+    Bytes key = AEADChain::deriveKey(*hash, pwhash, enc_salt, key_salt);
+    std::unique_ptr<Bytes> enc_data;
+    if (cipher_mode == CIPHERMODE_HASHCHAIN) {
+        EncryptBlockChain ebc{std::move(HashModes::getHash(HModes::HASHMODE_SHA256)), pwhash, enc_salt};
+        ebc.addData(data);
+        enc_data = ebc.getResult();
+    } else {
+        EncryptAEADChain eac{cipher_mode, key, AEAD_CHUNK_LEN};
+        eac.addData(data);
+        enc_data = eac.getResult();
+    }
+    for (bool encrypt : {true, false}) {
+        Timer timer;
+
+        std::thread memory_thread(MemoryThread);
+        timer.start();
+        for (int i = 0; i < ITERS; i++) {
+            std::unique_ptr<Bytes> res;
+            if (cipher_mode == CIPHERMODE_HASHCHAIN && encrypt) {
+                EncryptBlockChain ebc{std::move(HashModes::getHash(HModes::HASHMODE_SHA256)), pwhash, enc_salt};
+                ebc.addData(data);
+                res = ebc.getResult();
+            } else if (cipher_mode == CIPHERMODE_HASHCHAIN) {
+                DecryptBlockChain dbc{std::move(HashModes::getHash(HModes::HASHMODE_SHA256)), pwhash, enc_salt};
+                dbc.addData(*enc_data);
+                res = dbc.getResult();
+            } else if (encrypt) {
+                EncryptAEADChain eac{cipher_mode, key, AEAD_CHUNK_LEN};
+                eac.addData(data);
+                res = eac.getResult();
+            } else {
+                DecryptAEADChain dac{cipher_mode, key, AEAD_CHUNK_LEN};
+                dac.addData(*enc_data);
+                res = dac.getResult();
+            }
+            if (i != ITERS - 1) timer.recordTime();
+        }
+        timer.stop();
+        _terminateMeasurementThread = true;
+        memory_thread.join();
+        filing(std::string(encrypt ? "encrypt_" : "decrypt_") + name, num_bytes, timer.getAverageTime(), timer.getSlowest());
+    }
+}
+
+TEST(BlockChain, cipher_hashchain) { benchCipherMode(CIPHERMODE_HASHCHAIN, "hashchain_sha256"); }
+
+TEST(BlockChain, cipher_aes256gcm) { benchCipherMode(CIPHERMODE_AES256GCM, "aes256gcm"); }
+
+TEST(BlockChain, cipher_chacha20poly1305) { benchCipherMode(CIPHERMODE_CHACHA20POLY1305, "chacha20poly1305"); }
\ No newline at end of file
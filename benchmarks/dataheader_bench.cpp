@@ -1,12 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <malloc.h>
 
 #include "dataheader.h"
 #include "timer.h"
 
 const constexpr int ITERS = 10000;
 const constexpr int HASHITERS = 1000000;
+const constexpr int LISTING_SIZE = 1000;
 
 void filing(std::string op, u_int64_t iters, u_int64_t avg, u_int64_t slowest) {
     std::ofstream file;
@@ -15,6 +20,22 @@ void filing(std::string op, u_int64_t iters, u_int64_t avg, u_int64_t slowest) {
     file.close();
 }
 
+void filingRate(std::string op, u_int64_t iters, u_int64_t time) {
+    // writes the number of operations per second
+    std::ofstream file;
+    file.open("dataheader_bench.csv", std::ios::app);
+    file << op << "," << iters << "," << iters * 1000 / std::max<u_int64_t>(1, time) << "/s\n";
+    file.close();
+}
+
+void filingBytes(std::string op, u_int64_t iters, u_int64_t bytes) {
+    // writes the number of Bytes per operation
+    std::ofstream file;
+    file.open("dataheader_bench.csv", std::ios::app);
+    file << op << "," << iters << "," << bytes << "B\n";
+    file.close();
+}
+
 TEST(DataHeader, calcHeaderBytes_sha256) {
     Timer timer;
     std::shared_ptr<ChainHashData> chd1 = std::make_shared<ChainHashData>(Format{CHAINHASH_QUADRATIC});
@@ -148,4 +169,133 @@ TEST(DataHeader, setHeaderBytes_sha512) {
     }
     timer.stop();
     filing("setHeaderBytes_sha512", ITERS, timer.getAverageTime(), timer.getSlowest());
-}
\ No newline at end of file
+}
+DataHeader createBenchHeader(const bool max_size, const int blocks = 255) {
+    // the minimum header has no datablocks and no chainhash data (sha256)
+    // the maximum header has 255 datablocks and 255 encrypted datablocks with 255 Bytes each and 255 Bytes of chainhash data per chainhash (sha512, about 132KB)
+    // fewer blocks give the sizes in between
+    HModes hash_mode = max_size ? HASHMODE_SHA512 : HASHMODE_SHA256;
+    CHModes chainhash_mode = max_size ? CHAINHASH_CONSTANT_SALT : CHAINHASH_NORMAL;
+    std::shared_ptr<ChainHashData> chd1 = std::make_shared<ChainHashData>(Format{chainhash_mode});
+    std::shared_ptr<ChainHashData> chd2 = std::make_shared<ChainHashData>(Format{chainhash_mode});
+    chd1->generateRandomData();
+    chd2->generateRandomData();
+    DataHeader header{hash_mode};
+    header.setFileDataMode(FILEMODE_PASSWORD);
+    Bytes bytes(max_size ? 64 : 32);
+    bytes.fillrandom();
+    header.setValidPasswordHashBytes(bytes);
+    header.setChainHash1(ChainHash{chainhash_mode, HASHITERS, chd1});
+    header.setChainHash2(ChainHash{chainhash_mode, HASHITERS, chd2});
+    if (max_size) {
+        Bytes data(255);
+        for (int i = 0; i < blocks; i++) {
+            data.setLen(0);
+            data.fillrandom();
+            header.addDataBlock(DataBlock{DatablockType::DEFAULT, data});
+            header.addEncDataBlock(EncDataBlock::createEncBlock(DatablockType::DEFAULT, data, 255));
+        }
+    }
+    header.setDataSize(0);
+    return header;
+}
+
+void benchCalcHeaderBytes(const bool max_size, const std::string name) {
+    // serializes the header again and again
+    Timer timer;
+    DataHeader header = createBenchHeader(max_size);
+    timer.start();
+    for (int i = 0; i < ITERS; i++) {
+        header.calcHeaderBytes();
+    }
+    timer.stop();
+    filing("calcHeaderBytes_" + name + "_" + std::to_string(header.getHeaderLength()) + "B", ITERS, timer.getAverageTime(), timer.getSlowest());
+}
+
+void benchSetHeaderBytes(const bool max_size, const std::string name) {
+    // parses the serialized header again and again
+    Timer timer;
+    DataHeader header = createBenchHeader(max_size);
+    header.calcHeaderBytes();
+    Bytes headerBytes = header.getHeaderBytes();
+    timer.start();
+    for (int i = 0; i < ITERS; i++) {
+        DataHeader::setHeaderBytes(headerBytes);
+    }
+    timer.stop();
+    filing("setHeaderBytes_" + name + "_" + std::to_string(header.getHeaderLength()) + "B", ITERS, timer.getAverageTime(), timer.getSlowest());
+}
+
+void benchParseHeader(const bool max_size, const int blocks) {
+    // parses the header in place from one buffer and from a file stream (one read of the header), reports the parses per second
+    DataHeader header = createBenchHeader(max_size, blocks);
+    header.calcHeaderBytes();
+    const Bytes& headerBytes = header.getHeaderBytes();
+    const std::string size = std::to_string(headerBytes.getLen()) + "B";
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < ITERS; i++) {
+        if (!DataHeader::setHeaderBytes(headerBytes.getBytes(), headerBytes.getLen()).isSuccess()) FAIL() << "the header could not be parsed";
+    }
+    timer.stop();
+    filingRate("parseHeader_buffer_" + size, ITERS, timer.getTime());
+
+    // the file only contains the header (no data)
+    std::ofstream out("dataheader_bench.enc", std::ios::binary);
+    out << headerBytes;
+    out.close();
+    std::ifstream in("dataheader_bench.enc", std::ios::binary);
+    Timer stream_timer;
+    stream_timer.start();
+    for (int i = 0; i < ITERS; i++) {
+        in.seekg(0);
+        if (!DataHeader::setHeaderBytes(in).isSuccess()) FAIL() << "the header could not be parsed from the stream";
+    }
+    stream_timer.stop();
+    in.close();
+    std::remove("dataheader_bench.enc");
+    filingRate("parseHeader_stream_" + size, ITERS, stream_timer.getTime());
+}
+
+TEST(DataHeader, parseHeader) {
+    // headers from the minimum size (104B) up to the maximum size (about 132KB)
+    benchParseHeader(false, 0);
+    for (int blocks : {1, 16, 64, 255}) benchParseHeader(true, blocks);
+}
+
+TEST(DataHeader, loadHeader) {
+    // a directory listing loads the headers of many files, keeps them and only checks the file mode (like FileHandler::isDataHeader)
+    // reports the time to load one header and the heap memory that one loaded header keeps
+    for (int blocks : {0, 16, 255}) {
+        DataHeader header = createBenchHeader(blocks != 0, blocks);
+        header.calcHeaderBytes();
+        const Bytes& headerBytes = header.getHeaderBytes();
+        const std::string size = std::to_string(headerBytes.getLen()) + "B";
+        std::vector<std::unique_ptr<DataHeader>> listing;
+        listing.reserve(LISTING_SIZE);
+        size_t heap_before = mallinfo2().uordblks;
+        u_int64_t total = 0;
+        u_int64_t slowest = 0;
+        for (int i = 0; i < LISTING_SIZE; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ErrorStruct<std::unique_ptr<DataHeader>> err = DataHeader::setHeaderBytes(headerBytes.getBytes(), headerBytes.getLen());
+            if (!err.isSuccess() || err.returnRef()->getDataHeaderParts().getFileDataMode() != FILEMODE_PASSWORD) FAIL() << "the header could not be loaded";
+            u_int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            total += time;
+            slowest = std::max(slowest, time);
+            listing.push_back(std::move(err.returnRef()));
+        }
+        size_t heap = mallinfo2().uordblks - heap_before;
+        // the times are in ns, the timer only measures ms
+        filing("loadHeader_ns_" + size, LISTING_SIZE, total / LISTING_SIZE, slowest);
+        filingBytes("loadHeader_heap_" + size, LISTING_SIZE, heap / LISTING_SIZE);
+    }
+}
+
+TEST(DataHeader, calcHeaderBytes_min) { benchCalcHeaderBytes(false, "min"); }
+
+TEST(DataHeader, calcHeaderBytes_max) { benchCalcHeaderBytes(true, "max"); }
+
+TEST(DataHeader, setHeaderBytes_min) { benchSetHeaderBytes(false, "min"); }
+
+TEST(DataHeader, setHeaderBytes_max) { benchSetHeaderBytes(true, "max"); }
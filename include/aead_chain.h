@@ -0,0 +1,100 @@
+#pragma once
+#include <openssl/evp.h>
+
+#include <fstream>
+#include <memory>
+
+#include "base.h"
+#include "bytes.h"
+#include "hash.h"
+#include "logger.h"
+
+class AEADChain {
+    /*
+    The AEADChain class encrypts/decrypts data with an AEAD cipher (AES-256-GCM or ChaCha20-Poly1305) of OpenSSL
+    it is the alternative to the BlockChain for the AEAD cipher modes and provides the same interface (addData and getResult)
+
+    The data is split into chunks of chunk_len plaintext Bytes, every encrypted chunk is followed by its tag
+    the nonce of a chunk is its index and the additional data marks the last chunk, so chunks cannot be reordered or cut off
+    the chunks do not depend on each other, a chain can start at any chunk (first_chunk) and several chains can run in parallel
+    a new key has to be derived for every encryption (deriveKey with a new key salt), because the nonces repeat for every chain
+
+    The AEADChain class is abstract, because you use it differently for encryption and decryption
+    */
+   protected:
+    CModes cipher_mode;                                                   // the AEAD cipher mode
+    size_t chunk_len;                                                     // the number of plaintext Bytes in one chunk
+    u_int64_t chunk_index;                                                // the index of the next chunk that is processed
+    Bytes key{0};                                                         // the key of the cipher
+    Bytes buffer{0};                                                      // the input of the chunk that is not processed yet
+    std::unique_ptr<Bytes> result = nullptr;                              // the result data of the chain
+    std::unique_ptr<EVP_CIPHER_CTX, void (*)(EVP_CIPHER_CTX*)> ctx;       // the cipher context that is reused for every chunk
+
+   protected:
+    // returns the number of input Bytes of one chunk (with the tag for decryption)
+    virtual size_t getInputChunkLen() const noexcept = 0;
+    // encrypts/decrypts one chunk and adds it to the result
+    virtual void processChunk(const unsigned char* data, const size_t len, const bool last) = 0;
+    // writes the nonce and the additional data of the current chunk
+    void getChunkParams(unsigned char* nonce, unsigned char* aad, const bool last) const noexcept;
+    // returns the OpenSSL cipher of the cipher mode
+    const EVP_CIPHER* getCipher() const;
+
+   public:
+    // creates a new empty chain with the cipher mode, the key (32 Bytes) and the chunk length
+    // first_chunk is the index of the first chunk that is added
+    AEADChain(const CModes cipher_mode, const Bytes& key, const size_t chunk_len, const u_int64_t first_chunk = 0);
+    AEADChain(const AEADChain&) = delete;
+    AEADChain& operator=(const AEADChain&) = delete;
+    AEADChain() = delete;
+    virtual ~AEADChain() = default;
+
+    // derives the 32 Byte key of the cipher from the password hash, the encrypted salt and the key salt
+    static Bytes deriveKey(const Hash& hash, const Bytes& passwordhash, const Bytes& enc_salt, const Bytes& key_salt);
+    // returns the length of the encrypted data for the given plaintext length (every chunk gets a tag, empty data is one chunk)
+    static u_int64_t getEncryptedLen(const u_int64_t data_len, const size_t chunk_len) noexcept;
+    // returns the plaintext length for the given encrypted length, throws if the length cannot belong to encrypted data
+    static u_int64_t getDecryptedLen(const u_int64_t enc_len, const size_t chunk_len);
+
+    // adds new data to the chain (only complete chunks that are followed by more data are processed)
+    void addData(const Bytes& data);
+    void addData(std::ifstream&& filestream, const size_t stream_len);
+    void addData(std::unique_ptr<Bytes>&& data);
+    void addData(const unsigned char* data, const size_t data_len);
+
+    // processes the remaining data as one chunk and returns the result data of the chain
+    // last marks if this chunk is the last chunk of the content (false if the chain only covers a part of the chunks)
+    std::unique_ptr<Bytes> getResult(const bool last = true);
+
+    // returns the index of the next chunk
+    u_int64_t getChunkIndex() const noexcept { return this->chunk_index; };
+};
+
+class EncryptAEADChain : public AEADChain {
+    /*
+    the EncryptAEADChain class encrypts data chunk by chunk, every chunk is followed by its tag
+    */
+   public:
+    EncryptAEADChain(const CModes cipher_mode, const Bytes& key, const size_t chunk_len, const u_int64_t first_chunk = 0) : AEADChain(cipher_mode, key, chunk_len, first_chunk) {
+        PLOG_VERBOSE << "created new EncryptAEADChain";
+    };
+
+   protected:
+    size_t getInputChunkLen() const noexcept override;                                         // returns the chunk length
+    void processChunk(const unsigned char* data, const size_t len, const bool last) override;  // encrypts one chunk
+};
+
+class DecryptAEADChain : public AEADChain {
+    /*
+    the DecryptAEADChain class decrypts data chunk by chunk and verifies the tag of every chunk
+    it throws if a chunk was modified, reordered or cut off
+    */
+   public:
+    DecryptAEADChain(const CModes cipher_mode, const Bytes& key, const size_t chunk_len, const u_int64_t first_chunk = 0) : AEADChain(cipher_mode, key, chunk_len, first_chunk) {
+        PLOG_VERBOSE << "created new DecryptAEADChain";
+    };
+
+   protected:
+    size_t getInputChunkLen() const noexcept override;                                         // returns the chunk length with the tag
+    void processChunk(const unsigned char* data, const size_t len, const bool last) override;  // decrypts and verifies one chunk
+};
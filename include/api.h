@@ -9,11 +9,16 @@ for full documentation see the documentation of the API class in the documentati
 #include <filesystem>
 #include <iostream>
 
+#include "chainhash_control.h"
 #include "dataheader.h"
+#include "decrypted_reader.h"
 #include "error.h"
 #include "file_data.h"
 #include "filehandler.h"
 #include "logger.h"
+#include "session_cache.h"
+
+class BlockChain;
 
 // struct that is returned by the API if you decode a file
 struct WorkflowDecStruct {
@@ -110,12 +115,39 @@ struct DataHeaderHelperStruct {
     Bytes password_hash = Bytes(0);  // contains the password hash
 };
 
+// the settings of the first chainhash (password -> password hash) of a data header
+// files with equal settings get the same password hash for the same password, so the first chainhash can be shared (VaultManager::unlockAll)
+struct PasswordHashSettings {
+    HModes hash_mode{};    // the hash function of the chainhashes
+    ChainHash chainhash1;  // mode, iterations and data of the first chainhash
+
+    std::string getKey() const {
+        // returns a string that is equal for equal settings
+        return std::to_string(+this->hash_mode) + ":" + std::to_string(+this->chainhash1.getMode()) + ":" + std::to_string(this->chainhash1.getIters()) + ":" +
+               this->chainhash1.getChainHashData()->getDataBlock().toHex();
+    }
+};
+
+// helper struct that describes how the data of a file is split into the encrypted content and the trailer
+// the trailer contains the checkpoint table, the resume state of the last block and the leaf hashes of the integrity tree
+struct DataLayout {
+    unsigned char version = 0;          // the version of the trailer layout (0 if the file has no trailer)
+    u_int64_t checkpoint_interval = 0;  // the number of blocks between two checkpoints (0 if the file has no trailer)
+    u_int64_t content_len = 0;          // the length of the encrypted content
+    u_int64_t content_cap = 0;          // the room of the content in front of the checkpoint table (the content length before trailer version 4)
+    u_int64_t checkpoints = 0;          // the number of checkpoints of the content
+    u_int64_t checkpoint_cap = 0;       // the number of entries in the checkpoint table (the number of checkpoints before trailer version 4)
+    u_int64_t leaf_table_len = 0;       // the length of the leaf hash table at the end of the trailer (with the region hashes since version 4, 0 if it has none)
+};
+
 class API {
     /*
     API class between the front-end and the back-end
     encapsulates the backend implementations
     */
    private:
+    friend class DecryptedReader;  // decrypts the content of the selected file with the password hash of the API
+
     class WorkflowState {
        protected:
         API* parent;
@@ -172,14 +204,26 @@ class API {
         // This call is expensive
         // because it has to hash the password twice. A timeout (in ms) can be specified to limit the time of the call (0 means no timeout)
         // NOTE that if the timeout is reached, the function will return with a TIMEOUT SuccessType, but the password could be valid
-        virtual ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0) noexcept {
+        virtual ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
             return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "verifyPassword is only available in the FILE_SELECTED state"};
         };
+        // takes the password hash of the selected file from the session cache instead of verifying the password (no chainhashes)
+        virtual ErrorStruct<bool> unlockFromSession() noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "unlockFromSession is only available in the FILE_SELECTED state"};
+        };
+        // returns the hash mode and the first chainhash of the selected file
+        virtual ErrorStruct<PasswordHashSettings> getPasswordHashSettings() noexcept {
+            return ErrorStruct<PasswordHashSettings>{FAIL, ERR_API_STATE_INVALID, "getPasswordHashSettings is only available in the FILE_SELECTED state"};
+        };
+        // checks a password hash (the result of the first chainhash) with the second chainhash
+        virtual ErrorStruct<bool> verifyPasswordHash(const Bytes& password_hash, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "verifyPasswordHash is only available in the FILE_SELECTED state"};
+        };
         // creates a data header for a given password and settings by randomizing the salt and chainhash data
         // This call is expensive because it has to chainhash the password twice to generate a validator.
         // A timeout (in ms) can be specified to limit the time of the call (0 means no timeout)
         // you can specify the iterations or the time (the chainhash runs until the time is reached to get the iterations)
-        virtual ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0) noexcept {
+        virtual ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
             return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "createDataHeader is only available in the EMPTY_FILE_SELECTED or DECRYPT state"};
         };
         virtual ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsTime& ds) noexcept {
@@ -195,6 +239,35 @@ class API {
         virtual ErrorStruct<std::unique_ptr<FileDataStruct>> getDecryptedData() noexcept {
             return ErrorStruct<std::unique_ptr<FileDataStruct>>{FAIL, ERR_API_STATE_INVALID, "getDecryptedData is only available in the PASSWORD_VERIFIED state"};
         };
+        // decrypts only the given range (offset and length in Bytes) of the content
+        // starts at the last checkpoint in front of the range if the file has a checkpoint table
+        virtual ErrorStruct<std::unique_ptr<Bytes>> decryptRange(const u_int64_t offset, const u_int64_t len) noexcept {
+            return ErrorStruct<std::unique_ptr<Bytes>>{FAIL, ERR_API_STATE_INVALID, "decryptRange is only available in the PASSWORD_VERIFIED state"};
+        };
+        // creates a reader that decrypts the content chunk by chunk while it is read
+        virtual ErrorStruct<std::unique_ptr<DecryptedReader>> getDecryptedReader(const u_int64_t chunk_len = DECRYPTED_READER_CHUNK_LEN) noexcept {
+            return ErrorStruct<std::unique_ptr<DecryptedReader>>{FAIL, ERR_API_STATE_INVALID, "getDecryptedReader is only available in the PASSWORD_VERIFIED state"};
+        };
+        // appends data to the content of the selected file without re-encrypting the existing content
+        virtual ErrorStruct<bool> appendData(const Bytes& data) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "appendData is only available in the PASSWORD_VERIFIED state"};
+        };
+        // replaces a range of the content of the selected file without re-encrypting the content in front of it
+        virtual ErrorStruct<bool> editData(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "editData is only available in the PASSWORD_VERIFIED state"};
+        };
+        // wraps the data key of the selected file for a new password in a free key slot (only the header is written)
+        virtual ErrorStruct<bool> addPassword(const std::string& password, ChainHashControl* control = nullptr) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "addPassword is only available in the PASSWORD_VERIFIED state"};
+        };
+        // replaces the key slot of a password of the selected file with a new password (only the header is written)
+        virtual ErrorStruct<bool> changePassword(const std::string& old_password, const std::string& new_password, ChainHashControl* control = nullptr) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "changePassword is only available in the PASSWORD_VERIFIED state"};
+        };
+        // frees the key slot of a password of the selected file (only the header is written)
+        virtual ErrorStruct<bool> removePassword(const std::string& password, ChainHashControl* control = nullptr) noexcept {
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "removePassword is only available in the PASSWORD_VERIFIED state"};
+        };
         // gets the file data struct
         // it stores the file mode as well as the decrypted file content
         virtual ErrorStruct<std::unique_ptr<FileDataStruct>> getFileData() noexcept {
@@ -213,7 +286,7 @@ class API {
         };
 
        public:
-        WorkflowState(API* x) : parent(x){};
+        WorkflowState(API* x) : parent(x) { x->generation++; };  // every new state is a new generation of the API
     };
 
     class INIT : public WorkflowState {
@@ -225,13 +298,20 @@ class API {
     };
 
     class FILE_SELECTED : public WorkflowState {
+       private:
+        // performs the second chainhash and changes the state if the password hash is valid
+        ErrorStruct<bool> checkPasswordHash(const DataHeaderParts& dhp, std::shared_ptr<Hash> hash, const Bytes& password_hash, const u_int64_t timeout, ChainHashControl* control) noexcept;
+
        public:
         FILE_SELECTED(API* x) : WorkflowState(x) { PLOG_DEBUG << "API state changed to FILE_SELECTED"; };
         ErrorStruct<bool> isFileEmpty() const noexcept override;
         ErrorStruct<bool> deleteFile() noexcept override;
         ErrorStruct<Bytes> getFileContent() noexcept override;
         ErrorStruct<bool> unselectFile() noexcept override;
-        ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0) noexcept override;
+        ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept override;
+        ErrorStruct<bool> unlockFromSession() noexcept override;
+        ErrorStruct<PasswordHashSettings> getPasswordHashSettings() noexcept override;
+        ErrorStruct<bool> verifyPasswordHash(const Bytes& password_hash, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept override;
     };
 
     class EMPTY_FILE_SELECTED : public WorkflowState {
@@ -241,7 +321,7 @@ class API {
         ErrorStruct<bool> deleteFile() noexcept override;
         ErrorStruct<Bytes> getFileContent() noexcept override;
         ErrorStruct<bool> unselectFile() noexcept override;
-        ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0) noexcept override;
+        ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept override;
         ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsTime& ds) noexcept override;
     };
 
@@ -249,6 +329,13 @@ class API {
        public:
         PASSWORD_VERIFIED(API* x) : WorkflowState(x) { PLOG_DEBUG << "API state changed to PASSWORD_VERIFIED"; };
         ErrorStruct<std::unique_ptr<FileDataStruct>> getDecryptedData() noexcept override;
+        ErrorStruct<std::unique_ptr<Bytes>> decryptRange(const u_int64_t offset, const u_int64_t len) noexcept override;
+        ErrorStruct<std::unique_ptr<DecryptedReader>> getDecryptedReader(const u_int64_t chunk_len = DECRYPTED_READER_CHUNK_LEN) noexcept override;
+        ErrorStruct<bool> appendData(const Bytes& data) noexcept override;
+        ErrorStruct<bool> editData(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data) noexcept override;
+        ErrorStruct<bool> addPassword(const std::string& password, ChainHashControl* control = nullptr) noexcept override;
+        ErrorStruct<bool> changePassword(const std::string& old_password, const std::string& new_password, ChainHashControl* control = nullptr) noexcept override;
+        ErrorStruct<bool> removePassword(const std::string& password, ChainHashControl* control = nullptr) noexcept override;
     };
 
     class DECRYPTED : public WorkflowState {
@@ -257,7 +344,7 @@ class API {
         ErrorStruct<bool> encryptData(std::unique_ptr<FileDataStruct>&& file_data) noexcept override;
         ErrorStruct<std::unique_ptr<FileDataStruct>> getFileData() noexcept override;
         ErrorStruct<bool> changeSalt() noexcept override;
-        ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0) noexcept override;
+        ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept override;
         ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsTime& ds) noexcept override;
     };
 
@@ -283,13 +370,27 @@ class API {
     std::unique_ptr<DataHeader> dh;  // the data header for the correct password
     // stores the handler to the working file
     std::unique_ptr<FileHandler> selected_file;
+    // stores the password hashes of unlocked files for later API objects (can be shared, nullptr disables the session cache)
+    std::shared_ptr<SessionCache> session_cache;
+    // the generation of the API, it only increases (every state transition, file selection and in place change of the content with appendData or editData)
+    // a DecryptedReader fails if the generation changed since it was created
+    u_int64_t generation = 0;
+    // true after the data checksum of the selected file was verified (selectFile only verifies the header checksum)
+    bool data_checksum_verified = false;
 
     // utility functions
     // gets the file handler for the given file path
     ErrorStruct<std::unique_ptr<FileHandler>> _getFileHandler(const std::filesystem::path& file_path) const noexcept;
 
+    // checks the file data mode of the settings and sets the modes and the datablocks that do not depend on the chainhashes
+    // returns false if the header cannot be created (the error is stored in dhhs)
+    bool _setDataHeaderSettings(DataHeaderHelperStruct& dhhs, DataHeaderParts& dhp, const DataHeaderSettingsBase& ds) const noexcept;
+
+    // sets the salt and the key slots after the chainhashes and creates the data header in dhhs (with the content key)
+    void _finishDataHeader(DataHeaderHelperStruct& dhhs, DataHeaderParts& dhp, const Hash& hash, const Bytes& password_hash, const DataHeaderSettingsBase& ds) const noexcept;
+
     // does the most work for creating a new dataheader from DataHeaderSettingsIters
-    DataHeaderHelperStruct _createDataHeaderIters(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0) const noexcept;
+    DataHeaderHelperStruct _createDataHeaderIters(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) const noexcept;
 
     // does the most work for creating a new dataheader from DataHeaderSettingsTime
     DataHeaderHelperStruct _createDataHeaderTime(const std::string& password, const DataHeaderSettingsTime& ds) const noexcept;
@@ -302,9 +403,100 @@ class API {
 
     ErrorStruct<bool> _unselectFile() noexcept;
 
+    // verifies the data checksum of the selected file once, before its data is decrypted for the first time
+    // appends and edits do not need it, they patch the checksum per written chunk, so a mismatch of the other chunks is kept
+    ErrorStruct<bool> _verifyDataChecksum() noexcept;
+
+    // stores the password hash for the given file and the current data header in the session cache (if the API has one)
+    void _storeSession(const std::filesystem::path& file_path) const noexcept;
+
+    // gets the layout of the data of the selected file (encrypted content and trailer)
+    DataLayout _getDataLayout() const;
+
+    // gets the number of blocks between two checkpoints for the block format of the data header
+    u_int64_t _getCheckpointInterval() const;
+
+    // gets the number of checkpoints of a content with the given length
+    u_int64_t _getCheckpointCount(const u_int64_t content_len, const u_int64_t checkpoint_interval) const;
+
+    // gets the capacity a content with the given length gets when the trailer is laid out (the content length and the room to grow)
+    u_int64_t _getContentCapacity(const u_int64_t content_len) const;
+
+    // checks if the index datablock has the trailer layout of a version up to TRAILER_VERSION (files of other versions are not selected)
+    static bool _isTrailerVersionValid(const DataBlock& index) noexcept;
+
+    // stores TRAILER_VERSION, the checkpoint interval, the content length and capacity and the leaf table length in the index datablock of the data header
+    void _setIndexDataBlock(const u_int64_t checkpoint_interval, const u_int64_t content_len, const u_int64_t content_cap, const u_int64_t leaf_table_len);
+
+    // recalculates the integrity tree over the given encrypted data (the data of the file without the header) if the data header has one
+    void _setIntegrityDataBlock(const unsigned char* data, const u_int64_t data_len);
+
+    // sets the integrity tree of the data header from the leaf hashes of the data and returns the leaf hash table (with the region hashes) for the trailer
+    Bytes _setLeafTable(const std::vector<Bytes>& leaves, const u_int64_t data_len);
+
+    // updates the integrity tree of the data header for the writes (offsets in the data of the selected file) that do not change the data length
+    // the new leaf and region hashes are added to the writes, hashes owns them
+    void _patchIntegrityTree(std::vector<JournalWrite>& writes, std::vector<Bytes>& hashes, const DataLayout& layout);
+
+    // returns the data checksum after the writes (offsets in the data of the selected file) that do not change the data length
+    u_int64_t _patchDataChecksum(const std::vector<JournalWrite>& writes, u_int64_t data_checksum) const;
+
+    // adds the KEYSLOT datablocks for a new header to the parts, the password gets the first slot and the others are free
+    // returns the random data key that is wrapped by the slots (the content key of the header)
+    static Bytes _createKeySlots(DataHeaderParts& dhp, const Hash& hash, const Bytes& password_hash, const u_int64_t slot_count);
+
+    // performs both chainhashes of the selected data header on the password and returns the validator of its key slot
+    // the password hash (result of the first chainhash) is stored in password_hash
+    ErrorStruct<Bytes> _getKeySlotValidator(const std::string& password, Bytes& password_hash, ChainHashControl* control) const noexcept;
+
+    // replaces the key slots of the data header and writes only the header of the selected file again
+    // the datablocks keep their length, the content and its data key do not change
+    ErrorStruct<bool> _writeKeySlots(const std::vector<KeySlot>& slots);
+
+    // replaces remove_len Bytes at offset of the content of the selected file with data
+    // only the blocks from the last checkpoint in front of the first changed block to the end, the changed trailer entries and the header are written
+    // the chain is reseeded there, so the changed blocks get new salts (edits in front of the first checkpoint encrypt the whole content again)
+    // a content that does not fit into its capacity is laid out again
+    ErrorStruct<bool> _editContent(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data);
+
+    // encrypts the content of the selected file again with a new encrypted salt and writes the whole file (through the journal of the file)
+    ErrorStruct<bool> _rewriteContent(const Bytes& content);
+
+    // encrypts the content with one blockchain and returns it laid out with the trailer (see _layoutData)
+    std::unique_ptr<Bytes> _encryptChain(const Bytes& content);
+
+    // returns the data of a file with the encrypted content and the trailer, the index (and integrity) datablock describes the new layout
+    std::unique_ptr<Bytes> _layoutData(std::unique_ptr<Bytes>&& content, const Bytes& checkpoint_table, const Bytes& resume_state, const u_int64_t checkpoint_interval);
+
+    // replaces the data of the selected file, the header and the data are written through the journal of the file
+    ErrorStruct<bool> _writeData(const Bytes& data);
+
+    // gives the chain the stored checkpoint states of the selected file for the content from start to end (the chain continues with them)
+    void _setCheckpointStates(BlockChain& bc, const DataLayout& layout, const u_int64_t start, const u_int64_t end) const;
+
+    // adds a part of the encrypted content of the selected file to the chain (BlockChain or AEADChain, reads from a file mapping if possible)
+    template <typename Chain>
+    void _addFileData(Chain& bc, const u_int64_t start, const u_int64_t len) const;
+
+    // reads a part of the encrypted content of the selected file
+    Bytes _readFileData(const u_int64_t start, const u_int64_t len) const;
+
+    // encrypts the content shard by shard, the shards are encrypted in parallel
+    std::unique_ptr<Bytes> _encryptShards(const Bytes& data, const ShardLayout& shards) const;
+
+    // decrypts len Bytes at offset of the sharded content of the selected file, the overlapping shards are decrypted in parallel
+    std::unique_ptr<Bytes> _decryptShards(const u_int64_t offset, const u_int64_t len) const;
+
+    // encrypts the content with the AEAD cipher mode of the cipher format, groups of chunks are encrypted in parallel
+    std::unique_ptr<Bytes> _encryptAEAD(const Bytes& data, const CipherFormat& cipher) const;
+
+    // decrypts and verifies len Bytes at offset of the AEAD encrypted content of the selected file, the overlapping chunks are decrypted in parallel
+    std::unique_ptr<Bytes> _decryptAEAD(const u_int64_t offset, const u_int64_t len) const;
+
    public:
     // constructs the api with the file mode that should be worked with
-    API(const FModes file_mode);
+    // API objects that share a session cache can unlock a file without the password after it was unlocked once (until the session expires)
+    API(const FModes file_mode, std::shared_ptr<SessionCache> session_cache = nullptr);
 
     // WORK
     // //*************** WORKFLOW 1 *****************
@@ -383,22 +575,51 @@ class API {
     // This call is expensive
     // because it has to hash the password twice. A timeout (in ms) can be specified to limit the time of the call (0 means no timeout)
     // NOTE that if the timeout is reached, the function will return with a TIMEOUT SuccessType, but the password could be valid
-    ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0) noexcept {
+    // a control reports the progress (iterations of both chainhashes) and can cancel the call from another thread (returns ERR_CANCELLED)
+    ErrorStruct<bool> verifyPassword(const std::string& password, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
         PLOG_DEBUG << "API call made (verifyPassword) with timeout: " << timeout;
-        return this->current_state->verifyPassword(password, timeout);
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "verifyPassword was cancelled before it started"};
+        return this->current_state->verifyPassword(password, timeout, control);
+    }
+
+    // only call this function on non empty files
+    // unlocks the selected file with the password hash from the session cache (stored by an earlier verifyPassword or writeToFile)
+    // this call is cheap, it fails with ERR_SESSION_NOT_FOUND if the API has no session cache or the session expired, use verifyPassword then
+    ErrorStruct<bool> unlockFromSession() noexcept {
+        PLOG_DEBUG << "API call made (unlockFromSession)";
+        return this->current_state->unlockFromSession();
+    }
+
+    // only call this function on non empty files
+    // returns the settings of the first chainhash (password -> password hash) of the selected file
+    // files with equal settings (getKey()) get the same password hash for the same password
+    ErrorStruct<PasswordHashSettings> getPasswordHashSettings() noexcept {
+        PLOG_DEBUG << "API call made (getPasswordHashSettings)";
+        return this->current_state->getPasswordHashSettings();
+    }
+
+    // only call this function on non empty files
+    // verifies a password hash that was calculated with the first chainhash of getPasswordHashSettings (e.g. for another file with equal settings)
+    // only the second chainhash is done, otherwise it works like verifyPassword
+    ErrorStruct<bool> verifyPasswordHash(const Bytes& password_hash, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
+        PLOG_DEBUG << "API call made (verifyPasswordHash) with timeout: " << timeout;
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "verifyPasswordHash was cancelled before it started"};
+        return this->current_state->verifyPasswordHash(password_hash, timeout, control);
     }
 
     // creates a data header for a given password and settings by randomizing the salt and chainhash data
     // This call is expensive because it has to chainhash the password twice to generate a validator.
     // A timeout (in ms) can be specified to limit the time of the call (0 means no timeout)
     // you can specify the iterations or the time (the chainhash runs until the time is reached to get the iterations)
-    ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0) noexcept {
+    // a control reports the progress and can cancel the call from another thread (returns ERR_CANCELLED), only with iterations
+    ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0, ChainHashControl* control = nullptr) noexcept {
         if (!ds.isComplete()) {
             PLOG_ERROR << "API call made (createDataHeader) with incomplete DataHeaderSettingsIters";
             return ErrorStruct<bool>{FAIL, ERR_DATAHEADERSETTINGS_INCOMPLETE, "API call made (createDataHeader) with incomplete DataHeaderSettingsIters"};
         }
         PLOG_DEBUG << "API call made (createDataHeader) with timeout: " << timeout << " and Iterations: " << ds.getChainHash1Iters() << " and " << ds.getChainHash2Iters();
-        return this->current_state->createDataHeader(password, ds, timeout);
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "createDataHeader was cancelled before it started"};
+        return this->current_state->createDataHeader(password, ds, timeout, control);
     }
     ErrorStruct<bool> createDataHeader(const std::string& password, const DataHeaderSettingsTime& ds) noexcept {
         if (!ds.isComplete()) {
@@ -424,6 +645,65 @@ class API {
         return this->current_state->getDecryptedData();
     }
 
+    // decrypts only the given range of the content (requires successful verifyPassword run)
+    // offset and len are in Bytes of the decrypted content, the state is not changed
+    // files with a checkpoint table are decrypted from the last checkpoint in front of the range
+    ErrorStruct<std::unique_ptr<Bytes>> decryptRange(const u_int64_t offset, const u_int64_t len) noexcept {
+        PLOG_DEBUG << "API call made (decryptRange) with offset: " << offset << " and len: " << len;
+        return this->current_state->decryptRange(offset, len);
+    }
+
+    // creates a reader over the decrypted content (requires successful verifyPassword run), the state is not changed
+    // every DecryptedReader::next() decrypts the next chunk of chunk_len Bytes (rounded up to whole blocks), so the first Bytes are
+    // available early and the memory is bounded by one chunk, the reader can be dropped at any point
+    // the API has to outlive the reader, appendData, editData and a state change invalidate it
+    ErrorStruct<std::unique_ptr<DecryptedReader>> getDecryptedReader(const u_int64_t chunk_len = DECRYPTED_READER_CHUNK_LEN) noexcept {
+        PLOG_DEBUG << "API call made (getDecryptedReader) with chunk_len: " << chunk_len;
+        return this->current_state->getDecryptedReader(chunk_len);
+    }
+
+    // appends data to the content of the selected file (requires successful verifyPassword run)
+    // only the last (partial) block and the trailer are rewritten, the existing content is not re-encrypted
+    // the file is updated in place and stays selected
+    ErrorStruct<bool> appendData(const Bytes& data) noexcept {
+        PLOG_DEBUG << "API call made (appendData) with data len: " << data.getLen();
+        return this->current_state->appendData(data);
+    }
+
+    // replaces remove_len Bytes at offset of the content of the selected file with data (requires successful verifyPassword run)
+    // the blocks in front of the first changed block keep their encrypted Bytes, only the suffix is encrypted and written again
+    // editing near the end of a large file therefore costs time proportional to the tail, the file stays selected
+    ErrorStruct<bool> editData(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data) noexcept {
+        PLOG_DEBUG << "API call made (editData) with offset: " << offset << ", remove_len: " << remove_len << ", data len: " << data.getLen();
+        return this->current_state->editData(offset, remove_len, data);
+    }
+
+    // adds a password to the selected file (requires successful verifyPassword run, the file needs key slots, see DataHeaderSettingsIters::setKeySlotCount)
+    // the data key of the content is wrapped for the password in a free key slot, only the header is written (the content is not encrypted again)
+    // the password is chainhashed with the chainhash settings of the header (expensive), a control reports the progress and can cancel the call
+    ErrorStruct<bool> addPassword(const std::string& password, ChainHashControl* control = nullptr) noexcept {
+        PLOG_DEBUG << "API call made (addPassword)";
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "addPassword was cancelled before it started"};
+        return this->current_state->addPassword(password, control);
+    }
+
+    // replaces old_password of the selected file with new_password (requires successful verifyPassword run, the file needs key slots)
+    // only the key slot of old_password is rewritten, so the time does not depend on the size of the content
+    // both passwords are chainhashed (expensive), a control reports the progress and can cancel the call
+    ErrorStruct<bool> changePassword(const std::string& old_password, const std::string& new_password, ChainHashControl* control = nullptr) noexcept {
+        PLOG_DEBUG << "API call made (changePassword)";
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "changePassword was cancelled before it started"};
+        return this->current_state->changePassword(old_password, new_password, control);
+    }
+
+    // removes a password from the selected file (requires successful verifyPassword run, the file needs key slots)
+    // the key slot of the password is freed, the last password of the file cannot be removed (ERR_KEYSLOT_LAST)
+    ErrorStruct<bool> removePassword(const std::string& password, ChainHashControl* control = nullptr) noexcept {
+        PLOG_DEBUG << "API call made (removePassword)";
+        if (control != nullptr && control->isCancelled()) return ErrorStruct<bool>{FAIL, ERR_CANCELLED, "removePassword was cancelled before it started"};
+        return this->current_state->removePassword(password, control);
+    }
+
     // gets the file data struct
     // it stores the file mode as well as the decrypted file content
     ErrorStruct<std::unique_ptr<FileDataStruct>> getFileData() noexcept {
@@ -22,6 +22,13 @@ enum HModes {
     HASHMODE_SHA512,      // sha512 hashmode
 };
 
+// enum which holds the cipher modes (how the content is encrypted)
+enum CModes {
+    CIPHERMODE_HASHCHAIN = 1,     // hash chain block cipher (BlockChain)
+    CIPHERMODE_AES256GCM,         // AES-256-GCM chunks (AEADChain)
+    CIPHERMODE_CHACHA20POLY1305,  // ChaCha20-Poly1305 chunks (AEADChain)
+};
+
 // enum which holds the file data modes
 enum FModes {
     FILEMODE_PASSWORD = 1,  // password filemode
@@ -37,6 +44,12 @@ enum DatablockType {
     FILEEXTENSION,  // fileextension datablock type
     INDEX,          // index datablock type
     TIMESTAMP,      // timestamp datablock type
+    BLOCKFORMAT,    // block format datablock type (version and block length of the keystream block format)
+    SHARDS,         // shard layout datablock type (number and length of the independent chains)
+    CIPHER,         // cipher datablock type (cipher mode, chunk length and key salt of the AEAD cipher modes)
+    INTEGRITY,      // integrity datablock type (leaf length, root and region hashes of the hash tree over the encrypted data)
+    CHECKSUM,       // checksum datablock type (keyless checksum over the header and the encrypted data)
+    KEYSLOT,        // key slot datablock type (validator and wrapped data key of one password, all zero if the slot is free)
 };
 
 // struct that is used as an data package between format and other classes
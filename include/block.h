@@ -8,6 +8,8 @@ class Block {
     /*
     the abstract block class represents one block of the blockchain
     one block has a fixed length and a salt that is used to encrypt/decrypt the input data
+    in the legacy format the block length is the hash size and the salt is used directly
+    in the keystream format the salt is expanded with a counter-mode hash to the (larger) block length
     new data is pushed into the block with addData
     that should be implemented in the derived class
     if the block is completed (the data member is full) the result can be retrieved with getResult
@@ -26,8 +28,13 @@ class Block {
     // creates a block with a length and a salt that is used to encrypt input data
     // requires a Hash to calculate the block hash of the decrypted data if necessary (save memory)
     Block(std::shared_ptr<Hash> hash, const Bytes& salt);
+    // creates a block of the keystream format, the salt is expanded to a keystream of block_len Bytes
+    Block(std::shared_ptr<Hash> hash, const Bytes& salt, const size_t block_len);
+    // expands the salt with a counter-mode hash: H(salt + counter) for every hash sized part of the keystream
+    static Bytes expandSalt(const Hash& hash, const Bytes& salt, const size_t len);
     size_t getFreeSpace() const noexcept;          // returns the available space in the block
     virtual void addData(const Bytes& data) = 0;   // adds new data to the block (this data is encrypted/decrypted with the salt)
+    virtual void addData(const unsigned char* data, const size_t len) = 0;  // adds new data from a raw buffer to the block (no intermediate Bytes copy)
     virtual Bytes getResult() const noexcept = 0;  // getter for the result data
     Bytes getHash() const;                         // getter for the block hash of the decrypted data (block has to be completed)
 
@@ -9,6 +9,8 @@ class EncryptBlock : public Block {
     */
    public:
     EncryptBlock(std::shared_ptr<Hash> hash, const Bytes& salt) : Block(std::move(hash), salt){};
+    EncryptBlock(std::shared_ptr<Hash> hash, const Bytes& salt, const size_t block_len) : Block(std::move(hash), salt, block_len){};
     void addData(const Bytes& dec_data) override;  // adds new data to the block (this data is encrypted with the salt)
+    void addData(const unsigned char* dec_data, const size_t len) override;  // adds new data from a raw buffer to the block
     Bytes getResult() const noexcept override;     // getter for the result data
 };
\ No newline at end of file
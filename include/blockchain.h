@@ -1,7 +1,11 @@
 #pragma once
+#include <array>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include "block.h"
+#include "fixed_block.h"
 #include "hash.h"
 #include "logger.h"
 
@@ -32,10 +36,12 @@ class BlockChain {
         the SaltIterator class is used to generate the salts for the blocks
         it is initialized with the password hash and the encrypted salt
         for every block it generates a new salt with the hash of the last block
+        this is the generic iterator for every hash function, FixedSaltIterator replaces it for the known hash sizes
         */
-       private:
+       protected:
         bool ready;     // is the iterator ready to generate salts
         bool first;     // is this the first salt/block
+        bool resumed;   // was the state restored from a checkpoint (next salt is derived from the state only)
         Bytes hash{0};  // the current hash (first is the passwordhash)
         Bytes salt{0};  // the current salt (first is the encrypted salt)
        public:
@@ -46,8 +52,10 @@ class BlockChain {
             // not ready yet, has to be initialized first (with init)
             this->ready = false;
             this->first = true;
+            this->resumed = false;
         }
-        void init(const Bytes& pwhash, const Bytes& enc_salt, std::shared_ptr<Hash> hashObj) {
+        virtual ~SaltIterator() = default;
+        virtual void init(const Bytes& pwhash, const Bytes& enc_salt, std::shared_ptr<Hash> hashObj) {
             // initializes the iterator with the password hash and the encrypted salt
             if (hashObj == nullptr) {
                 PLOG_FATAL << "given hash object is nullptr";
@@ -66,8 +74,36 @@ class BlockChain {
             this->salt = enc_salt;
             this->hashObj = std::move(hashObj);
         }
-        Bytes next(Bytes last_block_hash = Bytes(255)) {
+        virtual Bytes getState() const {
+            // returns the current state (hash and salt) that is needed to continue the iteration at this point
+            Bytes state(2 * this->hashObj->getHashSize());
+            this->hash.addcopyToBytes(state);
+            this->salt.addcopyToBytes(state);
+            return state;
+        }
+        virtual void setState(const Bytes& state) {
+            // restores a state that was returned by getState after the salt for a block was generated
+            // the following next call returns the salt of that block again
+            if (!this->ready) {
+                PLOG_FATAL << "SaltIterator is not ready, call init first";
+                throw std::runtime_error("SaltIterator is not ready, call init first");
+            }
+            if (state.getLen() != 2 * this->hashObj->getHashSize()) {
+                PLOG_FATAL << "state has to be twice the size of the hash (state_len: " << state.getLen() << ", hash_size: " << this->hashObj->getHashSize() << ")";
+                throw std::invalid_argument("state has to be twice the size of the hash");
+            }
+            this->hash = state.copySubBytes(0, this->hashObj->getHashSize());
+            this->salt = state.copySubBytes(this->hashObj->getHashSize(), state.getLen());
+            this->first = false;
+            this->resumed = true;
+        }
+        virtual Bytes next(Bytes last_block_hash = Bytes(255)) {
             // generates the next salt with the last block hash
+            if (this->resumed) {
+                // the state belongs to the block that is generated now, the last block hash is not needed
+                this->resumed = false;
+                return this->hashObj->hash(this->hash + this->salt);
+            }
             if (this->first) {
                 // if this is the first block, the last_block_hash is set to 0
                 first = false;
@@ -94,21 +130,124 @@ class BlockChain {
             return this->hashObj->hash(this->hash + this->salt);
         }
     };
+
+    template <size_t HS>
+    class FixedSaltIterator : public SaltIterator {
+        /*
+        the FixedSaltIterator class generates the same salts as the SaltIterator for a hash size that is known at compile time
+        the sizes are checked once in init, the state is kept in arrays and the hashes are calculated on stack buffers
+        the raw next call is used by the blockchain for complete legacy format blocks, the Bytes calls stay available for the other blocks
+        */
+       private:
+        using Array = std::array<unsigned char, HS>;
+        Array fixed_hash{};  // the current hash (first is the passwordhash)
+        Array fixed_salt{};  // the current salt (first is the encrypted salt)
+
+       public:
+        void init(const Bytes& pwhash, const Bytes& enc_salt, std::shared_ptr<Hash> hashObj) override {
+            // checks the sizes once and copies the password hash and the encrypted salt into the arrays
+            SaltIterator::init(pwhash, enc_salt, std::move(hashObj));
+            if (this->hashObj->getHashSize() != HS || !FixedBlock<HS>::matches(*this->hashObj)) {
+                PLOG_FATAL << "the hash function does not match with the fixed hash size (hash_size: " << this->hashObj->getHashSize() << ", fixed_hash_size: " << HS << ")";
+                throw std::invalid_argument("the hash function does not match with the fixed hash size");
+            }
+            pwhash.copyToArray(this->fixed_hash.data(), HS);
+            enc_salt.copyToArray(this->fixed_salt.data(), HS);
+        }
+        Bytes getState() const override {
+            // returns the current state (hash and salt) that is needed to continue the iteration at this point
+            Bytes state(2 * HS);
+            state.addBytes(this->fixed_hash.data(), HS);
+            state.addBytes(this->fixed_salt.data(), HS);
+            return state;
+        }
+        void setState(const Bytes& state) override {
+            // restores a state that was returned by getState after the salt for a block was generated
+            SaltIterator::setState(state);
+            std::memcpy(this->fixed_hash.data(), state.getBytes(), HS);
+            std::memcpy(this->fixed_salt.data(), state.getBytes() + HS, HS);
+        }
+        Bytes next(Bytes last_block_hash = Bytes(255)) override {
+            // generates the next salt with the last block hash
+            if (!this->first && !this->resumed && last_block_hash.getLen() != HS) {
+                PLOG_FATAL << "last_block_hash has to be the same size as the hash from the hash function (last_block_hash_len: " << last_block_hash.getLen() << ", hash_size: " << HS << ")";
+                throw std::invalid_argument("last_block_hash has to be the same size as the hash");
+            }
+            Array salt;
+            this->next(last_block_hash.getBytes(), salt);
+            Bytes ret(HS);
+            ret.addBytes(salt.data(), HS);
+            return ret;
+        }
+        void next(const unsigned char* last_block_hash, Array& next_salt) noexcept {
+            // generates the next salt with the last block hash (HS Bytes, ignored for the first block and for resumed states)
+            // the inputs are the elementwise sums (mod 256) of hash, salt and last block hash, as in the SaltIterator
+            Array input;
+            if (this->resumed) {
+                // the state belongs to the block that is generated now, the last block hash is not needed
+                this->resumed = false;
+                for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i];
+                FixedHash<HS>::hash(input.data(), HS, next_salt.data());
+                return;
+            }
+            if (this->first) {
+                // the last block hash of the first block is 0
+                this->first = false;
+                for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i];
+                FixedHash<HS>::hash(input.data(), HS, this->fixed_hash.data());
+                for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i];
+            } else {
+                for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i] + last_block_hash[i];
+                FixedHash<HS>::hash(input.data(), HS, this->fixed_hash.data());
+                for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i] + last_block_hash[i];
+            }
+            FixedHash<HS>::hash(input.data(), HS, this->fixed_salt.data());
+            for (size_t i = 0; i < HS; i++) input[i] = this->fixed_hash[i] + this->fixed_salt[i];
+            FixedHash<HS>::hash(input.data(), HS, next_salt.data());
+        }
+    };
+
     std::unique_ptr<Block> current_block = nullptr;  // the current block that is being filled
     std::unique_ptr<Bytes> result = nullptr;         // the result data of the blockchain
-    SaltIterator salt_iter;                          // the salt iterator that is used to generate the salts
+    std::unique_ptr<SaltIterator> salt_iter;         // the salt iterator that is used to generate the salts (fixed variant for the known hash sizes)
+    // encrypts/decrypts complete legacy format blocks with the fixed variants (chosen once for the hash size, nullptr if there is none)
+    void (BlockChain::*add_fixed_blocks)(const unsigned char* data, size_t& written, const size_t data_len) = nullptr;
     size_t hash_size;                                // the byte size of the hash function
+    size_t block_len;                                // the byte size of one block (the hash size in the legacy format)
+    bool keystream;                                  // are the block salts expanded to a keystream (keystream block format)
     size_t chain_height = 0;                         // the height of the chain
+    size_t checkpoint_interval = 0;                  // the number of blocks between two checkpoints (0 means no checkpoints are recorded)
+    std::vector<Bytes> checkpoints;                  // the encrypted salt iterator states of every checkpoint block (starting at getFirstCheckpointIndex)
+    size_t resume_block = 0;                         // the block the chain was resumed at (0 if it starts at the beginning)
+    Bytes stored_checkpoints{0};                     // the encrypted states the chain continues with at their checkpoint blocks (see setCheckpointStates)
+    size_t stored_first = 0;                         // the index of the first checkpoint in stored_checkpoints
+    size_t stored_interval = 0;                      // the number of blocks between two stored checkpoints (0 if there are none)
+    Bytes state_key{0};                              // the password hash and encrypted salt, used to derive the keys for the encrypted states
 
    protected:
     // adds a new block to the chain
-    virtual bool addBlock() = 0;
+    bool addBlock();
+    // creates a new EncryptBlock/DecryptBlock with the salt (in the keystream format if it is selected)
+    virtual std::unique_ptr<Block> createBlock(const Bytes& salt) const = 0;
+    // returns true if the chain encrypts data (false if it decrypts)
+    virtual bool isEncrypting() const noexcept = 0;
+    // encrypts/decrypts the complete blocks behind the (completed) current block without creating Block objects
+    // stops in front of the last block of the data and sets a new current block for it
+    template <size_t HS>
+    void addFixedBlocks(const unsigned char* data, size_t& written, const size_t data_len);
     // returns the free space in the last block
-    unsigned char getFreeSpaceInLastBlock() const noexcept;
+    size_t getFreeSpaceInLastBlock() const noexcept;
+    // records the salt iterator state if the newest block is a checkpoint block (has to be called after every salt generation)
+    void addCheckpoint();
+    // continues with the stored state if the next block is a stored checkpoint block (has to be called before every salt generation)
+    void loadCheckpoint();
+    // returns the key that encrypts the salt iterator state of the given block
+    Bytes getStateKey(const size_t block_index) const;
 
    public:
     // creates a new empty blockchain with the hash function, the password hash and the encrypted salt
-    BlockChain(std::shared_ptr<Hash> hash, const Bytes& passwordhash, const Bytes& enc_salt);
+    // block_len selects the keystream block format with blocks of that length, 0 keeps the legacy format (blocks of hash size)
+    BlockChain(std::shared_ptr<Hash> hash, const Bytes& passwordhash, const Bytes& enc_salt, const size_t block_len = 0);
     BlockChain(const BlockChain&) = delete;
     BlockChain& operator=(const BlockChain&) = delete;
     BlockChain() = delete;
@@ -117,13 +256,42 @@ class BlockChain {
     void addData(const Bytes& data);
     void addData(std::ifstream&& filestream, const size_t stream_len);
     void addData(std::unique_ptr<Bytes>&& data);
+    void addData(const unsigned char* data, const size_t data_len);  // consumes a raw buffer (e.g. a file mapping) without intermediate copies
 
     // returns the result data of the blockchain
     std::unique_ptr<Bytes> getResult();
 
+    // records a checkpoint every interval blocks, has to be set before data is added
+    void setCheckpointInterval(const size_t interval);
+    // returns the recorded checkpoints (encrypted) as one table, checkpoint i belongs to block (i+1)*interval
+    // the table starts at the checkpoint with the index getFirstCheckpointIndex
+    std::unique_ptr<Bytes> getCheckpointTable() const;
+    // returns the index of the first checkpoint that is recorded by this chain (not 0 for resumed chains)
+    size_t getFirstCheckpointIndex() const noexcept;
+    // returns the length of one encrypted salt iterator state (checkpoint or resume state)
+    size_t getStateLen() const noexcept { return 2 * this->hash_size; };
+    // returns the encrypted salt iterator state of the last block, the chain can be continued with it
+    Bytes getResumeState() const;
+    // continues the chain at the given block with an encrypted state of that block (checkpoint or resume state)
+    // the data that is added next has to start at this block
+    void resumeFromState(const Bytes& enc_state, const size_t block_index);
+    // continues the chain at the given block with a random state, the blocks from there on get new salts although the blocks in front of them did not change
+    // the state is recorded as the checkpoint of the block, so block_index has to be a checkpoint block
+    void reseed(const size_t block_index);
+    // the chain continues with the given encrypted states at their checkpoint blocks instead of the states that follow from the blocks in front of them
+    // these are the checkpoints of a file whose chain was reseeded at some of them, the table starts at the checkpoint with the index first_index
+    void setCheckpointStates(const Bytes& table, const size_t first_index, const size_t interval);
+
+    // derives the encrypted salt of one shard (independent chain) from the encrypted salt of the file
+    // the hash input (enc_salt, shard index, shard count) is longer than the keystream inputs, so the salts do not collide with them
+    static Bytes getShardSalt(const Hash& hash, const Bytes& enc_salt, const u_int64_t shard, const u_int64_t shard_count);
+
+    // returns the byte size of one block
+    size_t getBlockLen() const noexcept { return this->block_len; };
+
     // returns the number of blocks in the chain
     size_t getHeight() const noexcept { return this->chain_height; };
 
     // returns the size of the data in the chain (in Bytes)
-    size_t getDataSize() const noexcept { return this->getHeight() * this->hash_size - this->getFreeSpaceInLastBlock(); };
+    size_t getDataSize() const noexcept { return this->getHeight() * this->block_len - this->getFreeSpaceInLastBlock(); };
 };
\ No newline at end of file
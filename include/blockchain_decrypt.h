@@ -9,10 +9,11 @@ class DecryptBlockChain : public BlockChain {
     it is used to decrypt data, its one type of BlockChain
     */
    public:
-    DecryptBlockChain(std::unique_ptr<Hash>&& hash, const Bytes& passwordhash, const Bytes& enc_salt) : BlockChain(std::move(hash), passwordhash, enc_salt) {
+    DecryptBlockChain(std::unique_ptr<Hash>&& hash, const Bytes& passwordhash, const Bytes& enc_salt, const size_t block_len = 0) : BlockChain(std::move(hash), passwordhash, enc_salt, block_len) {
         PLOG_VERBOSE << "created new DecryptBlockChain";
     };
 
    protected:
-    bool addBlock() override;  // adds a new DecryptBlock to the chain
+    std::unique_ptr<Block> createBlock(const Bytes& salt) const override;  // creates a new DecryptBlock
+    bool isEncrypting() const noexcept override { return false; };         // the chain decrypts data
 };
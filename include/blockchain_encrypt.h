@@ -9,10 +9,11 @@ class EncryptBlockChain : public BlockChain {
     it is used to encrypt data, its one type of BlockChain
     */
    public:
-    EncryptBlockChain(std::unique_ptr<Hash>&& hash, const Bytes& passwordhash, const Bytes& enc_salt) : BlockChain(std::move(hash), passwordhash, enc_salt) {
+    EncryptBlockChain(std::unique_ptr<Hash>&& hash, const Bytes& passwordhash, const Bytes& enc_salt, const size_t block_len = 0) : BlockChain(std::move(hash), passwordhash, enc_salt, block_len) {
         PLOG_VERBOSE << "created new EncryptBlockChain";
     };
 
    protected:
-    bool addBlock() override;  // adds a new EncryptBlocks to the chain
+    std::unique_ptr<Block> createBlock(const Bytes& salt) const override;  // creates a new EncryptBlock
+    bool isEncrypting() const noexcept override { return true; };          // the chain encrypts data
 };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include "settings.h"
+
+class ChainHashControl {
+    /*
+    the ChainHashControl is shared between the caller and a running chainhash (e.g. verifyPassword or createDataHeader on a worker thread)
+    the chainhash reports the number of iterations it has done and stops with ERR_CANCELLED after cancel() was called
+    both are checked every TIMEOUT_ITERATIONS iterations (like the timeout)
+    the getters and cancel() can be called from any thread, the other methods are only used by the thread that runs the chainhash
+    */
+   private:
+    std::atomic<bool> cancelled{false};  // stops the running chainhash
+    std::atomic<u_int64_t> done{0};      // the iterations done by all chainhashes of the operation
+    std::atomic<u_int64_t> total{0};     // the iterations of all chainhashes of the operation
+    u_int64_t offset = 0;                // the iterations of the finished chainhashes
+
+   public:
+    ChainHashControl() noexcept = default;
+    ChainHashControl(const ChainHashControl&) = delete;
+    ChainHashControl& operator=(const ChainHashControl&) = delete;
+
+    void cancel() noexcept { this->cancelled = true; }                       // the running chainhash stops at its next check
+    bool isCancelled() const noexcept { return this->cancelled; }            // true after cancel() was called
+    u_int64_t getDone() const noexcept { return this->done; }                // returns the iterations that are done
+    u_int64_t getTotal() const noexcept { return this->total; }              // returns the iterations of the operation (0 if it was not started yet)
+    double getProgress() const noexcept {
+        // returns the fraction of the iterations that are done (between 0 and 1)
+        u_int64_t total = this->total;
+        return total == 0 ? 0 : static_cast<double>(std::min<u_int64_t>(this->done, total)) / total;
+    }
+
+    void start(const u_int64_t total) noexcept {
+        // starts an operation with the given number of iterations (a cancel() before the start is kept)
+        this->offset = 0;
+        this->done = 0;
+        this->total = total;
+    }
+    void report(const u_int64_t iterations) noexcept { this->done = this->offset + iterations; }  // the running chainhash has done the iterations
+    void finishChainHash(const u_int64_t iterations) noexcept {
+        // a chainhash with the given iterations is done, the next one continues the progress
+        this->offset += iterations;
+        this->done = this->offset;
+    }
+};
@@ -28,8 +28,8 @@ class ChainHashData {
 
     // gets the number of gotten parts
     unsigned char getPartsNumber() const noexcept;
-    // gets one Bytes object that is a concatenation of all byte parts, throws if not complete
-    Bytes getDataBlock() const;
+    // gets one Bytes object that is a concatenation of all byte parts (without copying it), throws if not complete
+    const Bytes& getDataBlock() const;
     // gets the bytes for a given part name, throws if the part name is not found (or set)
     Bytes getPart(const std::string& data_name) const;
 
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "base.h"
+#include "chainhash_control.h"
 #include "chainhash_data.h"
 #include "error.h"
 #include "hash.h"
@@ -27,8 +28,9 @@ class ChainHashModes {
     static bool isModeValid(const CHModes& chainhash_mode) noexcept;  // checks if the given chain hash mode is valid
     // two methods for actually performing the chainhash, one for Bytes input and one for string input
     // expensive methods, you can set an timeout (in ms). 0 means no timeout.
-    static ErrorStruct<Bytes> performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const Bytes& data, const u_int64_t timeout = 0);
-    static ErrorStruct<Bytes> performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const std::string& data, const u_int64_t timeout = 0);
+    // a control reports the progress and can cancel the chainhash (nullptr means no control)
+    static ErrorStruct<Bytes> performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const Bytes& data, const u_int64_t timeout = 0, ChainHashControl* control = nullptr);
+    static ErrorStruct<Bytes> performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const std::string& data, const u_int64_t timeout = 0, ChainHashControl* control = nullptr);
     // two other methods for actually performing the chainhash, one for Bytes input and one for string input
     // these methods use a runtime instead of iterations and are returning a ChainHash
     static ErrorStruct<ChainHashResult> performChainHash(const ChainHashTimed& chainh, std::shared_ptr<Hash> hash, const Bytes& data);
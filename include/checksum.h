@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+
+#include <utility>
+#include <vector>
+
+class Checksum {
+    /*
+    the Checksum class calculates xxHash64 over data that is added in parts
+    it is a fast keyless checksum that detects damaged or partially written files before the chainhashes run
+    it does NOT protect against manipulation, everyone can calculate it
+
+    a file stores two checksums: one over the header and one over the data behind the header
+    the data checksum is the sum (mod 2^64) of the checksums of its CHECKSUM_CHUNK_LEN chunks, every chunk is hashed with its index as the seed
+    so a write that replaces the data from some offset to the end only hashes the old and the new Bytes of the chunks from that offset
+    */
+   private:
+    u_int64_t seed;            // the seed of the checksum
+    u_int64_t lanes[4];        // the four accumulators, every one consumes 8 Bytes of a 32 Byte stripe
+    unsigned char buffer[32];  // the Bytes that do not fill a stripe yet
+    size_t buffered = 0;       // number of Bytes in the buffer
+    u_int64_t total_len = 0;   // number of Bytes that were added
+
+    void consumeStripe(const unsigned char* stripe) noexcept;  // adds one stripe of 32 Bytes to the lanes
+   public:
+    explicit Checksum(const u_int64_t seed = 0) noexcept;                // starts an empty checksum with the seed
+    void addData(const unsigned char* data, const size_t len) noexcept;  // adds the next Bytes
+    void addZeros(const size_t len) noexcept;                            // adds len zero Bytes
+    u_int64_t getResult() const noexcept;                                // returns the checksum over all added Bytes (more data can be added afterwards)
+
+    // calculates the checksum over the header, the 8 Bytes of the header at checksum_pos are treated as zeros
+    // so the checksum can be stored inside of the header that it covers
+    static u_int64_t calculateHeader(const unsigned char* header, const size_t header_len, const size_t checksum_pos) noexcept;
+    // calculates the sum of the chunk checksums over the data that is given in consecutive parts (pointer and length)
+    // the data starts at offset (a multiple of CHECKSUM_CHUNK_LEN) of the file data and ends at a chunk end or at the end of the file data
+    static u_int64_t calculateChunks(const std::vector<std::pair<const unsigned char*, u_int64_t>>& parts, const u_int64_t offset) noexcept;
+};
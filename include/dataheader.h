@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -10,31 +12,78 @@
 #include "hash_modes.h"
 
 struct DataBlock {
+    /*
+    a datablock either owns its data (created by the program) or it is a view into the header bytes it was read from (DataHeader::setHeaderBytes)
+    a view does not copy its data when the header is read, the data is only copied or decoded (DataHeader getters) when it is accessed
+    the data is never changed in place, so copies of a datablock share it, setData gives the datablock new data
+    */
    private:
-    Bytes data = Bytes(0);  // the decrypted data
+    std::shared_ptr<const Bytes> source = nullptr;  // the owned data or the header bytes of a view
+    u_int32_t offset = 0;                           // the position of the data inside of source (0 if the data is owned)
+    unsigned char len = 0;                          // the length of the data
+    bool view = false;                              // the data is a part of the header bytes
    public:
     DatablockType type = DatablockType::DEFAULT;
 
     DataBlock() = default;
 
-    DataBlock(const DatablockType type, const Bytes data) {
-        // basic constructor
-        this->type = type;
-        this->setData(data);
-    }
-
-    void setData(const Bytes& data) {
-        // sets the data
-        if (data.getLen() > 0 && data.getLen() <= 255)  // the size has to be one byte
-            this->data = data;
-        else {
+    DataBlock(const DatablockType type, Bytes data) : type(type) {
+        // basic constructor (the data is moved into the block)
+        this->setData(std::move(data));
+    }
+
+    static DataBlock createView(const DatablockType type, std::shared_ptr<const Bytes> source, const size_t offset, const unsigned char len) {
+        // creates a datablock that points to len Bytes at the offset of the header bytes (they are not copied)
+        if (source == nullptr || len == 0 || offset + len > source->getLen()) {
+            PLOG_ERROR << "the given view is not inside of the header bytes (offset: " << offset << ", len: " << +len << ")";
+            throw std::invalid_argument("view is not inside of the header bytes");
+        }
+        DataBlock datablock;
+        datablock.type = type;
+        datablock.source = std::move(source);
+        datablock.offset = (u_int32_t)offset;
+        datablock.len = len;
+        datablock.view = true;
+        return datablock;
+    }
+
+    void setData(Bytes data) {
+        // sets the data (the data is moved into the block)
+        if (data.getLen() > 0 && data.getLen() <= 255) {  // the size has to be one byte
+            this->len = (unsigned char)data.getLen();
+            this->source = std::make_shared<const Bytes>(std::move(data));
+            this->offset = 0;
+            this->view = false;
+        } else {
             PLOG_ERROR << "the given data has an invalid length: " << data.getLen();
             throw std::invalid_argument("data has an invalid length");
         }
     }
-    Bytes getData() const noexcept {
-        // gets the data
-        return this->data;
+    Bytes getData() const {
+        // gets a copy of the data (a view is materialized)
+        return this->copySubBytes(0, this->len);
+    }
+    Bytes copySubBytes(const size_t start, const size_t end) const {
+        // gets a copy of the data from start to end (only these Bytes are copied)
+        if (start > end || end > this->len) {
+            PLOG_ERROR << "the given range is not inside of the datablock (start: " << start << ", end: " << end << ", len: " << +this->len << ")";
+            throw std::length_error("range is not inside of the datablock");
+        }
+        Bytes ret(end - start);
+        if (end > start) ret.addBytes(this->getBytes() + start, end - start);
+        return ret;
+    }
+    const unsigned char* getBytes() const noexcept {
+        // gets the data in place (inside of the header bytes for a view, nullptr if there is no data)
+        return this->source != nullptr ? this->source->getBytes() + this->offset : nullptr;
+    }
+    unsigned char getLen() const noexcept {
+        // gets the length of the data
+        return this->len;
+    }
+    bool isView() const noexcept {
+        // checks if the datablock points into the header bytes it was read from
+        return this->view;
     }
 };
 
@@ -43,47 +92,54 @@ struct EncDataBlock {
     DataBlock data_block;  // the enc data
     unsigned char enc_len;
     EncDataBlock() = default;
+    EncDataBlock(DataBlock data_block, const unsigned char enc_len) : data_block(std::move(data_block)), enc_len(enc_len) {}
 
    public:
-    static EncDataBlock createEncBlock(const unsigned char enc_type, const Bytes enc_data, const unsigned char enc_len) {
-        // creates an EncDataBlock from the given data
+    static EncDataBlock createEncBlock(const unsigned char enc_type, Bytes enc_data, const unsigned char enc_len) {
+        // creates an EncDataBlock from the given data (the data is moved into the block)
         if (enc_data.getLen() != 255) {
             PLOG_ERROR << "the given data has an invalid length: " << enc_data.getLen();
             throw std::invalid_argument("data has an invalid length");
         }
-        EncDataBlock enc_block;
-        enc_block.enc_len = enc_len;
-        enc_block.data_block.type = DatablockType(enc_type);
-        enc_block.data_block.setData(enc_data);
-        return enc_block;
+        return EncDataBlock(DataBlock(DatablockType(enc_type), std::move(enc_data)), enc_len);
+    }
+
+    static EncDataBlock createEncView(const unsigned char enc_type, std::shared_ptr<const Bytes> source, const size_t offset, const unsigned char enc_len) {
+        // creates an EncDataBlock that points to the 255 encrypted Bytes at the offset of the header bytes, they are decrypted when getDec is called
+        return EncDataBlock(DataBlock::createView(DatablockType(enc_type), std::move(source), offset, 255), enc_len);
     }
 
     EncDataBlock(DataBlock datablock, const std::unique_ptr<Hash>&& hash, Bytes pwhash, Bytes enc_salt) {
         // basic constructor
         pwhash = hash->hash(pwhash);
-        this->data_block.type = DatablockType((unsigned char)(datablock.type + pwhash.copySubBytes(0, 1).toLong()));
-        this->enc_len = (unsigned char)(datablock.getData().getLen() + pwhash.copySubBytes(1, 2).toLong());
+        const unsigned char enc_type = (unsigned char)(datablock.type + pwhash.copySubBytes(0, 1).toLong());
+        this->enc_len = (unsigned char)(datablock.getLen() + pwhash.copySubBytes(1, 2).toLong());
         u_int16_t written = 0;
         u_int16_t end;
         Bytes enc_data(255);
-        while (enc_data.getLen() != datablock.getData().getLen()) {
+        while (enc_data.getLen() != datablock.getLen()) {
             // encrypt the data
             enc_salt = hash->hash(enc_salt - pwhash);
-            end = std::min<int>(written + enc_salt.getLen(), datablock.getData().getLen());
-            (datablock.getData().copySubBytes(written, end) + enc_salt.copySubBytes(0, end - written)).addcopyToBytes(enc_data);
+            end = std::min<int>(written + enc_salt.getLen(), datablock.getLen());
+            (datablock.copySubBytes(written, end) + enc_salt.copySubBytes(0, end - written)).addcopyToBytes(enc_data);
             written = end;
         }
-        enc_data.addSize(255 - enc_data.getLen());  // fill the rest with random data
-        enc_data.fillrandom();
-        datablock.setData(enc_data);
+        enc_data.fillrandom();  // fill the rest with random data
+        datablock.setData(std::move(enc_data));
+        datablock.type = DatablockType(enc_type);
         this->data_block = datablock;
     }
 
-    Bytes getEnc() const noexcept {
-        // gets the data
+    Bytes getEnc() const {
+        // gets a copy of the encrypted data
         return this->data_block.getData();
     }
 
+    const DataBlock& getEncBlock() const noexcept {
+        // gets the datablock with the encrypted type and data (without copying it)
+        return this->data_block;
+    }
+
     Bytes getDec(const std::unique_ptr<Hash>&& hash, Bytes pwhash, Bytes enc_salt) const noexcept {
         // decrypts the data
         pwhash = hash->hash(pwhash);
@@ -95,7 +151,7 @@ struct EncDataBlock {
             // decrypt the data
             enc_salt = hash->hash(enc_salt - pwhash);
             end = std::min<int>(written + enc_salt.getLen(), len);
-            (this->data_block.getData().copySubBytes(written, end) - enc_salt.copySubBytes(0, end - written)).addcopyToBytes(dec_data);
+            (this->data_block.copySubBytes(written, end) - enc_salt.copySubBytes(0, end - written)).addcopyToBytes(dec_data);
             written = end;
         }
         return dec_data;
@@ -166,8 +222,8 @@ struct DataHeaderParts {
             throw std::runtime_error("hash mode is not set");
         }
     }
-    Bytes getValidPasswordHash() const {
-        // gets the valid password hash
+    const Bytes& getValidPasswordHash() const {
+        // gets the valid password hash (without copying it)
         if (this->valid_passwordhash.has_value()) {
             return this->valid_passwordhash.value();
         } else {
@@ -175,8 +231,8 @@ struct DataHeaderParts {
             throw std::runtime_error("valid password hash is not set");
         }
     }
-    Bytes getEncSalt() const {
-        // gets the encoded salt
+    const Bytes& getEncSalt() const {
+        // gets the encoded salt (without copying it)
         if (this->enc_salt.has_value()) {
             return this->enc_salt.value();
         } else {
@@ -257,16 +313,19 @@ struct DataHeaderParts {
     }
 };
 
-struct DataHeaderSettingsIters {
-    // holds the settings used for the dataheader
+struct DataHeaderSettingsBase {
+    // holds the settings that DataHeaderSettingsIters and DataHeaderSettingsTime share
     // the values that should not be choosen randomly when generating a new header
    private:
     std::optional<FModes> file_mode;            // the file data mode that is choosen (content of the file)
     std::optional<HModes> hash_mode;            // the hash mode that is choosen (hash function)
     std::optional<CHModes> chainhash1_mode;     // chainhash mode for the first chainhash (password -> passwordhash)
     std::optional<CHModes> chainhash2_mode;     // chainhash mode for the second chainhash (passwordhash -> validate password)
-    std::optional<u_int64_t> chainhash1_iters;  // iterations for the first chainhash
-    std::optional<u_int64_t> chainhash2_iters;  // iterations for the second chainhash
+    std::optional<u_int64_t> block_len;         // block length of the keystream block format (not set: legacy format)
+    std::optional<u_int64_t> shard_count;       // number of independent chains the content is split into (not set: one chain)
+    std::optional<CModes> cipher_mode;          // cipher mode for the content (not set: hash chain block cipher)
+    std::optional<u_int64_t> integrity_leaf_len;  // leaf length of the integrity tree over the encrypted data (not set: no integrity tree)
+    std::optional<u_int64_t> key_slot_count;      // number of key slots for passwords of the random data key (not set: the password hash is the content key)
    public:
     std::vector<DataBlock> dec_data_blocks;     // the decrypted data blocks
     std::vector<EncDataBlock> enc_data_blocks;  // the encrypted data blocks
@@ -288,14 +347,6 @@ struct DataHeaderSettingsIters {
         // checks if the chainhash mode for the second chainhash is set
         return this->chainhash2_mode.has_value();
     }
-    bool isChainHash1ItersSet() const noexcept {
-        // checks if the iterations for the first chainhash are set
-        return this->chainhash1_iters.has_value();
-    }
-    bool isChainHash2ItersSet() const noexcept {
-        // checks if the iterations for the second chainhash are set
-        return this->chainhash2_iters.has_value();
-    }
     FModes getFileDataMode() const {
         // gets the file data mode
         if (this->file_mode.has_value())
@@ -332,24 +383,6 @@ struct DataHeaderSettingsIters {
             throw std::runtime_error("chainhash mode for the second chainhash is not set");
         }
     }
-    u_int64_t getChainHash1Iters() const {
-        // gets the iterations for the first chainhash
-        if (this->chainhash1_iters.has_value())
-            return this->chainhash1_iters.value();
-        else {
-            PLOG_ERROR << "iterations for the first chainhash are not set";
-            throw std::runtime_error("iterations for the first chainhash are not set");
-        }
-    }
-    u_int64_t getChainHash2Iters() const {
-        // gets the iterations for the second chainhash
-        if (this->chainhash2_iters.has_value())
-            return this->chainhash2_iters.value();
-        else {
-            PLOG_ERROR << "iterations for the second chainhash are not set";
-            throw std::runtime_error("iterations for the second chainhash are not set");
-        }
-    }
     void setFileDataMode(const FModes file_mode) {
         // sets the file data mode
         if (FileModes::isModeValid(file_mode))
@@ -386,6 +419,169 @@ struct DataHeaderSettingsIters {
             throw std::invalid_argument("chainhash mode for the second chainhash is not valid");
         }
     }
+
+    bool isBlockLenSet() const noexcept {
+        // checks if the block length of the keystream block format is set
+        return this->block_len.has_value();
+    }
+    u_int64_t getBlockLen() const {
+        // gets the block length of the keystream block format
+        if (this->block_len.has_value())
+            return this->block_len.value();
+        else {
+            PLOG_ERROR << "block length is not set";
+            throw std::runtime_error("block length is not set");
+        }
+    }
+    void setBlockLen(const u_int64_t block_len) {
+        // sets the block length, the file is encrypted with the keystream block format
+        if (block_len >= MIN_BLOCK_LEN && block_len <= MAX_BLOCK_LEN)
+            this->block_len = block_len;
+        else {
+            PLOG_ERROR << "the given block length is not valid: " << block_len;
+            throw std::invalid_argument("block length is not valid");
+        }
+    }
+
+    bool isShardCountSet() const noexcept {
+        // checks if the number of shards is set
+        return this->shard_count.has_value();
+    }
+    u_int64_t getShardCount() const {
+        // gets the number of shards
+        if (this->shard_count.has_value())
+            return this->shard_count.value();
+        else {
+            PLOG_ERROR << "shard count is not set";
+            throw std::runtime_error("shard count is not set");
+        }
+    }
+    void setShardCount(const u_int64_t shard_count) {
+        // sets the number of shards, the content is split into independent chains that are encrypted/decrypted in parallel
+        if (shard_count >= 2 && shard_count <= MAX_SHARD_COUNT)
+            this->shard_count = shard_count;
+        else {
+            PLOG_ERROR << "the given shard count is not valid: " << shard_count;
+            throw std::invalid_argument("shard count is not valid");
+        }
+    }
+
+    bool isCipherModeSet() const noexcept {
+        // checks if the cipher mode is set
+        return this->cipher_mode.has_value();
+    }
+    CModes getCipherMode() const {
+        // gets the cipher mode
+        if (this->cipher_mode.has_value())
+            return this->cipher_mode.value();
+        else {
+            PLOG_ERROR << "cipher mode is not set";
+            throw std::runtime_error("cipher mode is not set");
+        }
+    }
+    void setCipherMode(const CModes cipher_mode) {
+        // sets the cipher mode, the AEAD modes encrypt the content in authenticated chunks instead of the hash chain
+        if (cipher_mode >= 1 && cipher_mode <= MAX_CIPHERMODE_NUMBER)
+            this->cipher_mode = cipher_mode;
+        else {
+            PLOG_ERROR << "the given cipher mode is not valid: " << +cipher_mode;
+            throw std::invalid_argument("cipher mode is not valid");
+        }
+    }
+
+    bool isIntegrityLeafLenSet() const noexcept {
+        // checks if the leaf length of the integrity tree is set
+        return this->integrity_leaf_len.has_value();
+    }
+    u_int64_t getIntegrityLeafLen() const {
+        // gets the leaf length of the integrity tree
+        if (this->integrity_leaf_len.has_value())
+            return this->integrity_leaf_len.value();
+        else {
+            PLOG_ERROR << "integrity leaf length is not set";
+            throw std::runtime_error("integrity leaf length is not set");
+        }
+    }
+    void setIntegrityLeafLen(const u_int64_t leaf_len) {
+        // sets the leaf length, a hash tree over the encrypted data is stored in the header
+        if (leaf_len >= MIN_INTEGRITY_LEAF_LEN && leaf_len <= MAX_INTEGRITY_LEAF_LEN)
+            this->integrity_leaf_len = leaf_len;
+        else {
+            PLOG_ERROR << "the given integrity leaf length is not valid: " << leaf_len;
+            throw std::invalid_argument("integrity leaf length is not valid");
+        }
+    }
+
+    bool isKeySlotCountSet() const noexcept {
+        // checks if the number of key slots is set
+        return this->key_slot_count.has_value();
+    }
+    u_int64_t getKeySlotCount() const {
+        // gets the number of key slots
+        if (this->key_slot_count.has_value())
+            return this->key_slot_count.value();
+        else {
+            PLOG_ERROR << "key slot count is not set";
+            throw std::runtime_error("key slot count is not set");
+        }
+    }
+    void setKeySlotCount(const u_int64_t key_slot_count) {
+        // sets the number of key slots, the content is encrypted with a random data key that is wrapped by every password of the file
+        // the password is stored in the first slot, more passwords can be added later without encrypting the content again (API::addPassword)
+        if (key_slot_count >= 1 && key_slot_count <= MAX_KEY_SLOTS)
+            this->key_slot_count = key_slot_count;
+        else {
+            PLOG_ERROR << "the given key slot count is not valid: " << key_slot_count;
+            throw std::invalid_argument("key slot count is not valid");
+        }
+    }
+
+    void setOrReplaceDataBlock(const DatablockType type, const Bytes& data) {
+        // sets the decrypted datablock of the given type, an existing datablock of that type is replaced
+        this->removeDataBlocks(type);
+        this->dec_data_blocks.push_back(DataBlock(type, data));
+    }
+    void removeDataBlocks(const DatablockType type) noexcept {
+        // removes every decrypted datablock of the given type
+        this->dec_data_blocks.erase(std::remove_if(this->dec_data_blocks.begin(), this->dec_data_blocks.end(), [type](const DataBlock& datablock) { return datablock.type == type; }),
+                                    this->dec_data_blocks.end());
+    }
+};
+
+struct DataHeaderSettingsIters : public DataHeaderSettingsBase {
+    // holds the settings used for the dataheader
+    // the chainhashes run a fixed number of iterations
+   private:
+    std::optional<u_int64_t> chainhash1_iters;  // iterations for the first chainhash
+    std::optional<u_int64_t> chainhash2_iters;  // iterations for the second chainhash
+    std::shared_ptr<ChainHashData> chainhash1_data;  // data (salts) of the first chainhash (not set: random data)
+   public:
+    bool isChainHash1ItersSet() const noexcept {
+        // checks if the iterations for the first chainhash are set
+        return this->chainhash1_iters.has_value();
+    }
+    bool isChainHash2ItersSet() const noexcept {
+        // checks if the iterations for the second chainhash are set
+        return this->chainhash2_iters.has_value();
+    }
+    u_int64_t getChainHash1Iters() const {
+        // gets the iterations for the first chainhash
+        if (this->chainhash1_iters.has_value())
+            return this->chainhash1_iters.value();
+        else {
+            PLOG_ERROR << "iterations for the first chainhash are not set";
+            throw std::runtime_error("iterations for the first chainhash are not set");
+        }
+    }
+    u_int64_t getChainHash2Iters() const {
+        // gets the iterations for the second chainhash
+        if (this->chainhash2_iters.has_value())
+            return this->chainhash2_iters.value();
+        else {
+            PLOG_ERROR << "iterations for the second chainhash are not set";
+            throw std::runtime_error("iterations for the second chainhash are not set");
+        }
+    }
     void setChainHash1Iters(const u_int64_t chainhash1_iters) {
         // sets the iterations for the first chainhash
         if (chainhash1_iters > 0 && chainhash1_iters <= MAX_ITERATIONS)
@@ -405,6 +601,31 @@ struct DataHeaderSettingsIters {
         }
     }
 
+    bool isChainHash1DataSet() const noexcept {
+        // checks if the data of the first chainhash is set
+        return this->chainhash1_data != nullptr;
+    }
+    std::shared_ptr<ChainHashData> getChainHash1Data() const {
+        // gets the data of the first chainhash
+        if (this->chainhash1_data != nullptr)
+            return this->chainhash1_data;
+        else {
+            PLOG_ERROR << "chainhash data for the first chainhash is not set";
+            throw std::runtime_error("chainhash data for the first chainhash is not set");
+        }
+    }
+    void setChainHash1Data(const std::shared_ptr<ChainHashData> chainhash1_data) {
+        // sets the data of the first chainhash instead of random data, it has to match the chainhash mode
+        // files with the same password and the same first chainhash (hash mode, mode, iterations and data) get the same password hash
+        // so they can be unlocked with one first chainhash (VaultManager::unlockAll), but one leaked password hash unlocks all of them
+        if (chainhash1_data != nullptr && chainhash1_data->isComplete())
+            this->chainhash1_data = chainhash1_data;
+        else {
+            PLOG_ERROR << "the given chainhash data for the first chainhash is not complete";
+            throw std::invalid_argument("chainhash data for the first chainhash is not complete");
+        }
+    }
+
     bool isComplete() const noexcept {
         // checks if everything is set correctly
         try {
@@ -426,42 +647,22 @@ struct DataHeaderSettingsIters {
                   << "ch1_mode: " << (ds.isChainHash1ModeSet() ? std::to_string(+ds.getChainHash1Mode()) : "not set") << ", "
                   << "ch1_iters: " << (ds.isChainHash1ItersSet() ? std::to_string(ds.getChainHash1Iters()) : "not set") << ", "
                   << "ch2_mode: " << (ds.isChainHash2ModeSet() ? std::to_string(+ds.getChainHash2Mode()) : "not set") << ", "
-                  << "ch2_iters: " << (ds.isChainHash2ItersSet() ? std::to_string(ds.getChainHash2Iters()) : "not set");
+                  << "ch2_iters: " << (ds.isChainHash2ItersSet() ? std::to_string(ds.getChainHash2Iters()) : "not set") << ", "
+                  << "block_len: " << (ds.isBlockLenSet() ? std::to_string(ds.getBlockLen()) : "not set") << ", "
+                  << "shard_count: " << (ds.isShardCountSet() ? std::to_string(ds.getShardCount()) : "not set") << ", "
+                  << "cipher_mode: " << (ds.isCipherModeSet() ? std::to_string(+ds.getCipherMode()) : "not set") << ", "
+                  << "integrity_leaf_len: " << (ds.isIntegrityLeafLenSet() ? std::to_string(ds.getIntegrityLeafLen()) : "not set") << ", "
+                  << "key_slot_count: " << (ds.isKeySlotCountSet() ? std::to_string(ds.getKeySlotCount()) : "not set");
     }
 };
 
-struct DataHeaderSettingsTime {
+struct DataHeaderSettingsTime : public DataHeaderSettingsBase {
     // dataheader iterations are calculated by a time limit
     // holds the settings used for the dataheader
-    // the values that should not be choosen randomly when generating a new header
    private:
-    std::optional<FModes> file_mode;           // the file data mode that is choosen (content of the file)
-    std::optional<HModes> hash_mode;           // the hash mode that is choosen (hash function)
-    std::optional<CHModes> chainhash1_mode;    // chainhash mode for the first chainhash (password -> passwordhash)
-    std::optional<CHModes> chainhash2_mode;    // chainhash mode for the second chainhash (passwordhash -> validate password)
     std::optional<u_int64_t> chainhash1_time;  // max miliseconds for the first chainhash
     std::optional<u_int64_t> chainhash2_time;  // max miliseconds for the second chainhash
    public:
-    std::vector<DataBlock> dec_data_blocks;     // the decrypted data blocks
-    std::vector<EncDataBlock> enc_data_blocks;  // the encrypted data blocks
-
-   public:
-    bool isFileDataModeSet() const noexcept {
-        // checks if the file data mode is set
-        return this->file_mode.has_value();
-    }
-    bool isHashModeSet() const noexcept {
-        // checks if the hash mode is set
-        return this->hash_mode.has_value();
-    }
-    bool isChainHash1ModeSet() const noexcept {
-        // checks if the chainhash mode for the first chainhash is set
-        return this->chainhash1_mode.has_value();
-    }
-    bool isChainHash2ModeSet() const noexcept {
-        // checks if the chainhash mode for the second chainhash is set
-        return this->chainhash2_mode.has_value();
-    }
     bool isChainHash1TimeSet() const noexcept {
         // checks if the time for the first chainhash is set
         return this->chainhash1_time.has_value();
@@ -470,42 +671,6 @@ struct DataHeaderSettingsTime {
         // checks if the time for the second chainhash is set
         return this->chainhash2_time.has_value();
     }
-    FModes getFileDataMode() const {
-        // gets the file data mode
-        if (this->file_mode.has_value())
-            return this->file_mode.value();
-        else {
-            PLOG_ERROR << "file data mode is not set";
-            throw std::runtime_error("file data mode is not set");
-        }
-    }
-    HModes getHashMode() const {
-        // gets the hash mode
-        if (this->hash_mode.has_value())
-            return this->hash_mode.value();
-        else {
-            PLOG_ERROR << "hash mode is not set";
-            throw std::runtime_error("hash mode is not set");
-        }
-    }
-    CHModes getChainHash1Mode() const {
-        // gets the chainhash mode for the first chainhash
-        if (this->chainhash1_mode.has_value())
-            return this->chainhash1_mode.value();
-        else {
-            PLOG_ERROR << "chainhash mode for the first chainhash is not set";
-            throw std::runtime_error("chainhash mode for the first chainhash is not set");
-        }
-    }
-    CHModes getChainHash2Mode() const {
-        // gets the chainhash mode for the second chainhash
-        if (this->chainhash2_mode.has_value())
-            return this->chainhash2_mode.value();
-        else {
-            PLOG_ERROR << "chainhash mode for the second chainhash is not set";
-            throw std::runtime_error("chainhash mode for the second chainhash is not set");
-        }
-    }
     u_int64_t getChainHash1Time() const {
         // gets the time for the first chainhash
         if (this->chainhash1_time.has_value())
@@ -524,42 +689,6 @@ struct DataHeaderSettingsTime {
             throw std::runtime_error("run time for the second chainhash is not set");
         }
     }
-    void setFileDataMode(const FModes file_mode) {
-        // sets the file data mode
-        if (FileModes::isModeValid(file_mode))
-            this->file_mode = file_mode;
-        else {
-            PLOG_ERROR << "the given file data mode is not valid: " << +file_mode;
-            throw std::invalid_argument("file mode is not valid");
-        }
-    }
-    void setHashMode(const HModes hash_mode) {
-        // sets the hash mode
-        if (HashModes::isModeValid(hash_mode))
-            this->hash_mode = hash_mode;
-        else {
-            PLOG_ERROR << "the given hash mode is not valid: " << +hash_mode;
-            throw std::invalid_argument("hash mode is not valid");
-        }
-    }
-    void setChainHash1Mode(const CHModes chainhash1_mode) {
-        // sets the chainhash mode for the first chainhash
-        if (ChainHashModes::isModeValid(chainhash1_mode))
-            this->chainhash1_mode = chainhash1_mode;
-        else {
-            PLOG_ERROR << "the given chainhash mode for the first chainhash is not valid: " << +chainhash1_mode;
-            throw std::invalid_argument("chainhash mode for the first chainhash is not valid");
-        }
-    }
-    void setChainHash2Mode(const CHModes chainhash2_mode) {
-        // sets the chainhash mode for the second chainhash
-        if (ChainHashModes::isModeValid(chainhash2_mode))
-            this->chainhash2_mode = chainhash2_mode;
-        else {
-            PLOG_ERROR << "the given chainhash mode for the second chainhash is not valid: " << +chainhash2_mode;
-            throw std::invalid_argument("chainhash mode for the second chainhash is not valid");
-        }
-    }
     void setChainHash1Time(const u_int64_t chainhash1_time) {
         // sets the run time for the first chainhash
         if (chainhash1_time > 0 && chainhash1_time <= MAX_RUNTIME)
@@ -600,7 +729,51 @@ struct DataHeaderSettingsTime {
                   << "ch1_mode: " << (ds.isChainHash1ModeSet() ? std::to_string(+ds.getChainHash1Mode()) : "not set") << ", "
                   << "ch1_time: " << (ds.isChainHash1TimeSet() ? std::to_string(ds.getChainHash1Time()) : "not set") << ", "
                   << "ch2_mode: " << (ds.isChainHash2ModeSet() ? std::to_string(+ds.getChainHash2Mode()) : "not set") << ", "
-                  << "ch2_time: " << (ds.isChainHash2TimeSet() ? std::to_string(ds.getChainHash2Time()) : "not set");
+                  << "ch2_time: " << (ds.isChainHash2TimeSet() ? std::to_string(ds.getChainHash2Time()) : "not set") << ", "
+                  << "block_len: " << (ds.isBlockLenSet() ? std::to_string(ds.getBlockLen()) : "not set") << ", "
+                  << "shard_count: " << (ds.isShardCountSet() ? std::to_string(ds.getShardCount()) : "not set") << ", "
+                  << "cipher_mode: " << (ds.isCipherModeSet() ? std::to_string(+ds.getCipherMode()) : "not set") << ", "
+                  << "integrity_leaf_len: " << (ds.isIntegrityLeafLenSet() ? std::to_string(ds.getIntegrityLeafLen()) : "not set") << ", "
+                  << "key_slot_count: " << (ds.isKeySlotCountSet() ? std::to_string(ds.getKeySlotCount()) : "not set");
+    }
+};
+
+struct ShardLayout {
+    // describes how the content is split into independent chains (shards)
+    // shard i stores the content Bytes [i*shard_len, (i+1)*shard_len), the last used shard can be shorter
+    u_int64_t shard_count = 0;  // the number of shards (0 if the content is one chain)
+    u_int64_t shard_len = 0;    // the length of one shard in Bytes (0 until the content is encrypted)
+};
+
+struct CipherFormat {
+    // describes how the content is encrypted
+    // the AEAD cipher modes encrypt chunks of chunk_len Bytes, every encrypted chunk is followed by its tag
+    CModes cipher_mode = CIPHERMODE_HASHCHAIN;  // the cipher mode
+    u_int64_t chunk_len = 0;                     // the number of plaintext Bytes in one chunk (0 for the hash chain)
+    Bytes key_salt{0};                           // the salt that is used to derive the key (empty for the hash chain)
+};
+
+struct IntegrityTree {
+    // describes the hash tree over the encrypted data (the data of the file without the header)
+    // the leaves are grouped into region_count regions of equal length, the root is the hash tree over the region hashes
+    u_int64_t leaf_len = 0;      // the number of encrypted Bytes in one leaf (0 if the file has no integrity tree)
+    u_int64_t region_count = 0;  // the number of regions
+    Bytes root{0};               // the root of the tree (hash size)
+    std::vector<Bytes> regions;  // the first INTEGRITY_REGION_HASH_LEN Bytes of every region hash
+};
+
+struct KeySlot {
+    // one password of a file with key slots, every slot wraps the same random data key (the content key of the file)
+    // the data key is added to the hash of the password hash and the validator, so only the password hash of the slot can unwrap it
+    Bytes validator{0};    // the second chainhash of the password hash (hash size, all zero if the slot is free)
+    Bytes wrapped_key{0};  // the data key plus the hash of the password hash and the validator (hash size)
+
+    bool isFree() const noexcept {
+        // a free slot is all zero
+        for (size_t i = 0; i < this->validator.getLen(); i++) {
+            if (this->validator.getBytes()[i] != 0) return false;
+        }
+        return true;
     }
 };
 
@@ -618,11 +791,15 @@ class DataHeader {
     Bytes header_bytes = Bytes(0);       // bytes that are in the header
     std::optional<u_int64_t> file_size;  // the size of the file that is encrypted
     u_int32_t datablocks_len = 0;        // the length of the datablocks
+    // the header bytes the header was read from, the datablocks that were read are views into them
+    // they are the current header bytes until the header is changed (header_bytes stays empty until then)
+    std::shared_ptr<const Bytes> read_header = nullptr;
 
    private:
     // checks if all data is set correctly
     bool isComplete() const noexcept;
     void setEncSalt(const Bytes& salt);  // sets the salt
+    void clearHeaderBytes() noexcept;    // clears the header bytes because they have to be recalculated
 
    public:
     // sets up the data header with a hash mode which is necessary to
@@ -636,8 +813,14 @@ class DataHeader {
     void setChainHash2(const ChainHash chainhash);
     void setValidPasswordHashBytes(const Bytes& validBytes);  // sets the passwordhashhash to validate the password hash
     void clearDataBlocks() noexcept;                          // clears the data blocks
-    void addDataBlock(const DataBlock datablock);             // adds a data block
-    void addEncDataBlock(const EncDataBlock encdatablock);    // adds an encrypted data block
+    void removeDataBlocks(const DatablockType type) noexcept;  // removes all (not encrypted) data blocks of the given type
+    bool hasDataBlock(const DatablockType type) const noexcept;  // checks if there is a (not encrypted) data block of the given type
+    // gets the first (not encrypted) data block of the given type without copying it (nullptr if there is none)
+    // the pointer is valid until the data blocks are changed
+    const DataBlock* findDataBlock(const DatablockType type) const noexcept;
+    void addDataBlock(DataBlock datablock);                   // adds a data block (moves it into the header)
+    void addEncDataBlock(EncDataBlock encdatablock);          // adds an encrypted data block (moves it into the header)
+    void setOrReplaceDataBlock(DataBlock datablock);  // adds a data block instead of all data blocks of its type
 
     void setFileSize(const u_int64_t file_size);            // sets the file size
     void setDataSize(const u_int32_t data_size);            // sets the file size by adding the header size to the data size
@@ -645,12 +828,19 @@ class DataHeader {
     // calculates the header bytes with all information that is set, throws if not enough information is set (or not valid)
     // verifies the pwhash with the previous set pwhash validator
     void calcHeaderBytes(const Bytes& passwordhash = Bytes(0));
-    Bytes getHeaderBytes() const;  // gets the current set header bytes, calcHeaderBytes overwrites this variable
+    const Bytes& getHeaderBytes() const;  // gets the current set header bytes (without copying them), calcHeaderBytes overwrites this variable
 
     // creates a new DataHeader object with the given header bytes
     // after this call the fileBytes are the data that is not part of the header
     static ErrorStruct<std::unique_ptr<DataHeader>> setHeaderBytes(Bytes& fileBytes) noexcept;
     static ErrorStruct<std::unique_ptr<DataHeader>> setHeaderBytes(std::ifstream& file) noexcept;
+    // parses the header in place from a buffer that starts with the header (e.g. read with one pread or mapped), the buffer can be longer than the header
+    // only the header is copied from the buffer, the datablocks are views into this copy
+    static ErrorStruct<std::unique_ptr<DataHeader>> setHeaderBytes(const unsigned char* header, const size_t len) noexcept;
+    // parses the header in place and keeps the buffer without copying it (it is shortened to the header), the datablocks are views into it
+    static ErrorStruct<std::unique_ptr<DataHeader>> setHeaderBytes(std::shared_ptr<Bytes> header) noexcept;
+    // reads the file size and the header size from the first 16 header Bytes, checks them against the actual size of the file and returns the header size
+    static ErrorStruct<u_int64_t> checkHeaderPrefix(const unsigned char* prefix, const u_int64_t actual_file_size) noexcept;
     // creates a new DataHeader object with the given data header parts
     static ErrorStruct<std::unique_ptr<DataHeader>> setHeaderParts(const DataHeaderParts& dhp) noexcept;
 
@@ -659,6 +849,61 @@ class DataHeader {
     unsigned int getHeaderLength() const noexcept;
     // gets the hash size of the hash function that is used
     int getHashSize() const noexcept;
+    // gets the block length of the keystream block format from the BLOCKFORMAT datablock (0 for the legacy format)
+    // throws if the datablock stores an unknown version or an invalid block length
+    u_int64_t getBlockLen() const;
+    // gets the byte size of one keystream block (the hash size for the legacy format)
+    // throws if the BLOCKFORMAT datablock is invalid
+    u_int64_t getEffectiveBlockLen() const;
+    // creates the BLOCKFORMAT datablock for the keystream block format with the given block length
+    static DataBlock createBlockFormatDataBlock(const u_int64_t block_len);
+    // gets the shard layout from the SHARDS datablock (shard_count is 0 if the content is one chain)
+    // throws if the datablock is invalid
+    ShardLayout getShardLayout() const;
+    // creates the SHARDS datablock with the given shard layout
+    static DataBlock createShardDataBlock(const ShardLayout& layout);
+    // gets the cipher format from the CIPHER datablock (hash chain if there is no datablock)
+    // throws if the datablock is invalid
+    CipherFormat getCipherFormat() const;
+    // creates the CIPHER datablock with the given cipher format
+    static DataBlock createCipherDataBlock(const CipherFormat& format);
+    // gets the integrity tree from the INTEGRITY datablock (leaf_len is 0 if the file has no integrity tree)
+    // throws if the datablock is invalid
+    IntegrityTree getIntegrityTree() const;
+    // creates the INTEGRITY datablock with the given integrity tree (the datablock has the same length for every tree of one hash size)
+    static DataBlock createIntegrityDataBlock(const IntegrityTree& tree);
+    // gets the length of the leaf hash table at the end of the data from the INDEX datablock (0 if the trailer has no table)
+    // since trailer version 4 the length includes the region hashes behind the leaf hashes
+    u_int64_t getLeafTableLen() const;
+    // gets the version of the trailer layout from the INDEX datablock (0 if the data has no trailer)
+    unsigned char getTrailerVersion() const;
+    // gets the key slots from the KEYSLOT datablocks in the order of the header (empty if the password hash is the content key)
+    // throws if a datablock is invalid
+    std::vector<KeySlot> getKeySlots() const;
+    // creates a KEYSLOT datablock with the given key slot (the datablock has the same length for every slot of one hash size)
+    static DataBlock createKeySlotDataBlock(const KeySlot& slot);
+    // wraps the data key for a password, the validator is the second chainhash of the password hash
+    static KeySlot createKeySlot(const Hash& hash, const Bytes& password_hash, const Bytes& validator, const Bytes& data_key);
+    // creates a free key slot for the hash size
+    static KeySlot createFreeKeySlot(const size_t hash_size);
+    // unwraps the data key of the key slot with the password hash of its password
+    static Bytes unwrapKeySlot(const Hash& hash, const Bytes& password_hash, const KeySlot& slot);
+    // creates an empty CHECKSUM datablock (header checksum and data checksum), the checksums are set with setChecksum after the header bytes are calculated
+    static DataBlock createChecksumDataBlock();
+    // gets the position of the header checksum inside of the header bytes, the data checksum follows it (0 if the header has no CHECKSUM datablock)
+    // only the unencrypted datablocks are read, throws if the header bytes are too short
+    static size_t getChecksumPos(const unsigned char* header, const size_t header_len);
+    // checks if the header has a CHECKSUM datablock (the 8 Byte datablock of older files is ignored)
+    bool hasChecksum() const noexcept;
+    // gets the data checksum from the calculated header bytes (0 if the header has no CHECKSUM datablock)
+    u_int64_t getDataChecksum() const;
+    // calculates the data checksum over the given data (the encrypted data of the file) and the header checksum and stores them in the CHECKSUM datablock
+    // the header bytes have to be calculated, they are updated in place (does nothing if the header has no CHECKSUM datablock)
+    void setChecksum(const unsigned char* data, const u_int64_t data_len);
+    // calculates the data checksum over the data that is given in consecutive parts (pointer and length)
+    void setChecksum(const std::vector<std::pair<const unsigned char*, u_int64_t>>& data_parts);
+    // stores the given data checksum (e.g. updated by the rewritten chunks) and calculates the header checksum, the data is not read
+    void setChecksum(const u_int64_t data_checksum);
     // gets the dataheader parts if they are complete
     DataHeaderParts getDataHeaderParts() const;
     // WORK
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+
+#include "bytes.h"
+#include "error.h"
+#include "settings.h"
+
+class API;
+class DataHeader;
+
+class DecryptedReader {
+    /*
+    the DecryptedReader is a pull based reader over the decrypted content of a vault (API::getDecryptedReader)
+    every next() call decrypts only the next chunk, so the first Bytes are available without decrypting the whole file
+    the reader holds one chunk (and its encrypted Bytes) at a time, the caller can stop reading at any point
+
+    the blockchain formats continue the chain of the last chunk with the encrypted salt iterator state of its last block
+    sharded files continue the chain of the current shard, AEAD files decrypt and verify the chunks that belong to the next chunk
+    the reader works on the API it was created by, the API has to stay alive and in the PASSWORD_VERIFIED state while it is used
+    appendData and editData change the chains of the content, the reader fails after them
+    */
+   private:
+    const API* api;              // the API that created the reader (selected file, data header and password hash)
+    const DataHeader* dh;        // the data header of the API when the reader was created
+    const u_int64_t generation;  // the generation of the API when the reader was created (API::generation), the reader fails if it changed
+    u_int64_t content_len = 0;   // the length of the decrypted content
+    u_int64_t chunk_len = 0;     // the length of one chunk (whole blocks or AEAD chunks)
+    u_int64_t position = 0;      // the offset of the next chunk in the decrypted content
+    bool aead = false;           // the content is encrypted with an AEAD cipher mode
+    u_int64_t shard_len = 0;     // the length of one shard (0 if the content is one chain)
+    Bytes state{0};              // the encrypted salt iterator state of the block the next chunk continues (empty at the start of a chain)
+    u_int64_t state_block = 0;   // the index of that block in its chain
+
+   private:
+    // decrypts len Bytes of the blockchain content at the position, continues the chain of the last chunk
+    std::unique_ptr<Bytes> nextBlocks(const u_int64_t len);
+
+   public:
+    // creates a reader for the selected file of the API, chunk_len is rounded up to whole blocks (or AEAD chunks)
+    // throws if the chunk length is 0 or the data layout of the file is invalid
+    DecryptedReader(const API* api, const u_int64_t chunk_len = DECRYPTED_READER_CHUNK_LEN);
+    DecryptedReader(const DecryptedReader&) = delete;
+    DecryptedReader& operator=(const DecryptedReader&) = delete;
+
+    // returns the next chunk of the decrypted content (an empty Bytes object after the last chunk)
+    // fails with ERR_API_STATE_INVALID if the API left the PASSWORD_VERIFIED state or the file was changed
+    ErrorStruct<std::unique_ptr<Bytes>> next() noexcept;
+
+    bool isDone() const noexcept { return this->position == this->content_len; }  // true if all chunks were read
+    u_int64_t getPosition() const noexcept { return this->position; }             // returns the number of Bytes that were read
+    u_int64_t getContentLen() const noexcept { return this->content_len; }        // returns the length of the decrypted content
+    u_int64_t getChunkLen() const noexcept { return this->chunk_len; }            // returns the (rounded) length of one chunk
+};
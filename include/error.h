@@ -41,6 +41,7 @@ enum ErrorCode {
     ERR_FILE_NOT_OPEN,
     ERR_FILE_NOT_EMPTY,
     ERR_FILE_READ,
+    ERR_FILE_NOT_MAPPED,
     ERR_NOT_ENOUGH_DATA,
     ERR_WRONG_WORKFLOW,
     ERR_API_NOT_INITIALIZED,
@@ -52,6 +53,19 @@ enum ErrorCode {
     ERR_FILESIZE_INVALID,
     ERR_HEADERSIZE_FILESIZE_MISMATCH,
     ERR_FILEHANDLER_CREATION,
+    ERR_APPEND_NOT_SUPPORTED,
+    ERR_INTEGRITY_TREE_MISSING,
+    ERR_CHECKSUM_MISMATCH,
+    ERR_SESSION_NOT_FOUND,
+    ERR_MEMORY_NOT_LOCKED,
+    ERR_SOCKET,
+    ERR_MESSAGE_INVALID,
+    ERR_CANCELLED,
+    ERR_KEYSLOTS_NOT_SUPPORTED,
+    ERR_KEYSLOTS_FULL,
+    ERR_KEYSLOT_LAST,
+    ERR_FILE_NOT_REPLACED,
+    ERR_TRAILER_VERSION_INVALID,
 };
 
 // used in a function that could fail, it returns a success type, a value and an error message
@@ -272,6 +286,9 @@ std::string getErrorMessage(ErrorStruct<T>& err, bool verbose_err_msg = true) no
         case ERR_FILE_READ:
             return "File could not be read: " + err.errorInfo + err_msg;
 
+        case ERR_FILE_NOT_MAPPED:
+            return "File could not be mapped into memory: " + err.errorInfo + err_msg;
+
         case ERR_NOT_ENOUGH_DATA:
             return "Not enough data to read information: " + err.errorInfo + err_msg;
 
@@ -308,6 +325,45 @@ std::string getErrorMessage(ErrorStruct<T>& err, bool verbose_err_msg = true) no
         case ERR_FILEHANDLER_CREATION:
             return "FileHandler could not be created: " + err.errorInfo + err_msg;
 
+        case ERR_APPEND_NOT_SUPPORTED:
+            return "File does not support appending (no resume state): " + err.errorInfo + err_msg;
+
+        case ERR_INTEGRITY_TREE_MISSING:
+            return "File has no integrity tree: " + err.errorInfo + err_msg;
+
+        case ERR_CHECKSUM_MISMATCH:
+            return "File checksum does not match (damaged or partially written file): " + err.errorInfo + err_msg;
+
+        case ERR_SESSION_NOT_FOUND:
+            return "No unlocked session for the file (never unlocked, expired or the data header changed): " + err.errorInfo + err_msg;
+
+        case ERR_MEMORY_NOT_LOCKED:
+            return "Memory could not be locked: " + err.errorInfo + err_msg;
+
+        case ERR_SOCKET:
+            return "Socket operation failed: " + err.errorInfo + err_msg;
+
+        case ERR_MESSAGE_INVALID:
+            return "Invalid agent message: " + err.errorInfo + err_msg;
+
+        case ERR_CANCELLED:
+            return "The operation was cancelled: " + err.errorInfo + err_msg;
+
+        case ERR_KEYSLOTS_NOT_SUPPORTED:
+            return "File has no key slots (the content key is the password hash): " + err.errorInfo + err_msg;
+
+        case ERR_KEYSLOTS_FULL:
+            return "All key slots of the file are used: " + err.errorInfo + err_msg;
+
+        case ERR_KEYSLOT_LAST:
+            return "The last password of the file cannot be removed: " + err.errorInfo + err_msg;
+
+        case ERR_FILE_NOT_REPLACED:
+            return "The file could not be replaced by its rotated version: " + err.errorInfo + err_msg;
+
+        case ERR_TRAILER_VERSION_INVALID:
+            return "The trailer of the file has an unknown version: " + err.errorInfo + err_msg;
+
         case ERR:
             if (err.errorInfo.empty()) return "An error occurred" + err_msg;
             return err.errorInfo + err_msg;
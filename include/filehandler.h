@@ -1,43 +1,114 @@
 #pragma once
 
+#include <sys/stat.h>
+
 #include <filesystem>
+#include <vector>
 
 #include "base.h"
 #include "dataheader.h"
+#include "merkle_tree.h"
+
+class FileMapping {
+    /*
+    this class holds a read-only memory mapping of an encryption file
+    it exposes a region of the file (e.g. the data without the data header) without copying it
+    the mapping is released when the object is destroyed
+    */
+   private:
+    void* base;      // start of the mapped region (page aligned)
+    size_t map_len;  // length of the mapped region
+    size_t offset;   // offset of the exposed region inside of the mapped region
+   public:
+    FileMapping(void* base, const size_t map_len, const size_t offset) noexcept;  // takes ownership of an existing mapping
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+    const unsigned char* getData() const noexcept;  // returns a pointer to the exposed region
+    size_t getLen() const noexcept;                 // returns the length of the exposed region
+    ~FileMapping();                                 // unmaps the region
+};
+
+struct JournalWrite {
+    /*
+    one write of a journaled update of a file, the Bytes are not owned
+    */
+    u_int64_t offset;           // file offset of the write
+    const unsigned char* data;  // the Bytes that are written
+    u_int64_t len;              // number of Bytes
+};
 
 class FileHandler {
     /*
     this class handles the files
     That means it writes and reads from a given enc file
+    the file is opened once and the descriptor is held for the lifetime of the object, all reads and in place writes are positional (pread/pwrite)
     */
    private:
     const std::filesystem::path filepath;  // stores the path to the encryption file
+    int fd = -1;                           // stores the descriptor of the opened file
+    bool writable = false;                 // stores if the file was opened for writing
+    u_int64_t inode = 0;                   // stores the inode of the opened file (the file is opened again if the path is replaced)
     size_t header_size = 0;                // stores the size of the data header
     size_t file_size = 0;                  // stores the size of the file
     bool empty;                            // stores if the file is empty
+
+   private:
+    void openFile();                  // opens the file (read and write if possible) and closes the old descriptor
+    void statFile(struct stat& st);  // stats the file, the file is opened again if the path was replaced by another file
+    void replayJournal();             // applies a complete journal that was left behind by a crash and removes a torn one
+    // applies the writes, cuts the file to the new size, syncs the file and removes the journal
+    ErrorStruct<bool> applyWrites(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept;
    public:
     static const std::string extension;  // encryption files (.enc)
    public:
     static ErrorStruct<bool> isValidPath(const std::filesystem::path& file, bool should_exist) noexcept;  // checks if the path is valid
     static ErrorStruct<bool> createFile(const std::filesystem::path& file) noexcept;                      // creates a file
-    FileHandler(const std::filesystem::path& file);                                                       // sets the filepath
+    FileHandler(const std::filesystem::path& file);                                                       // sets the filepath and opens the file
+    FileHandler(const FileHandler&) = delete;
+    FileHandler& operator=(const FileHandler&) = delete;
+    ~FileHandler();                                                                                       // closes the file
     void update();                                                                                        // updates the header_size and file_size variables
     ErrorStruct<bool> isDataHeader(FModes exp_file_mode) noexcept;                                        // checks if the file has a valid data header
     bool isEmtpy() const noexcept;                                                                        // checks if the file is empty
     ErrorStruct<std::unique_ptr<DataHeader>> getDataHeader() noexcept;                                    // reads the data header from the file
     std::ifstream getFileStream() const noexcept;                                                         // returns the file stream
     std::ifstream getDataStream() const noexcept;                                                         // returns the data stream from the file (without the data header)
+    ErrorStruct<std::unique_ptr<FileMapping>> getDataMapping() const noexcept;                            // maps the data from the file (without the data header) read-only into memory
     size_t getHeaderSize() const noexcept;                                                                // returns the size of the data header
     size_t getFileSize() const noexcept;                                                                  // returns the length of the file
     size_t getDataSize() const noexcept;                                                                  // returns the length of the data in the file
+    // verifies the encrypted data with the integrity tree of the data header (no password needed), 0 threads uses one thread per core
+    // the damaged regions in the report are given as file offsets
+    ErrorStruct<IntegrityReport> verifyIntegrity(const size_t threads = INTEGRITY_THREADS) noexcept;
+    // verifies the keyless checksums of the header and of the encrypted data (no password needed, files without a checksum are accepted)
+    // fails with ERR_CHECKSUM_MISMATCH if the file is damaged or was only partially written
+    ErrorStruct<bool> verifyChecksum() noexcept;
+    // verifies only the header checksum (the header is read, the data is not hashed)
+    ErrorStruct<bool> verifyHeaderChecksum() noexcept;
+    // verifies only the data checksum (the header checksum is not checked, the mapped data is hashed)
+    ErrorStruct<bool> verifyDataChecksum() noexcept;
 
     // NO update() needed
-    Bytes getFirstBytes(const size_t num) const;  // reads the first num Bytes from the encryption file
-    Bytes getAllBytes() const;                    // reads all Bytes from the given encryption file
+    Bytes getFirstBytes(const size_t num) const;                                              // reads the first num Bytes from the encryption file
+    Bytes getAllBytes() const;                                                                // reads all Bytes from the given encryption file
+    size_t readAt(unsigned char* data, const size_t len, const size_t offset) const noexcept;  // reads len Bytes at the file offset, returns the number of read Bytes
+    // writes len Bytes at the file offset without truncating the file, the caller has to call update() after writing
+    ErrorStruct<bool> writeAt(const unsigned char* data, const size_t len, const size_t offset) noexcept;
+    // writes the Bytes at their file offsets and sets the file size, the writes are written to a journal first (the journal is replayed by the next FileHandler after a crash)
+    // so the file has either the old or the new content, the I/O is proportional to the written Bytes and not to the file size
+    ErrorStruct<bool> writeJournaled(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept;
+    // only writes and syncs the journal of writeJournaled, the file is not changed (the next FileHandler of the file applies it)
+    ErrorStruct<bool> writeJournal(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept;
+    // returns the path of the journal of the file
+    static std::filesystem::path getJournalPath(const std::filesystem::path& file);
+    void adviseReadahead(const size_t offset, const size_t len) const noexcept;  // hints the kernel to read the range in the background (if FILE_READAHEAD is set)
 
     // ErrorStruct<bool> writeBytesIfEmpty(Bytes& bytes) noexcept;                                           // writes the given bytes to the file if it is empty
     // ErrorStruct<bool> writeBytes(Bytes& bytes) noexcept;                                                  // writes the given bytes to the file
+    // replaces the content of the file with the given parts (pointer and length), the file is preallocated and the parts are written with writev from their own buffers
+    ErrorStruct<bool> writeParts(const std::vector<std::pair<const unsigned char*, u_int64_t>>& parts) noexcept;
     ErrorStruct<std::ofstream> getWriteStream() noexcept;         // returns a write stream to the file
     ErrorStruct<std::ofstream> getWriteStreamIfEmpty() noexcept;  // returns a write stream to the file if it is empty
+    ErrorStruct<std::ofstream> getUpdateStream() noexcept;        // returns a write stream to the file that keeps the old content
     std::filesystem::path getPath() const noexcept;               // returns the filepath
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <openssl/sha.h>
+
+#include <array>
+#include <cstddef>
+
+#include "hash.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+
+template <size_t HS>
+struct FixedHash;  // hash function with a compile time hash size (only 32, 48 and 64 Bytes are defined)
+
+template <>
+struct FixedHash<32> {
+    // sha256 on raw buffers, no Bytes are created
+    using HashType = sha256;
+    static void hash(const unsigned char* data, const size_t len, unsigned char* out) noexcept { SHA256(data, len, out); }
+};
+
+template <>
+struct FixedHash<48> {
+    // sha384 on raw buffers, no Bytes are created
+    using HashType = sha384;
+    static void hash(const unsigned char* data, const size_t len, unsigned char* out) noexcept { SHA384(data, len, out); }
+};
+
+template <>
+struct FixedHash<64> {
+    // sha512 on raw buffers, no Bytes are created
+    using HashType = sha512;
+    static void hash(const unsigned char* data, const size_t len, unsigned char* out) noexcept { SHA512(data, len, out); }
+};
+
+template <size_t HS>
+struct FixedBlock {
+    /*
+    the FixedBlock struct is the compile time variant of a legacy format block (block length = hash size)
+    it encrypts/decrypts one complete block from a raw buffer into a raw buffer and calculates the block hash of the decrypted data
+    the salt, the block hash and the data stay in a few cache lines, there is no heap allocation
+    */
+    using Array = std::array<unsigned char, HS>;
+
+    // checks if the hash object is the hash function of this hash size (the fixed variants can replace it)
+    static bool matches(const Hash& hash) noexcept { return dynamic_cast<const typename FixedHash<HS>::HashType*>(&hash) != nullptr; }
+
+    // encrypts one block (data + salt elementwise mod 256) and writes the block hash of the decrypted data to dec_hash
+    static void encrypt(const unsigned char* dec_data, const Array& salt, unsigned char* enc_data, Array& dec_hash) noexcept {
+        FixedHash<HS>::hash(dec_data, HS, dec_hash.data());
+        for (size_t i = 0; i < HS; i++) enc_data[i] = dec_data[i] + salt[i];
+    }
+
+    // decrypts one block (data - salt elementwise mod 256) and writes the block hash of the decrypted data to dec_hash
+    static void decrypt(const unsigned char* enc_data, const Array& salt, unsigned char* dec_data, Array& dec_hash) noexcept {
+        for (size_t i = 0; i < HS; i++) dec_data[i] = enc_data[i] - salt[i];
+        FixedHash<HS>::hash(dec_data, HS, dec_hash.data());
+    }
+};
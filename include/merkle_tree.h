@@ -0,0 +1,61 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "bytes.h"
+#include "dataheader.h"
+#include "hash.h"
+#include "settings.h"
+
+struct IntegrityReport {
+    // the result of the verification of an integrity tree
+    bool valid = false;                                    // the data matches with the root of the integrity tree
+    std::vector<std::pair<u_int64_t, u_int64_t>> damaged;  // the regions whose hashes do not match (offset and length in Bytes of the data)
+};
+
+class MerkleTree {
+    /*
+    the MerkleTree class calculates and verifies the integrity tree (hash tree) over the encrypted data of a file
+    it only works on the encrypted Bytes, so no password is needed
+
+    a leaf is leaf_len Bytes of the data (the last leaf can be shorter, empty data is one empty leaf)
+    leaf hash: H(0x00 | leaf), node hash: H(0x01 | left | right), a node without a partner is moved to the next level
+    the leaves are grouped into at most INTEGRITY_REGIONS regions of whole leaves, every region is the subtree over its leaves
+    the regions are hashed in parallel, the root is the tree over the region hashes
+    */
+   public:
+    // returns the number of leaves of data with the given length (at least one)
+    static u_int64_t getLeafCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept;
+    // returns the number of leaves in one region (the last region can have less leaves)
+    static u_int64_t getRegionLeafCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept;
+    // returns the number of regions of data with the given length
+    static u_int64_t getRegionCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept;
+    // returns the Bytes of the data (offset and length) that are covered by the region
+    static std::pair<u_int64_t, u_int64_t> getRegionRange(const u_int64_t data_len, const u_int64_t leaf_len, const u_int64_t region) noexcept;
+
+    // returns the root of the tree over the given nodes (the leaf hashes or the region hashes)
+    static Bytes getRoot(const Hash& hash, std::vector<Bytes> nodes);
+    // returns the hash of one region (the root of the subtree over the leaves of the region)
+    static Bytes getRegionHash(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const u_int64_t region);
+    // returns the hash of one leaf
+    static Bytes getLeafHash(const Hash& hash, const unsigned char* leaf, const u_int64_t len);
+    // returns the hashes of all leaves of the data, the leaves are hashed on a thread pool (0 threads uses one thread per core)
+    static std::vector<Bytes> getLeafHashes(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads = INTEGRITY_THREADS);
+    // returns the hashes of all regions, the regions are hashed on a thread pool (0 threads uses one thread per core)
+    static std::vector<Bytes> getRegionHashes(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads = INTEGRITY_THREADS);
+    // returns the hashes of all regions from the hashes of all leaves of the data
+    static std::vector<Bytes> getRegionHashesFromLeaves(const Hash& hash, const std::vector<Bytes>& leaves, const u_int64_t data_len, const u_int64_t leaf_len);
+
+    // calculates the integrity tree over the data
+    static IntegrityTree build(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads = INTEGRITY_THREADS);
+    // calculates the integrity tree of data with the given length from the hashes of all its leaves, the data is not needed
+    // so an edit only hashes the leaves it changed, the other leaf hashes are taken from the leaf hash table of the file
+    static IntegrityTree buildFromLeaves(const Hash& hash, const std::vector<Bytes>& leaves, const u_int64_t data_len, const u_int64_t leaf_len);
+    // calculates the integrity tree from the (full) hashes of all regions, an edit only builds the regions of the leaves it changed again
+    static IntegrityTree buildFromRegions(const Hash& hash, std::vector<Bytes> regions, const u_int64_t leaf_len);
+    // verifies the data with the integrity tree and reports the regions that do not match
+    static IntegrityReport verify(const Hash& hash, const IntegrityTree& tree, const unsigned char* data, const u_int64_t data_len, const size_t threads = INTEGRITY_THREADS);
+    // verifies the hashes of all leaves of the data with the integrity tree and reports the regions that do not match
+    static IntegrityReport verifyLeaves(const Hash& hash, const IntegrityTree& tree, const std::vector<Bytes>& leaves, const u_int64_t data_len);
+};
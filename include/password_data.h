@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include "file_data.h"
 
@@ -77,12 +78,20 @@ struct PasswordSiteSet {
 };
 
 class PasswordData : public FileData {
+    /*
+    the decrypted data is a sequence of password sets, every set is stored as site, username, email and password
+    every string is stored with one length byte in front of it (so every string is at most 255 Bytes long)
+    a new set can be stored by appending its Bytes (getSetBytes) to the decrypted data
+    */
    private:
     // contains for each site sets of password data, one set contains a username, an email and a password. Multiple sets can be stored for one site
     std::unordered_map<std::string, std::vector<PasswordSiteSet>> siteMap;
     Bytes getBytes() const;
 
    public:
+    // returns the Bytes of one password set in the format of the decrypted data
+    static Bytes getSetBytes(const PasswordSet& pwset);
+
     // checks if the decrypted data is valid for it's use case. Checks if the file mode is correct
     // formats the byte data into the right datatypes (like maps and lists)
     ErrorStruct<bool> constructFileData(FileDataStruct& file_data) noexcept override final;
@@ -95,7 +104,14 @@ class PasswordData : public FileData {
 
     // returns the password data for all sites that contain the substring
     std::vector<PasswordSet> getSets(const std::string substring, const bool sorted) const noexcept;
+    // returns the password data of the site (exact match)
+    std::vector<PasswordSet> getSiteSets(const std::string& site) const noexcept;
+    // returns the number of stored password sets
+    size_t getSetCount() const noexcept;
     void addPw(const PasswordSet pwset);
-    void remPw(const PasswordSet pwset) const noexcept;
-    void editPw(const PasswordSet input) const noexcept;
+    // removes the set (all four strings have to match), returns false if the set is not stored
+    bool remPw(const PasswordSet pwset) noexcept;
+    // replaces the email and the password of the set with the same site and username, returns false if there is no such set
+    // throws if the input is not valid
+    bool editPw(const PasswordSet input);
 };
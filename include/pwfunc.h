@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "chainhash_control.h"
 #include "error.h"
 #include "hash.h"
 
@@ -22,14 +23,22 @@ class PwFunc {
     You can set a timeout (in ms) for the chainhash functions.
     timeout = 0 means no timeout (which is also the default)
     if the timeout is reached before the chainhash is ready calculating it returns with a TIMEOUT SuccessType
+
+    You can also set a ChainHashControl, the chainhash functions (not the timed versions) report their progress to it
+    and return with ERR_CANCELLED if it was cancelled
     */
    private:
     std::shared_ptr<Hash> hash;  // stores the hash function that should be used
+    ChainHashControl* control;   // reports the progress and cancels the chainhash (nullptr if not used)
+
+   private:
+    bool isCancelled(const u_int64_t iterations) const noexcept;  // reports the iterations to the control and checks if the chainhash was cancelled
+
    public:
     // checks the password for illegal characters and length
     static ErrorStruct<bool> isPasswordValid(const std::string& password) noexcept;
 
-    PwFunc(std::shared_ptr<Hash> hash) noexcept;                                                                                            // sets the hash function
+    PwFunc(std::shared_ptr<Hash> hash, ChainHashControl* control = nullptr) noexcept;                                                       // sets the hash function
     ErrorStruct<Bytes> chainhash(const std::string& password, const u_int64_t iterations = 1, const u_int64_t timeout = 0) const noexcept;  // performs a chainhash
     // adds a constant salt each iteration
     ErrorStruct<Bytes> chainhashWithConstantSalt(const std::string& password, const u_int64_t iterations = 1, const std::string& salt = "", const u_int64_t timeout = 0) const noexcept;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "api.h"
+#include "settings.h"
+
+struct RotationSettings {
+    /*
+    the settings of a RotationJob, all vaults of the job use the same settings
+    with new data header settings every vault gets a new data header (new password hash, salts and key) and its content is encrypted again
+    without them only the salts of the vaults are changed (API::changeSalt), the password and the chainhashes are kept
+    */
+    std::string password;                             // the current password of the vaults
+    std::string new_password;                         // the password after the rotation (empty keeps the current password)
+    std::optional<DataHeaderSettingsIters> settings;  // the new data header settings (not set: the vaults are only re-salted)
+    FModes file_mode = FILEMODE_PASSWORD;             // the file mode of the vaults
+};
+
+struct RotationReport {
+    /*
+    the result of one vault of a RotationJob, the times are in microseconds
+    */
+    std::filesystem::path file;  // the rotated vault
+    ErrorStruct<bool> result;    // the result of the rotation (the vault is unchanged if it failed)
+    bool skipped = false;        // the vault was already rotated by an earlier (interrupted) run of the job
+    u_int64_t bytes = 0;         // the size of the rotated vault
+    u_int64_t unlock_time = 0;   // selects the vault and verifies the password
+    u_int64_t decrypt_time = 0;  // decrypts the content
+    u_int64_t rekey_time = 0;    // creates the new data header (or changes the salts)
+    u_int64_t encrypt_time = 0;  // encrypts the content
+    u_int64_t write_time = 0;    // writes and syncs the temporary file and replaces the vault with it
+
+    u_int64_t getTotalTime() const noexcept;  // returns the time of all steps
+};
+
+// writes one report as a csv line (file, success, error code, skipped, bytes and the times)
+std::ostream& operator<<(std::ostream& os, const RotationReport& report);
+
+class RotationJob {
+    /*
+    the RotationJob re-keys or re-salts many vaults (e.g. every vault of a directory) with the same settings
+    the vaults are rotated on a thread pool, at most threads vaults are rotated (and held in memory) at the same time
+    while one worker waits for its file, the others hash and encrypt, the next queued vault is read ahead when a worker starts a vault
+
+    a vault is never written in place: its rotated version is written to a hidden temporary file (ROTATION_TMP_SUFFIX) with the mode and the owner of the vault, synced and renamed over the vault
+    so after a crash every vault is either the old or the complete rotated file, a left temporary file is deleted by the next run
+    the rotated vaults are appended to the journal by their canonical path, a run skips the vaults of the journal, so an interrupted job is resumed by running it again
+    a vault that was replaced but not journaled before the crash is detected by the new password and skipped as well
+    */
+   private:
+    const std::vector<std::filesystem::path> files;       // the vaults of the job
+    const RotationSettings settings;                      // the settings of all vaults
+    const std::filesystem::path journal;                  // stores the rotated vaults (empty disables resuming)
+    const size_t threads;                                 // the number of vaults that are rotated at the same time
+    std::unordered_set<std::string> journaled;            // the vaults of the journal when the run was started
+    std::mutex mutex;                                     // guards the journal file and the running controls
+    std::unordered_set<ChainHashControl*> controls;       // the controls of the running chainhashes, they are cancelled by cancel()
+    std::atomic<bool> cancelled{false};                   // the job was cancelled, the remaining vaults are not rotated
+    std::atomic<size_t> done{0};                          // the number of vaults that are done (rotated, skipped or failed)
+    std::function<void(const RotationReport&)> progress;  // called after every vault (from the worker thread)
+
+   private:
+    RotationReport rotate(const std::filesystem::path& file) noexcept;                      // rotates one vault (runs on a worker)
+    bool isRotated(const std::filesystem::path& file, ChainHashControl* control) noexcept;  // true if the new password unlocks the vault
+    void addToJournal(const std::filesystem::path& file) noexcept;                          // appends a rotated vault to the journal
+    void readJournal() noexcept;                                                            // reads the journaled vaults
+    static std::string getJournalKey(const std::filesystem::path& file) noexcept;           // returns the canonical path of the vault (its line in the journal)
+
+   public:
+    // returns the path of the temporary file the rotated version of the vault is written to
+    static std::filesystem::path getTempPath(const std::filesystem::path& file);
+    // creates the empty temporary file with the mode and the owner of the vault (fails if they cannot be kept)
+    static ErrorStruct<bool> createTempFile(const std::filesystem::path& tmp_path, const std::filesystem::path& file) noexcept;
+    // gives the temporary file the mode of the vault, syncs it and renames it over the vault, the directory is synced afterwards
+    static ErrorStruct<bool> commit(const std::filesystem::path& tmp_path, const std::filesystem::path& file) noexcept;
+    // writes the encrypted data of the API to the temporary file of the vault and commits it (the vault is never written in place)
+    // the temporary file is deleted if the write fails, the vault is unchanged then
+    static ErrorStruct<bool> replaceVault(API& api, const std::filesystem::path& file) noexcept;
+
+    // creates a job (0 threads rotates one vault per core), the vaults are rotated by run()
+    // throws if a new password is set without new data header settings (the password can only be changed with a new data header)
+    RotationJob(const std::vector<std::filesystem::path>& files, const RotationSettings& settings, const std::filesystem::path& journal = "",
+                const size_t threads = ROTATION_THREADS);
+    RotationJob(const RotationJob&) = delete;
+    RotationJob& operator=(const RotationJob&) = delete;
+
+    // rotates all vaults that are not in the journal and returns a report per vault in the order of the files
+    // the progress callback gets every report when its vault is done, it is called from the worker threads
+    // blocks until all vaults are done, must not be called twice at the same time
+    std::vector<RotationReport> run(std::function<void(const RotationReport&)> progress = nullptr);
+    // stops the job, the running chainhashes and the vaults that are not started yet fail with ERR_CANCELLED (can be called from any thread)
+    // a vault that is already written is committed, so no vault is left half rotated
+    void cancel() noexcept;
+
+    size_t getDone() const noexcept { return this->done; }                // returns the number of vaults that are done
+    size_t getTotal() const noexcept { return this->files.size(); }       // returns the number of vaults of the job
+    bool isCancelled() const noexcept { return this->cancelled; }         // true after cancel() was called
+};
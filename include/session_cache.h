@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "bytes.h"
+#include "error.h"
+#include "settings.h"
+
+class SessionCache {
+    /*
+    the SessionCache keeps the password hashes of unlocked vaults, so later API sessions on the same vault can skip the chainhashes
+    an entry is keyed by the canonical path of the vault and belongs to the validator of its data header (a new data header invalidates the entry)
+    the password hashes are stored in locked memory (not swapped out and not written to core dumps) and are wiped when they are removed
+
+    an entry expires if it was not used for the idle ttl or if it is older than the absolute ttl (even if it is used)
+    the cache can be shared between API objects and threads
+
+    the cache lives in the memory of one process only, nothing is written to disk or shared with other processes
+    so a CLI call that starts a new process always pays both chainhashes again, only a long running process (e.g. the VaultAgent, see agent.md) skips them
+    */
+   private:
+    class LockedKey {
+        // a password hash in its own locked pages, the pages are wiped and released when the object is destroyed
+       private:
+        unsigned char* data = nullptr;  // start of the locked pages
+        size_t len = 0;                 // length of the password hash
+        size_t map_len = 0;             // length of the locked pages
+       public:
+        explicit LockedKey(const Bytes& key);  // copies the key into locked pages, throws if the memory cannot be locked
+        LockedKey(const LockedKey&) = delete;
+        LockedKey& operator=(const LockedKey&) = delete;
+        Bytes getKey() const;  // returns a copy of the key
+        ~LockedKey();          // wipes and releases the pages
+    };
+
+    struct Entry {
+        // an unlocked vault
+        Bytes validator = Bytes(0);                       // the validator of the data header the key belongs to
+        std::unique_ptr<LockedKey> key;                   // the password hash
+        std::chrono::steady_clock::time_point created;    // the time the vault was unlocked
+        std::chrono::steady_clock::time_point last_used;  // the time the entry was stored or looked up the last time
+    };
+
+    const std::chrono::milliseconds idle_ttl;        // the time an entry stays in the cache without being used
+    const std::chrono::milliseconds max_ttl;         // the time an entry stays in the cache at most
+    std::mutex mutex;                                // guards the entries
+    std::unordered_map<std::string, Entry> entries;  // the unlocked vaults by their canonical path
+
+   private:
+    static std::string getKeyPath(const std::filesystem::path& file) noexcept;                           // returns the canonical path of the file
+    bool isExpired(const Entry& entry, const std::chrono::steady_clock::time_point now) const noexcept;  // checks the idle and the absolute ttl
+    void removeExpired(const std::chrono::steady_clock::time_point now) noexcept;                        // removes all expired entries (mutex has to be locked)
+
+   public:
+    // the ttls are given in ms
+    explicit SessionCache(const u_int64_t idle_ttl = SESSION_IDLE_TTL, const u_int64_t max_ttl = SESSION_MAX_TTL) noexcept;
+    // stores the password hash of the vault (replaces an old entry), fails with ERR_MEMORY_NOT_LOCKED if the key cannot be stored in locked memory
+    ErrorStruct<bool> store(const std::filesystem::path& file, const Bytes& validator, const Bytes& password_hash) noexcept;
+    // returns the password hash of the vault and refreshes its idle time
+    // fails with ERR_SESSION_NOT_FOUND if the vault is not cached, the entry expired or the validator does not match (the entry is removed)
+    ErrorStruct<Bytes> lookup(const std::filesystem::path& file, const Bytes& validator) noexcept;
+    void remove(const std::filesystem::path& file) noexcept;  // removes the entry of the vault
+    // moves the entry of the file to the new path (the file was renamed over the vault), an old entry of the new path is replaced
+    void rename(const std::filesystem::path& from, const std::filesystem::path& to) noexcept;
+    void clear() noexcept;                                    // removes all entries
+    size_t size() noexcept;                                   // returns the number of entries that are not expired
+};
@@ -23,6 +23,12 @@ const constexpr unsigned char MAX_HASHMODE_NUMBER = 3;
 // stores the default mode
 const constexpr unsigned char STANDARD_HASHMODE = 3;
 
+//##################### CIPHERMODE ####################
+// stores the maximum valid mode, all modes from 1 to this number are valid
+const constexpr unsigned char MAX_CIPHERMODE_NUMBER = 3;
+// stores the default mode (the hash chain block cipher)
+const constexpr unsigned char STANDARD_CIPHERMODE = 1;
+
 //##################### CHAINHASHMODE #################
 // stores the maximum valid mode, all modes from 1 to this number are valid
 const constexpr unsigned char MAX_CHAINHASHMODE_NUMBER = 5;
@@ -46,4 +52,106 @@ const constexpr u_int64_t TIMEOUT_ITERATIONS = 1000;
 
 //##################### LENGTHS #######################
 // stores the minimum length of the dataheader
-const constexpr unsigned int MIN_DATAHEADER_LEN = 104;
\ No newline at end of file
+const constexpr unsigned int MIN_DATAHEADER_LEN = 104;
+//##################### BLOCKCHAIN ####################
+// stores the number of blocks between two salt iterator checkpoints (0 disables the checkpoint table)
+// the checkpoints are appended encrypted to the data and allow decrypting a range without decrypting all blocks in front of it
+// the interval counts hash sized blocks, for the keystream block format it is scaled to cover the same number of Bytes
+const constexpr u_int64_t CHECKPOINT_INTERVAL = 4096;
+// stores the version of the trailer layout (written in the INDEX datablock), files with another version are not selected
+// version 2 appends the leaf hashes of the integrity tree to the trailer, version 3 reseeds the chain at the checkpoint in front of an edit
+// (the stored checkpoint states are authoritative), version 4 gives the content and the checkpoint table room to grow and stores the region hashes
+// files of older versions are still read and encrypted again with the current version on edits
+const constexpr unsigned char TRAILER_VERSION = 4;
+// stores the room (in Bytes) the content gets behind its end when the trailer is laid out: at least the minimum, at least the content length / divisor
+// appends and edits that fit into the room write only the changed Bytes, a content that outgrows it (or shrinks far below it) is laid out again
+const constexpr u_int64_t CONTENT_SLACK_MIN_LEN = 4096;
+const constexpr u_int64_t CONTENT_SLACK_DIVISOR = 8;
+// stores the version of the keystream block format (written in the BLOCKFORMAT datablock, files without it use the legacy format)
+// in this format every block salt is expanded with a counter-mode hash to a keystream of the block length
+const constexpr unsigned char KEYSTREAM_BLOCK_FORMAT = 1;
+// stores the minimum and the maximum block length (in Bytes) of the keystream block format
+const constexpr u_int64_t MIN_BLOCK_LEN = 64;
+const constexpr u_int64_t MAX_BLOCK_LEN = 1024 * 1024;
+// stores the maximum number of independent chains (shards) the content of a file can be split into
+// the shards are encrypted/decrypted in parallel, sharded files have no checkpoint table and cannot be appended/edited in place
+const constexpr u_int64_t MAX_SHARD_COUNT = 256;
+// stores the number of threads that encrypt/decrypt the shards of a file (0 uses one thread per core)
+const constexpr size_t SHARD_THREADS = 0;
+// stores the standard number of decrypted Bytes that a DecryptedReader returns per chunk (rounded up to whole blocks or AEAD chunks)
+const constexpr u_int64_t DECRYPTED_READER_CHUNK_LEN = 1024 * 1024;
+//##################### AEAD ##########################
+// stores the number of plaintext Bytes in one chunk of the AEAD cipher modes, every chunk gets its own tag
+const constexpr u_int64_t AEAD_CHUNK_LEN = 64 * 1024;
+// stores the length of the authentication tag of one chunk
+const constexpr u_int64_t AEAD_TAG_LEN = 16;
+// stores the length of the random key salt (a new key is derived for every encryption, so the chunk nonces are never reused)
+const constexpr u_int64_t AEAD_KEY_SALT_LEN = 16;
+// stores the number of threads that encrypt/decrypt the chunks of a file (0 uses one thread per core)
+const constexpr size_t AEAD_THREADS = 0;
+//##################### INTEGRITY #####################
+// stores the standard number of encrypted Bytes in one leaf of the integrity tree (hash tree over the encrypted data)
+// the root of the tree is stored unencrypted in the header, so the data can be verified without the password
+const constexpr u_int64_t INTEGRITY_LEAF_LEN = 64 * 1024;
+// stores the minimum and the maximum leaf length (in Bytes) of the integrity tree
+const constexpr u_int64_t MIN_INTEGRITY_LEAF_LEN = 4096;
+const constexpr u_int64_t MAX_INTEGRITY_LEAF_LEN = 64 * 1024 * 1024;
+// stores the maximum number of regions the leaves are grouped into, the hash of every region is stored in the header
+// a damaged file reports the regions whose hashes do not match, the regions are verified in parallel
+const constexpr u_int64_t INTEGRITY_REGIONS = 16;
+// stores the number of Bytes of a region hash that are stored in the header (the root is stored with the full hash size)
+const constexpr u_int64_t INTEGRITY_REGION_HASH_LEN = 8;
+// stores the number of threads that hash the regions of the integrity tree (0 uses one thread per core)
+const constexpr size_t INTEGRITY_THREADS = 0;
+//##################### CHECKSUM ######################
+// stores the length of the chunks the data checksum is split into, the checksums of the chunks are added up
+// so an append or an edit only hashes the chunks it writes
+const constexpr u_int64_t CHECKSUM_CHUNK_LEN = 64 * 1024;
+//##################### FILEHANDLER ###################
+// hints the kernel to read the encrypted data of a selected file in the background while the password is verified
+const constexpr bool FILE_READAHEAD = true;
+// stores the suffix of the journal that makes the in place writes of a file (key slots, appends, edits) atomic
+const std::string JOURNAL_SUFFIX = ".journal";
+//##################### SCANNER #######################
+// stores the number of Bytes at the beginning of a header that are read to list the encryption files of a directory
+// (file size, header size, file mode and hash mode), the rest of the header is only read if a file is selected
+const constexpr size_t HEADER_PREFIX_LEN = 18;
+// stores the number of threads that read the header prefixes of the files in a directory (0 uses one thread per core)
+const constexpr size_t SCAN_THREADS = 0;
+//##################### SESSION #######################
+// stores the time (in ms) an unlocked vault stays in the session cache without being used
+const constexpr u_int64_t SESSION_IDLE_TTL = 5 * 60 * 1000;
+// stores the time (in ms) an unlocked vault stays in the session cache at most (even if it is used)
+const constexpr u_int64_t SESSION_MAX_TTL = 60 * 60 * 1000;
+//##################### AGENT #########################
+// stores the maximum length (in Bytes) of one request to the agent (without the length prefix), a request holds at most 4 strings of 255 Bytes
+const constexpr u_int32_t AGENT_MAX_REQUEST_LEN = 4096;
+// stores the maximum length (in Bytes) of one response of the agent (without the length prefix)
+const constexpr u_int32_t AGENT_MAX_RESPONSE_LEN = 16 * 1024 * 1024;
+// stores the number of connections that can wait to be accepted by the agent
+const constexpr int AGENT_BACKLOG = 128;
+// stores the time (in ms) the agent waits after a change before it writes the vault, so changes of many clients are written together
+const constexpr u_int64_t AGENT_WRITE_DELAY = 50;
+
+//##################### MANAGER #######################
+// stores the number of worker threads of a VaultManager that run the expensive calls of all vaults (0 uses one thread per core)
+const constexpr size_t VAULT_MANAGER_THREADS = 0;
+
+//##################### KEYSLOTS ######################
+// stores the maximum number of key slots of a file (passwords that unlock the same random data key of the content)
+const constexpr u_int64_t MAX_KEY_SLOTS = 16;
+
+//##################### ROTATION ######################
+// stores the number of vaults a RotationJob rotates at the same time (0 uses one thread per core)
+// every rotated vault is held in memory (encrypted and decrypted) until it is written, so this also limits the memory of a job
+const constexpr size_t ROTATION_THREADS = 0;
+// is inserted before the extension of a vault to get the hidden temporary file its rotated version is written to (vault.enc -> .vault.rotating.enc)
+const std::string ROTATION_TMP_SUFFIX = ".rotating";
+
+//##################### AUTOSAVE ######################
+// stores the time (in ms) without an edit after which a VaultAutosave writes the unwritten edits (edits of a burst are written together)
+const constexpr u_int64_t AUTOSAVE_DELAY = 100;
+// stores the time (in ms) an edit stays unwritten at most, even if the edits do not stop
+const constexpr u_int64_t AUTOSAVE_MAX_DELAY = 1000;
+// stores the number of unwritten edits after which a VaultAutosave writes them without waiting
+const constexpr u_int64_t AUTOSAVE_MAX_EDITS = 1000;
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+    /*
+    the thread pool class runs submitted tasks on a fixed number of worker threads
+    tasks are started in the order they were submitted, the result (or the thrown exception) is returned with a future
+    the destructor waits until all submitted tasks are done
+    */
+   private:
+    std::vector<std::thread> workers;          // the worker threads
+    std::queue<std::function<void()>> tasks;  // the tasks that are not started yet
+    std::mutex mutex;                          // guards the task queue and the stopping flag
+    std::condition_variable condition;         // wakes up the workers if a task is added or the pool is stopping
+    bool stopping = false;                     // is the pool stopping (no new tasks are accepted)
+
+   private:
+    void work();  // the loop of one worker thread
+
+   public:
+    // creates a pool with the given number of worker threads (0 creates one thread per core)
+    explicit ThreadPool(const size_t threads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    size_t getThreadCount() const noexcept;  // returns the number of worker threads
+
+    // adds a task to the pool, the returned future gets the result of the task
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& task) {
+        using R = std::invoke_result_t<F>;
+        std::shared_ptr<std::packaged_task<R()>> packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        std::future<R> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->stopping) throw std::logic_error("cannot submit a task to a stopping thread pool");
+            this->tasks.emplace([packaged]() { (*packaged)(); });
+        }
+        this->condition.notify_one();
+        return result;
+    }
+};
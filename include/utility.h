@@ -24,4 +24,8 @@ bool isValidNumber(const std::string& number, const bool accept_blank = false, c
 // reads the data from the stream and avoid buffering limits
 bool readData(std::istream& stream, Bytes& data, const unsigned int& size) noexcept;
 // data is at least size bytes long
-bool readData(std::istream& stream, unsigned char* data, const unsigned int& size) noexcept;
\ No newline at end of file
+bool readData(std::istream& stream, unsigned char* data, const unsigned int& size) noexcept;
+// reads size bytes at the offset of the file descriptor (pread), returns the number of read bytes (less than size if the file ends or the read fails)
+size_t readDataAt(const int fd, unsigned char* data, const size_t size, const size_t offset) noexcept;
+// writes size bytes at the offset of the file descriptor (pwrite), returns the number of written bytes (less than size if the write fails)
+size_t writeDataAt(const int fd, const unsigned char* data, const size_t size, const size_t offset) noexcept;
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api.h"
+#include "password_data.h"
+
+enum AgentOp : unsigned char {
+    AGENT_GET = 1,     // returns the password sets of a site (exact match)
+    AGENT_SEARCH = 2,  // returns the password sets of all sites that contain a substring (ignores the case)
+    AGENT_ADD = 3,     // adds a password set
+};
+
+class VaultAgent {
+    /*
+    the VaultAgent keeps the unlocked password data of one vault in memory and serves requests of local clients over a unix domain socket
+    so a lookup does not have to derive the key and decrypt the vault again
+
+    every message starts with its length (4 Bytes, big endian)
+    a request is the operation (1 Byte, AgentOp) followed by its strings (site for GET, substring for SEARCH, site, username, email and password for ADD)
+    a response is the error code (1 Byte, ErrorCode) followed by the number of password sets (4 Bytes, big endian) and the sets
+    every string is stored with one length byte in front of it (like in the password data)
+
+    every client is served by its own thread, lookups run in parallel, an added set is visible to all clients immediately
+    new sets are written to the vault in the background by one writer thread (appended to the encrypted content, after AGENT_WRITE_DELAY)
+    vaults without a resume state are encrypted and written completely instead
+    a writer that is lost by a failed write is unlocked again from the session cache, after the session expired (idle_ttl, max_ttl) the writes fail until the agent is stopped and unlocked again
+    */
+   private:
+    struct Client {
+        // a connected client
+        int fd = -1;                    // the socket of the client
+        std::thread thread;             // the thread that serves the client
+        std::atomic<bool> done{false};  // true if the thread finished (the client disconnected)
+    };
+
+    const std::filesystem::path vault_path;       // the vault that is served
+    const std::filesystem::path socket_path;      // the path of the unix domain socket
+    std::shared_ptr<SessionCache> session_cache;  // lets the writer unlock the vault again without the password
+    std::unique_ptr<API> writer;                  // an unlocked (PASSWORD_VERIFIED) API on the vault, only used by the writer thread
+    bool unlocked = false;                        // true after a successful unlock
+
+    PasswordData data;             // the unlocked password data
+    std::shared_mutex data_mutex;  // guards the password data (lookups share the lock)
+
+    int listen_fd = -1;                // the listening socket
+    std::atomic<bool> running{false};  // true between start and stop
+    std::thread accept_thread;         // accepts the clients
+    std::mutex clients_mutex;          // guards the clients
+    std::list<Client> clients;         // the connected clients (a list, so the clients do not move)
+
+    std::thread write_thread;             // writes the new sets to the vault
+    std::mutex write_mutex;               // guards the writer state
+    std::condition_variable write_cv;     // signals new sets, finished writes and the stop of the writer
+    std::vector<PasswordSet> pending;     // the sets that are not written yet
+    bool writing = false;                 // true while the writer thread writes a batch
+    bool stop_writer = false;             // stops the writer thread after the pending sets are written
+    bool append_supported = true;         // false if the vault has to be written completely
+    u_int64_t write_count = 0;            // the number of successful writes
+    u_int64_t failed_writes = 0;          // the number of failed writes
+    ErrorStruct<bool> write_error{true};  // the error of the last failed write
+
+   private:
+    ErrorStruct<bool> openWriter() noexcept;                                     // selects the vault with a new writer API and unlocks it from the session cache
+    void acceptLoop() noexcept;                                                  // accepts clients until the agent is stopped
+    void serveClient(Client* client) noexcept;                                   // answers the requests of one client until it disconnects
+    Bytes handleRequest(const Bytes& request) noexcept;                          // executes one request and returns the response
+    void writeLoop() noexcept;                                                   // writes the pending sets in batches
+    ErrorStruct<bool> writeSets(const std::vector<PasswordSet>& sets) noexcept;  // appends the sets to the vault
+    ErrorStruct<bool> rewriteVault() noexcept;                                   // encrypts and writes the whole password data
+
+   public:
+    // the writer is unlocked again from a session cache with the given TTLs (in ms), the session policy of every other API by default
+    VaultAgent(const std::filesystem::path& vault_path, const std::filesystem::path& socket_path, const u_int64_t idle_ttl = SESSION_IDLE_TTL,
+               const u_int64_t max_ttl = SESSION_MAX_TTL) noexcept;
+    VaultAgent(const VaultAgent&) = delete;
+    VaultAgent& operator=(const VaultAgent&) = delete;
+
+    // verifies the password (this call is expensive, a timeout in ms can be given) and decrypts the vault into memory
+    ErrorStruct<bool> unlock(const std::string& password, const u_int64_t timeout = 0) noexcept;
+    // creates the socket and starts serving clients (requires a successful unlock)
+    ErrorStruct<bool> start() noexcept;
+    // waits until all sets that were added before are written, returns the error if a write failed
+    ErrorStruct<bool> flush() noexcept;
+    // disconnects all clients, removes the socket and writes the pending sets
+    void stop() noexcept;
+
+    size_t getSetCount() noexcept;       // returns the number of password sets in memory
+    u_int64_t getWriteCount() noexcept;  // returns the number of writes to the vault
+    ~VaultAgent();
+};
+
+class AgentClient {
+    /*
+    connects to a running VaultAgent, one request is answered at a time
+    an AgentClient must not be shared between threads (every thread uses its own connection)
+    */
+   private:
+    int fd = -1;  // the connected socket
+
+   private:
+    // sends the request and returns the password sets of the response
+    ErrorStruct<std::vector<PasswordSet>> request(const AgentOp op, const std::vector<std::string>& fields) noexcept;
+
+   public:
+    explicit AgentClient(const std::filesystem::path& socket_path);  // connects to the agent, throws if the agent is not reachable
+    AgentClient(const AgentClient&) = delete;
+    AgentClient& operator=(const AgentClient&) = delete;
+
+    ErrorStruct<std::vector<PasswordSet>> get(const std::string& site) noexcept;          // returns the password sets of the site
+    ErrorStruct<std::vector<PasswordSet>> search(const std::string& substring) noexcept;  // returns the password sets of all sites that contain the substring
+    ErrorStruct<bool> add(const PasswordSet& pwset) noexcept;                             // adds the password set to the vault
+    ~AgentClient();
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api.h"
+#include "password_data.h"
+#include "settings.h"
+
+class VaultAutosave {
+    /*
+    the VaultAutosave keeps the unlocked password data of one vault in memory and writes the edits in the background (write-behind)
+    an edit changes the data in memory immediately, so every call sees it, and marks it as unwritten
+
+    the writer thread waits until no edit came for delay ms (at most max_delay ms after the first unwritten edit) or max_edits edits are unwritten
+    all unwritten edits are merged into one write:
+    - if only sets were added, the new sets are appended to the encrypted content (API::appendData, only the last block and the trailer are written again)
+    - if a written set was removed or edited, the whole data is encrypted with a new salt and written once to a temporary file that replaces the vault
+    - a set that is removed or edited before it was written only changes the pending sets (an add followed by a remove writes nothing)
+    flush() is a barrier, it returns after every edit that was made before the call is written
+    a writer that is lost by a failed write is unlocked again from the session cache, after the session expired (idle_ttl, max_ttl) the writes fail until the autosave is closed and unlocked again
+    */
+   private:
+    const std::filesystem::path vault_path;       // the vault that is edited
+    const u_int64_t delay;                        // the time (in ms) without an edit after which the edits are written
+    const u_int64_t max_delay;                    // the time (in ms) an edit stays unwritten at most
+    const u_int64_t max_edits;                    // the number of unwritten edits after which they are written without waiting
+    std::shared_ptr<SessionCache> session_cache;  // lets the writer unlock the vault again without the password
+    std::unique_ptr<API> writer;                  // an unlocked (PASSWORD_VERIFIED) API on the vault, only used by the writer thread
+    bool append_supported = true;                 // false if the vault format cannot be appended (every write rewrites the vault)
+    std::mutex unlock_mutex;                      // held by unlock and close, so the vault is unlocked and the writer is started only once
+
+    std::mutex mutex;                                  // guards the password data and the writer state
+    std::condition_variable cv;                        // signals edits, flush requests, finished writes and the stop of the writer
+    PasswordData data;                                 // the current password data (with the unwritten edits)
+    std::vector<PasswordSet> added;                    // the sets that were added since the last write (appended if rewrite is false)
+    bool rewrite = false;                              // a written set was removed or edited, the whole data is written
+    u_int64_t edits = 0;                               // the number of unwritten edits
+    u_int64_t edit_count = 0;                          // the number of all edits
+    u_int64_t written_edits = 0;                       // the number of edits that are written (flush waits for edit_count)
+    std::chrono::steady_clock::time_point first_edit;  // the time of the first unwritten edit
+    std::chrono::steady_clock::time_point last_edit;   // the time of the last edit
+    bool flush_requested = false;                      // the unwritten edits are written without waiting
+    bool unlocked = false;                             // the vault was unlocked, the writer thread runs
+    bool stop_writer = false;                          // stops the writer thread after the unwritten edits are written
+    u_int64_t write_count = 0;                         // the number of successful writes
+    u_int64_t failed_writes = 0;                       // the number of failed writes
+    ErrorStruct<bool> write_error{true};               // the error of the last failed write
+    std::thread write_thread;                          // writes the unwritten edits
+
+   private:
+    ErrorStruct<bool> openWriter() noexcept;                                         // selects the vault with a new writer API and unlocks it from the session cache
+    void writeLoop() noexcept;                                                       // waits for edits and writes them in batches
+    void markEdit() noexcept;                                                        // counts an edit and wakes up the writer (requires the lock)
+    ErrorStruct<bool> appendSets(const std::vector<PasswordSet>& sets) noexcept;     // appends the sets to the encrypted content
+    ErrorStruct<bool> rewriteVault(std::unique_ptr<FileDataStruct>&& fds) noexcept;  // encrypts and writes the whole password data
+
+   public:
+    // the delays are in ms, the edits are written after delay ms without an edit, max_delay ms after the first unwritten edit or after max_edits edits
+    // the writer is unlocked again from a session cache with the given TTLs (in ms), the session policy of every other API by default
+    VaultAutosave(const std::filesystem::path& vault_path, const u_int64_t delay = AUTOSAVE_DELAY, const u_int64_t max_delay = AUTOSAVE_MAX_DELAY,
+                  const u_int64_t max_edits = AUTOSAVE_MAX_EDITS, const u_int64_t idle_ttl = SESSION_IDLE_TTL, const u_int64_t max_ttl = SESSION_MAX_TTL) noexcept;
+    VaultAutosave(const VaultAutosave&) = delete;
+    VaultAutosave& operator=(const VaultAutosave&) = delete;
+
+    // verifies the password (this call is expensive, a timeout in ms can be given), decrypts the vault into memory and starts the writer
+    ErrorStruct<bool> unlock(const std::string& password, const u_int64_t timeout = 0) noexcept;
+
+    // the edits fail with ERR_API_STATE_INVALID if the vault is not unlocked and with ERR_ARGUMENT_INVALID if the set is invalid or not stored
+    ErrorStruct<bool> addPw(const PasswordSet& pwset) noexcept;   // adds the set
+    ErrorStruct<bool> remPw(const PasswordSet& pwset) noexcept;   // removes the set (all four strings have to match)
+    ErrorStruct<bool> editPw(const PasswordSet& pwset) noexcept;  // replaces the email and the password of the set with the same site and username
+
+    std::vector<PasswordSet> getSets(const std::string& substring, const bool sorted) noexcept;  // returns the sets of all sites that contain the substring
+    std::vector<PasswordSet> getSiteSets(const std::string& site) noexcept;                      // returns the sets of the site (exact match)
+    size_t getSetCount() noexcept;                                                               // returns the number of sets in memory
+
+    // waits until every edit that was made before the call is written, returns the error if a write failed
+    ErrorStruct<bool> flush() noexcept;
+    // writes the unwritten edits and stops the writer, the vault has to be unlocked again before the next edit
+    ErrorStruct<bool> close() noexcept;
+
+    u_int64_t getWriteCount() noexcept;  // returns the number of writes to the vault
+    u_int64_t getEditCount() noexcept;   // returns the number of edits
+    ~VaultAutosave();
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "api.h"
+#include "settings.h"
+#include "thread_pool.h"
+
+struct VaultPoolHandle {
+    // the worker pool of a VaultManager as seen by its sessions, the pool itself is owned by the manager
+    std::shared_mutex mutex;     // shared while a task is submitted, exclusive while the manager shuts the pool down
+    ThreadPool* pool = nullptr;  // the pool of the manager, nullptr after the shutdown
+};
+
+class VaultSession : public std::enable_shared_from_this<VaultSession> {
+    /*
+    one vault of a VaultManager, every session has its own API object
+    the calls of a session are queued and run on the worker pool of the manager one after another (in the order they were made)
+    calls of different sessions run in parallel, there is no lock that is shared between the sessions (except the task queue of the pool and the shared lock of the pool handle)
+    every call returns a future with the result of the API call, a session can be used from many threads
+    */
+   private:
+    friend class VaultManager;
+
+    const std::filesystem::path path;         // the selected vault
+    API api;                                  // the API of the vault, only used by the task that runs the queued calls
+    std::shared_ptr<VaultPoolHandle> pool;    // the worker pool of the manager (the session never owns the pool)
+    std::mutex mutex;                         // guards the queue and the scheduled flag
+    std::deque<std::function<void()>> queue;  // the calls that are not started yet
+    bool scheduled = false;                   // true if a task of the pool runs (or will run) the queued calls
+
+   private:
+    void drain() noexcept;  // runs the queued calls until the queue is empty
+
+   public:
+    VaultSession(const std::filesystem::path& path, const FModes file_mode, std::shared_ptr<VaultPoolHandle> pool, std::shared_ptr<SessionCache> session_cache);
+    VaultSession(const VaultSession&) = delete;
+    VaultSession& operator=(const VaultSession&) = delete;
+
+    std::filesystem::path getPath() const noexcept;  // returns the path of the vault
+
+    // queues a call on the API of this session, the future gets the result of the call
+    // throws if the manager of the session was shut down
+    template <typename F>
+    std::future<std::invoke_result_t<F, API&>> call(F&& function) {
+        using R = std::invoke_result_t<F, API&>;
+        std::shared_ptr<VaultSession> self = this->shared_from_this();
+        std::shared_ptr<std::packaged_task<R()>> packaged =
+            std::make_shared<std::packaged_task<R()>>([self, function = std::forward<F>(function)]() mutable { return function(self->api); });
+        std::future<R> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->queue.emplace_back([packaged]() { (*packaged)(); });
+            if (this->scheduled) return result;
+            this->scheduled = true;
+        }
+        // the first call of an idle session starts a task on the pool, the pool cannot be shut down while the task is submitted
+        try {
+            std::shared_lock<std::shared_mutex> pool_lock(this->pool->mutex);
+            if (this->pool->pool == nullptr) throw std::logic_error("the vault manager of the session was shut down");
+            this->pool->pool->submit([self]() { self->drain(); });
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->queue.pop_back();
+            this->scheduled = false;
+            throw;
+        }
+        return result;
+    }
+
+    // the expensive API calls (see API for the documentation)
+    // a control reports the progress of the chainhashes and cancels the call, also if it is still queued (the future gets ERR_CANCELLED)
+    std::future<ErrorStruct<bool>> verifyPassword(const std::string& password, const u_int64_t timeout = 0, std::shared_ptr<ChainHashControl> control = nullptr);
+    std::future<ErrorStruct<bool>> createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout = 0,
+                                                    std::shared_ptr<ChainHashControl> control = nullptr);
+    std::future<ErrorStruct<std::unique_ptr<FileDataStruct>>> getDecryptedData();
+    std::future<ErrorStruct<bool>> encryptData(std::unique_ptr<FileDataStruct>&& file_data);
+    std::future<ErrorStruct<bool>> writeToFile();
+};
+
+class VaultManager {
+    /*
+    the VaultManager serves many vaults in one process, every opened vault gets its own VaultSession (and API object)
+    the expensive calls of all sessions run on one worker pool, the calls of one session never run at the same time
+    the manager can be used from many threads, the sessions can be used after the manager is shut down (their calls throw then)
+    the pool is owned by the manager only, shutdown (or the destructor) waits until all queued calls are done and joins the workers
+    */
+   private:
+    std::unique_ptr<ThreadPool> pool;             // runs the calls of the sessions (nullptr after the shutdown)
+    std::shared_ptr<VaultPoolHandle> handle;      // gives the sessions access to the pool until the shutdown
+    std::shared_ptr<SessionCache> session_cache;  // shared by the APIs of the sessions (nullptr disables the session cache)
+
+   public:
+    // creates the worker pool (0 creates one thread per core)
+    explicit VaultManager(const size_t threads = VAULT_MANAGER_THREADS, std::shared_ptr<SessionCache> session_cache = nullptr);
+    VaultManager(const VaultManager&) = delete;
+    VaultManager& operator=(const VaultManager&) = delete;
+
+    // creates a session and selects the vault (creates an empty vault first if create is true)
+    ErrorStruct<std::shared_ptr<VaultSession>> open(const std::filesystem::path& file, const FModes file_mode, const bool create = false) noexcept;
+    // verifies the same password for many sessions (in the FILE_SELECTED state) and returns the results in the order of the sessions
+    // the sessions are grouped by the settings of their first chainhash (API::getPasswordHashSettings), the first chainhash is done once per group
+    // the groups and then the second chainhashes of all sessions run in parallel on the pool, the call waits for all of them
+    // must not be called from a call of a session (it would wait for the pool it blocks)
+    std::vector<ErrorStruct<bool>> unlockAll(const std::vector<std::shared_ptr<VaultSession>>& sessions, const std::string& password);
+    // new calls of the sessions throw from now on, the queued calls are done and the workers are joined (called by the destructor)
+    // must not be called from a call of a session (it would join its own worker)
+    void shutdown() noexcept;
+    size_t getThreadCount() const noexcept;  // returns the number of worker threads (0 after the shutdown)
+    ~VaultManager();
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "settings.h"
+
+struct VaultInfo {
+    // the information about one encryption file that is read from the beginning of its data header
+    std::string file_name;        // the name of the file in the scanned directory
+    bool empty = false;           // the file is empty (no data header yet)
+    bool valid = false;           // the header prefix is valid (the sizes match with the file and the modes are known)
+    u_int64_t header_size = 0;    // the size of the data header
+    unsigned char file_mode = 0;  // the file mode of the data header
+    unsigned char hash_mode = 0;  // the hash mode of the data header
+};
+
+class VaultScanner {
+    /*
+    the VaultScanner lists the encryption files of a directory together with the beginning of their data headers
+    only the first HEADER_PREFIX_LEN Bytes of a file are read (no FileHandler and no parsing of the full header)
+    the files are read in parallel on a thread pool
+
+    the results are stored in a cache file in the scanned directory, every entry is keyed by the inode, the size and the modification time of the file
+    files that did not change since the last scan are taken from the cache, so they only cost one stat call
+    */
+   private:
+    struct CacheEntry {
+        // a scanned file with the stat values it was scanned with
+        u_int64_t inode = 0;
+        u_int64_t size = 0;
+        int64_t mtime = 0;  // modification time in nanoseconds
+        VaultInfo info;
+    };
+
+    const std::filesystem::path dir;                    // the scanned directory
+    const size_t threads;                               // the number of threads that read the files (0 uses one thread per core)
+    std::unordered_map<std::string, CacheEntry> cache;  // the scanned files by their name
+    size_t read_count = 0;                              // the number of files that were read during the last scan (not in the cache)
+
+   private:
+    void loadCache() noexcept;         // loads the cache file of the directory (a missing or broken cache is ignored)
+    void storeCache() const noexcept;  // writes the cache file of the directory (replaces the old cache file at once)
+
+   public:
+    static const std::string cache_name;  // the name of the cache file in the scanned directory
+
+    // reads the header prefix of the file and checks it against the size of the file (an unreadable file is not valid)
+    static VaultInfo readPrefix(const std::filesystem::path& file, const u_int64_t file_size) noexcept;
+
+    explicit VaultScanner(const std::filesystem::path& dir, const size_t threads = SCAN_THREADS) noexcept;
+    // lists all encryption files of the directory sorted by their name, changed files are read again and the cache is updated
+    ErrorStruct<std::vector<VaultInfo>> scan() noexcept;
+    size_t getReadCount() const noexcept;  // returns the number of files that were read during the last scan
+};
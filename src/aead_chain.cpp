@@ -0,0 +1,182 @@
+#include "aead_chain.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "settings.h"
+#include "utility.h"
+
+AEADChain::AEADChain(const CModes cipher_mode, const Bytes& key, const size_t chunk_len, const u_int64_t first_chunk) : ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free) {
+    // initializes the cipher context with the cipher and the key, the nonce is set for every chunk
+    this->cipher_mode = cipher_mode;
+    this->chunk_len = chunk_len;
+    this->chunk_index = first_chunk;
+    if (chunk_len == 0) {
+        PLOG_FATAL << "chunk length cannot be 0";
+        throw std::invalid_argument("chunk length cannot be 0");
+    }
+    if (key.getLen() != 32) {
+        PLOG_FATAL << "key has to be 32 Bytes long (key_len: " << key.getLen() << ")";
+        throw std::invalid_argument("key has to be 32 Bytes long");
+    }
+    if (this->ctx == nullptr || EVP_CipherInit_ex(this->ctx.get(), this->getCipher(), nullptr, key.getBytes(), nullptr, -1) != 1) {
+        PLOG_FATAL << "could not initialize the cipher context (cipher_mode: " << +cipher_mode << ")";
+        throw std::runtime_error("could not initialize the cipher context");
+    }
+    this->key = key;
+    this->result = std::make_unique<Bytes>(0);
+}
+
+const EVP_CIPHER* AEADChain::getCipher() const {
+    // returns the OpenSSL cipher of the cipher mode (both use a 12 Byte nonce and a 16 Byte tag)
+    switch (this->cipher_mode) {
+        case CIPHERMODE_AES256GCM:
+            return EVP_aes_256_gcm();
+        case CIPHERMODE_CHACHA20POLY1305:
+            return EVP_chacha20_poly1305();
+        default:
+            PLOG_FATAL << "cipher mode is not an AEAD cipher mode (cipher_mode: " << +this->cipher_mode << ")";
+            throw std::invalid_argument("cipher mode is not an AEAD cipher mode");
+    }
+}
+
+void AEADChain::getChunkParams(unsigned char* nonce, unsigned char* aad, const bool last) const noexcept {
+    // the nonce is the big endian chunk index (12 Bytes), the additional data is the chunk index and the last chunk flag (9 Bytes)
+    std::memset(nonce, 0, 12);
+    for (int i = 0; i < 8; i++) nonce[11 - i] = static_cast<unsigned char>(this->chunk_index >> (8 * i));
+    std::memcpy(aad, nonce + 4, 8);
+    aad[8] = last ? 1 : 0;
+}
+
+Bytes AEADChain::deriveKey(const Hash& hash, const Bytes& passwordhash, const Bytes& enc_salt, const Bytes& key_salt) {
+    // hashes the password hash with the encrypted salt and the key salt, the first 32 Bytes are the key
+    Bytes input(passwordhash.getLen() + enc_salt.getLen() + key_salt.getLen());
+    passwordhash.addcopyToBytes(input);
+    enc_salt.addcopyToBytes(input);
+    key_salt.addcopyToBytes(input);
+    return hash.hash(input).copySubBytes(0, 32);
+}
+
+u_int64_t AEADChain::getEncryptedLen(const u_int64_t data_len, const size_t chunk_len) noexcept {
+    // every chunk gets a tag, empty data is encrypted to one empty chunk (only the tag)
+    u_int64_t chunks = std::max<u_int64_t>(1, (data_len + chunk_len - 1) / chunk_len);
+    return data_len + chunks * AEAD_TAG_LEN;
+}
+
+u_int64_t AEADChain::getDecryptedLen(const u_int64_t enc_len, const size_t chunk_len) {
+    // every full chunk has chunk_len + AEAD_TAG_LEN Bytes, the last chunk can be shorter but has at least the tag
+    u_int64_t full_chunks = enc_len / (chunk_len + AEAD_TAG_LEN);
+    u_int64_t rest = enc_len % (chunk_len + AEAD_TAG_LEN);
+    if ((rest == 0 && full_chunks == 0) || (rest != 0 && rest < AEAD_TAG_LEN)) {
+        PLOG_ERROR << "the encrypted length does not match with the chunk length (enc_len: " << enc_len << ", chunk_len: " << chunk_len << ")";
+        throw std::length_error("the encrypted length does not match with the chunk length");
+    }
+    return full_chunks * chunk_len + (rest == 0 ? 0 : rest - AEAD_TAG_LEN);
+}
+
+void AEADChain::addData(const Bytes& data) { this->addData(data.getBytes(), data.getLen()); }
+
+void AEADChain::addData(std::ifstream&& filestream, const size_t stream_len) {
+    // reads the stream chunk by chunk, only one chunk is held in memory
+    size_t in_len = this->getInputChunkLen();
+    Bytes data_part(in_len);
+    u_int64_t written = 0;  // the amount of data that has been added to the chain
+    while (written < stream_len) {
+        data_part.setLen(0);
+        size_t part_len = std::min<size_t>(in_len, stream_len - written);
+        if (!readData(filestream, data_part, part_len)) {
+            PLOG_FATAL << "could not read all bytes from file. streamsize: " << stream_len << ", written: " << written << ", data_part_len: " << part_len;
+            throw std::runtime_error("could not read all bytes from file");
+        }
+        this->addData(data_part.getBytes(), part_len);
+        written += part_len;
+    }
+}
+
+void AEADChain::addData(std::unique_ptr<Bytes>&& data) { this->addData(data->getBytes(), data->getLen()); }
+
+void AEADChain::addData(const unsigned char* data, const size_t data_len) {
+    // a chunk is only processed if more data follows, the last chunk is processed by getResult
+    // complete chunks are processed directly from the given buffer, only partial chunks are buffered
+    size_t in_len = this->getInputChunkLen();
+    if (this->buffer.getMaxLen() < in_len) this->buffer = Bytes(in_len);
+    this->result->addSize(data_len + (data_len / this->chunk_len + 2) * AEAD_TAG_LEN);
+    size_t written = 0;  // the amount of data that has been added to the chain
+    while (written < data_len) {
+        if (this->buffer.getLen() == in_len) {
+            // the buffered chunk is complete and more data follows
+            this->processChunk(this->buffer.getBytes(), in_len, false);
+            this->buffer.setLen(0);
+        }
+        if (this->buffer.getLen() == 0 && data_len - written > in_len) {
+            this->processChunk(data + written, in_len, false);
+            written += in_len;
+            continue;
+        }
+        size_t part_len = std::min<size_t>(in_len - this->buffer.getLen(), data_len - written);
+        this->buffer.addBytes(data + written, part_len);
+        written += part_len;
+    }
+    PLOG_VERBOSE << "added new data to AEAD chain [CHUNK] " << this->chunk_index << " [RESULT_SIZE] " << this->result->getLen() << "B";
+}
+
+std::unique_ptr<Bytes> AEADChain::getResult(const bool last) {
+    // processes the buffered data as the last chunk of the chain and returns the result by moving it
+    PLOG_DEBUG << "moving AEAD chain result. [CHUNK] " << this->chunk_index << " [RESULT_SIZE] " << this->result->getLen() << "B";
+    this->processChunk(this->buffer.getBytes(), this->buffer.getLen(), last);
+    this->buffer.setLen(0);
+    return std::move(this->result);
+}
+
+size_t EncryptAEADChain::getInputChunkLen() const noexcept { return this->chunk_len; }
+
+void EncryptAEADChain::processChunk(const unsigned char* data, const size_t len, const bool last) {
+    // encrypts the chunk and adds the encrypted chunk and its tag to the result
+    unsigned char nonce[12];
+    unsigned char aad[9];
+    this->getChunkParams(nonce, aad, last);
+    if (this->result->getMaxLen() - this->result->getLen() < len + AEAD_TAG_LEN) this->result->addSize(std::max<size_t>(len + AEAD_TAG_LEN, this->result->getMaxLen()));
+    unsigned char* out = this->result->getBytes() + this->result->getLen();
+    int out_len = 0;
+    int final_len = 0;
+    if (EVP_EncryptInit_ex(this->ctx.get(), nullptr, nullptr, nullptr, nonce) != 1 || EVP_EncryptUpdate(this->ctx.get(), nullptr, &out_len, aad, sizeof(aad)) != 1 ||
+        (len > 0 && EVP_EncryptUpdate(this->ctx.get(), out, &out_len, data, len) != 1) || EVP_EncryptFinal_ex(this->ctx.get(), out + len, &final_len) != 1 ||
+        EVP_CIPHER_CTX_ctrl(this->ctx.get(), EVP_CTRL_AEAD_GET_TAG, AEAD_TAG_LEN, out + len) != 1) {
+        PLOG_FATAL << "could not encrypt the chunk (chunk_index: " << this->chunk_index << ")";
+        throw std::runtime_error("could not encrypt the chunk");
+    }
+    this->result->setLen(this->result->getLen() + len + AEAD_TAG_LEN);
+    this->chunk_index++;
+}
+
+size_t DecryptAEADChain::getInputChunkLen() const noexcept { return this->chunk_len + AEAD_TAG_LEN; }
+
+void DecryptAEADChain::processChunk(const unsigned char* data, const size_t len, const bool last) {
+    // decrypts the chunk and verifies its tag, the decrypted chunk is added to the result
+    if (len < AEAD_TAG_LEN) {
+        PLOG_ERROR << "the encrypted chunk is shorter than the tag (chunk_index: " << this->chunk_index << ", len: " << len << ")";
+        throw std::length_error("the encrypted chunk is shorter than the tag");
+    }
+    size_t data_len = len - AEAD_TAG_LEN;
+    unsigned char nonce[12];
+    unsigned char aad[9];
+    unsigned char tag[AEAD_TAG_LEN];
+    std::memcpy(tag, data + data_len, AEAD_TAG_LEN);
+    this->getChunkParams(nonce, aad, last);
+    if (this->result->getMaxLen() - this->result->getLen() < data_len) this->result->addSize(std::max<size_t>(data_len, this->result->getMaxLen()));
+    unsigned char* out = this->result->getBytes() + this->result->getLen();
+    int out_len = 0;
+    int final_len = 0;
+    if (EVP_DecryptInit_ex(this->ctx.get(), nullptr, nullptr, nullptr, nonce) != 1 || EVP_DecryptUpdate(this->ctx.get(), nullptr, &out_len, aad, sizeof(aad)) != 1 ||
+        (data_len > 0 && EVP_DecryptUpdate(this->ctx.get(), out, &out_len, data, data_len) != 1) || EVP_CIPHER_CTX_ctrl(this->ctx.get(), EVP_CTRL_AEAD_SET_TAG, AEAD_TAG_LEN, tag) != 1) {
+        PLOG_FATAL << "could not decrypt the chunk (chunk_index: " << this->chunk_index << ")";
+        throw std::runtime_error("could not decrypt the chunk");
+    }
+    if (EVP_DecryptFinal_ex(this->ctx.get(), out + data_len, &final_len) != 1) {
+        // the tag does not match, the chunk was modified, moved or the content was cut off
+        PLOG_ERROR << "the chunk could not be authenticated (chunk_index: " << this->chunk_index << ")";
+        throw std::runtime_error("the chunk could not be authenticated");
+    }
+    this->result->setLen(this->result->getLen() + data_len);
+    this->chunk_index++;
+}
@@ -4,10 +4,40 @@ implementation of api.h
 
 #include "api.h"
 
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+
+#include "aead_chain.h"
 #include "blockchain_decrypt.h"
 #include "blockchain_encrypt.h"
+#include "checksum.h"
 #include "file_modes.h"
+#include "merkle_tree.h"
+#include "settings.h"
+#include "thread_pool.h"
 #include "timer.h"
+#include "utility.h"
+#include "vault_scanner.h"
+
+namespace {
+void addZeros(Bytes& bytes, const u_int64_t len) {
+    // adds len zero Bytes at the end (the Bytes object grows if it has no room for them)
+    if (bytes.getLen() + len > bytes.getMaxLen()) bytes.addSize(bytes.getLen() + len - bytes.getMaxLen());
+    std::memset(bytes.getBytes() + bytes.getLen(), 0, len);
+    bytes.setLen(bytes.getLen() + len);
+}
+
+void applyWrites(Bytes& part, const u_int64_t start, const std::vector<JournalWrite>& writes) {
+    // overwrites the Bytes of the part (at start of the data) with the writes that overlap with it (offsets in the data)
+    for (const JournalWrite& write : writes) {
+        u_int64_t from = std::max<u_int64_t>(start, write.offset);
+        u_int64_t to = std::min<u_int64_t>(start + part.getLen(), write.offset + write.len);
+        if (from < to) std::memcpy(part.getBytes() + (from - start), write.data + (from - write.offset), to - from);
+    }
+}
+}  // namespace
 
 ErrorStruct<std::unique_ptr<FileHandler>> API::_getFileHandler(const std::filesystem::path& file_path) const noexcept {
     // checks if the given file path is valid and sets the file handler
@@ -26,7 +56,81 @@ ErrorStruct<std::unique_ptr<FileHandler>> API::_getFileHandler(const std::filesy
     }
 }
 
-DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout) const noexcept {
+bool API::_setDataHeaderSettings(DataHeaderHelperStruct& dhhs, DataHeaderParts& dhp, const DataHeaderSettingsBase& ds) const noexcept {
+    // sets the modes and the datablocks of the settings that do not depend on the chainhashes (helper function for _createDataHeaderIters and _createDataHeaderTime)
+    if (ds.getFileDataMode() != this->file_mode) {
+        // the file mode does not match with the file data mode
+        PLOG_ERROR << "The provided file mode does not match with selected file (file_mode: " << +ds.getFileDataMode() << ", selected file file_mode: " << +this->file_mode << ")";
+        dhhs.errorStruct.errorCode = ErrorCode::ERR_FILEMODE_INVALID;
+        dhhs.errorStruct.errorInfo = "The file mode does not match with the file data mode";
+        return false;
+    }
+    DataHeaderSettingsBase settings = ds;
+    try {
+        if (ds.isBlockLenSet()) {
+            // the file uses the keystream block format, the block length is stored in the header
+            settings.setOrReplaceDataBlock(DatablockType::BLOCKFORMAT, DataHeader::createBlockFormatDataBlock(ds.getBlockLen()).getData());
+        }
+        if (ds.isShardCountSet()) {
+            // the content is split into independent chains, the shard length is set when the content is encrypted
+            settings.setOrReplaceDataBlock(DatablockType::SHARDS, DataHeader::createShardDataBlock(ShardLayout{ds.getShardCount(), 0}).getData());
+        }
+        if (ds.isIntegrityLeafLenSet()) {
+            // the integrity tree is stored unencrypted in the header, it is calculated when the content is encrypted
+            IntegrityTree tree = MerkleTree::build(*HashModes::getHash(ds.getHashMode()), nullptr, 0, ds.getIntegrityLeafLen(), 1);
+            settings.setOrReplaceDataBlock(DatablockType::INTEGRITY, DataHeader::createIntegrityDataBlock(tree).getData());
+        }
+        // the key slots of the settings wrap the data key of another header, the new slots are created after the chainhashes
+        settings.removeDataBlocks(DatablockType::KEYSLOT);
+        // the checksum lets selectFile reject damaged files before the chainhashes run, it is set when the content is encrypted
+        settings.setOrReplaceDataBlock(DatablockType::CHECKSUM, DataHeader::createChecksumDataBlock().getData());
+        if (ds.isCipherModeSet()) {
+            // the AEAD cipher modes are stored in the header, the key salt is renewed for every encryption
+            settings.removeDataBlocks(DatablockType::CIPHER);
+            if (ds.getCipherMode() != CIPHERMODE_HASHCHAIN) {
+                Bytes key_salt(AEAD_KEY_SALT_LEN);
+                key_salt.fillrandom();
+                settings.setOrReplaceDataBlock(DatablockType::CIPHER, DataHeader::createCipherDataBlock(CipherFormat{ds.getCipherMode(), AEAD_CHUNK_LEN, key_salt}).getData());
+            }
+        }
+    } catch (const std::exception& e) {
+        // something went wrong while creating the datablocks
+        PLOG_ERROR << "Something went wrong while creating the datablocks (what: " << e.what() << ")";
+        dhhs.errorStruct.errorInfo = "Something went wrong while creating the datablocks";
+        dhhs.errorStruct.what = e.what();
+        return false;
+    }
+    dhp.dec_data_blocks = std::move(settings.dec_data_blocks);
+    dhp.enc_data_blocks = std::move(settings.enc_data_blocks);
+    dhp.setFileDataMode(ds.getFileDataMode());
+    dhp.setHashMode(ds.getHashMode());
+    return true;
+}
+
+void API::_finishDataHeader(DataHeaderHelperStruct& dhhs, DataHeaderParts& dhp, const Hash& hash, const Bytes& password_hash, const DataHeaderSettingsBase& ds) const noexcept {
+    // sets the salt and the key slots and creates the data header (helper function for _createDataHeaderIters and _createDataHeaderTime)
+    Bytes salt(hash.getHashSize());
+    salt.fillrandom();
+    dhp.setEncSalt(salt);
+    // with key slots the content is encrypted with a random data key instead of the password hash
+    Bytes content_key = password_hash;
+    if (ds.isKeySlotCountSet()) {
+        try {
+            content_key = API::_createKeySlots(dhp, hash, content_key, ds.getKeySlotCount());
+        } catch (const std::exception& e) {
+            PLOG_ERROR << "Something went wrong while creating the key slots (what: " << e.what() << ")";
+            dhhs.errorStruct.errorInfo = "Something went wrong while creating the key slots";
+            dhhs.errorStruct.what = e.what();
+            return;
+        }
+    }
+
+    // dataheader parts is now ready to create the dataheader object
+    dhhs.errorStruct = DataHeader::setHeaderParts(dhp);
+    dhhs.Password_hash(content_key);  // adding the content key (password hash or data key) to the dhhs struct
+}
+
+DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout, ChainHashControl* control) const noexcept {
     // creates a DataHeader with the given settings (helper function for createDataHeader)
     if (!ds.isComplete()) {
         PLOG_ERROR << "The given DataHeaderSettingsIters is not complete";
@@ -35,27 +139,23 @@ DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password,
     }
     PLOG_VERBOSE << "Creating data header with iter settings (" << ds << ", timeout: " << timeout << ")";
     DataHeaderHelperStruct dhhs = DataHeaderHelperStruct::createMove(ErrorStruct<std::unique_ptr<DataHeader>>{SuccessType::FAIL, ErrorCode::ERR, ""});
-    if (ds.getFileDataMode() != this->file_mode) {
-        // the file mode does not match with the file data mode
-        PLOG_ERROR << "The provided file mode does not match with selected file (file_mode: " << +ds.getFileDataMode() << ", selected file file_mode: " << +this->file_mode << ")";
-        dhhs.errorStruct.errorCode = ErrorCode::ERR_FILEMODE_INVALID;
-        dhhs.errorStruct.errorInfo = "The file mode does not match with the file data mode";
-        return dhhs;
-    }
     DataHeaderParts dhp;
-    // copy the datablocks
-    dhp.dec_data_blocks = ds.dec_data_blocks;
-    dhp.enc_data_blocks = ds.enc_data_blocks;
+    if (!this->_setDataHeaderSettings(dhhs, dhp, ds)) return dhhs;
     try {
         // trying to get the chainhashes
         std::shared_ptr<ChainHashData> chd1 = std::make_shared<ChainHashData>(Format{ds.getChainHash1Mode()});
         std::shared_ptr<ChainHashData> chd2 = std::make_shared<ChainHashData>(Format{ds.getChainHash2Mode()});
         // setting random data for the chainhashes datablocks (salts that are used by the chainhash)
-        chd1->generateRandomData();
+        // the data of the first chainhash can be given by the settings (shared with other files)
+        if (ds.isChainHash1DataSet())
+            chd1 = ds.getChainHash1Data();
+        else
+            chd1->generateRandomData();
         chd2->generateRandomData();
         // creating ChainHash structures
         dhp.chainhash1 = ChainHash{ds.getChainHash1Mode(), ds.getChainHash1Iters(), chd1};
         dhp.chainhash2 = ChainHash{ds.getChainHash2Mode(), ds.getChainHash2Iters(), chd2};
+        if (!dhp.chainhash1.valid()) throw std::invalid_argument("The chainhash data does not match the mode of the first chainhash");
         if (dhp.chainhash1.getChainHashData()->getLen() != chd1->getLen() || dhp.chainhash2.getChainHashData()->getLen() != chd2->getLen()) {
             throw std::logic_error("The chainhash data length does not match");
         }
@@ -67,17 +167,15 @@ DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password,
         dhhs.errorStruct.what = e.what();
         return dhhs;
     }
-    // setting up the other parts
-    dhp.setFileDataMode(ds.getFileDataMode());
-    dhp.setHashMode(ds.getHashMode());
     // create a new shared hash ptr
     std::shared_ptr<Hash> hash = std::move(HashModes::getHash(dhp.getHashMode()));
 
     // setting up an timer to calculate the remaining time for the second chainhash
     Timer timer;
     timer.start();
+    if (control != nullptr) control->start(dhp.chainhash1.getIters() + dhp.chainhash2.getIters());
     // first chainhash (password -> passwordhash)
-    ErrorStruct<Bytes> ch1_err = ChainHashModes::performChainHash(dhp.chainhash1, hash, password, timeout);
+    ErrorStruct<Bytes> ch1_err = ChainHashModes::performChainHash(dhp.chainhash1, hash, password, timeout, control);
     if (!ch1_err.isSuccess()) {
         // something went wrong while performing the first chainhash
         PLOG_ERROR << "Something went wrong while performing the first chainhash (success: " << +ch1_err.success << ", errorCode: " << +ch1_err.errorCode << ", errorInfo: " << ch1_err.errorInfo
@@ -88,6 +186,7 @@ DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password,
         dhhs.errorStruct.what = ch1_err.what;
         return dhhs;
     }
+    if (control != nullptr) control->finishChainHash(dhp.chainhash1.getIters());
     // handling the timeout
     u_int64_t elapsedTime = timer.peekTime();
     u_int64_t timeout_copy = timeout;
@@ -105,7 +204,7 @@ DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password,
         }
     }
     // second chainhash (passwordhash -> passwordhashhash = validation hash)
-    ErrorStruct<Bytes> ch2_err = ChainHashModes::performChainHash(dhp.chainhash2, hash, ch1_err.returnRef(), timeout_copy);
+    ErrorStruct<Bytes> ch2_err = ChainHashModes::performChainHash(dhp.chainhash2, hash, ch1_err.returnRef(), timeout_copy, control);
     if (!ch2_err.isSuccess()) {
         // something went wrong while performing the second chainhash
         PLOG_ERROR << "Something went wrong while performing the second chainhash (success: " << +ch2_err.success << ", errorCode: " << +ch2_err.errorCode << ", errorInfo: " << ch2_err.errorInfo
@@ -116,15 +215,10 @@ DataHeaderHelperStruct API::_createDataHeaderIters(const std::string& password,
         dhhs.errorStruct.what = ch2_err.what;
         return dhhs;
     }
+    if (control != nullptr) control->finishChainHash(dhp.chainhash2.getIters());
     // setting the validation hash
     dhp.setValidPasswordHash(ch2_err.returnValue());
-    Bytes salt(hash->getHashSize());
-    salt.fillrandom();
-    dhp.setEncSalt(salt);
-
-    // dataheader parts is now ready to create the dataheader object
-    dhhs.errorStruct = DataHeader::setHeaderParts(dhp);
-    dhhs.Password_hash(ch1_err.returnValue());  // adding the password hash to the dhhs struct
+    this->_finishDataHeader(dhhs, dhp, *hash, ch1_err.returnValue(), ds);
     return dhhs;
 }
 
@@ -139,18 +233,8 @@ DataHeaderHelperStruct API::_createDataHeaderTime(const std::string& password, c
     PLOG_VERBOSE << "Creating data header with time settings (" << ds << ")";
     DataHeaderHelperStruct dhhs{ErrorStruct<std::unique_ptr<DataHeader>>{SuccessType::FAIL, ErrorCode::ERR, "", ""}};
 
-    if (ds.getFileDataMode() != this->file_mode) {
-        // the file mode does not match with the file data mode
-        PLOG_ERROR << "The provided file mode does not match with selected file (file_mode: " << +ds.getFileDataMode() << ", selected file file_mode: " << +this->file_mode << ")";
-        dhhs.errorStruct.errorCode = ErrorCode::ERR_FILEMODE_INVALID;
-        dhhs.errorStruct.errorInfo = "The file mode does not match with the file data mode";
-        return dhhs;
-    }
-
     DataHeaderParts dhp;
-    // copy the datablocks
-    dhp.dec_data_blocks = ds.dec_data_blocks;
-    dhp.enc_data_blocks = ds.enc_data_blocks;
+    if (!this->_setDataHeaderSettings(dhhs, dhp, ds)) return dhhs;
     ChainHashTimed ch1;
     ChainHashTimed ch2;
     try {
@@ -174,9 +258,6 @@ DataHeaderHelperStruct API::_createDataHeaderTime(const std::string& password, c
         dhhs.errorStruct.what = e.what();
         return dhhs;
     }
-    // setting up the other parts
-    dhp.setFileDataMode(ds.getFileDataMode());
-    dhp.setHashMode(ds.getHashMode());
     // create new shared hash ptr
     std::shared_ptr<Hash> hash = std::move(HashModes::getHash(dhp.getHashMode()));
 
@@ -211,13 +292,7 @@ DataHeaderHelperStruct API::_createDataHeaderTime(const std::string& password, c
     // collecting the ChainHash that was used (getting the iterations)
     dhp.chainhash2 = ch2_err.returnValue().chainhash;
     dhp.setValidPasswordHash(ch2_err.returnValue().result);
-    Bytes salt(hash->getHashSize());
-    salt.fillrandom();
-    dhp.setEncSalt(salt);
-
-    // dataheader parts is now ready to create the dataheader object
-    dhhs.errorStruct = DataHeader::setHeaderParts(dhp);
-    dhhs.Password_hash(ch1_err.returnValue().result);  // adding the password hash to the dhhs struct
+    this->_finishDataHeader(dhhs, dhp, *hash, ch1_err.returnValue().result, ds);
     return dhhs;
 }
 
@@ -232,16 +307,32 @@ ErrorStruct<bool> API::_select_empty_file(std::unique_ptr<FileHandler>&& file) n
 
 ErrorStruct<bool> API::_select_non_empty_file(std::unique_ptr<FileHandler>&& file) noexcept {
     // sets the file data
+    // the keyless header checksum rejects damaged or partially written headers before the chainhashes of verifyPassword run
+    // the data is not hashed here, its checksum is verified when the data is decrypted the first time
+    ErrorStruct<bool> err_checksum = file->verifyHeaderChecksum();
+    if (!err_checksum.isSuccess()) {
+        PLOG_ERROR << "The file checksum could not be verified (errorCode: " << +err_checksum.errorCode << ", errorInfo: " << err_checksum.errorInfo << ", what: " << err_checksum.what << ")";
+        return err_checksum;
+    }
     ErrorStruct<std::unique_ptr<DataHeader>> err_dataheader = file->getDataHeader();
     if (!err_dataheader.isSuccess()) {
         // the data header could not be read
         PLOG_ERROR << "The data header could not be read (errorCode: " << +err_dataheader.errorCode << ", errorInfo: " << err_dataheader.errorInfo << ", what: " << err_dataheader.what << ")";
         return ErrorStruct<bool>{err_dataheader.success, err_dataheader.errorCode, err_dataheader.errorInfo, err_dataheader.what};
     }
+    // a trailer of another layout would be decrypted as the wrong content, such files are not selected
+    const DataBlock* index = err_dataheader.returnRef()->findDataBlock(DatablockType::INDEX);
+    if (index != nullptr && !API::_isTrailerVersionValid(*index)) {
+        PLOG_ERROR << "The trailer of the file has an unknown version (file_path: " << file->getPath() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_TRAILER_VERSION_INVALID, file->getPath().c_str()};
+    }
     this->dh = err_dataheader.returnMove();
+    // the data is read into the page cache in the background while the password is verified
+    file->adviseReadahead(file->getHeaderSize(), file->getDataSize());
     PLOG_INFO << "File selected (file_path: " << file->getPath().c_str() << ")";
     // set the selected file
     this->selected_file = std::move(file);
+    this->data_checksum_verified = false;
     this->current_state = std::make_unique<FILE_SELECTED>(this);
     return ErrorStruct<bool>{true};
 }
@@ -253,6 +344,8 @@ ErrorStruct<bool> API::_deleteFile() noexcept {
         PLOG_ERROR << "The file could not be deleted (deleteFile)";
         return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_DELETED, this->selected_file->getPath().c_str()};
     }
+    // a new file at the same path must not be unlocked with the old session
+    if (this->session_cache != nullptr) this->session_cache->remove(this->selected_file->getPath());
     // reset the selected file
     return this->current_state->unselectFile();
 }
@@ -265,7 +358,483 @@ ErrorStruct<bool> API::_unselectFile() noexcept {
     return ErrorStruct<bool>{true};
 }
 
-API::API(const FModes file_mode) : current_state(std::make_unique<INIT>(this)), file_mode(file_mode), correct_password_hash(Bytes(0)) {
+ErrorStruct<bool> API::_verifyDataChecksum() noexcept {
+    // the data checksum is verified only once per selected file, the writes of this API keep it valid
+    if (this->data_checksum_verified) return ErrorStruct<bool>{true};
+    ErrorStruct<bool> err = this->selected_file->verifyDataChecksum();
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The data checksum could not be verified (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
+        return err;
+    }
+    this->data_checksum_verified = true;
+    return err;
+}
+
+void API::_storeSession(const std::filesystem::path& file_path) const noexcept {
+    // the session belongs to the validator of the data header, a new data header needs a new session
+    if (this->session_cache == nullptr || this->dh == nullptr) return;
+    try {
+        ErrorStruct<bool> err = this->session_cache->store(file_path, this->dh->getDataHeaderParts().getValidPasswordHash(), this->correct_password_hash);
+        if (!err.isSuccess()) PLOG_WARNING << "The session could not be stored (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
+    } catch (const std::exception& e) {
+        PLOG_WARNING << "The session could not be stored (what: " << e.what() << ")";
+    }
+}
+
+DataLayout API::_getDataLayout() const {
+    // reads the data layout from the index datablock of the data header
+    // the datablock stores the trailer version (1 Byte), the checkpoint interval (8 Bytes), the length of the encrypted content (8 Bytes),
+    // since version 4 the capacity of the content (8 Bytes) and since version 2 the length of the leaf hash table (8 Bytes)
+    // the trailer behind the content capacity holds the checkpoint table and the resume state (each state is 2*HashSize Bytes) and the leaf hash table
+    DataLayout layout;
+    layout.content_len = this->selected_file->getDataSize();
+    u_int64_t state_len = 2 * this->dh->getHashSize();
+    // the datablock is looked up without copying the header parts, only its Bytes are decoded
+    const DataBlock* datablock = this->dh->findDataBlock(DatablockType::INDEX);
+    if (datablock != nullptr) {
+        if (!API::_isTrailerVersionValid(*datablock)) {
+            PLOG_ERROR << "The trailer of the file has an unknown version (len: " << +datablock->getLen() << ")";
+            throw std::logic_error("The trailer of the file has an unknown version");
+        }
+        unsigned char version = datablock->getBytes()[0];
+        u_int64_t interval = datablock->copySubBytes(1, 9).toLong();
+        u_int64_t content_len = datablock->copySubBytes(9, 17).toLong();
+        u_int64_t content_cap = version >= 4 ? datablock->copySubBytes(17, 25).toLong() : content_len;
+        u_int64_t leaf_table_len = this->dh->getLeafTableLen();
+        u_int64_t data_size = this->selected_file->getDataSize();
+        if (interval == 0 || content_len > content_cap || leaf_table_len > data_size || content_cap + state_len > data_size - leaf_table_len ||
+            (data_size - leaf_table_len - content_cap) % state_len != 0) {
+            PLOG_ERROR << "The data layout does not match with the file (interval: " << interval << ", content_len: " << content_len << ", content_cap: " << content_cap
+                       << ", leaf_table_len: " << leaf_table_len << ", data_size: " << data_size << ")";
+            throw std::logic_error("The data layout does not match with the file");
+        }
+        layout.version = version;
+        layout.checkpoint_interval = interval;
+        layout.content_len = content_len;
+        layout.content_cap = content_cap;
+        layout.checkpoint_cap = (data_size - leaf_table_len - content_cap) / state_len - 1;
+        // before version 4 the table has no room, every entry is a checkpoint of the content
+        layout.checkpoints = version >= 4 ? this->_getCheckpointCount(content_len, interval) : layout.checkpoint_cap;
+        layout.leaf_table_len = leaf_table_len;
+        if (version >= 4 && layout.checkpoint_cap != this->_getCheckpointCount(content_cap, interval)) {
+            PLOG_ERROR << "The checkpoint table does not match with the content capacity (checkpoint_cap: " << layout.checkpoint_cap << ", content_cap: " << content_cap << ")";
+            throw std::logic_error("The checkpoint table does not match with the content capacity");
+        }
+        return layout;
+    }
+    // no trailer, the whole data is encrypted content
+    layout.content_cap = layout.content_len;
+    return layout;
+}
+
+u_int64_t API::_getCheckpointInterval() const {
+    // the interval counts hash sized blocks, larger blocks of the keystream block format get a smaller interval
+    return std::max<u_int64_t>(1, CHECKPOINT_INTERVAL * this->dh->getHashSize() / this->dh->getEffectiveBlockLen());
+}
+
+u_int64_t API::_getCheckpointCount(const u_int64_t content_len, const u_int64_t checkpoint_interval) const {
+    // checkpoint i belongs to block (i+1)*interval, every checkpoint block that starts in front of the end of the content has one
+    if (content_len == 0) return 0;
+    return (content_len - 1) / this->dh->getEffectiveBlockLen() / checkpoint_interval;
+}
+
+u_int64_t API::_getContentCapacity(const u_int64_t content_len) const {
+    // the room behind the content is at least CONTENT_SLACK_MIN_LEN Bytes and grows with the content, the capacity ends at a block end
+    u_int64_t block_len = this->dh->getEffectiveBlockLen();
+    u_int64_t capacity = content_len + std::max<u_int64_t>(CONTENT_SLACK_MIN_LEN, content_len / CONTENT_SLACK_DIVISOR);
+    return (capacity + block_len - 1) / block_len * block_len;
+}
+
+Bytes API::_createKeySlots(DataHeaderParts& dhp, const Hash& hash, const Bytes& password_hash, const u_int64_t slot_count) {
+    // the password gets the first slot, so the validator of the header stays the validator of the password
+    Bytes data_key(hash.getHashSize());
+    data_key.fillrandom();
+    dhp.dec_data_blocks.push_back(DataHeader::createKeySlotDataBlock(DataHeader::createKeySlot(hash, password_hash, dhp.getValidPasswordHash(), data_key)));
+    for (u_int64_t slot = 1; slot < slot_count; slot++) dhp.dec_data_blocks.push_back(DataHeader::createKeySlotDataBlock(DataHeader::createFreeKeySlot(hash.getHashSize())));
+    return data_key;
+}
+
+ErrorStruct<Bytes> API::_getKeySlotValidator(const std::string& password, Bytes& password_hash, ChainHashControl* control) const noexcept {
+    // all key slots share the chainhashes of the header, so every password is checked with the same settings
+    try {
+        DataHeaderParts dhp = this->dh->getDataHeaderParts();
+        std::shared_ptr<Hash> hash = std::move(HashModes::getHash(dhp.getHashMode()));
+        ErrorStruct<Bytes> err1 = ChainHashModes::performChainHash(dhp.chainhash1, hash, password, 0, control);
+        if (!err1.isSuccess()) {
+            PLOG_ERROR << "The first chain hash failed (getKeySlotValidator) (errorCode: " << +err1.errorCode << ", errorInfo: " << err1.errorInfo << ", what: " << err1.what << ")";
+            return ErrorStruct<Bytes>{err1.success, err1.errorCode, err1.errorInfo, err1.what};
+        }
+        if (control != nullptr) control->finishChainHash(dhp.chainhash1.getIters());
+        password_hash = err1.returnValue();
+        ErrorStruct<Bytes> err2 = ChainHashModes::performChainHash(dhp.chainhash2, hash, password_hash, 0, control);
+        if (!err2.isSuccess()) {
+            PLOG_ERROR << "The second chain hash failed (getKeySlotValidator) (errorCode: " << +err2.errorCode << ", errorInfo: " << err2.errorInfo << ", what: " << err2.what << ")";
+            return ErrorStruct<Bytes>{err2.success, err2.errorCode, err2.errorInfo, err2.what};
+        }
+        if (control != nullptr) control->finishChainHash(dhp.chainhash2.getIters());
+        return ErrorStruct<Bytes>{err2.returnValue()};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while hashing the password (getKeySlotValidator) (what: " << e.what() << ")";
+        return ErrorStruct<Bytes>{SuccessType::FAIL, ErrorCode::ERR, "Some error occurred while hashing the password", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::_writeKeySlots(const std::vector<KeySlot>& slots) {
+    // the header length does not change, so only the header is written (through the journal of the file) and the data of the file stays where it is
+    u_int64_t header_len = this->dh->getHeaderLength();
+    u_int64_t data_size = this->selected_file->getDataSize();
+    // the data does not change, so its checksum is kept and only the header checksum is calculated again
+    u_int64_t data_checksum = this->dh->getDataChecksum();
+    this->dh->removeDataBlocks(DatablockType::KEYSLOT);
+    for (const KeySlot& slot : slots) this->dh->addDataBlock(DataHeader::createKeySlotDataBlock(slot));
+    // the validator of the header is the validator of the first used slot (the session cache is keyed by it)
+    for (const KeySlot& slot : slots) {
+        if (!slot.isFree()) {
+            this->dh->setValidPasswordHashBytes(slot.validator);
+            break;
+        }
+    }
+    this->dh->calcHeaderBytes();
+    this->dh->setChecksum(data_checksum);
+    if (this->dh->getHeaderLength() != header_len) {
+        PLOG_FATAL << "The header length changed while writing the key slots (old: " << header_len << ", new: " << this->dh->getHeaderLength() << ")";
+        throw std::logic_error("The header length changed while writing the key slots");
+    }
+    // a crash during the write leaves the old or the new header, never a mix of both
+    ErrorStruct<bool> err_write = this->selected_file->writeJournaled({JournalWrite{0, this->dh->getHeaderBytes().getBytes(), header_len}}, header_len + data_size);
+    if (!err_write.isSuccess()) {
+        PLOG_ERROR << "Could not write the key slots to the file (writeKeySlots) (errorCode: " << +err_write.errorCode << ", errorInfo: " << err_write.errorInfo << ")";
+        return err_write;
+    }
+    this->_storeSession(this->selected_file->getPath());
+    return ErrorStruct<bool>{true};
+}
+
+bool API::_isTrailerVersionValid(const DataBlock& index) noexcept {
+    // the first Byte of the index datablock is the version of the trailer layout, version 1 has no leaf hash table
+    // versions 2 and 3 have no content capacity (version 3 has the layout of version 2, but reseeds its chain on edits)
+    if (index.getLen() == 0) return false;
+    unsigned char version = index.getBytes()[0];
+    return (index.getLen() == 17 && version == 1) || (index.getLen() == 25 && (version == 2 || version == 3)) || (index.getLen() == 33 && version == TRAILER_VERSION);
+}
+
+void API::_setIndexDataBlock(const u_int64_t checkpoint_interval, const u_int64_t content_len, const u_int64_t content_cap, const u_int64_t leaf_table_len) {
+    // replaces the index datablock with the current trailer version, the checkpoint interval, the content length and capacity and the length of the leaf hash table
+    // the datablock always has the same length, so the header length does not change if the content is edited in place
+    Bytes index(33);
+    index.addByte(TRAILER_VERSION);
+    Bytes::fromLong(checkpoint_interval, true).addcopyToBytes(index);
+    Bytes::fromLong(content_len, true).addcopyToBytes(index);
+    Bytes::fromLong(content_cap, true).addcopyToBytes(index);
+    Bytes::fromLong(leaf_table_len, true).addcopyToBytes(index);
+    this->dh->setOrReplaceDataBlock(DataBlock(DatablockType::INDEX, index));
+}
+
+void API::_setIntegrityDataBlock(const unsigned char* data, const u_int64_t data_len) {
+    // replaces the integrity datablock with the tree over the new data, the datablock keeps its length
+    IntegrityTree tree = this->dh->getIntegrityTree();
+    if (tree.leaf_len == 0) return;
+    std::unique_ptr<Hash> hash = HashModes::getHash(this->dh->getDataHeaderParts().getHashMode());
+    this->dh->setOrReplaceDataBlock(DataHeader::createIntegrityDataBlock(MerkleTree::build(*hash, data, data_len, tree.leaf_len)));
+}
+
+Bytes API::_setLeafTable(const std::vector<Bytes>& leaves, const u_int64_t data_len) {
+    // the tree is built from the leaf hashes, the leaf hashes and the (full) region hashes are returned as the table that ends the trailer
+    // an edit reads the region hashes of the regions it does not change from the table
+    IntegrityTree tree = this->dh->getIntegrityTree();
+    std::unique_ptr<Hash> hash = HashModes::getHash(this->dh->getDataHeaderParts().getHashMode());
+    std::vector<Bytes> regions = MerkleTree::getRegionHashesFromLeaves(*hash, leaves, data_len, tree.leaf_len);
+    Bytes table((leaves.size() + regions.size()) * hash->getHashSize());
+    for (const Bytes& leaf : leaves) leaf.addcopyToBytes(table);
+    for (const Bytes& region : regions) region.addcopyToBytes(table);
+    this->dh->setOrReplaceDataBlock(DataHeader::createIntegrityDataBlock(MerkleTree::buildFromRegions(*hash, std::move(regions), tree.leaf_len)));
+    return table;
+}
+
+void API::_patchIntegrityTree(std::vector<JournalWrite>& writes, std::vector<Bytes>& hashes, const DataLayout& layout) {
+    // the leaves that are changed by the writes (offsets in the data) are hashed again, the other leaf hashes are read from the leaf hash table
+    // only the regions of the changed leaves are built again, the root is built from the region hashes of the table
+    // the new leaf hashes and the new region hashes are added to the writes, hashes owns their Bytes
+    IntegrityTree tree = this->dh->getIntegrityTree();
+    std::unique_ptr<Hash> hash = HashModes::getHash(this->dh->getDataHeaderParts().getHashMode());
+    u_int64_t hash_size = hash->getHashSize();
+    u_int64_t covered_len = this->selected_file->getDataSize() - layout.leaf_table_len;
+    u_int64_t leaf_count = MerkleTree::getLeafCount(covered_len, tree.leaf_len);
+    u_int64_t region_leaves = MerkleTree::getRegionLeafCount(covered_len, tree.leaf_len);
+    u_int64_t region_count = MerkleTree::getRegionCount(covered_len, tree.leaf_len);
+    std::map<u_int64_t, Bytes> leaves;
+    for (const JournalWrite& write : writes) {
+        if (write.len == 0) continue;
+        for (u_int64_t leaf = write.offset / tree.leaf_len; leaf <= (write.offset + write.len - 1) / tree.leaf_len; leaf++) leaves.emplace(leaf, Bytes(0));
+    }
+    for (std::pair<const u_int64_t, Bytes>& leaf : leaves) {
+        u_int64_t offset = leaf.first * tree.leaf_len;
+        Bytes data = this->_readFileData(offset, std::min<u_int64_t>(tree.leaf_len, covered_len - offset));
+        applyWrites(data, offset, writes);
+        leaf.second = MerkleTree::getLeafHash(*hash, data.getBytes(), data.getLen());
+    }
+    Bytes regions = this->_readFileData(covered_len + leaf_count * hash_size, region_count * hash_size);
+    std::vector<Bytes> region_hashes;
+    for (u_int64_t region = 0; region < region_count; region++) {
+        u_int64_t first = region * region_leaves;
+        u_int64_t last = std::min<u_int64_t>(first + region_leaves, leaf_count);
+        if (leaves.lower_bound(first) != leaves.lower_bound(last)) {
+            // the region has a changed leaf
+            Bytes table = this->_readFileData(covered_len + first * hash_size, (last - first) * hash_size);
+            std::vector<Bytes> nodes;
+            for (u_int64_t leaf = first; leaf < last; leaf++) {
+                std::map<u_int64_t, Bytes>::const_iterator changed = leaves.find(leaf);
+                nodes.push_back(changed != leaves.end() ? changed->second : table.copySubBytes((leaf - first) * hash_size, (leaf - first + 1) * hash_size));
+            }
+            Bytes region_hash = MerkleTree::getRoot(*hash, std::move(nodes));
+            std::memcpy(regions.getBytes() + region * hash_size, region_hash.getBytes(), hash_size);
+        }
+        region_hashes.push_back(regions.copySubBytes(region * hash_size, (region + 1) * hash_size));
+    }
+    this->dh->setOrReplaceDataBlock(DataHeader::createIntegrityDataBlock(MerkleTree::buildFromRegions(*hash, std::move(region_hashes), tree.leaf_len)));
+    // the writes point into hashes, so it is not reallocated while they are added
+    hashes.reserve(hashes.size() + leaves.size() + 1);
+    for (std::pair<const u_int64_t, Bytes>& leaf : leaves) {
+        hashes.push_back(std::move(leaf.second));
+        writes.push_back(JournalWrite{covered_len + leaf.first * hash_size, hashes.back().getBytes(), hash_size});
+    }
+    hashes.push_back(std::move(regions));
+    writes.push_back(JournalWrite{covered_len + leaf_count * hash_size, hashes.back().getBytes(), region_count * hash_size});
+}
+
+u_int64_t API::_patchDataChecksum(const std::vector<JournalWrite>& writes, u_int64_t data_checksum) const {
+    // the data checksum is a sum over the chunks, only the chunks that are changed by the writes (offsets in the data) are read and hashed again
+    u_int64_t data_size = this->selected_file->getDataSize();
+    std::set<u_int64_t> chunks;
+    for (const JournalWrite& write : writes) {
+        if (write.len == 0) continue;
+        for (u_int64_t chunk = write.offset / CHECKSUM_CHUNK_LEN; chunk <= (write.offset + write.len - 1) / CHECKSUM_CHUNK_LEN; chunk++) chunks.insert(chunk);
+    }
+    for (u_int64_t chunk : chunks) {
+        u_int64_t offset = chunk * CHECKSUM_CHUNK_LEN;
+        Bytes data = this->_readFileData(offset, std::min<u_int64_t>(CHECKSUM_CHUNK_LEN, data_size - offset));
+        data_checksum -= Checksum::calculateChunks({{data.getBytes(), data.getLen()}}, offset);
+        applyWrites(data, offset, writes);
+        data_checksum += Checksum::calculateChunks({{data.getBytes(), data.getLen()}}, offset);
+    }
+    return data_checksum;
+}
+
+std::unique_ptr<Bytes> API::_encryptChain(const Bytes& content) {
+    // encrypts the content with one blockchain and lays it out with the trailer (checkpoint table, resume state and the leaf hash table of the integrity tree)
+    EncryptBlockChain ebc{HashModes::getHash(this->dh->getDataHeaderParts().getHashMode()), this->correct_password_hash, this->dh->getDataHeaderParts().getEncSalt(), this->dh->getBlockLen()};
+    u_int64_t checkpoint_interval = this->_getCheckpointInterval();
+    ebc.setCheckpointInterval(checkpoint_interval);
+    ebc.addData(content);
+    std::unique_ptr<Bytes> encrypted = ebc.getResult();
+    return this->_layoutData(std::move(encrypted), *ebc.getCheckpointTable(), ebc.getResumeState(), checkpoint_interval);
+}
+
+std::unique_ptr<Bytes> API::_layoutData(std::unique_ptr<Bytes>&& content, const Bytes& checkpoint_table, const Bytes& resume_state, const u_int64_t checkpoint_interval) {
+    // the content and the checkpoint table are followed by zero Bytes up to their capacity, the trailer does not move until the content outgrows it
+    // so appends and edits write only the changed Bytes in place, the layout is stored in the index (and integrity) datablock
+    u_int64_t content_len = content->getLen();
+    u_int64_t content_cap = this->_getContentCapacity(content_len);
+    u_int64_t checkpoint_cap = this->_getCheckpointCount(content_cap, checkpoint_interval);
+    u_int64_t covered_len = content_cap + (checkpoint_cap + 1) * resume_state.getLen();
+    std::unique_ptr<Bytes> data = std::move(content);
+    data->addSize(covered_len - content_len);
+    addZeros(*data, content_cap - content_len);
+    checkpoint_table.addcopyToBytes(*data);
+    addZeros(*data, checkpoint_cap * resume_state.getLen() - checkpoint_table.getLen());
+    resume_state.addcopyToBytes(*data);
+    Bytes leaf_table(0);
+    u_int64_t leaf_len = this->dh->getIntegrityTree().leaf_len;
+    if (leaf_len != 0) {
+        std::unique_ptr<Hash> hash = HashModes::getHash(this->dh->getDataHeaderParts().getHashMode());
+        leaf_table = this->_setLeafTable(MerkleTree::getLeafHashes(*hash, data->getBytes(), covered_len, leaf_len), covered_len);
+    }
+    this->_setIndexDataBlock(checkpoint_interval, content_len, content_cap, leaf_table.getLen());
+    data->addSize(leaf_table.getLen());
+    leaf_table.addcopyToBytes(data);
+    return data;
+}
+
+ErrorStruct<bool> API::_writeData(const Bytes& data) {
+    // the header gets the size and the checksum of the new data, the whole file goes through the journal (the header of an older trailer version can grow)
+    this->dh->setDataSize(data.getLen());
+    this->dh->calcHeaderBytes();
+    this->dh->setChecksum(data.getBytes(), data.getLen());
+    // the chains of the DecryptedReaders on the old content cannot be continued
+    this->generation++;
+    u_int64_t header_len = this->dh->getHeaderLength();
+    ErrorStruct<bool> err_write = this->selected_file->writeJournaled(
+        {JournalWrite{0, this->dh->getHeaderBytes().getBytes(), header_len}, JournalWrite{header_len, data.getBytes(), data.getLen()}}, header_len + data.getLen());
+    if (!err_write.isSuccess()) {
+        PLOG_ERROR << "Could not write the data to the file (writeData) (errorCode: " << +err_write.errorCode << ", errorInfo: " << err_write.errorInfo << ")";
+        return err_write;
+    }
+    return ErrorStruct<bool>{true};
+}
+
+void API::_setCheckpointStates(BlockChain& bc, const DataLayout& layout, const u_int64_t start, const u_int64_t end) const {
+    // gives the chain the stored checkpoints of the blocks behind start up to end (Bytes of the content, start is the start of a block)
+    // since version 3 the chain is reseeded at some checkpoints, the checkpoints of older versions follow from the chain
+    if (layout.version < 3 || layout.checkpoint_interval == 0 || end == 0) return;
+    u_int64_t first = start / bc.getBlockLen() / layout.checkpoint_interval;
+    u_int64_t last = std::min<u_int64_t>((end - 1) / bc.getBlockLen() / layout.checkpoint_interval, layout.checkpoints);
+    if (first >= last) return;
+    bc.setCheckpointStates(this->_readFileData(layout.content_cap + first * bc.getStateLen(), (last - first) * bc.getStateLen()), first, layout.checkpoint_interval);
+}
+
+template <typename Chain>
+void API::_addFileData(Chain& bc, const u_int64_t start, const u_int64_t len) const {
+    // adds a part of the encrypted content to the blockchain
+    // the mapped file is consumed directly, buffered reads are only used if the file cannot be mapped
+    ErrorStruct<std::unique_ptr<FileMapping>> mapping = this->selected_file->getDataMapping();
+    if (mapping.isSuccess()) {
+        bc.addData(mapping.returnRef()->getData() + start, len);
+        return;
+    }
+    std::ifstream data_stream = this->selected_file->getDataStream();
+    data_stream.seekg(start, std::ios::cur);
+    bc.addData(std::move(data_stream), len);
+}
+
+Bytes API::_readFileData(const u_int64_t start, const u_int64_t len) const {
+    // reads a part of the encrypted content with one pread on the selected file
+    Bytes data(len);
+    if (this->selected_file->readAt(data.getBytes(), len, this->selected_file->getHeaderSize() + start) != len) {
+        PLOG_ERROR << "Could not read the data from the file (start: " << start << ", len: " << len << ")";
+        throw std::length_error("Could not read the data from the file");
+    }
+    data.setLen(len);
+    return data;
+}
+
+std::unique_ptr<Bytes> API::_encryptShards(const Bytes& data, const ShardLayout& shards) const {
+    // encrypts every shard with its own blockchain on a thread pool and concatenates the results
+    // the shards are independent, so the order in which they are finished does not matter
+    HModes hash_mode = this->dh->getDataHeaderParts().getHashMode();
+    std::unique_ptr<Hash> hash = HashModes::getHash(hash_mode);
+    u_int64_t used = std::max<u_int64_t>(1, (data.getLen() + shards.shard_len - 1) / shards.shard_len);
+    size_t threads = SHARD_THREADS == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : SHARD_THREADS;
+    ThreadPool pool(std::min<size_t>(used, threads));
+    std::vector<std::future<std::unique_ptr<Bytes>>> results;
+    for (u_int64_t shard = 0; shard < used; shard++) {
+        Bytes salt = BlockChain::getShardSalt(*hash, this->dh->getDataHeaderParts().getEncSalt(), shard, shards.shard_count);
+        results.push_back(pool.submit([this, &data, &shards, hash_mode, shard, salt]() {
+            u_int64_t start = shard * shards.shard_len;
+            EncryptBlockChain ebc{HashModes::getHash(hash_mode), this->correct_password_hash, salt, this->dh->getBlockLen()};
+            ebc.addData(data.getBytes() + start, std::min<u_int64_t>(shards.shard_len, data.getLen() - start));
+            return ebc.getResult();
+        }));
+    }
+    std::unique_ptr<Bytes> encrypted = std::make_unique<Bytes>(data.getLen());
+    for (std::future<std::unique_ptr<Bytes>>& result : results) result.get()->addcopyToBytes(*encrypted);
+    return encrypted;
+}
+
+std::unique_ptr<Bytes> API::_decryptShards(const u_int64_t offset, const u_int64_t len) const {
+    // decrypts the shards that overlap with the range on a thread pool
+    // every shard is decrypted from its beginning up to the end of the range
+    ShardLayout shards = this->dh->getShardLayout();
+    if (len == 0) return std::make_unique<Bytes>(0);
+    if (shards.shard_len == 0) {
+        PLOG_ERROR << "The shard datablock does not contain a shard length";
+        throw std::logic_error("The shard datablock does not contain a shard length");
+    }
+    HModes hash_mode = this->dh->getDataHeaderParts().getHashMode();
+    std::unique_ptr<Hash> hash = HashModes::getHash(hash_mode);
+    u_int64_t first = offset / shards.shard_len;
+    u_int64_t last = (offset + len - 1) / shards.shard_len;
+    if (last >= shards.shard_count) {
+        PLOG_ERROR << "The range is out of the shards (offset: " << offset << ", len: " << len << ", shard_count: " << shards.shard_count << ")";
+        throw std::length_error("The range is out of the shards");
+    }
+    size_t threads = SHARD_THREADS == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : SHARD_THREADS;
+    ThreadPool pool(std::min<size_t>(last - first + 1, threads));
+    std::vector<std::future<std::unique_ptr<Bytes>>> results;
+    for (u_int64_t shard = first; shard <= last; shard++) {
+        Bytes salt = BlockChain::getShardSalt(*hash, this->dh->getDataHeaderParts().getEncSalt(), shard, shards.shard_count);
+        results.push_back(pool.submit([this, &shards, hash_mode, shard, salt, offset, len]() {
+            u_int64_t start = shard * shards.shard_len;
+            u_int64_t end = std::min<u_int64_t>(start + shards.shard_len, offset + len);
+            DecryptBlockChain dbc{HashModes::getHash(hash_mode), this->correct_password_hash, salt, this->dh->getBlockLen()};
+            this->_addFileData(dbc, start, end - start);
+            return dbc.getResult();
+        }));
+    }
+    std::unique_ptr<Bytes> decrypted = std::make_unique<Bytes>(len);
+    for (u_int64_t shard = first; shard <= last; shard++) {
+        std::unique_ptr<Bytes> result = results[shard - first].get();
+        // the first shard is decrypted from its beginning, skip the Bytes in front of the range
+        u_int64_t skip = shard == first ? offset - first * shards.shard_len : 0;
+        decrypted->addBytes(result->getBytes() + skip, result->getLen() - skip);
+    }
+    return decrypted;
+}
+
+std::unique_ptr<Bytes> API::_encryptAEAD(const Bytes& data, const CipherFormat& cipher) const {
+    // splits the chunks into one group per thread, every group is encrypted by its own chain
+    // the chunks are independent, so the groups can be concatenated in order
+    Bytes key = AEADChain::deriveKey(*HashModes::getHash(this->dh->getDataHeaderParts().getHashMode()), this->correct_password_hash, this->dh->getDataHeaderParts().getEncSalt(), cipher.key_salt);
+    u_int64_t chunks = std::max<u_int64_t>(1, (data.getLen() + cipher.chunk_len - 1) / cipher.chunk_len);
+    size_t threads = AEAD_THREADS == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : AEAD_THREADS;
+    u_int64_t group_chunks = (chunks + threads - 1) / threads;
+    ThreadPool pool(std::min<size_t>((chunks + group_chunks - 1) / group_chunks, threads));
+    std::vector<std::future<std::unique_ptr<Bytes>>> results;
+    for (u_int64_t first = 0; first < chunks; first += group_chunks) {
+        results.push_back(pool.submit([&data, &cipher, &key, first, group_chunks, chunks]() {
+            u_int64_t start = first * cipher.chunk_len;
+            u_int64_t end = std::min<u_int64_t>(data.getLen(), (first + group_chunks) * cipher.chunk_len);
+            EncryptAEADChain eac{cipher.cipher_mode, key, cipher.chunk_len, first};
+            eac.addData(data.getBytes() + start, end - start);
+            return eac.getResult(first + group_chunks >= chunks);
+        }));
+    }
+    std::unique_ptr<Bytes> encrypted = std::make_unique<Bytes>(AEADChain::getEncryptedLen(data.getLen(), cipher.chunk_len));
+    for (std::future<std::unique_ptr<Bytes>>& result : results) result.get()->addcopyToBytes(*encrypted);
+    return encrypted;
+}
+
+std::unique_ptr<Bytes> API::_decryptAEAD(const u_int64_t offset, const u_int64_t len) const {
+    // decrypts the chunks that overlap with the range in one group per thread
+    // the tag of every decrypted chunk is verified, the last chunk of the content is verified as the last chunk
+    CipherFormat cipher = this->dh->getCipherFormat();
+    Bytes key = AEADChain::deriveKey(*HashModes::getHash(this->dh->getDataHeaderParts().getHashMode()), this->correct_password_hash, this->dh->getDataHeaderParts().getEncSalt(), cipher.key_salt);
+    u_int64_t enc_len = this->selected_file->getDataSize();
+    u_int64_t enc_chunk_len = cipher.chunk_len + AEAD_TAG_LEN;
+    u_int64_t chunks = (enc_len + enc_chunk_len - 1) / enc_chunk_len;
+    if (offset + len > AEADChain::getDecryptedLen(enc_len, cipher.chunk_len)) {
+        PLOG_ERROR << "The range is out of the content (offset: " << offset << ", len: " << len << ")";
+        throw std::length_error("The range is out of the content");
+    }
+    // an empty range at the end of the content still verifies the last chunk
+    u_int64_t first = std::min<u_int64_t>(offset / cipher.chunk_len, chunks - 1);
+    u_int64_t last = len == 0 ? first : (offset + len - 1) / cipher.chunk_len;
+    size_t threads = AEAD_THREADS == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : AEAD_THREADS;
+    u_int64_t group_chunks = (last - first + threads) / threads;
+    ThreadPool pool(std::min<size_t>((last - first + group_chunks) / group_chunks, threads));
+    std::vector<std::future<std::unique_ptr<Bytes>>> results;
+    for (u_int64_t group = first; group <= last; group += group_chunks) {
+        results.push_back(pool.submit([this, &cipher, &key, group, group_chunks, last, chunks, enc_len, enc_chunk_len]() {
+            u_int64_t group_last = std::min<u_int64_t>(group + group_chunks - 1, last);
+            u_int64_t start = group * enc_chunk_len;
+            u_int64_t end = std::min<u_int64_t>(enc_len, (group_last + 1) * enc_chunk_len);
+            DecryptAEADChain dac{cipher.cipher_mode, key, cipher.chunk_len, group};
+            this->_addFileData(dac, start, end - start);
+            return dac.getResult(group_last == chunks - 1);
+        }));
+    }
+    std::unique_ptr<Bytes> decrypted = std::make_unique<Bytes>(len);
+    u_int64_t skip = offset - first * cipher.chunk_len;  // the Bytes of the first chunk in front of the range
+    for (std::future<std::unique_ptr<Bytes>>& result : results) {
+        std::unique_ptr<Bytes> part = result.get();
+        u_int64_t take = std::min<u_int64_t>(part->getLen() - skip, len - decrypted->getLen());
+        decrypted->addBytes(part->getBytes() + skip, take);
+        skip = 0;
+    }
+    return decrypted;
+}
+
+API::API(const FModes file_mode, std::shared_ptr<SessionCache> session_cache)
+    : current_state(std::make_unique<INIT>(this)), file_mode(file_mode), correct_password_hash(Bytes(0)), session_cache(session_cache) {
     // constructs the API in a given workflow mode and initializes the private variables
     PLOG_VERBOSE << "API object created (file_mode: " << +file_mode << ")";
     if (!FileModes::isModeValid(file_mode)) {
@@ -336,30 +905,21 @@ ErrorStruct<std::vector<std::string>> API::getAllEncFileNames(const std::filesys
 
 ErrorStruct<std::vector<std::string>> API::INIT::getRelevantFileNames(const std::filesystem::path& dir) noexcept {
     // only gets the file names that have the same file mode as the given file data or are empty
-    // gets all file names
+    // the files are checked by their header prefix (VaultScanner), unchanged files are taken from the scan cache of the directory
     PLOG_VERBOSE << "Getting relevant file names (dir: " << dir << ")";
-    ErrorStruct<std::vector<std::string>> err = API::getAllEncFileNames(dir);
+    VaultScanner scanner{dir};
+    ErrorStruct<std::vector<VaultInfo>> err = scanner.scan();
     if (!err.isSuccess()) {
-        PLOG_ERROR << "Could not get all file names (getRelevantFileNames) (err.errorCode: " << +err.errorCode << ", err.errorInfo: " << err.errorInfo << ")";
-        return err;
+        PLOG_ERROR << "Could not scan the directory (getRelevantFileNames) (err.errorCode: " << +err.errorCode << ", err.errorInfo: " << err.errorInfo << ")";
+        return ErrorStruct<std::vector<std::string>>{err.success, err.errorCode, err.errorInfo, err.what};
     }
-    ErrorStruct<std::vector<std::string>> ret{std::vector<std::string>()};
-    for (int i = 0; i < err.returnRef().size(); i++) {
-        // checks for every file if it has the same file mode as the given file data
-        // build the complete file path
-        std::filesystem::path fp = dir / err.returnRef()[i];
-        // checks if the file data mode matches with the file mode of the file is empty
-        ErrorStruct<std::unique_ptr<FileHandler>> err2 = this->parent->_getFileHandler(fp);
-        if (err2.isSuccess()) {
-            if (err2.returnRef()->isEmtpy() || err2.returnRef()->isDataHeader(this->parent->file_mode).isSuccess()) {
-                // dataheader is valid or file is empty
-                // we include the file to the relevant files
-                std::vector<std::string> tmp = ret.returnRef();
-                tmp.push_back(err.returnValue()[i]);
-            }
-        }
+    PLOG_DEBUG << "Scanned " << err.returnRef().size() << " files, " << scanner.getReadCount() << " were read (getRelevantFileNames)";
+    std::vector<std::string> file_names;
+    for (const VaultInfo& info : err.returnRef()) {
+        // the file is empty or its data header stores the wished file data
+        if (info.empty || (info.valid && info.file_mode == this->parent->file_mode)) file_names.push_back(info.file_name);
     }
-    return ret;
+    return ErrorStruct<std::vector<std::string>>{file_names};
 }
 
 ErrorStruct<bool> API::INIT::createFile(const std::filesystem::path& file_path) noexcept {
@@ -428,7 +988,7 @@ ErrorStruct<bool> API::EMPTY_FILE_SELECTED::unselectFile() noexcept {
     return this->parent->_unselectFile();
 }
 
-ErrorStruct<bool> API::FILE_SELECTED::verifyPassword(const std::string& password, const u_int64_t timeout) noexcept {
+ErrorStruct<bool> API::FILE_SELECTED::verifyPassword(const std::string& password, const u_int64_t timeout, ChainHashControl* control) noexcept {
     // timeout=0 means no timeout
     // checks if a password (given from the user to decrypt) is valid for the selected file and returns its hash.
     // This call is expensive
@@ -443,13 +1003,15 @@ ErrorStruct<bool> API::FILE_SELECTED::verifyPassword(const std::string& password
         // perform the first chain hash (password -> passwordhash)
         Timer timer;
         timer.start();
-        ErrorStruct<Bytes> err1 = ChainHashModes::performChainHash(dhp.chainhash1, hash, password, timeout);
+        if (control != nullptr) control->start(dhp.chainhash1.getIters() + dhp.chainhash2.getIters());
+        ErrorStruct<Bytes> err1 = ChainHashModes::performChainHash(dhp.chainhash1, hash, password, timeout, control);
         if (!err1.isSuccess()) {
             // the first chain hash failed (due to timeout or other error)
             PLOG_ERROR << "The first chain hash failed (verifyPassword) (err1.success: " << +err1.success << ", err1.errorCode: " << +err1.errorCode << ", err1.errorInfo: " << err1.errorInfo
                        << ", err1.what: " << err1.what << ")";
             return ErrorStruct<bool>{err1.success, err1.errorCode, err1.errorInfo, err1.what};
         }
+        if (control != nullptr) control->finishChainHash(dhp.chainhash1.getIters());
         // perform the second chain hash (passwordhash -> passwordhashhash = validation hash)
         u_int64_t new_timeout = timeout - timer.peekTime();
         timer.stop();
@@ -461,29 +1023,7 @@ ErrorStruct<bool> API::FILE_SELECTED::verifyPassword(const std::string& password
             err.errorInfo = "Timeout reached after the first chainhash";
             return err;
         }
-        ErrorStruct<Bytes> err2 = ChainHashModes::performChainHash(dhp.chainhash2, hash, err1.returnRef(), new_timeout);
-        if (!err2.isSuccess()) {
-            // the second chain hash failed (due to timeout or other error)
-            PLOG_ERROR << "The second chain hash failed (verifyPassword) (err2.success: " << +err2.success << ", err2.errorCode: " << +err2.errorCode << ", err2.errorInfo: " << err2.errorInfo
-                       << ", err2.what: " << err2.what << ")";
-            return ErrorStruct<bool>{err2.success, err2.errorCode, err2.errorInfo, err2.what};
-        }
-        if (err2.returnValue() == dhp.getValidPasswordHash()) {
-            // the password is valid (because the validation hashes match)
-            // updating the state
-            // setting the correct password hash and dataheader to the application
-            PLOG_INFO << "The given password is valid (verifyPassword)";
-            this->parent->correct_password_hash = err1.returnValue();
-            this->parent->current_state = std::make_unique<PASSWORD_VERIFIED>(this->parent);
-            return ErrorStruct<bool>{true};
-        }
-        // the password is invalid
-        PLOG_WARNING << "The given password is invalid (verifyPassword)";
-        ErrorStruct<bool> err;
-        err.success = SuccessType::FAIL;
-        err.errorCode = ErrorCode::ERR_PASSWORD_INVALID;
-        return err;
-
+        return this->checkPasswordHash(dhp, hash, err1.returnRef(), new_timeout, control);
     } catch (const std::exception& e) {
         // some error occurred
         PLOG_ERROR << "Some error occurred while verifying the password (verifyPassword) (what: " << e.what() << ")";
@@ -492,7 +1032,107 @@ ErrorStruct<bool> API::FILE_SELECTED::verifyPassword(const std::string& password
     }
 }
 
-ErrorStruct<bool> API::EMPTY_FILE_SELECTED::createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout) noexcept {
+ErrorStruct<bool> API::FILE_SELECTED::checkPasswordHash(const DataHeaderParts& dhp, std::shared_ptr<Hash> hash, const Bytes& password_hash, const u_int64_t timeout,
+                                                         ChainHashControl* control) noexcept {
+    // performs the second chainhash on the password hash and compares it with the validator, the state changes on success
+    // files with key slots compare it with the validator of every used slot, the data key of the matching slot is the content key
+    // the caller must not use this state object afterwards
+    ErrorStruct<Bytes> err2 = ChainHashModes::performChainHash(dhp.chainhash2, hash, password_hash, timeout, control);
+    if (!err2.isSuccess()) {
+        // the second chain hash failed (due to timeout or other error)
+        PLOG_ERROR << "The second chain hash failed (verifyPassword) (err2.success: " << +err2.success << ", err2.errorCode: " << +err2.errorCode << ", err2.errorInfo: " << err2.errorInfo
+                   << ", err2.what: " << err2.what << ")";
+        return ErrorStruct<bool>{err2.success, err2.errorCode, err2.errorInfo, err2.what};
+    }
+    if (control != nullptr) control->finishChainHash(dhp.chainhash2.getIters());
+    Bytes content_key(0);
+    try {
+        std::vector<KeySlot> slots = this->parent->dh->getKeySlots();
+        if (slots.empty() && err2.returnValue() == dhp.getValidPasswordHash()) content_key = password_hash;
+        for (const KeySlot& slot : slots) {
+            if (!slot.isFree() && slot.validator == err2.returnValue()) {
+                content_key = DataHeader::unwrapKeySlot(*hash, password_hash, slot);
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The key slots of the data header are invalid (verifyPassword) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "The key slots of the data header are invalid", e.what()};
+    }
+    if (!content_key.isEmpty()) {
+        // the password is valid (because the validation hashes match)
+        // updating the state
+        // setting the correct password hash and dataheader to the application
+        PLOG_INFO << "The given password is valid (verifyPassword)";
+        this->parent->correct_password_hash = content_key;
+        this->parent->_storeSession(this->parent->selected_file->getPath());
+        this->parent->current_state = std::make_unique<PASSWORD_VERIFIED>(this->parent);
+        return ErrorStruct<bool>{true};
+    }
+    // the password is invalid
+    PLOG_WARNING << "The given password is invalid (verifyPassword)";
+    ErrorStruct<bool> err;
+    err.success = SuccessType::FAIL;
+    err.errorCode = ErrorCode::ERR_PASSWORD_INVALID;
+    return err;
+}
+
+ErrorStruct<PasswordHashSettings> API::FILE_SELECTED::getPasswordHashSettings() noexcept {
+    // the first chainhash and the hash mode are everything that is needed to get the password hash from the password
+    try {
+        DataHeaderParts dhp = this->parent->dh->getDataHeaderParts();
+        PasswordHashSettings settings;
+        settings.hash_mode = dhp.getHashMode();
+        settings.chainhash1 = dhp.chainhash1;
+        return ErrorStruct<PasswordHashSettings>{settings};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while reading the data header (getPasswordHashSettings) (what: " << e.what() << ")";
+        return ErrorStruct<PasswordHashSettings>{SuccessType::FAIL, ErrorCode::ERR, "Some error occurred while reading the data header", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::FILE_SELECTED::verifyPasswordHash(const Bytes& password_hash, const u_int64_t timeout, ChainHashControl* control) noexcept {
+    // only the second chainhash is done, the password hash was calculated with the settings of getPasswordHashSettings
+    PLOG_VERBOSE << "Verifying password hash (timeout: " << timeout << ")";
+    try {
+        DataHeaderParts dhp = this->parent->dh->getDataHeaderParts();
+        std::shared_ptr<Hash> hash = std::move(HashModes::getHash(dhp.getHashMode()));
+        if (password_hash.getLen() != hash->getHashSize()) {
+            PLOG_WARNING << "The password hash has the wrong length (verifyPasswordHash) (length: " << password_hash.getLen() << ")";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_PASSWORD_INVALID, "The password hash has the wrong length"};
+        }
+        if (control != nullptr) control->start(dhp.chainhash2.getIters());
+        return this->checkPasswordHash(dhp, hash, password_hash, timeout, control);
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while verifying the password hash (verifyPasswordHash) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "Some error occurred while verifying the password hash", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::FILE_SELECTED::unlockFromSession() noexcept {
+    // takes the password hash from the session cache, the session belongs to the validator of the selected data header
+    PLOG_VERBOSE << "Unlocking from session";
+    if (this->parent->session_cache == nullptr) {
+        PLOG_WARNING << "The API has no session cache (unlockFromSession)";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_SESSION_NOT_FOUND, "The API has no session cache"};
+    }
+    try {
+        ErrorStruct<Bytes> err = this->parent->session_cache->lookup(this->parent->selected_file->getPath(), this->parent->dh->getDataHeaderParts().getValidPasswordHash());
+        if (!err.isSuccess()) {
+            PLOG_WARNING << "No session for the selected file (unlockFromSession) (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
+            return ErrorStruct<bool>{err.success, err.errorCode, err.errorInfo, err.what};
+        }
+        PLOG_INFO << "The selected file was unlocked from the session (unlockFromSession)";
+        this->parent->correct_password_hash = err.returnValue();
+        this->parent->current_state = std::make_unique<PASSWORD_VERIFIED>(this->parent);
+        return ErrorStruct<bool>{true};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while unlocking from the session (unlockFromSession) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "Some error occurred while unlocking from the session", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::EMPTY_FILE_SELECTED::createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout, ChainHashControl* control) noexcept {
     // creates a data header for a given password and settings by randomizing the salt and chainhash data
     // This call is expensive because it has to chainhash the password twice to generate a validator.
     // A timeout (in ms) can be specified to limit the time of the call (0 means no timeout)
@@ -503,7 +1143,7 @@ ErrorStruct<bool> API::EMPTY_FILE_SELECTED::createDataHeader(const std::string&
         return err;
     }
     // calculates the data header (its a refactored function that is used more than once)
-    DataHeaderHelperStruct dhhs = this->parent->_createDataHeaderIters(password, ds, timeout);
+    DataHeaderHelperStruct dhhs = this->parent->_createDataHeaderIters(password, ds, timeout, control);
     if (!dhhs.errorStruct.isSuccess()) {
         // the data header could not be created
         PLOG_ERROR << "The data header could not be created (createDataHeader) (success: " << +dhhs.errorStruct.success << ", errorCode: " << +dhhs.errorStruct.errorCode
@@ -552,13 +1192,28 @@ ErrorStruct<std::unique_ptr<FileDataStruct>> API::PASSWORD_VERIFIED::getDecrypte
     // returns the decrypted content (without the data header)
     // uses the password and data header that were passed to verifyPassword (or createDataHeader for new files)
     PLOG_VERBOSE << "Getting decrypted data";
+    ErrorStruct<bool> err_checksum = this->parent->_verifyDataChecksum();
+    if (!err_checksum.isSuccess()) return ErrorStruct<std::unique_ptr<FileDataStruct>>{err_checksum.success, err_checksum.errorCode, err_checksum.errorInfo, err_checksum.what};
     try {
-        // construct the blockchain
-        DecryptBlockChain dbc{HashModes::getHash(this->parent->dh->getDataHeaderParts().getHashMode()), this->parent->correct_password_hash, this->parent->dh->getDataHeaderParts().getEncSalt()};
-        // add the data onto the blockchain
-        dbc.addData(this->parent->selected_file->getDataStream(), this->parent->selected_file->getDataSize());
+        std::unique_ptr<Bytes> decrypted;
+        if (this->parent->dh->getCipherFormat().cipher_mode != CIPHERMODE_HASHCHAIN) {
+            // the chunks are decrypted and verified in parallel
+            decrypted = this->parent->_decryptAEAD(0, AEADChain::getDecryptedLen(this->parent->selected_file->getDataSize(), this->parent->dh->getCipherFormat().chunk_len));
+        } else if (this->parent->dh->getShardLayout().shard_count != 0) {
+            // the shards are decrypted in parallel
+            decrypted = this->parent->_decryptShards(0, this->parent->selected_file->getDataSize());
+        } else {
+            // construct the blockchain
+            DecryptBlockChain dbc{HashModes::getHash(this->parent->dh->getDataHeaderParts().getHashMode()), this->parent->correct_password_hash, this->parent->dh->getDataHeaderParts().getEncSalt(),
+                                  this->parent->dh->getBlockLen()};
+            // add the data onto the blockchain (the checkpoint table is not part of the content, the chain continues with its states)
+            DataLayout layout = this->parent->_getDataLayout();
+            this->parent->_setCheckpointStates(dbc, layout, 0, layout.content_len);
+            this->parent->_addFileData(dbc, 0, layout.content_len);
+            decrypted = dbc.getResult();
+        }
         // get the decrypted data
-        std::unique_ptr<FileDataStruct> result = std::make_unique<FileDataStruct>(this->parent->file_mode, std::move(dbc.getResult()));
+        std::unique_ptr<FileDataStruct> result = std::make_unique<FileDataStruct>(this->parent->file_mode, std::move(decrypted));
         this->parent->file_data_struct = nullptr;
         // changes the state
         this->parent->current_state = std::make_unique<DECRYPTED>(this->parent);
@@ -570,6 +1225,331 @@ ErrorStruct<std::unique_ptr<FileDataStruct>> API::PASSWORD_VERIFIED::getDecrypte
     }
 }
 
+ErrorStruct<std::unique_ptr<Bytes>> API::PASSWORD_VERIFIED::decryptRange(const u_int64_t offset, const u_int64_t len) noexcept {
+    // decrypts only the given range of the content
+    // the decryption starts at the last checkpoint in front of the range (or at the beginning if there is none)
+    PLOG_VERBOSE << "Decrypting range (offset: " << offset << ", len: " << len << ")";
+    ErrorStruct<bool> err_checksum = this->parent->_verifyDataChecksum();
+    if (!err_checksum.isSuccess()) return ErrorStruct<std::unique_ptr<Bytes>>{err_checksum.success, err_checksum.errorCode, err_checksum.errorInfo, err_checksum.what};
+    try {
+        DataLayout layout = this->parent->_getDataLayout();
+        CipherFormat cipher = this->parent->dh->getCipherFormat();
+        // the encrypted chunks of the AEAD cipher modes are longer than the content (every chunk has a tag)
+        if (cipher.cipher_mode != CIPHERMODE_HASHCHAIN) layout.content_len = AEADChain::getDecryptedLen(this->parent->selected_file->getDataSize(), cipher.chunk_len);
+        if (offset > layout.content_len || len > layout.content_len - offset) {
+            PLOG_ERROR << "The given range is out of the content (offset: " << offset << ", len: " << len << ", content_len: " << layout.content_len << ")";
+            return ErrorStruct<std::unique_ptr<Bytes>>{SuccessType::FAIL, ErrorCode::ERR_ARGUMENT_INVALID, "In decryptRange: The given range is out of the content"};
+        }
+        if (len == 0) return ErrorStruct<std::unique_ptr<Bytes>>::createMove(std::make_unique<Bytes>(0));
+        // only the chunks that overlap with the range are decrypted
+        if (cipher.cipher_mode != CIPHERMODE_HASHCHAIN) return ErrorStruct<std::unique_ptr<Bytes>>::createMove(this->parent->_decryptAEAD(offset, len));
+        // sharded content is decrypted from the beginning of the shards that overlap with the range
+        if (this->parent->dh->getShardLayout().shard_count != 0) return ErrorStruct<std::unique_ptr<Bytes>>::createMove(this->parent->_decryptShards(offset, len));
+        DecryptBlockChain dbc{HashModes::getHash(this->parent->dh->getDataHeaderParts().getHashMode()), this->parent->correct_password_hash, this->parent->dh->getDataHeaderParts().getEncSalt(),
+                              this->parent->dh->getBlockLen()};
+        u_int64_t start = 0;  // the first content Byte that is decrypted
+        if (layout.checkpoint_interval != 0) {
+            // find the last checkpoint in front of the range, checkpoint i belongs to block (i+1)*interval
+            u_int64_t checkpoint = std::min<u_int64_t>(offset / dbc.getBlockLen() / layout.checkpoint_interval, layout.checkpoints);
+            if (checkpoint > 0) {
+                u_int64_t block_index = checkpoint * layout.checkpoint_interval;
+                dbc.resumeFromState(this->parent->_readFileData(layout.content_cap + (checkpoint - 1) * dbc.getStateLen(), dbc.getStateLen()), block_index);
+                start = block_index * dbc.getBlockLen();
+            }
+        }
+        this->parent->_setCheckpointStates(dbc, layout, start, offset + len);
+        this->parent->_addFileData(dbc, start, offset + len - start);
+        std::unique_ptr<Bytes> result = dbc.getResult();
+        return ErrorStruct<std::unique_ptr<Bytes>>::createMove(std::make_unique<Bytes>(result->copySubBytes(offset - start, offset - start + len)));
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while decrypting the range (decryptRange) (what: " << e.what() << ")";
+        return ErrorStruct<std::unique_ptr<Bytes>>{SuccessType::FAIL, ErrorCode::ERR, "In decryptRange: Something went wrong while decrypting the range", e.what()};
+    }
+}
+
+ErrorStruct<std::unique_ptr<DecryptedReader>> API::PASSWORD_VERIFIED::getDecryptedReader(const u_int64_t chunk_len) noexcept {
+    // creates a reader over the decrypted content, nothing is decrypted until the first chunk is read
+    PLOG_VERBOSE << "Creating decrypted reader (chunk_len: " << chunk_len << ")";
+    if (chunk_len == 0) {
+        PLOG_ERROR << "The chunk length of the decrypted reader cannot be 0";
+        return ErrorStruct<std::unique_ptr<DecryptedReader>>{SuccessType::FAIL, ErrorCode::ERR_ARGUMENT_INVALID, "In getDecryptedReader: The chunk length cannot be 0"};
+    }
+    ErrorStruct<bool> err_checksum = this->parent->_verifyDataChecksum();
+    if (!err_checksum.isSuccess()) return ErrorStruct<std::unique_ptr<DecryptedReader>>{err_checksum.success, err_checksum.errorCode, err_checksum.errorInfo, err_checksum.what};
+    try {
+        return ErrorStruct<std::unique_ptr<DecryptedReader>>::createMove(std::make_unique<DecryptedReader>(this->parent, chunk_len));
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while creating the decrypted reader (getDecryptedReader) (what: " << e.what() << ")";
+        return ErrorStruct<std::unique_ptr<DecryptedReader>>{SuccessType::FAIL, ErrorCode::ERR, "In getDecryptedReader: Something went wrong while creating the reader", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::_editContent(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data) {
+    // replaces remove_len Bytes at offset with data, the chain only looks backward, so the blocks in front of the
+    // first rewritten block keep their encrypted Bytes and only the suffix is encrypted and written again
+    // a changed block never gets its old salt again: an append continues the last block (its new Bytes were never encrypted before)
+    // and every other edit reseeds the chain at the last checkpoint in front of the first changed block
+    DataLayout layout = this->_getDataLayout();
+    if (layout.checkpoint_interval == 0) {
+        PLOG_ERROR << "The selected file has no resume state (editContent)";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_APPEND_NOT_SUPPORTED, this->selected_file->getPath().c_str()};
+    }
+    if (offset > layout.content_len || remove_len > layout.content_len - offset) {
+        PLOG_ERROR << "The given range is out of the content (offset: " << offset << ", remove_len: " << remove_len << ", content_len: " << layout.content_len << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_ARGUMENT_INVALID, "The given range is out of the content"};
+    }
+    u_int64_t block_len = this->dh->getEffectiveBlockLen();
+    // the last block is continued if it is partial (an empty content still has one empty block)
+    u_int64_t last_block = layout.content_len == 0 ? 0 : (layout.content_len - 1) / block_len;
+    bool append = offset == layout.content_len && remove_len == 0;
+    // the first rewritten block
+    u_int64_t start_block = append ? last_block : offset / block_len / layout.checkpoint_interval * layout.checkpoint_interval;
+    HModes hash_mode = this->dh->getDataHeaderParts().getHashMode();
+    Bytes enc_salt = this->dh->getDataHeaderParts().getEncSalt();
+
+    if (layout.version != TRAILER_VERSION || (!append && start_block == 0)) {
+        // there is no checkpoint in front of the changed block (or the file was written by an older version that did not reseed its edits)
+        // the whole content is encrypted again with a new encrypted salt
+        DecryptBlockChain dbc{HashModes::getHash(hash_mode), this->correct_password_hash, enc_salt, this->dh->getBlockLen()};
+        this->_setCheckpointStates(dbc, layout, 0, layout.content_len);
+        this->_addFileData(dbc, 0, layout.content_len);
+        std::unique_ptr<Bytes> plain = dbc.getResult();
+        Bytes content(layout.content_len - remove_len + data.getLen());
+        content.addBytes(plain->getBytes(), offset);
+        data.addcopyToBytes(content);
+        content.addBytes(plain->getBytes() + offset + remove_len, layout.content_len - offset - remove_len);
+        plain.reset();
+        return this->_rewriteContent(content);
+    }
+
+    // the chain is decrypted from the state of the first rewritten block (resume state or checkpoint) to the end
+    DecryptBlockChain dbc{HashModes::getHash(hash_mode), this->correct_password_hash, enc_salt, this->dh->getBlockLen()};
+    u_int64_t state_len = dbc.getStateLen();
+    u_int64_t state_pos = append ? layout.checkpoint_cap : start_block / layout.checkpoint_interval - 1;
+    Bytes start_state = this->_readFileData(layout.content_cap + state_pos * state_len, state_len);
+    dbc.resumeFromState(start_state, start_block);
+    u_int64_t start = start_block * block_len;
+    this->_setCheckpointStates(dbc, layout, start, layout.content_len);
+    this->_addFileData(dbc, start, layout.content_len - start);
+    std::unique_ptr<Bytes> plain = dbc.getResult();
+
+    // encrypt the new suffix: the unchanged part in front of the offset, the new data and the data behind the removed range
+    EncryptBlockChain ebc{HashModes::getHash(hash_mode), this->correct_password_hash, enc_salt, this->dh->getBlockLen()};
+    ebc.setCheckpointInterval(layout.checkpoint_interval);
+    if (append)
+        ebc.resumeFromState(start_state, start_block);
+    else
+        ebc.reseed(start_block);
+    ebc.addData(plain->getBytes(), offset - start);
+    ebc.addData(data);
+    ebc.addData(plain->getBytes() + (offset + remove_len - start), layout.content_len - offset - remove_len);
+    plain.reset();
+    std::unique_ptr<Bytes> encrypted = ebc.getResult();
+    // the checkpoints in front of the first rewritten block are kept
+    u_int64_t first_checkpoint = std::min<u_int64_t>(ebc.getFirstCheckpointIndex(), layout.checkpoints);
+    std::unique_ptr<Bytes> checkpoint_table = ebc.getCheckpointTable();
+    Bytes resume_state = ebc.getResumeState();
+    u_int64_t content_len = start + encrypted->getLen();
+
+    if (content_len > layout.content_cap || layout.content_cap - content_len > 2 * (this->_getContentCapacity(content_len) - content_len)) {
+        // the content outgrew its capacity (or leaves most of it empty), the trailer is laid out again behind the kept prefix
+        std::unique_ptr<Bytes> content = std::make_unique<Bytes>(content_len);
+        this->_readFileData(0, start).addcopyToBytes(content);
+        encrypted->addcopyToBytes(content);
+        encrypted.reset();
+        Bytes table = this->_readFileData(layout.content_cap, first_checkpoint * state_len);
+        table.addSize(checkpoint_table->getLen());
+        checkpoint_table->addcopyToBytes(table);
+        return this->_writeData(*this->_layoutData(std::move(content), table, resume_state, layout.checkpoint_interval));
+    }
+
+    // the content fits into its capacity, the trailer stays where it is and only the changed Bytes are written (the offsets are in the data)
+    u_int64_t checkpoints = first_checkpoint + checkpoint_table->getLen() / state_len;
+    // the content and the checkpoints behind the new end are cleared, the room stays zero
+    Bytes zeros(0);
+    addZeros(zeros, std::max<u_int64_t>(layout.content_len > content_len ? layout.content_len - content_len : 0,
+                                        layout.checkpoints > checkpoints ? (layout.checkpoints - checkpoints) * state_len : 0));
+    std::vector<JournalWrite> writes{JournalWrite{start, encrypted->getBytes(), encrypted->getLen()},
+                                     JournalWrite{layout.content_cap + first_checkpoint * state_len, checkpoint_table->getBytes(), checkpoint_table->getLen()},
+                                     JournalWrite{layout.content_cap + layout.checkpoint_cap * state_len, resume_state.getBytes(), resume_state.getLen()}};
+    if (layout.content_len > content_len) writes.push_back(JournalWrite{content_len, zeros.getBytes(), layout.content_len - content_len});
+    if (layout.checkpoints > checkpoints) writes.push_back(JournalWrite{layout.content_cap + checkpoints * state_len, zeros.getBytes(), (layout.checkpoints - checkpoints) * state_len});
+    // the checksums are read before the datablocks change
+    bool checksum = this->dh->hasChecksum();
+    u_int64_t data_checksum = checksum ? this->dh->getDataChecksum() : 0;
+    u_int64_t header_len = this->dh->getHeaderLength();
+    // only the leaves and the regions that are changed by the writes are hashed again, their new hashes are written into the leaf hash table
+    std::vector<Bytes> hashes;
+    if (this->dh->getIntegrityTree().leaf_len != 0) this->_patchIntegrityTree(writes, hashes, layout);
+    if (checksum) data_checksum = this->_patchDataChecksum(writes, data_checksum);
+    // only the index and the integrity datablock change, both keep their length
+    this->_setIndexDataBlock(layout.checkpoint_interval, content_len, layout.content_cap, layout.leaf_table_len);
+    this->dh->calcHeaderBytes();
+    if (checksum) this->dh->setChecksum(data_checksum);
+    if (this->dh->getHeaderLength() != header_len) {
+        PLOG_FATAL << "The header length changed while editing the content (old: " << header_len << ", new: " << this->dh->getHeaderLength() << ")";
+        throw std::logic_error("The header length changed while editing the content");
+    }
+
+    // the chains of the DecryptedReaders on the old content cannot be continued
+    this->generation++;
+    // the changed Bytes, the header and the file size go through the journal of the file, a crash leaves the old or the new content
+    std::vector<JournalWrite> file_writes{JournalWrite{0, this->dh->getHeaderBytes().getBytes(), header_len}};
+    for (const JournalWrite& write : writes) file_writes.push_back(JournalWrite{header_len + write.offset, write.data, write.len});
+    ErrorStruct<bool> err_write = this->selected_file->writeJournaled(file_writes, this->selected_file->getFileSize());
+    if (!err_write.isSuccess()) {
+        PLOG_ERROR << "Could not write the edited content to the file (editContent) (errorCode: " << +err_write.errorCode << ", errorInfo: " << err_write.errorInfo << ")";
+        return err_write;
+    }
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> API::_rewriteContent(const Bytes& content) {
+    // a new encrypted salt changes the salt of every block and the keys of the stored states, the new content shares no keystream with the old one
+    DataHeaderParts dhp = this->dh->getDataHeaderParts();
+    Bytes enc_salt(dhp.getEncSalt().getLen());
+    enc_salt.fillrandom();
+    dhp.setEncSalt(std::move(enc_salt));
+    ErrorStruct<std::unique_ptr<DataHeader>> err_dh = DataHeader::setHeaderParts(dhp);
+    if (!err_dh.isSuccess()) {
+        PLOG_ERROR << "The data header could not be created (rewriteContent) (errorCode: " << +err_dh.errorCode << ", errorInfo: " << err_dh.errorInfo << ", what: " << err_dh.what << ")";
+        return ErrorStruct<bool>{err_dh.success, err_dh.errorCode, err_dh.errorInfo, err_dh.what};
+    }
+    this->dh = err_dh.returnMove();
+    return this->_writeData(*this->_encryptChain(content));
+}
+
+ErrorStruct<bool> API::PASSWORD_VERIFIED::appendData(const Bytes& data) noexcept {
+    // appends data to the content, only the last (partial) block, the new blocks and the trailer are written
+    PLOG_VERBOSE << "Appending data (len: " << data.getLen() << ")";
+    try {
+        return this->parent->_editContent(this->parent->_getDataLayout().content_len, 0, data);
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while appending the data (appendData) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "In appendData: Something went wrong while appending the data", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::PASSWORD_VERIFIED::editData(const u_int64_t offset, const u_int64_t remove_len, const Bytes& data) noexcept {
+    // replaces a range of the content, only the blocks from the first changed block to the end and the trailer are written
+    PLOG_VERBOSE << "Editing data (offset: " << offset << ", remove_len: " << remove_len << ", len: " << data.getLen() << ")";
+    try {
+        return this->parent->_editContent(offset, remove_len, data);
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while editing the data (editData) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "In editData: Something went wrong while editing the data", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::PASSWORD_VERIFIED::addPassword(const std::string& password, ChainHashControl* control) noexcept {
+    // the data key is known after the password was verified, it is wrapped for the new password
+    PLOG_VERBOSE << "Adding password";
+    try {
+        std::vector<KeySlot> slots = this->parent->dh->getKeySlots();
+        if (slots.empty()) {
+            PLOG_ERROR << "The selected file has no key slots (addPassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_KEYSLOTS_NOT_SUPPORTED, this->parent->selected_file->getPath().c_str()};
+        }
+        std::vector<KeySlot>::iterator free_slot = std::find_if(slots.begin(), slots.end(), [](const KeySlot& slot) { return slot.isFree(); });
+        if (free_slot == slots.end()) {
+            PLOG_ERROR << "All key slots of the selected file are used (addPassword) (slots: " << slots.size() << ")";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_KEYSLOTS_FULL, this->parent->selected_file->getPath().c_str()};
+        }
+        DataHeaderParts dhp = this->parent->dh->getDataHeaderParts();
+        if (control != nullptr) control->start(dhp.chainhash1.getIters() + dhp.chainhash2.getIters());
+        Bytes password_hash(0);
+        ErrorStruct<Bytes> validator = this->parent->_getKeySlotValidator(password, password_hash, control);
+        if (!validator.isSuccess()) return ErrorStruct<bool>{validator.success, validator.errorCode, validator.errorInfo, validator.what};
+        for (const KeySlot& slot : slots) {
+            if (!slot.isFree() && slot.validator == validator.returnRef()) {
+                PLOG_ERROR << "The password already has a key slot (addPassword)";
+                return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_ARGUMENT_INVALID, "The password already has a key slot"};
+            }
+        }
+        *free_slot = DataHeader::createKeySlot(*HashModes::getHash(dhp.getHashMode()), password_hash, validator.returnRef(), this->parent->correct_password_hash);
+        return this->parent->_writeKeySlots(slots);
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while adding the password (addPassword) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "In addPassword: Something went wrong while adding the password", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::PASSWORD_VERIFIED::changePassword(const std::string& old_password, const std::string& new_password, ChainHashControl* control) noexcept {
+    // the slot of the old password is found by its validator and wraps the same data key for the new password
+    PLOG_VERBOSE << "Changing password";
+    try {
+        std::vector<KeySlot> slots = this->parent->dh->getKeySlots();
+        if (slots.empty()) {
+            PLOG_ERROR << "The selected file has no key slots (changePassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_KEYSLOTS_NOT_SUPPORTED, this->parent->selected_file->getPath().c_str()};
+        }
+        DataHeaderParts dhp = this->parent->dh->getDataHeaderParts();
+        if (control != nullptr) control->start(2 * (dhp.chainhash1.getIters() + dhp.chainhash2.getIters()));
+        Bytes old_hash(0);
+        ErrorStruct<Bytes> old_validator = this->parent->_getKeySlotValidator(old_password, old_hash, control);
+        if (!old_validator.isSuccess()) return ErrorStruct<bool>{old_validator.success, old_validator.errorCode, old_validator.errorInfo, old_validator.what};
+        std::vector<KeySlot>::iterator old_slot =
+            std::find_if(slots.begin(), slots.end(), [&old_validator](const KeySlot& slot) { return !slot.isFree() && slot.validator == old_validator.returnRef(); });
+        if (old_slot == slots.end()) {
+            PLOG_WARNING << "The old password has no key slot (changePassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_PASSWORD_INVALID, "The old password has no key slot"};
+        }
+        Bytes new_hash(0);
+        ErrorStruct<Bytes> new_validator = this->parent->_getKeySlotValidator(new_password, new_hash, control);
+        if (!new_validator.isSuccess()) return ErrorStruct<bool>{new_validator.success, new_validator.errorCode, new_validator.errorInfo, new_validator.what};
+        for (std::vector<KeySlot>::iterator it = slots.begin(); it != slots.end(); it++) {
+            if (it != old_slot && !it->isFree() && it->validator == new_validator.returnRef()) {
+                PLOG_ERROR << "The new password already has a key slot (changePassword)";
+                return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_ARGUMENT_INVALID, "The new password already has a key slot"};
+            }
+        }
+        *old_slot = DataHeader::createKeySlot(*HashModes::getHash(dhp.getHashMode()), new_hash, new_validator.returnRef(), this->parent->correct_password_hash);
+        return this->parent->_writeKeySlots(slots);
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while changing the password (changePassword) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "In changePassword: Something went wrong while changing the password", e.what()};
+    }
+}
+
+ErrorStruct<bool> API::PASSWORD_VERIFIED::removePassword(const std::string& password, ChainHashControl* control) noexcept {
+    // the slot of the password is freed, one used slot always remains so the file can be unlocked
+    PLOG_VERBOSE << "Removing password";
+    try {
+        std::vector<KeySlot> slots = this->parent->dh->getKeySlots();
+        if (slots.empty()) {
+            PLOG_ERROR << "The selected file has no key slots (removePassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_KEYSLOTS_NOT_SUPPORTED, this->parent->selected_file->getPath().c_str()};
+        }
+        DataHeaderParts dhp = this->parent->dh->getDataHeaderParts();
+        if (control != nullptr) control->start(dhp.chainhash1.getIters() + dhp.chainhash2.getIters());
+        Bytes password_hash(0);
+        ErrorStruct<Bytes> validator = this->parent->_getKeySlotValidator(password, password_hash, control);
+        if (!validator.isSuccess()) return ErrorStruct<bool>{validator.success, validator.errorCode, validator.errorInfo, validator.what};
+        std::vector<KeySlot>::iterator slot =
+            std::find_if(slots.begin(), slots.end(), [&validator](const KeySlot& slot) { return !slot.isFree() && slot.validator == validator.returnRef(); });
+        if (slot == slots.end()) {
+            PLOG_WARNING << "The password has no key slot (removePassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_PASSWORD_INVALID, "The password has no key slot"};
+        }
+        if (std::count_if(slots.begin(), slots.end(), [](const KeySlot& slot) { return !slot.isFree(); }) == 1) {
+            PLOG_ERROR << "The last password of the selected file cannot be removed (removePassword)";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_KEYSLOT_LAST, this->parent->selected_file->getPath().c_str()};
+        }
+        *slot = DataHeader::createFreeKeySlot(this->parent->dh->getHashSize());
+        return this->parent->_writeKeySlots(slots);
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while removing the password (removePassword) (what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR, "In removePassword: Something went wrong while removing the password", e.what()};
+    }
+}
+
 ErrorStruct<bool> API::DECRYPTED::encryptData(std::unique_ptr<FileDataStruct>&& file_data) noexcept {
     // encrypts the data and returns the encrypted data
     // uses the password and data header that were passed to verifyPassword
@@ -589,15 +1569,37 @@ ErrorStruct<bool> API::DECRYPTED::encryptData(std::unique_ptr<FileDataStruct>&&
         return err;
     }
     try {
-        // construct the blockchain
-        this->parent->dh->setDataSize(file_data->dec_data->getLen());
-        this->parent->dh->calcHeaderBytes();
-        EncryptBlockChain ebc{HashModes::getHash(this->parent->dh->getDataHeaderParts().getHashMode()), this->parent->correct_password_hash, this->parent->dh->getDataHeaderParts().getEncSalt()};
-        // add the data onto the blockchain
-        ebc.addData(std::move(file_data->dec_data));
+        CipherFormat cipher = this->parent->dh->getCipherFormat();
+        ShardLayout shards = this->parent->dh->getShardLayout();
+        if (cipher.cipher_mode != CIPHERMODE_HASHCHAIN) {
+            // the chunk nonces repeat for every encryption, so a new key salt (and key) is used every time
+            // AEAD files have no trailer and are not sharded, the chunks are already independent
+            cipher.chunk_len = AEAD_CHUNK_LEN;
+            cipher.key_salt = Bytes(AEAD_KEY_SALT_LEN);
+            cipher.key_salt.fillrandom();
+            this->parent->dh->setOrReplaceDataBlock(DataHeader::createCipherDataBlock(cipher));
+            this->parent->dh->removeDataBlocks(DatablockType::SHARDS);
+            this->parent->dh->removeDataBlocks(DatablockType::INDEX);
+            this->parent->encrypted = this->parent->_encryptAEAD(*file_data->dec_data, cipher);
+            this->parent->_setIntegrityDataBlock(this->parent->encrypted->getBytes(), this->parent->encrypted->getLen());
+        } else if (shards.shard_count != 0) {
+            // split the content into shards of whole blocks, every shard is encrypted by its own chain
+            // sharded files have no trailer, the content is the whole data
+            u_int64_t block_len = this->parent->dh->getEffectiveBlockLen();
+            u_int64_t shard_len = (file_data->dec_data->getLen() + shards.shard_count - 1) / shards.shard_count;
+            shards.shard_len = std::max<u_int64_t>(block_len, (shard_len + block_len - 1) / block_len * block_len);
+            this->parent->dh->setOrReplaceDataBlock(DataHeader::createShardDataBlock(shards));
+            this->parent->dh->removeDataBlocks(DatablockType::INDEX);
+            this->parent->encrypted = this->parent->_encryptShards(*file_data->dec_data, shards);
+            this->parent->_setIntegrityDataBlock(this->parent->encrypted->getBytes(), this->parent->encrypted->getLen());
+        } else {
+            // the content is encrypted by one chain, the trailer is appended
+            this->parent->encrypted = this->parent->_encryptChain(*file_data->dec_data);
+        }
         file_data->dec_data.reset();
-        // get the encrypted data
-        this->parent->encrypted = std::move(ebc.getResult());
+        this->parent->dh->setDataSize(this->parent->encrypted->getLen());
+        this->parent->dh->calcHeaderBytes();
+        this->parent->dh->setChecksum(this->parent->encrypted->getBytes(), this->parent->encrypted->getLen());
         this->parent->file_data_struct = std::move(file_data);
         // change the state
         this->parent->current_state = std::make_unique<ENCRYPTED>(this->parent);
@@ -640,7 +1642,7 @@ ErrorStruct<bool> API::DECRYPTED::changeSalt() noexcept {
     return ErrorStruct<bool>{err.success, err.errorCode, err.errorInfo, err.what};
 }
 
-ErrorStruct<bool> API::DECRYPTED::createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout) noexcept {
+ErrorStruct<bool> API::DECRYPTED::createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout, ChainHashControl* control) noexcept {
     // the new generated header will be used for the next encryption, that means the old password is not valid anymore
     // creates a data header for a given password and settings by randomizing the salt and chainhash data
     // This call is expensive because it has to chainhash the password twice to generate a validator.
@@ -653,7 +1655,7 @@ ErrorStruct<bool> API::DECRYPTED::createDataHeader(const std::string& password,
     }
     PLOG_VERBOSE << "Creating data header with iterations settings (" << ds << ", timeout: " << timeout << ")";
     // calculates the data header (its a refactored function that is used more than once)
-    DataHeaderHelperStruct dhhs = this->parent->_createDataHeaderIters(password, ds, timeout);
+    DataHeaderHelperStruct dhhs = this->parent->_createDataHeaderIters(password, ds, timeout, control);
     if (!dhhs.errorStruct.isSuccess()) {
         // the data header could not be created
         PLOG_ERROR << "The data header could not be created (createDataHeader) (success: " << +dhhs.errorStruct.success << ", errorCode: " << +dhhs.errorStruct.errorCode
@@ -704,13 +1706,16 @@ ErrorStruct<bool> API::ENCRYPTED::writeToFile(const std::filesystem::path& file_
         PLOG_ERROR << "The provided file path is invalid (writeToFile) (errorCode: " << +err_file.errorCode << ", errorInfo: " << err_file.errorInfo << ", what: " << err_file.what << ")";
         return ErrorStruct<bool>{err_file.success, err_file.errorCode, err_file.errorInfo, err_file.what};
     }
-    ErrorStruct<std::ofstream> err = err_file.returnRef()->getWriteStreamIfEmpty();
+    if (!err_file.returnRef()->isEmtpy()) {
+        PLOG_ERROR << "The file is not empty (writeToFile) (file_path: " << file_path << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_EMPTY, file_path.c_str()};
+    }
+    // the header and the encrypted data are written with one vectored write from their own buffers, nothing is copied
+    ErrorStruct<bool> err = err_file.returnRef()->writeParts({{this->parent->dh->getHeaderBytes().getBytes(), this->parent->dh->getHeaderBytes().getLen()},
+                                                              {this->parent->encrypted->getBytes(), this->parent->encrypted->getLen()}});
     if (err.isSuccess()) {
-        Bytes full_data{(int64_t)(this->parent->dh->getHeaderBytes().getLen() + this->parent->encrypted->getLen())};
-        this->parent->dh->getHeaderBytes().addcopyToBytes(full_data);  // adds the data header
-        this->parent->encrypted->addcopyToBytes(full_data);            // adds the encrypted data
         this->parent->encrypted.reset();
-        err.returnRef() << full_data;  // writes the data to the file
+        this->parent->_storeSession(file_path);
         this->parent->current_state = std::make_unique<FINISHED>(this->parent);
     } else {
         PLOG_ERROR << "Some error occurred while writing to the file (writeToFile) (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
@@ -721,14 +1726,13 @@ ErrorStruct<bool> API::ENCRYPTED::writeToFile(const std::filesystem::path& file_
 ErrorStruct<bool> API::ENCRYPTED::writeToFile() noexcept {
     // writes encrypted data to the selected file adds the dataheader, uses the encrypted data from getEncryptedData
     PLOG_VERBOSE << "Writing to selected file (file_path: " << this->parent->selected_file->getPath().c_str() << ")";
-    // checks if the selected file exists (it could be deleted in the meantime)
-    ErrorStruct<std::ofstream> err = this->parent->selected_file->getWriteStream();
+    // the header and the encrypted data are written with one vectored write from their own buffers, nothing is copied
+    // writeParts checks if the selected file still exists (it could be deleted in the meantime)
+    ErrorStruct<bool> err = this->parent->selected_file->writeParts({{this->parent->dh->getHeaderBytes().getBytes(), this->parent->dh->getHeaderBytes().getLen()},
+                                                                     {this->parent->encrypted->getBytes(), this->parent->encrypted->getLen()}});
     if (err.isSuccess()) {
-        Bytes full_data{(int64_t)(this->parent->dh->getHeaderBytes().getLen() + this->parent->encrypted->getLen())};
-        this->parent->dh->getHeaderBytes().addcopyToBytes(full_data);  // adds the data header
-        this->parent->encrypted->addcopyToBytes(full_data);            // adds the encrypted data
         this->parent->encrypted.reset();
-        err.returnRef() << full_data;  // writes the data to the file
+        this->parent->_storeSession(this->parent->selected_file->getPath());
         this->parent->current_state = std::make_unique<FINISHED>(this->parent);
     } else {
         PLOG_FATAL << "Some error occurred while writing to the selected file (writeToFile) (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
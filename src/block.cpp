@@ -19,6 +19,36 @@ Block::Block(std::shared_ptr<Hash> hash, const Bytes& salt) : block_len(hash->ge
     this->hash = std::move(hash);
 }
 
+Block::Block(std::shared_ptr<Hash> hash, const Bytes& salt, const size_t block_len)
+    : block_len(block_len), data(Bytes(block_len)), salt(Block::expandSalt(*hash, salt, block_len)), dec_hash(Bytes(hash->getHashSize())) {
+    if (salt.getLen() != hash->getHashSize()) {
+        // the salt is expanded from one hash
+        PLOG_ERROR << "length of salt bytes does not match with the hash size (hash_size: " << hash->getHashSize() << ", salt_len: " << salt.getLen() << ")";
+        throw std::length_error("length of salt bytes does not match with the hash size");
+    }
+    this->hash = std::move(hash);
+}
+
+Bytes Block::expandSalt(const Hash& hash, const Bytes& salt, const size_t len) {
+    // expands the salt to a keystream of len Bytes, every part of the keystream is the hash of the salt and the 8 Byte counter
+    if (len == 0) {
+        // invalid block length
+        PLOG_ERROR << "cannot expand the salt to an empty keystream";
+        throw std::invalid_argument("length of the block cannot be zero");
+    }
+    Bytes keystream(len);
+    Bytes input(salt, 8);
+    Bytes::fromLong(0, true).addcopyToBytes(input);
+    unsigned char* counter = input.getBytes() + salt.getLen();
+    for (u_int64_t part = 0; keystream.getLen() < len; part++) {
+        // write the counter (big endian) behind the salt
+        for (int i = 0; i < 8; i++) counter[i] = (unsigned char)(part >> (56 - 8 * i));
+        Bytes part_hash = hash.hash(input);
+        keystream.addBytes(part_hash.getBytes(), std::min<size_t>(part_hash.getLen(), len - keystream.getLen()));
+    }
+    return keystream;
+}
+
 size_t Block::getFreeSpace() const noexcept {
     // returns the number of bytes that can be added to the block until it is completed
     return this->block_len - this->data.getLen();
@@ -2,15 +2,17 @@
 
 #include "logger.h"
 
-void DecryptBlock::addData(const Bytes& enc_data) {
+void DecryptBlock::addData(const Bytes& enc_data) { this->addData(enc_data.getBytes(), enc_data.getLen()); }
+
+void DecryptBlock::addData(const unsigned char* enc_data, const size_t len) {
     // add the data to the block
-    if (this->getFreeSpace() < enc_data.getLen()) {
+    if (this->getFreeSpace() < len) {
         // the block data length will exceed the DecryptBlock length if the data is added
         PLOG_ERROR << "block data length will exceed the DecryptBlock length (block_len: " << this->block_len << ", current_data_len: " << this->data.getLen()
-                   << ", add_data_len: " << enc_data.getLen() << ")";
+                   << ", add_data_len: " << len << ")";
         throw std::length_error("block data length will exceed the DecryptBlock length");
     }
-    enc_data.addcopyToBytes(this->data);
+    if (len > 0) this->data.addBytes(enc_data, len);
     if (this->getFreeSpace() == 0) {
         // block is completed
         // calculate the block hash of the decrypted data
@@ -2,15 +2,17 @@
 
 #include "logger.h"
 
-void EncryptBlock::addData(const Bytes& dec_data) {
+void EncryptBlock::addData(const Bytes& dec_data) { this->addData(dec_data.getBytes(), dec_data.getLen()); }
+
+void EncryptBlock::addData(const unsigned char* dec_data, const size_t len) {
     // add the decrypted data to the block
-    if (this->getFreeSpace() < dec_data.getLen()) {
+    if (this->getFreeSpace() < len) {
         // the block data length will exceed the EncryptBlock length if the data is added
         PLOG_ERROR << "block data length will exceed the EncryptBlock length (block_len: " << this->block_len << ", current_data_len: " << this->data.getLen()
-                   << ", add_data_len: " << dec_data.getLen() << ")";
+                   << ", add_data_len: " << len << ")";
         throw std::length_error("block data length will exceed the EncryptBlock length");
     }
-    dec_data.addcopyToBytes(this->data);
+    if (len > 0) this->data.addBytes(dec_data, len);
     if (this->getFreeSpace() == 0) {
         // block is completed
         // calculate the block hash of the decrypted data
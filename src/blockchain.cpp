@@ -4,31 +4,33 @@
 
 #include "utility.h"
 
-BlockChain::BlockChain(std::shared_ptr<Hash> hash, const Bytes& passwordhash, const Bytes& enc_salt) {
+BlockChain::BlockChain(std::shared_ptr<Hash> hash, const Bytes& passwordhash, const Bytes& enc_salt, const size_t block_len) {
     // initialize the salt generator (iterator)
     this->hash_size = hash->getHashSize();
+    this->keystream = block_len != 0;
+    this->block_len = this->keystream ? block_len : this->hash_size;
     this->result = std::make_unique<Bytes>(0);
-    this->salt_iter.init(passwordhash, enc_salt, std::move(hash));
+    this->state_key = Bytes(passwordhash.getLen() + enc_salt.getLen());
+    passwordhash.addcopyToBytes(this->state_key);
+    enc_salt.addcopyToBytes(this->state_key);
+    // choose the fixed variants for the known hash sizes once, other hash functions use the generic salt iterator and blocks
+    if (this->hash_size == 32 && FixedBlock<32>::matches(*hash)) {
+        this->salt_iter = std::make_unique<FixedSaltIterator<32>>();
+        this->add_fixed_blocks = &BlockChain::addFixedBlocks<32>;
+    } else if (this->hash_size == 48 && FixedBlock<48>::matches(*hash)) {
+        this->salt_iter = std::make_unique<FixedSaltIterator<48>>();
+        this->add_fixed_blocks = &BlockChain::addFixedBlocks<48>;
+    } else if (this->hash_size == 64 && FixedBlock<64>::matches(*hash)) {
+        this->salt_iter = std::make_unique<FixedSaltIterator<64>>();
+        this->add_fixed_blocks = &BlockChain::addFixedBlocks<64>;
+    } else
+        this->salt_iter = std::make_unique<SaltIterator>();
+    // the keystream blocks are larger than one hash, they are added as Block objects
+    if (this->keystream) this->add_fixed_blocks = nullptr;
+    this->salt_iter->init(passwordhash, enc_salt, std::move(hash));
 }
 
-void BlockChain::addData(const Bytes& data) {
-    this->result->addSize(data.getLen());
-    if (this->current_block == nullptr) this->addBlock();
-    u_int64_t written = 0;  // the amount of data that has been added to the blockchain
-    while (true) {
-        // get the data that can be added on the last block to complete it
-        // it is the minimum of the free space in the last block and the length of the remaining data
-        Bytes data_part = data.copySubBytes(written, written + std::min<int>(this->getFreeSpaceInLastBlock(), data.getLen() - written));
-        written += data_part.getLen();
-        this->current_block->addData(data_part);
-        // add a new block if data is left
-        if (written < data.getLen())
-            this->addBlock();
-        else
-            break;
-    }
-    PLOG_VERBOSE << "added new data to blockchain [HEIGHT] " << this->getHeight() << " [DATA_SIZE] " << this->getDataSize() << "B";
-}
+void BlockChain::addData(const Bytes& data) { this->addData(data.getBytes(), data.getLen()); }
 
 void BlockChain::addData(std::ifstream&& filestream, const size_t stream_len) {
     this->result->addSize(stream_len);
@@ -37,7 +39,7 @@ void BlockChain::addData(std::ifstream&& filestream, const size_t stream_len) {
     while (true) {
         // get the data that can be added on the last block to complete it
         // it is the minimum of the free space in the last block and the length of the remaining data
-        Bytes data_part{std::min<int>(this->getFreeSpaceInLastBlock(), stream_len - written)};
+        Bytes data_part{std::min<size_t>(this->getFreeSpaceInLastBlock(), stream_len - written)};
         if (!readData(filestream, data_part, data_part.getMaxLen())) {
             PLOG_FATAL << "could not read all bytes from file. streamsize: " << stream_len << ", written: " << written << ", data_part_len: " << data_part.getLen();
             throw std::runtime_error("could not read all bytes from file");
@@ -53,25 +55,94 @@ void BlockChain::addData(std::ifstream&& filestream, const size_t stream_len) {
     PLOG_VERBOSE << "added new data to blockchain [HEIGHT] " << this->getHeight() << " [DATA_SIZE] " << this->getDataSize() << "B";
 }
 
-void BlockChain::addData(std::unique_ptr<Bytes>&& data) {
-    this->result->addSize(data->getLen());
+void BlockChain::addData(std::unique_ptr<Bytes>&& data) { this->addData(data->getBytes(), data->getLen()); }
+
+void BlockChain::addData(const unsigned char* data, const size_t data_len) {
+    this->result->addSize(data_len);
     if (this->current_block == nullptr) this->addBlock();
     u_int64_t written = 0;  // the amount of data that has been added to the blockchain
     while (true) {
         // get the data that can be added on the last block to complete it
         // it is the minimum of the free space in the last block and the length of the remaining data
-        Bytes data_part = data->copySubBytes(written, written + std::min<int>(this->getFreeSpaceInLastBlock(), data->getLen() - written));
-        written += data_part.getLen();
-        this->current_block->addData(data_part);
+        // the block reads directly from the given buffer, no sub Bytes are created
+        size_t part_len = std::min<size_t>(this->getFreeSpaceInLastBlock(), data_len - written);
+        this->current_block->addData(data + written, part_len);
+        written += part_len;
         // add a new block if data is left
-        if (written < data->getLen())
-            this->addBlock();
+        if (written >= data_len) break;
+        if (this->add_fixed_blocks != nullptr && data_len - written > this->block_len)
+            // the complete blocks in between are added without Block objects
+            (this->*add_fixed_blocks)(data, written, data_len);
         else
-            break;
+            this->addBlock();
     }
     PLOG_VERBOSE << "added new data to blockchain [HEIGHT] " << this->getHeight() << " [DATA_SIZE] " << this->getDataSize() << "B";
 }
 
+template <size_t HS>
+void BlockChain::addFixedBlocks(const unsigned char* data, size_t& written, const size_t data_len) {
+    // the current block is completed, its result is moved into the result and its hash is the first last block hash
+    // every following complete block is encrypted/decrypted directly from data into the result
+    FixedSaltIterator<HS>& iter = static_cast<FixedSaltIterator<HS>&>(*this->salt_iter);
+    const bool encrypting = this->isEncrypting();
+    typename FixedBlock<HS>::Array last_hash;
+    typename FixedBlock<HS>::Array salt;
+    this->current_block->getHash().copyToArray(last_hash.data(), HS);
+    this->current_block->getResult().addcopyToBytes(this->result);
+    unsigned char* out = this->result->getBytes() + this->result->getLen();
+    const unsigned char* in = data + written;
+    // the last block of the data is kept as a Block object (it can be incomplete and its result is added by getResult)
+    size_t blocks = (data_len - written - 1) / HS;
+    for (size_t block = 0; block < blocks; block++) {
+        this->loadCheckpoint();
+        iter.next(last_hash.data(), salt);
+        this->chain_height++;
+        this->addCheckpoint();
+        if (encrypting)
+            FixedBlock<HS>::encrypt(in, salt, out, last_hash);
+        else
+            FixedBlock<HS>::decrypt(in, salt, out, last_hash);
+        in += HS;
+        out += HS;
+    }
+    this->result->setLen(this->result->getLen() + blocks * HS);
+    written += blocks * HS;
+    // start the block of the remaining data
+    this->loadCheckpoint();
+    iter.next(last_hash.data(), salt);
+    this->chain_height++;
+    this->addCheckpoint();
+    Bytes next_salt(HS);
+    next_salt.addBytes(salt.data(), HS);
+    this->current_block = this->createBlock(next_salt);
+}
+
+bool BlockChain::addBlock() {
+    if (this->getFreeSpaceInLastBlock() != 0) {
+        // there is still free space in the last block no new block is needed
+        PLOG_WARNING << "tried to add a new block but there is still free space in the last block (free_space: " << this->getFreeSpaceInLastBlock() << ")";
+        return false;
+    }
+
+    // get the next block salt
+    Bytes next_salt(this->hash_size);
+    this->loadCheckpoint();
+    if (this->current_block != nullptr) {
+        // hashes the last block and use it to generate the next salt
+        next_salt = this->salt_iter->next(this->current_block->getHash());
+        this->current_block->getResult().addcopyToBytes(this->result);
+    } else
+        // no previous block, generate the next salt without a last block hash
+        next_salt = this->salt_iter->next();
+    this->chain_height++;
+    this->addCheckpoint();
+
+    // add the new block to the chain
+    this->current_block = this->createBlock(next_salt);
+
+    return true;
+}
+
 std::unique_ptr<Bytes> BlockChain::getResult() {
     // returns the bytes of the blockchain by moving the result
     PLOG_DEBUG << "moving blockchain result. [HEIGHT] " << this->getHeight() << " [DATA_SIZE] " << this->getDataSize() << "B";
@@ -79,10 +150,123 @@ std::unique_ptr<Bytes> BlockChain::getResult() {
     return std::move(this->result);
 }
 
-unsigned char BlockChain::getFreeSpaceInLastBlock() const noexcept {
+size_t BlockChain::getFreeSpaceInLastBlock() const noexcept {
     // returns the free space in the last block
     if (this->current_block != nullptr)
         return this->current_block->getFreeSpace();
     else
         return 0;
 }
+
+Bytes BlockChain::getShardSalt(const Hash& hash, const Bytes& enc_salt, const u_int64_t shard, const u_int64_t shard_count) {
+    // hashes the encrypted salt with the shard index and the shard count
+    if (shard >= shard_count) {
+        PLOG_ERROR << "shard index is out of range (shard: " << shard << ", shard_count: " << shard_count << ")";
+        throw std::invalid_argument("shard index is out of range");
+    }
+    Bytes input(enc_salt, 16);
+    Bytes::fromLong(shard, true).addcopyToBytes(input);
+    Bytes::fromLong(shard_count, true).addcopyToBytes(input);
+    return hash.hash(input);
+}
+
+void BlockChain::setCheckpointInterval(const size_t interval) {
+    // sets the number of blocks between two checkpoints
+    if (this->current_block != nullptr) {
+        PLOG_ERROR << "cannot set the checkpoint interval after data was added (height: " << this->getHeight() << ")";
+        throw std::logic_error("cannot set the checkpoint interval after data was added");
+    }
+    this->checkpoint_interval = interval;
+}
+
+Bytes BlockChain::getStateKey(const size_t block_index) const {
+    // derives the key for the state of one block from the password hash, the encrypted salt and the block index
+    // the hash input is longer than any input of the salt iterator, so the keys do not collide with the block salts
+    // the state of a block only changes for other previous data or if the chain is reseeded there (the new state is random, so it tells nothing about the old one)
+    Bytes key(this->getStateLen());
+    for (u_int64_t part = 0; part < 2; part++) {
+        Bytes input(this->state_key, 8);
+        Bytes::fromLong(2 * block_index + part, true).addcopyToBytes(input);
+        this->salt_iter->hashObj->hash(input).addcopyToBytes(key);
+    }
+    return key;
+}
+
+size_t BlockChain::getFirstCheckpointIndex() const noexcept {
+    // the first checkpoint block that is reached by the chain (resume blocks that are checkpoint blocks are recorded again)
+    if (this->checkpoint_interval == 0 || this->resume_block == 0) return 0;
+    return (this->resume_block + this->checkpoint_interval - 1) / this->checkpoint_interval - 1;
+}
+
+void BlockChain::addCheckpoint() {
+    // records the salt iterator state of the newest block if it is the next checkpoint block
+    size_t block_index = this->chain_height - 1;
+    if (this->checkpoint_interval == 0 || block_index == 0 || block_index % this->checkpoint_interval != 0) return;
+    if (block_index / this->checkpoint_interval != this->getFirstCheckpointIndex() + this->checkpoints.size() + 1) return;
+    this->checkpoints.push_back(this->salt_iter->getState() + this->getStateKey(block_index));
+}
+
+void BlockChain::loadCheckpoint() {
+    // the next block is the block with the index chain_height, its stored state replaces the state of the iterator
+    size_t block_index = this->chain_height;
+    if (this->stored_interval == 0 || block_index == 0 || block_index % this->stored_interval != 0) return;
+    size_t checkpoint = block_index / this->stored_interval - 1;
+    if (checkpoint < this->stored_first || checkpoint - this->stored_first >= this->stored_checkpoints.getLen() / this->getStateLen()) return;
+    size_t pos = (checkpoint - this->stored_first) * this->getStateLen();
+    this->salt_iter->setState(this->stored_checkpoints.copySubBytes(pos, pos + this->getStateLen()) - this->getStateKey(block_index));
+}
+
+void BlockChain::setCheckpointStates(const Bytes& table, const size_t first_index, const size_t interval) {
+    // stores the table, the states are loaded when the chain reaches their blocks
+    if (table.getLen() % this->getStateLen() != 0) {
+        PLOG_ERROR << "checkpoint table has an invalid length (len: " << table.getLen() << ", state_len: " << this->getStateLen() << ")";
+        throw std::length_error("checkpoint table has an invalid length");
+    }
+    this->stored_checkpoints = table;
+    this->stored_first = first_index;
+    this->stored_interval = interval;
+}
+
+std::unique_ptr<Bytes> BlockChain::getCheckpointTable() const {
+    // returns all recorded checkpoints as one table
+    std::unique_ptr<Bytes> table = std::make_unique<Bytes>(this->checkpoints.size() * this->getStateLen());
+    for (const Bytes& checkpoint : this->checkpoints) checkpoint.addcopyToBytes(table);
+    return table;
+}
+
+Bytes BlockChain::getResumeState() const {
+    // returns the encrypted state of the last block
+    if (this->current_block == nullptr) {
+        PLOG_ERROR << "cannot get the resume state of an empty chain";
+        throw std::logic_error("cannot get the resume state of an empty chain");
+    }
+    return this->salt_iter->getState() + this->getStateKey(this->chain_height - 1);
+}
+
+void BlockChain::resumeFromState(const Bytes& enc_state, const size_t block_index) {
+    // continues the chain at the block of the state
+    if (this->current_block != nullptr) {
+        PLOG_ERROR << "cannot resume from a state after data was added (height: " << this->getHeight() << ")";
+        throw std::logic_error("cannot resume from a state after data was added");
+    }
+    if (enc_state.getLen() != this->getStateLen()) {
+        PLOG_ERROR << "state has an invalid length (len: " << enc_state.getLen() << ", expected: " << this->getStateLen() << ")";
+        throw std::length_error("state has an invalid length");
+    }
+    this->salt_iter->setState(enc_state - this->getStateKey(block_index));
+    // the next block that is added is the block of the state
+    this->chain_height = block_index;
+    this->resume_block = block_index;
+    PLOG_VERBOSE << "resumed blockchain at block " << block_index;
+}
+
+void BlockChain::reseed(const size_t block_index) {
+    // a random state is independent of every state the block had before, so the new salts share no keystream with the old ones
+    if (this->checkpoint_interval == 0 || block_index == 0 || block_index % this->checkpoint_interval != 0) {
+        PLOG_ERROR << "the chain can only be reseeded at a checkpoint block (block_index: " << block_index << ", interval: " << this->checkpoint_interval << ")";
+        throw std::invalid_argument("the chain can only be reseeded at a checkpoint block");
+    }
+    Bytes state(this->getStateLen());
+    state.fillrandom();
+    this->resumeFromState(state + this->getStateKey(block_index), block_index);
+}
@@ -42,7 +42,7 @@ unsigned char ChainHashData::getPartsNumber() const noexcept {
     return this->name_len_ind;
 }
 
-Bytes ChainHashData::getDataBlock() const {
+const Bytes& ChainHashData::getDataBlock() const {
     // gets the datablock
     if (!this->isComplete()) {
         // throws if the block is not completed yet
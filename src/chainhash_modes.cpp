@@ -58,11 +58,11 @@ bool ChainHashModes::isModeValid(const CHModes& chainhash_mode) noexcept {
     return (1 <= chainhash_mode && chainhash_mode <= MAX_CHAINHASHMODE_NUMBER);
 }
 
-ErrorStruct<Bytes> ChainHashModes::performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const Bytes& data, const u_int64_t timeout) {
+ErrorStruct<Bytes> ChainHashModes::performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const Bytes& data, const u_int64_t timeout, ChainHashControl* control) {
     // performs a chainhash on bytes
     PLOG_VERBOSE << "performing chainhash (mode: " << +chainh.getMode() << ", iterations: " << chainh.getIters() << ", timeout " << timeout << ")";
-    PwFunc pwf = PwFunc(std::move(hash));  // init the pwfunc object with the given hash function
-    std::string constant_salt{};           // init all variables we might need, because in the switch statement no variables can be declared
+    PwFunc pwf = PwFunc(std::move(hash), control);  // init the pwfunc object with the given hash function (and the control)
+    std::string constant_salt{};                    // init all variables we might need, because in the switch statement no variables can be declared
     u_int64_t count_salt{};
     u_int64_t a{};
     u_int64_t b{};
@@ -92,11 +92,11 @@ ErrorStruct<Bytes> ChainHashModes::performChainHash(const ChainHash& chainh, std
     }
 }
 
-ErrorStruct<Bytes> ChainHashModes::performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const std::string& data, const u_int64_t timeout) {
+ErrorStruct<Bytes> ChainHashModes::performChainHash(const ChainHash& chainh, std::shared_ptr<Hash> hash, const std::string& data, const u_int64_t timeout, ChainHashControl* control) {
     // performs a chainhash on a string
     PLOG_VERBOSE << "performing chainhash (mode: " << +chainh.getMode() << ", iterations: " << chainh.getIters() << ", timeout " << timeout << ")";
-    PwFunc pwf = PwFunc(std::move(hash));  // init the pwfunc object with the given hash function
-    std::string constant_salt{};           // init all variables we might need, because in the switch statement no variables can be declared
+    PwFunc pwf = PwFunc(std::move(hash), control);  // init the pwfunc object with the given hash function (and the control)
+    std::string constant_salt{};                    // init all variables we might need, because in the switch statement no variables can be declared
     u_int64_t count_salt{};
     u_int64_t a{};
     u_int64_t b{};
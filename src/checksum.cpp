@@ -0,0 +1,160 @@
+#include "checksum.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "settings.h"
+
+namespace {
+// the primes of xxHash64
+const constexpr u_int64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+const constexpr u_int64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const constexpr u_int64_t PRIME3 = 0x165667B19E3779F9ULL;
+const constexpr u_int64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+const constexpr u_int64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline u_int64_t rotl(const u_int64_t x, const int r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+inline u_int64_t read64(const unsigned char* p) noexcept {
+    // little endian read of 8 Bytes (one unaligned load on little endian machines)
+    u_int64_t v;
+    std::memcpy(&v, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline u_int64_t read32(const unsigned char* p) noexcept {
+    // little endian read of 4 Bytes
+    return (u_int64_t)p[0] | ((u_int64_t)p[1] << 8) | ((u_int64_t)p[2] << 16) | ((u_int64_t)p[3] << 24);
+}
+
+inline u_int64_t laneRound(u_int64_t acc, const u_int64_t input) noexcept {
+    // mixes 8 Bytes into one lane
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+inline u_int64_t mergeRound(u_int64_t acc, const u_int64_t lane) noexcept {
+    // mixes one lane into the result
+    acc ^= laneRound(0, lane);
+    return acc * PRIME1 + PRIME4;
+}
+}  // namespace
+
+Checksum::Checksum(const u_int64_t seed) noexcept : seed(seed) {
+    // the lanes start with the seed
+    this->lanes[0] = seed + PRIME1 + PRIME2;
+    this->lanes[1] = seed + PRIME2;
+    this->lanes[2] = seed;
+    this->lanes[3] = seed - PRIME1;
+}
+
+void Checksum::consumeStripe(const unsigned char* stripe) noexcept {
+    // every lane consumes its 8 Bytes of the stripe
+    this->lanes[0] = laneRound(this->lanes[0], read64(stripe));
+    this->lanes[1] = laneRound(this->lanes[1], read64(stripe + 8));
+    this->lanes[2] = laneRound(this->lanes[2], read64(stripe + 16));
+    this->lanes[3] = laneRound(this->lanes[3], read64(stripe + 24));
+}
+
+void Checksum::addData(const unsigned char* data, const size_t len) noexcept {
+    // fills the buffer first, the full stripes of the data are consumed without copying them
+    if (len == 0) return;
+    this->total_len += len;
+    size_t pos = 0;
+    if (this->buffered > 0) {
+        size_t fill = std::min<size_t>(32 - this->buffered, len);
+        std::memcpy(this->buffer + this->buffered, data, fill);
+        this->buffered += fill;
+        pos = fill;
+        if (this->buffered < 32) return;
+        this->consumeStripe(this->buffer);
+        this->buffered = 0;
+    }
+    // the lanes are kept in locals, the data could alias the members and would force a store after every stripe
+    u_int64_t v1 = this->lanes[0], v2 = this->lanes[1], v3 = this->lanes[2], v4 = this->lanes[3];
+    for (; pos + 32 <= len; pos += 32) {
+        v1 = laneRound(v1, read64(data + pos));
+        v2 = laneRound(v2, read64(data + pos + 8));
+        v3 = laneRound(v3, read64(data + pos + 16));
+        v4 = laneRound(v4, read64(data + pos + 24));
+    }
+    this->lanes[0] = v1;
+    this->lanes[1] = v2;
+    this->lanes[2] = v3;
+    this->lanes[3] = v4;
+    std::memcpy(this->buffer, data + pos, len - pos);
+    this->buffered = len - pos;
+}
+
+void Checksum::addZeros(const size_t len) noexcept {
+    // adds the zeros in small parts
+    const unsigned char zeros[32] = {0};
+    for (size_t added = 0; added < len; added += 32) this->addData(zeros, std::min<size_t>(32, len - added));
+}
+
+u_int64_t Checksum::getResult() const noexcept {
+    // merges the lanes, mixes the remaining Bytes of the buffer and the length and avalanches the result
+    u_int64_t result;
+    if (this->total_len >= 32) {
+        result = rotl(this->lanes[0], 1) + rotl(this->lanes[1], 7) + rotl(this->lanes[2], 12) + rotl(this->lanes[3], 18);
+        for (int i = 0; i < 4; i++) result = mergeRound(result, this->lanes[i]);
+    } else {
+        result = this->seed + PRIME5;
+    }
+    result += this->total_len;
+    size_t pos = 0;
+    for (; pos + 8 <= this->buffered; pos += 8) {
+        result ^= laneRound(0, read64(this->buffer + pos));
+        result = rotl(result, 27) * PRIME1 + PRIME4;
+    }
+    if (pos + 4 <= this->buffered) {
+        result ^= read32(this->buffer + pos) * PRIME1;
+        result = rotl(result, 23) * PRIME2 + PRIME3;
+        pos += 4;
+    }
+    for (; pos < this->buffered; pos++) {
+        result ^= this->buffer[pos] * PRIME5;
+        result = rotl(result, 11) * PRIME1;
+    }
+    result ^= result >> 33;
+    result *= PRIME2;
+    result ^= result >> 29;
+    result *= PRIME3;
+    result ^= result >> 32;
+    return result;
+}
+
+u_int64_t Checksum::calculateHeader(const unsigned char* header, const size_t header_len, const size_t checksum_pos) noexcept {
+    // the header is added around the checksum Bytes
+    Checksum checksum;
+    checksum.addData(header, checksum_pos);
+    checksum.addZeros(8);
+    checksum.addData(header + checksum_pos + 8, header_len - checksum_pos - 8);
+    return checksum.getResult();
+}
+
+u_int64_t Checksum::calculateChunks(const std::vector<std::pair<const unsigned char*, u_int64_t>>& parts, const u_int64_t offset) noexcept {
+    // a part can end inside of a chunk, the chunk is continued with the next part
+    u_int64_t sum = 0;
+    u_int64_t chunk = offset / CHECKSUM_CHUNK_LEN;
+    Checksum checksum{chunk};
+    for (const std::pair<const unsigned char*, u_int64_t>& part : parts) {
+        u_int64_t pos = 0;
+        while (pos < part.second) {
+            u_int64_t len = std::min<u_int64_t>(part.second - pos, CHECKSUM_CHUNK_LEN - checksum.total_len);
+            checksum.addData(part.first + pos, len);
+            pos += len;
+            if (checksum.total_len == CHECKSUM_CHUNK_LEN) {
+                sum += checksum.getResult();
+                checksum = Checksum{++chunk};
+            }
+        }
+    }
+    // the last chunk of the data can be shorter
+    if (checksum.total_len > 0) sum += checksum.getResult();
+    return sum;
+}
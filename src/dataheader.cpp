@@ -3,10 +3,156 @@ this file contains the implementations of Data header class
 */
 #include "dataheader.h"
 
+#include <cstring>
+
+#include "checksum.h"
 #include "logger.h"
 #include "rng.h"
 #include "utility.h"
 
+namespace {
+struct HeaderWriter {
+    // writes the fields of the header into the preallocated header buffer, there are no intermediate Bytes objects
+    unsigned char* out;     // start of the header buffer
+    const size_t max_len;   // the calculated header length
+    size_t len = 0;         // number of written Bytes
+
+    void reserve(const size_t num) const {
+        // throws if num more Bytes do not fit into the header
+        if (this->len + num > this->max_len) throw std::length_error("the field does not fit into the header (len: " + std::to_string(this->len + num) + ")");
+    }
+    void addByte(const unsigned char byte) {
+        this->reserve(1);
+        this->out[this->len++] = byte;
+    }
+    void addLong(const u_int64_t l) {
+        // 8 Bytes, most significant Byte first (like Bytes::fromLong(l, true))
+        this->reserve(8);
+        for (int i = 7; i >= 0; i--) this->out[this->len++] = (unsigned char)(l >> (8 * i));
+    }
+    void addBytes(const Bytes& bytes) { this->addBytes(bytes.getBytes(), bytes.getLen()); }
+    void addBytes(const unsigned char* bytes, const size_t num) {
+        this->reserve(num);
+        std::memcpy(this->out + this->len, bytes, num);
+        this->len += num;
+    }
+    size_t getLen() const noexcept { return this->len; }
+};
+
+struct HeaderReader {
+    // reads the fields of the header in place from one contiguous buffer, every read is checked against the header length
+    const unsigned char* in;  // start of the header buffer
+    size_t max_len;           // the length of the buffer (the header size after it was read)
+    size_t pos = 0;           // number of read Bytes
+
+    bool has(const size_t num) const noexcept { return this->pos <= this->max_len && num <= this->max_len - this->pos; }
+    bool readByte(unsigned char& byte) noexcept {
+        if (!this->has(1)) return false;
+        byte = this->in[this->pos++];
+        return true;
+    }
+    bool readLong(u_int64_t& l) noexcept {
+        // 8 Bytes, most significant Byte first (like Bytes::toLong())
+        if (!this->has(8)) return false;
+        l = 0;
+        for (int i = 0; i < 8; i++) l = (l << 8) | this->in[this->pos++];
+        return true;
+    }
+    const unsigned char* readBytes(const size_t num) noexcept {
+        // returns a pointer to the next num Bytes inside of the buffer (nullptr if they are not in the header)
+        if (!this->has(num)) return nullptr;
+        const unsigned char* ret = this->in + this->pos;
+        this->pos += num;
+        return ret;
+    }
+    size_t getPos() const noexcept { return this->pos; }
+};
+
+bool readChainHash(HeaderReader& reader, const int num, ChainHash& chainhash, ErrorStruct<std::unique_ptr<DataHeader>>& err) noexcept {
+    // reads the mode, the iterations and the datablock of the chainhash num, sets err and returns false if they are invalid
+    unsigned char mode;
+    u_int64_t iters;
+    unsigned char datablock_len;
+    if (!reader.readByte(mode)) {
+        PLOG_ERROR << "not enogh data to read the chainhash" << num << " mode";
+        err.errorCode = ERR_NOT_ENOUGH_DATA;
+        err.errorInfo = "Chainhash" + std::to_string(num) + " mode";
+        return false;
+    }
+    std::shared_ptr<Format> format = nullptr;
+    std::shared_ptr<ChainHashData> chd = nullptr;
+    try {
+        format = std::make_shared<Format>(CHModes(mode));
+        chd = std::make_shared<ChainHashData>(*format);
+    } catch (const std::invalid_argument& ex) {
+        // the chainhash mode is invalid
+        PLOG_ERROR << "invalid chainhash mode " << num << " found in data (chainhash_mode " << num << ": " << +mode << ") (error msg: " << ex.what() << ")";
+        err.errorCode = ERR_CHAINHASHMODE_FORMAT_INVALID;
+        err.errorInfo = mode;
+        err.what = ex.what();
+        return false;
+    } catch (const std::exception& ex) {
+        // some other error occurred
+        PLOG_ERROR << "An error occurred while setting up the format" << num << " and chainhashdata" << num << " (error msg: " << ex.what() << ")";
+        err.errorCode = ERR;
+        err.errorInfo = "An error occurred while setting up the format" + std::to_string(num) + " and chainhashdata" + std::to_string(num);
+        err.what = ex.what();
+        return false;
+    }
+    const unsigned char* data = nullptr;
+    if (!reader.readLong(iters) || !reader.readByte(datablock_len) || (data = reader.readBytes(datablock_len)) == nullptr) {
+        PLOG_ERROR << "not enough data to read the chainhash data block " << num;
+        err.errorCode = ERR_NOT_ENOUGH_DATA;
+        err.errorInfo = "Chainhash data block " + std::to_string(num);
+        return false;
+    }
+    // the datablock is split into the parts of the format, a part with * length takes the remaining Bytes
+    Bytes part(255);
+    size_t data_len = 0;
+    try {
+        for (const NameLen& nl : format->getNameLenList()) {
+            size_t part_len = nl.len != 0 ? nl.len : datablock_len - data_len;
+            if (data_len + part_len > datablock_len) throw std::length_error("the chainhash data block is shorter than its format");
+            part.setBytes(data + data_len, part_len);
+            chd->addBytes(part);
+            data_len += part_len;
+            if (nl.len == 0) break;
+        }
+        if (data_len != datablock_len) throw std::length_error("the chainhash data block is longer than its format");
+    } catch (const std::length_error& ex) {
+        // the datablock length does not match with the format
+        PLOG_ERROR << "the chainhash data block " << num << " does not match with its format (error msg: " << ex.what() << ")";
+        err.errorCode = ERR_CHAINHASH_DATABLOCK_OUTOFRANGE;
+        err.errorInfo = part.toHex();
+        err.what = ex.what();
+        return false;
+    } catch (const std::invalid_argument& ex) {
+        // the bytes have the wrong len
+        PLOG_ERROR << "invalid format of the chainhash data block " << num << " (error msg: " << ex.what() << ")";
+        err.errorCode = ERR_CHAINHASH_DATAPART_INVALID;
+        err.errorInfo = part.toHex();
+        err.what = ex.what();
+        return false;
+    } catch (const std::logic_error& ex) {
+        // adding but its completed
+        PLOG_ERROR << "adding bytes to the chainhash data block " << num << " but its already completed (error msg: " << ex.what() << ")";
+        err.errorCode = ERR_CHAINHASH_DATABLOCK_ALREADY_COMPLETED;
+        err.errorInfo = part.toHex();
+        err.what = ex.what();
+        return false;
+    } catch (const std::exception& ex) {
+        // some other error occurred
+        PLOG_ERROR << "An error occurred while reading the chainhash data block " << num << " (error msg: " << ex.what() << ")";
+        err.errorCode = ERR;
+        err.errorInfo = "An error occurred while reading the chainhash data block " + std::to_string(num);
+        err.what = ex.what();
+        return false;
+    }
+    chainhash = ChainHash{CHModes(mode), iters, chd};
+    return true;
+}
+}  // namespace
+
 DataHeader::DataHeader(const HModes hash_mode) {
     PLOG_VERBOSE << "new DataHeader created (hash mode: " << +hash_mode << ")";
     // initialize the hash mode
@@ -30,6 +176,7 @@ unsigned int DataHeader::getHeaderLength() const noexcept {
     if (this->dh.chainhash1.valid() && this->dh.chainhash2.valid())  // all data set to calculate the header length
         return 40 + 2 * this->hash_size + this->datablocks_len + this->dh.chainhash1.getChainHashData()->getLen() + this->dh.chainhash2.getChainHashData()->getLen();  // dataheader.md
     if (this->header_bytes.getLen() > 0) return this->header_bytes.getLen();  // header bytes are set, so we get this length
+    if (this->read_header != nullptr) return this->read_header->getLen();     // the header was read and not changed
     return 0;                                                                 // not enough infos to get the header length
 }
 
@@ -38,6 +185,316 @@ int DataHeader::getHashSize() const noexcept {
     return this->hash_size;
 }
 
+u_int64_t DataHeader::getBlockLen() const {
+    // gets the block length of the keystream block format
+    // the BLOCKFORMAT datablock stores the format version (1 Byte) and the block length (8 Bytes)
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type != DatablockType::BLOCKFORMAT) continue;
+        if (datablock.getLen() != 9 || datablock.getBytes()[0] != KEYSTREAM_BLOCK_FORMAT) {
+            PLOG_ERROR << "unknown block format (datablock: " << datablock.getData().toHex() << ")";
+            throw std::invalid_argument("unknown block format");
+        }
+        u_int64_t block_len = datablock.copySubBytes(1, 9).toLong();
+        if (block_len < MIN_BLOCK_LEN || block_len > MAX_BLOCK_LEN) {
+            PLOG_ERROR << "the block format has an invalid block length: " << block_len;
+            throw std::invalid_argument("block format has an invalid block length");
+        }
+        return block_len;
+    }
+    // no block format datablock, legacy format
+    return 0;
+}
+
+u_int64_t DataHeader::getEffectiveBlockLen() const {
+    // the legacy format uses blocks of hash size
+    u_int64_t block_len = this->getBlockLen();
+    return block_len == 0 ? this->getHashSize() : block_len;
+}
+
+DataBlock DataHeader::createBlockFormatDataBlock(const u_int64_t block_len) {
+    // creates the BLOCKFORMAT datablock with the format version and the block length
+    if (block_len < MIN_BLOCK_LEN || block_len > MAX_BLOCK_LEN) {
+        PLOG_ERROR << "the given block length is not valid: " << block_len;
+        throw std::invalid_argument("block length is not valid");
+    }
+    Bytes data(9);
+    data.addByte(KEYSTREAM_BLOCK_FORMAT);
+    Bytes::fromLong(block_len, true).addcopyToBytes(data);
+    return DataBlock(DatablockType::BLOCKFORMAT, data);
+}
+
+ShardLayout DataHeader::getShardLayout() const {
+    // gets the shard layout
+    // the SHARDS datablock stores the number of shards (8 Bytes) and the length of one shard (8 Bytes)
+    ShardLayout layout;
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type != DatablockType::SHARDS) continue;
+        if (datablock.getLen() != 16) {
+            PLOG_ERROR << "the shard datablock has an invalid length: " << datablock.getLen();
+            throw std::invalid_argument("shard datablock has an invalid length");
+        }
+        layout.shard_count = datablock.copySubBytes(0, 8).toLong();
+        layout.shard_len = datablock.copySubBytes(8, 16).toLong();
+        if (layout.shard_count < 2 || layout.shard_count > MAX_SHARD_COUNT) {
+            PLOG_ERROR << "the shard datablock has an invalid shard count: " << layout.shard_count;
+            throw std::invalid_argument("shard datablock has an invalid shard count");
+        }
+        return layout;
+    }
+    // no shard datablock, the content is one chain
+    return layout;
+}
+
+DataBlock DataHeader::createShardDataBlock(const ShardLayout& layout) {
+    // creates the SHARDS datablock with the number of shards and the length of one shard
+    if (layout.shard_count < 2 || layout.shard_count > MAX_SHARD_COUNT) {
+        PLOG_ERROR << "the given shard count is not valid: " << layout.shard_count;
+        throw std::invalid_argument("shard count is not valid");
+    }
+    Bytes data(16);
+    Bytes::fromLong(layout.shard_count, true).addcopyToBytes(data);
+    Bytes::fromLong(layout.shard_len, true).addcopyToBytes(data);
+    return DataBlock(DatablockType::SHARDS, data);
+}
+
+CipherFormat DataHeader::getCipherFormat() const {
+    // gets the cipher format
+    // the CIPHER datablock stores the cipher mode (1 Byte), the chunk length (8 Bytes) and the key salt (AEAD_KEY_SALT_LEN Bytes)
+    CipherFormat format;
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type != DatablockType::CIPHER) continue;
+        if (datablock.getLen() != 9 + AEAD_KEY_SALT_LEN) {
+            PLOG_ERROR << "the cipher datablock has an invalid length: " << datablock.getLen();
+            throw std::invalid_argument("cipher datablock has an invalid length");
+        }
+        unsigned char cipher_mode = datablock.getBytes()[0];
+        format.chunk_len = datablock.copySubBytes(1, 9).toLong();
+        if (cipher_mode < 1 || cipher_mode > MAX_CIPHERMODE_NUMBER || (cipher_mode != CIPHERMODE_HASHCHAIN && format.chunk_len == 0)) {
+            PLOG_ERROR << "the cipher datablock is invalid (cipher_mode: " << +cipher_mode << ", chunk_len: " << format.chunk_len << ")";
+            throw std::invalid_argument("cipher datablock is invalid");
+        }
+        format.cipher_mode = static_cast<CModes>(cipher_mode);
+        format.key_salt = datablock.copySubBytes(9, 9 + AEAD_KEY_SALT_LEN);
+        return format;
+    }
+    // no cipher datablock, the content is encrypted with the hash chain
+    return format;
+}
+
+DataBlock DataHeader::createCipherDataBlock(const CipherFormat& format) {
+    // creates the CIPHER datablock with the cipher mode, the chunk length and the key salt
+    if (format.cipher_mode < 1 || format.cipher_mode > MAX_CIPHERMODE_NUMBER || format.key_salt.getLen() != AEAD_KEY_SALT_LEN) {
+        PLOG_ERROR << "the given cipher format is not valid (cipher_mode: " << +format.cipher_mode << ", key_salt_len: " << format.key_salt.getLen() << ")";
+        throw std::invalid_argument("cipher format is not valid");
+    }
+    Bytes data(9 + AEAD_KEY_SALT_LEN);
+    data.addByte(format.cipher_mode);
+    Bytes::fromLong(format.chunk_len, true).addcopyToBytes(data);
+    format.key_salt.addcopyToBytes(data);
+    return DataBlock(DatablockType::CIPHER, data);
+}
+
+IntegrityTree DataHeader::getIntegrityTree() const {
+    // gets the integrity tree
+    // the INTEGRITY datablock stores the leaf length (8 Bytes), the number of regions (1 Byte), the root (hash size)
+    // and INTEGRITY_REGIONS region hashes (INTEGRITY_REGION_HASH_LEN Bytes each, the unused ones are zero)
+    IntegrityTree tree;
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type != DatablockType::INTEGRITY) continue;
+        Bytes data = datablock.getData();
+        if (data.getLen() != 9 + this->hash_size + INTEGRITY_REGIONS * INTEGRITY_REGION_HASH_LEN) {
+            PLOG_ERROR << "the integrity datablock has an invalid length: " << data.getLen();
+            throw std::invalid_argument("integrity datablock has an invalid length");
+        }
+        tree.leaf_len = data.copySubBytes(0, 8).toLong();
+        tree.region_count = data.getBytes()[8];
+        if (tree.leaf_len < MIN_INTEGRITY_LEAF_LEN || tree.leaf_len > MAX_INTEGRITY_LEAF_LEN || tree.region_count == 0 || tree.region_count > INTEGRITY_REGIONS) {
+            PLOG_ERROR << "the integrity datablock is invalid (leaf_len: " << tree.leaf_len << ", region_count: " << tree.region_count << ")";
+            throw std::invalid_argument("integrity datablock is invalid");
+        }
+        tree.root = data.copySubBytes(9, 9 + this->hash_size);
+        for (u_int64_t region = 0; region < tree.region_count; region++) {
+            u_int64_t start = 9 + this->hash_size + region * INTEGRITY_REGION_HASH_LEN;
+            tree.regions.push_back(data.copySubBytes(start, start + INTEGRITY_REGION_HASH_LEN));
+        }
+        return tree;
+    }
+    // no integrity datablock, the file has no integrity tree
+    return tree;
+}
+
+DataBlock DataHeader::createIntegrityDataBlock(const IntegrityTree& tree) {
+    // creates the INTEGRITY datablock with the leaf length, the number of regions, the root and the region hashes
+    if (tree.leaf_len < MIN_INTEGRITY_LEAF_LEN || tree.leaf_len > MAX_INTEGRITY_LEAF_LEN || tree.region_count == 0 || tree.region_count > INTEGRITY_REGIONS ||
+        tree.regions.size() != tree.region_count || tree.root.getLen() == 0) {
+        PLOG_ERROR << "the given integrity tree is not valid (leaf_len: " << tree.leaf_len << ", region_count: " << tree.region_count << ", regions: " << tree.regions.size()
+                   << ", root_len: " << tree.root.getLen() << ")";
+        throw std::invalid_argument("integrity tree is not valid");
+    }
+    Bytes data(9 + tree.root.getLen() + INTEGRITY_REGIONS * INTEGRITY_REGION_HASH_LEN);
+    Bytes::fromLong(tree.leaf_len, true).addcopyToBytes(data);
+    data.addByte(static_cast<unsigned char>(tree.region_count));
+    tree.root.addcopyToBytes(data);
+    for (const Bytes& region : tree.regions) {
+        if (region.getLen() != INTEGRITY_REGION_HASH_LEN) {
+            PLOG_ERROR << "the given region hash has an invalid length: " << region.getLen();
+            throw std::invalid_argument("region hash has an invalid length");
+        }
+        region.addcopyToBytes(data);
+    }
+    // the datablock always has the same length, so the header length does not change if the tree is updated
+    while (data.getLen() < data.getMaxLen()) data.addByte(0);
+    return DataBlock(DatablockType::INTEGRITY, data);
+}
+
+u_int64_t DataHeader::getLeafTableLen() const {
+    // gets the leaf table length
+    // since trailer version 2 the INDEX datablock stores the length of the leaf hash table behind the content length (Bytes 17 to 25)
+    // version 4 stores the content capacity in front of it (Bytes 25 to 33), its table is followed by the region hashes
+    const DataBlock* datablock = this->findDataBlock(DatablockType::INDEX);
+    if (datablock == nullptr || datablock->getBytes()[0] < 2) return 0;
+    if (datablock->getLen() == 25) return datablock->getData().copySubBytes(17, 25).toLong();
+    if (datablock->getLen() == 33 && datablock->getBytes()[0] >= 4) return datablock->getData().copySubBytes(25, 33).toLong();
+    return 0;
+}
+
+unsigned char DataHeader::getTrailerVersion() const {
+    // gets the trailer version from the first Byte of the INDEX datablock
+    const DataBlock* datablock = this->findDataBlock(DatablockType::INDEX);
+    if (datablock == nullptr || datablock->getLen() == 0) return 0;
+    return datablock->getBytes()[0];
+}
+
+std::vector<KeySlot> DataHeader::getKeySlots() const {
+    // gets the key slots
+    // every KEYSLOT datablock stores the validator (hash size) and the wrapped data key (hash size) of one slot
+    std::vector<KeySlot> slots;
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type != DatablockType::KEYSLOT) continue;
+        if (datablock.getLen() != 2 * this->hash_size) {
+            PLOG_ERROR << "the key slot datablock has an invalid length: " << datablock.getLen();
+            throw std::invalid_argument("key slot datablock has an invalid length");
+        }
+        slots.push_back(KeySlot{datablock.copySubBytes(0, this->hash_size), datablock.copySubBytes(this->hash_size, 2 * this->hash_size)});
+    }
+    if (slots.size() > MAX_KEY_SLOTS) {
+        PLOG_ERROR << "the header has too many key slots: " << slots.size();
+        throw std::invalid_argument("header has too many key slots");
+    }
+    return slots;
+}
+
+DataBlock DataHeader::createKeySlotDataBlock(const KeySlot& slot) {
+    // creates the KEYSLOT datablock with the validator and the wrapped data key
+    if (slot.validator.getLen() == 0 || slot.validator.getLen() != slot.wrapped_key.getLen()) {
+        PLOG_ERROR << "the given key slot is not valid (validator_len: " << slot.validator.getLen() << ", wrapped_key_len: " << slot.wrapped_key.getLen() << ")";
+        throw std::invalid_argument("key slot is not valid");
+    }
+    Bytes data(slot.validator.getLen() + slot.wrapped_key.getLen());
+    slot.validator.addcopyToBytes(data);
+    slot.wrapped_key.addcopyToBytes(data);
+    return DataBlock(DatablockType::KEYSLOT, data);
+}
+
+KeySlot DataHeader::createKeySlot(const Hash& hash, const Bytes& password_hash, const Bytes& validator, const Bytes& data_key) {
+    // the wrapping key is the hash of the password hash and the validator, the validator alone does not reveal it
+    if (password_hash.getLen() != hash.getHashSize() || validator.getLen() != hash.getHashSize() || data_key.getLen() != hash.getHashSize()) {
+        PLOG_ERROR << "the key slot parts have an invalid length (password_hash_len: " << password_hash.getLen() << ", validator_len: " << validator.getLen()
+                   << ", data_key_len: " << data_key.getLen() << ")";
+        throw std::invalid_argument("key slot parts have an invalid length");
+    }
+    Bytes input(password_hash, validator.getLen());
+    validator.addcopyToBytes(input);
+    return KeySlot{validator, data_key + hash.hash(input)};
+}
+
+KeySlot DataHeader::createFreeKeySlot(const size_t hash_size) {
+    // a free slot is all zero, so it has the length of a used slot
+    Bytes zero(hash_size);
+    while (zero.getLen() < zero.getMaxLen()) zero.addByte(0);
+    return KeySlot{zero, zero};
+}
+
+Bytes DataHeader::unwrapKeySlot(const Hash& hash, const Bytes& password_hash, const KeySlot& slot) {
+    // subtracts the wrapping key of createKeySlot
+    Bytes input(password_hash, slot.validator.getLen());
+    slot.validator.addcopyToBytes(input);
+    return slot.wrapped_key - hash.hash(input);
+}
+
+DataBlock DataHeader::createChecksumDataBlock() {
+    // creates the CHECKSUM datablock, it stores the 8 Byte header checksum and the 8 Byte data checksum (zero until setChecksum is called)
+    Bytes data(16);
+    Bytes::fromLong(0, true).addcopyToBytes(data);
+    Bytes::fromLong(0, true).addcopyToBytes(data);
+    return DataBlock(DatablockType::CHECKSUM, data);
+}
+
+size_t DataHeader::getChecksumPos(const unsigned char* header, const size_t header_len) {
+    // walks over the unencrypted datablocks (count Byte behind the file size, header size, file mode and hash mode)
+    // every datablock is stored as type Byte, length Byte and data
+    size_t pos = 18;
+    if (header_len <= pos) {
+        PLOG_ERROR << "the header is too short to contain the datablocks (header_len: " << header_len << ")";
+        throw std::length_error("header is too short to contain the datablocks");
+    }
+    unsigned char count = header[pos++];
+    for (unsigned char i = 0; i < count; i++) {
+        if (pos + 2 > header_len || pos + 2 + header[pos + 1] > header_len) {
+            PLOG_ERROR << "the datablocks do not fit into the header (header_len: " << header_len << ")";
+            throw std::length_error("datablocks do not fit into the header");
+        }
+        if (header[pos] == DatablockType::CHECKSUM && header[pos + 1] == 16) return pos + 2;
+        pos += 2 + header[pos + 1];
+    }
+    // no CHECKSUM datablock (the file was written before the checksum was added or stores one checksum over the whole file)
+    return 0;
+}
+
+bool DataHeader::hasChecksum() const noexcept {
+    // the datablock is looked up without reading its data
+    const DataBlock* datablock = this->findDataBlock(DatablockType::CHECKSUM);
+    return datablock != nullptr && datablock->getLen() == 16;
+}
+
+u_int64_t DataHeader::getDataChecksum() const {
+    // the data checksum is stored behind the header checksum
+    const Bytes& header = this->getHeaderBytes();
+    size_t pos = DataHeader::getChecksumPos(header.getBytes(), header.getLen());
+    if (pos == 0) return 0;
+    return header.copySubBytes(pos + 8, pos + 16).toLong();
+}
+
+void DataHeader::setChecksum(const unsigned char* data, const u_int64_t data_len) {
+    // the data is one part
+    this->setChecksum({{data, data_len}});
+}
+
+void DataHeader::setChecksum(const std::vector<std::pair<const unsigned char*, u_int64_t>>& data_parts) {
+    // the data checksum covers the whole data
+    if (!this->hasChecksum()) return;
+    this->setChecksum(Checksum::calculateChunks(data_parts, 0));
+}
+
+void DataHeader::setChecksum(const u_int64_t data_checksum) {
+    // the data checksum is written into the header bytes first, so the header checksum covers it
+    if (!this->hasChecksum()) return;
+    size_t pos = DataHeader::getChecksumPos(this->getHeaderBytes().getBytes(), this->getHeaderBytes().getLen());
+    if (this->read_header != nullptr) {
+        // the read header bytes are shared with the views, the header bytes are copied before they are changed
+        this->header_bytes = *this->read_header;
+        this->read_header = nullptr;
+    }
+    std::memcpy(this->header_bytes.getBytes() + pos + 8, Bytes::fromLong(data_checksum, true).getBytes(), 8);
+    Bytes checksums(16);
+    Bytes::fromLong(Checksum::calculateHeader(this->header_bytes.getBytes(), this->header_bytes.getLen(), pos), true).addcopyToBytes(checksums);
+    Bytes::fromLong(data_checksum, true).addcopyToBytes(checksums);
+    for (DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type == DatablockType::CHECKSUM) datablock.setData(checksums);
+    }
+    std::memcpy(this->header_bytes.getBytes() + pos, checksums.getBytes(), 8);
+}
+
 void DataHeader::setChainHash1(const ChainHash chainhash) {
     // sets the information about the first chainhash
     PLOG_VERBOSE << "setting chainhash1: " << chainhash;
@@ -47,7 +504,7 @@ void DataHeader::setChainHash1(const ChainHash chainhash) {
     }
     // set the information to the object
     this->dh.chainhash1 = chainhash;
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
 }
 
 void DataHeader::setChainHash2(const ChainHash chainhash) {
@@ -59,21 +516,21 @@ void DataHeader::setChainHash2(const ChainHash chainhash) {
     }
     // set the information to the object
     this->dh.chainhash2 = chainhash;
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
 }
 
 void DataHeader::setFileDataMode(const FModes file_mode) {
     // sets the file data mode
     PLOG_VERBOSE << "setting file mode: " << +file_mode;
     this->dh.setFileDataMode(file_mode);
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
 }
 
 void DataHeader::setValidPasswordHashBytes(const Bytes& validBytes) {
     // set the passwordhash validator hash
     PLOG_VERBOSE << "setting password validator hash: " << validBytes.toHex();
     this->dh.setValidPasswordHash(validBytes);
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
 }
 
 void DataHeader::clearDataBlocks() noexcept {
@@ -81,22 +538,53 @@ void DataHeader::clearDataBlocks() noexcept {
     this->datablocks_len = 0;
     this->dh.dec_data_blocks.clear();
     this->dh.enc_data_blocks.clear();
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
+}
+
+void DataHeader::removeDataBlocks(const DatablockType type) noexcept {
+    // removes all data blocks of the given type
+    for (auto it = this->dh.dec_data_blocks.begin(); it != this->dh.dec_data_blocks.end();) {
+        if (it->type == type) {
+            this->datablocks_len -= 2 + it->getLen();
+            it = this->dh.dec_data_blocks.erase(it);
+            this->clearHeaderBytes();
+        } else
+            it++;
+    }
 }
 
-void DataHeader::addDataBlock(const DataBlock datablock) {
+bool DataHeader::hasDataBlock(const DatablockType type) const noexcept {
+    // checks if one of the data blocks has the given type
+    return this->findDataBlock(type) != nullptr;
+}
+
+const DataBlock* DataHeader::findDataBlock(const DatablockType type) const noexcept {
+    // only the type Bytes are compared, the data of the views is not read
+    for (const DataBlock& datablock : this->dh.dec_data_blocks) {
+        if (datablock.type == type) return &datablock;
+    }
+    return nullptr;
+}
+
+void DataHeader::addDataBlock(DataBlock datablock) {
     // adds a data block
     if (this->dh.dec_data_blocks.size() >= 255) {
         // there are already 255 datablocks
         PLOG_ERROR << "there are already 255 datablocks";
         throw std::length_error("there are already 255 datablocks");
     }
-    this->datablocks_len += 2 + datablock.getData().getLen();  // 1 for type, 1 for len, len for data
-    this->dh.dec_data_blocks.push_back(datablock);
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->datablocks_len += 2 + datablock.getLen();  // 1 for type, 1 for len, len for data
+    this->dh.dec_data_blocks.push_back(std::move(datablock));
+    this->clearHeaderBytes();
+}
+
+void DataHeader::setOrReplaceDataBlock(DataBlock datablock) {
+    // removes the data blocks of the same type before the data block is added
+    this->removeDataBlocks(datablock.type);
+    this->addDataBlock(std::move(datablock));
 }
 
-void DataHeader::addEncDataBlock(const EncDataBlock encdatablock) {
+void DataHeader::addEncDataBlock(EncDataBlock encdatablock) {
     // adds an encrypted data block
     if (this->dh.enc_data_blocks.size() >= 255) {
         // there are already 255 encrypted datablocks
@@ -104,9 +592,9 @@ void DataHeader::addEncDataBlock(const EncDataBlock encdatablock) {
         throw std::length_error("there are already 255 encrypted datablocks");
     }
     // should be the same as 257
-    this->datablocks_len += 2 + encdatablock.getEnc().getLen();  // 1 for type, 1 for len, len for data (255)
-    this->dh.enc_data_blocks.push_back(encdatablock);
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->datablocks_len += 2 + encdatablock.getEncBlock().getLen();  // 1 for type, 1 for len, len for data (255)
+    this->dh.enc_data_blocks.push_back(std::move(encdatablock));
+    this->clearHeaderBytes();
 }
 
 void DataHeader::setFileSize(const u_int64_t file_size) {
@@ -122,7 +610,7 @@ void DataHeader::setFileSize(const u_int64_t file_size) {
         PLOG_ERROR << "file size is to small (file_size: " << file_size << ", header_length: " << this->getHeaderLength() << ")";
         throw std::invalid_argument("file size is to small");
     }
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
     this->file_size = file_size;
 }
 
@@ -134,26 +622,33 @@ void DataHeader::setDataSize(const u_int32_t data_size) {
         PLOG_ERROR << "all dataheader parts have to be set to set the file size";
         throw std::logic_error("all dataheader parts have to be set to set the file size");
     }
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
     this->file_size = data_size + this->getHeaderLength();
 }
 
 std::optional<u_int64_t> DataHeader::getFileSize() const noexcept { return this->file_size; }
 
+void DataHeader::clearHeaderBytes() noexcept {
+    // the views keep the read header bytes alive, they are only dropped as the current header bytes
+    this->header_bytes.setLen(0);
+    this->read_header = nullptr;
+}
+
 void DataHeader::setEncSalt(const Bytes& salt) {
     // sets the salt
     PLOG_VERBOSE << "setting salt: " << salt.toHex();
     this->dh.setEncSalt(salt);
-    this->header_bytes.setLen(0);  // clear header bytes because they have to be recalculated
+    this->clearHeaderBytes();
 }
 
-Bytes DataHeader::getHeaderBytes() const {
+const Bytes& DataHeader::getHeaderBytes() const {
     // gets the header bytes
     if (this->getHeaderLength() == 0) {
         // no header is set and there are missing information
         PLOG_ERROR << "no header is set and there are even missing information to calculate the header bytes length";
         throw std::logic_error("not all data is set to calculate the length of the header");
     }
+    if (this->read_header != nullptr) return *this->read_header;  // the header was read and not changed
     if (this->getHeaderLength() != this->header_bytes.getLen()) {
         // current header has not the length that it should have (current header is out of date)
         PLOG_ERROR << "the calculated header length is not equal to the set header length. Call calcHeaderBytes() first. (set: " << +this->header_bytes.getLen()
@@ -193,52 +688,53 @@ void DataHeader::calcHeaderBytes(const Bytes& passwordhash) {
             throw std::invalid_argument("provided passwordhash is not valid (against validator)");
         }
     }
-    // saves the expected length to validate the result
+    // the exact length is known up front (dataheader.md), every field is written in one pass into the header buffer
     // need to clear header bytes to calculate the length. If it is not clear getHeaderLength() may return the current length
-    this->header_bytes.setLen(0);
+    this->clearHeaderBytes();
     unsigned int len = this->getHeaderLength();
-
-    Bytes dataheader = Bytes(len);
+    if (this->header_bytes.getMaxLen() < len) this->header_bytes.addSize(len - this->header_bytes.getMaxLen());  // the buffer is reused if it is large enough
+    HeaderWriter writer{this->header_bytes.getBytes(), len};
     try {
-        Bytes::fromLong(this->file_size.value(), true).addcopyToBytes(dataheader);  // add file size
-        Bytes::fromLong(len, true).addcopyToBytes(dataheader);                      // add header size
+        writer.addLong(this->file_size.value());  // add file size
+        writer.addLong(len);                      // add header size
 
-        dataheader.addByte(this->dh.getFileDataMode());  // add file mode byte
-        dataheader.addByte(this->dh.getHashMode());      // add hash mode byte
+        writer.addByte(this->dh.getFileDataMode());  // add file mode byte
+        writer.addByte(this->dh.getHashMode());      // add hash mode byte
 
-        dataheader.addByte((unsigned char)this->dh.dec_data_blocks.size());   // add data block count byte
-        for (DataBlock& datablock : this->dh.dec_data_blocks) {               // add all data blocks
-            dataheader.addByte(datablock.type);                               // add type byte
-            dataheader.addByte((unsigned char)datablock.getData().getLen());  // add data length byte
-            datablock.getData().addcopyToBytes(dataheader);                   // add data
+        writer.addByte((unsigned char)this->dh.dec_data_blocks.size());  // add data block count byte
+        for (const DataBlock& datablock : this->dh.dec_data_blocks) {   // add all data blocks
+            writer.addByte(datablock.type);                             // add type byte
+            writer.addByte(datablock.getLen());                         // add data length byte
+            writer.addBytes(datablock.getBytes(), datablock.getLen());  // add data
         }
-        dataheader.addByte(this->dh.chainhash1.getMode());                                  // add first chainhash mode byte
-        Bytes::fromLong(this->dh.chainhash1.getIters(), true).addcopyToBytes(dataheader);   // add iterations for the first chainhash
-        dataheader.addByte(this->dh.chainhash1.getChainHashData()->getLen());               // add datablock length byte
-        this->dh.chainhash1.getChainHashData()->getDataBlock().addcopyToBytes(dataheader);  // add first datablock
-        dataheader.addByte(this->dh.chainhash2.getMode());                                  // add second chainhash mode
-        Bytes::fromLong(this->dh.chainhash2.getIters(), true).addcopyToBytes(dataheader);   // add iterations for the second chainhash
-        dataheader.addByte(this->dh.chainhash2.getChainHashData()->getLen());               // add datablock length byte
-        this->dh.chainhash2.getChainHashData()->getDataBlock().addcopyToBytes(dataheader);  // add second datablock
-        this->dh.getValidPasswordHash().addcopyToBytes(dataheader);                         // add password validator
-        this->dh.getEncSalt().addcopyToBytes(dataheader);                                   // add encrypted salt
-
-        dataheader.addByte((unsigned char)this->dh.enc_data_blocks.size());  // add encrypted data block count byte
-        for (EncDataBlock& encdatablock : this->dh.enc_data_blocks) {        // add all encrypted data blocks
-            dataheader.addByte(encdatablock.getEncType());                   // add type byte
-            dataheader.addByte((unsigned char)encdatablock.getEncLen());     // add data length byte
-            encdatablock.getEnc().addcopyToBytes(dataheader);                // add data
+        writer.addByte(this->dh.chainhash1.getMode());                                // add first chainhash mode byte
+        writer.addLong(this->dh.chainhash1.getIters());                               // add iterations for the first chainhash
+        writer.addByte(this->dh.chainhash1.getChainHashData()->getLen());             // add datablock length byte
+        writer.addBytes(this->dh.chainhash1.getChainHashData()->getDataBlock());      // add first datablock
+        writer.addByte(this->dh.chainhash2.getMode());                                // add second chainhash mode
+        writer.addLong(this->dh.chainhash2.getIters());                               // add iterations for the second chainhash
+        writer.addByte(this->dh.chainhash2.getChainHashData()->getLen());             // add datablock length byte
+        writer.addBytes(this->dh.chainhash2.getChainHashData()->getDataBlock());      // add second datablock
+        writer.addBytes(this->dh.getValidPasswordHash());                             // add password validator
+        writer.addBytes(this->dh.getEncSalt());                                       // add encrypted salt
+
+        writer.addByte((unsigned char)this->dh.enc_data_blocks.size());     // add encrypted data block count byte
+        for (const EncDataBlock& encdatablock : this->dh.enc_data_blocks) { // add all encrypted data blocks
+            writer.addByte(encdatablock.getEncType());                      // add type byte
+            writer.addByte((unsigned char)encdatablock.getEncLen());        // add data length byte
+            writer.addBytes(encdatablock.getEncBlock().getBytes(), 255);    // add data
         }
     } catch (std::length_error& ex) {
         // trying to add more bytes than previously calculated
         PLOG_ERROR << "trying to add more bytes to the header than previously calculated (error msg: " << ex.what() << ")";
+        this->header_bytes.setLen(0);
         throw std::logic_error("trying to add more bytes to the header than previously calculated");
     }
-    if (dataheader.getLen() != len) {  // checks if the length is equal to the expected length
-        PLOG_FATAL << "calculated header has not the expected length (expected: " << +len << ", actual: " << +dataheader.getLen() << ")";
+    if (writer.getLen() != len) {  // checks if the length is equal to the expected length
+        PLOG_FATAL << "calculated header has not the expected length (expected: " << +len << ", actual: " << +writer.getLen() << ")";
         throw std::logic_error("calculated header has not the expected length");
     }
-    this->header_bytes = dataheader;
+    this->header_bytes.setLen(len);
 }
 
 DataHeaderParts DataHeader::getDataHeaderParts() const {
@@ -253,444 +749,91 @@ DataHeaderParts DataHeader::getDataHeaderParts() const {
 
 ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(Bytes& fileBytes) noexcept {
     // sets the header bytes by taking the first bytes of the file
-    // init error struct
-    ErrorStruct<std::unique_ptr<DataHeader>> err{FAIL, ERR, "An error occurred while reading the header", "setHeaderBytes"};
-    std::unique_ptr<DataHeader> dh = nullptr;
-    // setting the header parts
-    u_int64_t file_size;
-    u_int64_t header_size;
-    unsigned char fmode;
-    unsigned char hmode;
-    unsigned char data_block_count;
-    u_int16_t index = 0;  // index of the current byte
+    return DataHeader::setHeaderBytes(fileBytes.getBytes(), fileBytes.getLen());
+}
 
-    // ********************* FILESIZE *********************
+ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(const unsigned char* header, const size_t len) noexcept {
+    // copies the header (the header size is read from the prefix) out of the buffer, the buffer is not needed after this call
+    u_int64_t header_size = len;
+    HeaderReader prefix{header, len};
+    prefix.pos = 8;
+    if (prefix.readLong(header_size)) header_size = std::min<u_int64_t>(std::max<u_int64_t>(header_size, 16), len);  // the parser checks the header size
     try {
-        try {
-            // loading file size
-            file_size = fileBytes.copySubBytes(index, index + 8).toLong();
-        } catch (const std::length_error& ex) {
-            // copySubBytes failed because the length is reached
-            PLOG_ERROR << "not enogh data to read the file size (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "File size";
-            err.what = ex.what();
-            return err;
-        }
-        index += 8;
-
-        try {
-            // loading file size
-            header_size = fileBytes.copySubBytes(index, index + 8).toLong();
-        } catch (const std::length_error& ex) {
-            // copySubBytes failed because the length is reached
-            PLOG_ERROR << "not enogh data to read the header size (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Header size";
-            err.what = ex.what();
-            return err;
-        }
-        index += 8;
-
-        if (header_size > fileBytes.getLen()) {
-            // header size is bigger than the file size
-            PLOG_ERROR << "header size is bigger than the given bytes (header_size: " << header_size << ", given bytes: " << fileBytes.getLen() << ")";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = " because the given header size is bigger than the given size";
-            err.what = "header size is bigger than the given bytes";
-            return err;
-        }
-        //********************* FILEMODE *********************
-        // loading file mode
-        fmode = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-
-        // ********************* HASH FUNCTION *********************
-        // loading and setting hash mode
-        hmode = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-        try {
-            dh = std::make_unique<DataHeader>(HModes(hmode));
-        } catch (const std::invalid_argument& ex) {
-            // the hash mode is invalid
-            PLOG_ERROR << "invalid hash mode found in data (hash_mode: " << +hmode << ") (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_HASHMODE_INVALID;
-            err.errorInfo = hmode;
-            err.what = ex.what();
-            return err;
-        }
-
-        // setting the file data mode
-        try {
-            dh->setFileDataMode(FModes(fmode));
-        } catch (const std::invalid_argument& ex) {
-            // the file mode is invalid
-            PLOG_ERROR << "invalid file mode found in data (file_mode: " << +fmode << ") (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_FILEMODE_INVALID;
-            err.errorInfo = fmode;
-            err.what = ex.what();
-            return err;
-        }
-
-        // ********************* DATABLOCKS *********************
-        // loading data blocks
-        data_block_count = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-        for (int i = 0; i < data_block_count; i++) {
-            // data block type
-            unsigned char type = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            index += 1;
-            // data block len
-            unsigned char len = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            index += 1;
-            // data block data
-            Bytes data = fileBytes.copySubBytes(index, index + len);
-            index += len;
-            dh->addDataBlock(DataBlock(DatablockType(type), data));
-        }
-
-        // ********************* CHAINHASH1 *********************
-        std::shared_ptr<Format> format1 = nullptr;
-        std::shared_ptr<ChainHashData> chd1 = nullptr;
-        unsigned char ch1mode;
-        try {
-            ch1mode = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            format1 = std::make_shared<Format>(CHModes(ch1mode));
-            chd1 = std::make_shared<ChainHashData>(*format1);
-        } catch (const std::invalid_argument& ex) {
-            // the chainhash mode is invalid
-            PLOG_ERROR << "invalid chainhash mode 1 found in data (chainhash_mode 1: " << +ch1mode << ") (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASHMODE_FORMAT_INVALID;
-            err.errorInfo = ch1mode;
-            err.what = ex.what();
-            return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while reading the chainhash mode 1 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while reading the chainhash mode 1";
-            err.what = ex.what();
-            return err;
-        }
-        index += 1;
-        // chainhash 1 iters
-        u_int64_t ch1iters = fileBytes.copySubBytes(index, index + 8).toLong();
-        index += 8;
-        // chainhash 1 data block len
-        unsigned char ch1datablocklen = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-        // chainhash 1 data block
-        int data_len = 0;
-        Bytes tmp{255};
-        for (NameLen nl : format1->getNameLenList()) {
-            try {
-                if (nl.len != 0) {
-                    // got a data part with set length
-                    tmp = fileBytes.copySubBytes(index, index + nl.len);
-                    chd1->addBytes(tmp);
-                    index += nl.len;
-                    data_len += nl.len;
-                } else {
-                    // got a data parCHModest with * length (use the remaining bytes)
-                    tmp = fileBytes.copySubBytes(index, index + (ch1datablocklen - data_len));
-                    chd1->addBytes(tmp);
-                    data_len = ch1datablocklen;
-                    index += (ch1datablocklen - data_len);
-                    break;
-                }
-
-            } catch (const std::length_error& ex) {
-                // adding to much bytes
-                PLOG_ERROR << "adding to much bytes to the chainhash data block 1 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_OUTOFRANGE;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::invalid_argument& ex) {
-                // the bytes have the wrong len
-                PLOG_ERROR << "invalid format of the chainhash data block 1 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATAPART_INVALID;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::logic_error& ex) {
-                // adding but its completed
-                PLOG_ERROR << "adding bytes to the chainhash data block 1 but its already completed (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_ALREADY_COMPLETED;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::exception& ex) {
-                // some other error occurred
-                PLOG_ERROR << "An error occurred while reading the chainhash data block 1 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR;
-                err.errorInfo = "An error occurred while reading the chainhash data block 1";
-                err.what = ex.what();
-                return err;
-            }
-        }
-        assert(chd1->getLen() == ch1datablocklen);
-        assert(data_len == ch1datablocklen);
-        // chainhash 1
-        try {
-            dh->setChainHash1(ChainHash{CHModes(ch1mode), ch1iters, chd1});
-        } catch (const std::invalid_argument& ex) {
-            // the chainhash is invalid
-            PLOG_ERROR << "invalid chainhash 1 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH1_INVALID;
-            err.what = ex.what();
-            return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while setting the chainhash 1 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while setting the chainhash data block 1";
-            err.what = ex.what();
-            return err;
-        }
-
-        // ********************* CHAINHASH2 *********************
-        std::shared_ptr<Format> format2 = nullptr;
-        std::shared_ptr<ChainHashData> chd2 = nullptr;
-        unsigned char ch2mode;
-        try {
-            ch2mode = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            format2 = std::make_shared<Format>(CHModes(ch2mode));
-            chd2 = std::make_shared<ChainHashData>(*format2);
-        } catch (const std::invalid_argument& ex) {
-            // the chainhash mode is invalid
-            PLOG_ERROR << "invalid chainhash mode 2 found in data (chainhash_mode 2: " << +ch2mode << ") (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASHMODE_FORMAT_INVALID;
-            err.errorInfo = ch2mode;
-            err.what = ex.what();
-            return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while reading the chainhash mode 2 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while reading the chainhash mode 2";
-            err.what = ex.what();
-            return err;
-        }
-        index += 1;
-        // chainhash 2 iters
-        u_int64_t ch2iters = fileBytes.copySubBytes(index, index + 8).toLong();
-        index += 8;
-        // chainhash 2 data block len
-        unsigned char ch2datablocklen = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-        // chainhash 2 data block
-        data_len = 0;
-        for (NameLen nl : format2->getNameLenList()) {
-            try {
-                if (nl.len != 0) {
-                    // got a data part with set length
-                    tmp = fileBytes.copySubBytes(index, index + nl.len);
-                    chd2->addBytes(tmp);
-                    index += nl.len;
-                    data_len += nl.len;
-                } else {
-                    // got a data parCHModest with * length (use the remaining bytes)
-                    tmp = fileBytes.copySubBytes(index, index + (ch2datablocklen - data_len));
-                    chd2->addBytes(tmp);
-                    data_len = ch2datablocklen;
-                    index += (ch2datablocklen - data_len);
-                    break;
-                }
-
-            } catch (const std::length_error& ex) {
-                // adding to much bytes
-                PLOG_ERROR << "adding to much bytes to the chainhash data block 2 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_OUTOFRANGE;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::invalid_argument& ex) {
-                // the bytes have the wrong len
-                PLOG_ERROR << "invalid format of the chainhash data block 2 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATAPART_INVALID;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::logic_error& ex) {
-                // adding but its completed
-                PLOG_ERROR << "adding bytes to the chainhash data block 2 but its already completed (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_ALREADY_COMPLETED;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            } catch (const std::exception& ex) {
-                // some other error occurred
-                PLOG_ERROR << "An error occurred while reading the chainhash data block 2 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR;
-                err.errorInfo = "An error occurred while reading the chainhash data block 2";
-                err.what = ex.what();
-                return err;
-            }
-        }
-        assert(chd2->getLen() == ch2datablocklen);
-        assert(data_len == ch2datablocklen);
-        // chainhash 2
-        try {
-            dh->setChainHash2(ChainHash{CHModes(ch2mode), ch2iters, chd2});
-        } catch (const std::invalid_argument& ex) {
-            // the chainhash is invalid
-            PLOG_ERROR << "invalid chainhash 2 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH2_INVALID;
-            err.what = ex.what();
-            return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while setting the chainhash 2 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while setting the chainhash data block 2";
-            err.what = ex.what();
-            return err;
-        }
-
-        // password validator hash
-        try {
-            dh->setValidPasswordHashBytes(fileBytes.copySubBytes(index, index + dh->hash_size));
-            index += dh->hash_size;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while setting and reading the password validator hash (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while setting and reading the password validator hash";
-            err.what = ex.what();
-            return err;
-        }
-
-        // encrypted salt
-        try {
-            dh->setEncSalt(fileBytes.copySubBytes(index, index + dh->hash_size));
-            index += dh->hash_size;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while setting and reading the salt hash (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while setting and reading the salt hash";
-            err.what = ex.what();
-            return err;
-        }
-
-        // ********************* ENCRYPTED DATABLOCKS *********************
-        // loading encrypted data blocks
-        unsigned char enc_data_block_count = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-        index += 1;
-        for (int i = 0; i < enc_data_block_count; i++) {
-            // data block type
-            unsigned char enc_type = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            index += 1;
-            // enc data block len
-            unsigned char enc_len = fileBytes.copySubBytes(index, index + 1).getBytes()[0];
-            index += 1;
-            // data block data
-            Bytes enc_data = fileBytes.copySubBytes(index, index + 255);
-            index += 255;
-            dh->addEncDataBlock(EncDataBlock::createEncBlock(enc_type, enc_data, enc_len));
-        }
-        try {
-            dh->setFileSize(file_size);  // setting the file size
-        } catch (const std::invalid_argument& ex) {
-            PLOG_ERROR << "invalid file size (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_FILESIZE_INVALID;
-            err.errorInfo = file_size;
-            err.what = ex.what();
-            return err;
-        }
-        try {
-            dh->calcHeaderBytes();
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while calculating the header bytes (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while calculating the header bytes";
-            err.what = ex.what();
-            return err;
-        }
-        assert(index == header_size);
-        assert(dh->getHeaderLength() == header_size);
-        return ErrorStruct<std::unique_ptr<DataHeader>>::createMove(std::move(dh));
+        std::shared_ptr<Bytes> copy = std::make_shared<Bytes>(header_size);
+        copy->addBytes(header, header_size);
+        return DataHeader::setHeaderBytes(std::move(copy));
     } catch (const std::exception& ex) {
-        PLOG_ERROR << "An error occurred while reading the header (error msg: " << ex.what() << ")";
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while reading the header";
-        err.what = ex.what();
-        return err;
+        PLOG_ERROR << "An error occurred while copying the header (error msg: " << ex.what() << ")";
+        return ErrorStruct<std::unique_ptr<DataHeader>>{FAIL, ERR, "An error occurred while copying the header", ex.what()};
     }
 }
 
-ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(std::ifstream& file) noexcept {
-    // sets the header bytes by taking the first bytes of the file
-    // init error struct
+ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(std::shared_ptr<Bytes> header) noexcept {
+    // parses the header in place from one contiguous buffer that starts with the header (dataheader.md)
+    // every field is read with a bounds check against the header size, the fixed fields are decoded without any allocation
+    // the datablocks are views into the buffer, so they are neither copied nor decoded here
     ErrorStruct<std::unique_ptr<DataHeader>> err{FAIL, ERR, "An error occurred while reading the header", "setHeaderBytes"};
     std::unique_ptr<DataHeader> dh = nullptr;
-    // setting the header parts
     u_int64_t file_size;
     u_int64_t header_size;
-    Bytes tmp(8);
     unsigned char fmode;
     unsigned char hmode;
-    // get stream length
-    std::streampos start = file.tellg();
-    file.seekg(0, std::ios::end);
-    std::streampos end = file.tellg();
-    file.seekg(start);
-    //********************* FILESIZE *********************
-    if (!readData(file, tmp, 8)) {
-        // readsome could not read the file size
+    if (header == nullptr) {
+        PLOG_ERROR << "no header buffer is given";
+        err.errorCode = ERR_NOT_ENOUGH_DATA;
+        err.errorInfo = "File size";
+        return err;
+    }
+    const size_t len = header->getLen();
+    HeaderReader reader{header->getBytes(), len};
+
+    // ********************* FILESIZE *********************
+    if (!reader.readLong(file_size)) {
         PLOG_ERROR << "not enogh data to read the file size";
         err.errorCode = ERR_NOT_ENOUGH_DATA;
         err.errorInfo = "File size";
         return err;
     }
-    file_size = tmp.toLong();
-    tmp.setLen(0);  // clear tmp
     //********************* HEADERSIZE *********************
-    if (!readData(file, tmp, 8)) {
-        // readsome could not read the header size
+    if (!reader.readLong(header_size)) {
         PLOG_ERROR << "not enogh data to read the header size";
         err.errorCode = ERR_NOT_ENOUGH_DATA;
         err.errorInfo = "Header size";
         return err;
     }
-    header_size = tmp.toLong();
-    tmp.setLen(0);  // clear tmp
-    if (end - start != file_size) {
-        // file size is not equal to the stream size
-        PLOG_ERROR << "file size is not equal to the given stream size (file_size: " << file_size << ", stream size: " << (end - start) << ")";
-        err.errorCode = ERR_FILESIZE_INVALID;
-        err.errorInfo = "file size is not equal to the given stream size (file_size: " + std::to_string(file_size) + ", stream size: " + std::to_string(end - start) + ")";
+    if (header_size > len) {
+        // header size is bigger than the given buffer
+        PLOG_ERROR << "header size is bigger than the given bytes (header_size: " << header_size << ", given bytes: " << len << ")";
+        err.errorCode = ERR_NOT_ENOUGH_DATA;
+        err.errorInfo = " because the given header size is bigger than the given size";
+        err.what = "header size is bigger than the given bytes";
         return err;
     }
-    if (header_size > file_size) {
-        // header size is bigger than the file size
-        PLOG_ERROR << "header size is bigger than the file size (header_size: " << header_size << ", file size: " << file_size << ")";
-        err.errorCode = ERR_HEADERSIZE_FILESIZE_MISMATCH;
-        err.errorInfo = "header size is bigger than the file size (header_size: " + std::to_string(header_size) + ", file size: " + std::to_string(file_size) + ")";
+    if (header_size < MIN_DATAHEADER_LEN) {
+        // the header cannot contain all required fields (a header size below the read prefix would also make every later bounds check pass)
+        PLOG_ERROR << "header size is too small (header_size: " << header_size << ")";
+        err.errorCode = ERR_NOT_ENOUGH_DATA;
+        err.errorInfo = "Header size";
+        err.what = "header size is too small";
         return err;
     }
+    reader.max_len = header_size;  // the following fields have to be inside of the header
+    header->setLen(header_size);   // the buffer becomes the header bytes
+    std::shared_ptr<const Bytes> source = header;
     //********************* FILEMODE *********************
-    // loading file mode
-    if (!readData(file, &fmode, 1)) {
-        // readsome could not read the file mode
+    if (!reader.readByte(fmode)) {
         PLOG_ERROR << "not enogh data to read the file mode";
         err.errorCode = ERR_NOT_ENOUGH_DATA;
         err.errorInfo = "File mode";
         return err;
     }
-
     // ********************* HASH FUNCTION *********************
-    // loading and setting hash mode
-    if (!readData(file, &hmode, 1)) {
-        // readsome could not read the hash mode
+    if (!reader.readByte(hmode)) {
         PLOG_ERROR << "not enogh data to read the hash mode";
         err.errorCode = ERR_NOT_ENOUGH_DATA;
         err.errorInfo = "Hash mode";
         return err;
     }
-
     try {
         dh = std::make_unique<DataHeader>(HModes(hmode));
     } catch (const std::invalid_argument& ex) {
@@ -701,382 +844,112 @@ ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(std::ifstrea
         err.what = ex.what();
         return err;
     }
-
-    // setting the file data mode
     try {
         dh->setFileDataMode(FModes(fmode));
     } catch (const std::invalid_argument& ex) {
         // the file mode is invalid
         PLOG_ERROR << "invalid file mode found in data (file_mode: " << +fmode << ") (error msg: " << ex.what() << ")";
-        err.success = FAIL;
         err.errorCode = ERR_FILEMODE_INVALID;
         err.errorInfo = fmode;
         err.what = ex.what();
         return err;
     }
 
-    // ********************* DATABLOCKS *********************
-    // loading data blocks
-    unsigned char data_block_count;
-    if (!readData(file, &data_block_count, 1)) {
-        // readsome could not read the data block count
-        PLOG_ERROR << "not enogh data to read the data block count";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Data block count";
-        return err;
-    }
-    for (int i = 0; i < data_block_count; i++) {
-        // data block type
-        unsigned char type;
-        if (!readData(file, &type, 1)) {
-            // readsome could not read the data block type
-            PLOG_ERROR << "not enogh data to read the data block type";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Data block type";
-            return err;
-        }
-        // data block len
-        unsigned char len;
-        if (!readData(file, &len, 1)) {
-            // readsome could not read the data block len
-            PLOG_ERROR << "not enogh data to read the data block len";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Data block len";
-            return err;
-        }
-        // data block data
-        Bytes data(len);
-        if (!readData(file, data, len)) {
-            // readsome could not read the data block data
-            PLOG_ERROR << "not enogh data to read the data block data";
+    try {
+        // ********************* DATABLOCKS *********************
+        unsigned char data_block_count;
+        if (!reader.readByte(data_block_count)) {
+            PLOG_ERROR << "not enogh data to read the data block count";
             err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Data block data";
+            err.errorInfo = "Data block count";
             return err;
         }
-        dh->addDataBlock(DataBlock(DatablockType(type), data));
-    }
-
-    // ********************* CHAINHASH1 *********************
-    std::shared_ptr<Format> format1 = nullptr;
-    std::shared_ptr<ChainHashData> chd1 = nullptr;
-    unsigned char ch1mode;
-    // loading and setting chainhash1 mode
-    if (!readData(file, &ch1mode, 1)) {
-        // readsome could not read the hash mode
-        PLOG_ERROR << "not enogh data to read the chainhash1 mode";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash1 mode";
-        return err;
-    }
-    try {
-        format1 = std::make_shared<Format>(CHModes(ch1mode));
-        chd1 = std::make_shared<ChainHashData>(*format1);
-    } catch (const std::invalid_argument& ex) {
-        // the chainhash mode is invalid
-        PLOG_ERROR << "invalid chainhash mode 1 found in data (chainhash_mode 1: " << +ch1mode << ") (error msg: " << ex.what() << ")";
-        err.errorCode = ERR_CHAINHASHMODE_FORMAT_INVALID;
-        err.errorInfo = ch1mode;
-        err.what = ex.what();
-        return err;
-    } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while setting up the format1 and chainhashdata1 (error msg: " << ex.what() << ")";
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while setting up the format1 and chainhashdata1";
-        err.what = ex.what();
-        return err;
-    }
-    // chainhash 1 iters
-    u_int64_t ch1iters;
-    // loading and chainhash1 iters
-    if (!readData(file, tmp, 8)) {
-        // readsome could not read the chainhash1 iters
-        PLOG_ERROR << "not enogh data to read the chainhash1 iters";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash1 iters";
-        return err;
-    }
-    ch1iters = tmp.toLong();
-    // chainhash 1 data block len
-    unsigned char ch1datablocklen;
-    // loading and chainhash1 blocklen
-    if (!readData(file, &ch1datablocklen, 1)) {
-        // readsome could not read the chainhash1 blocklen
-        PLOG_ERROR << "not enogh data to read the chainhash1 blocklen";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash1 blocklen";
-        return err;
-    }
-    // chainhash 1 data block
-    int data_len = 0;
-    bool copied = false;
-    tmp = Bytes(255);
-    for (NameLen nl : format1->getNameLenList()) {
-        try {
-            bool copied = false;
-            if (nl.len != 0) {
-                // got a data part with set length
-                tmp.setLen(0);  // clear tmp
-                if (!readData(file, tmp, nl.len)) {
-                    throw std::length_error("not enough data to read the chainhash data block 1");
-                }
-                copied = true;
-                chd1->addBytes(tmp);
-                data_len += nl.len;
-            } else {
-                // got a data parCHModest with * length (use the remaining bytes)
-                tmp.setLen(0);  // clear tmp
-                if (!readData(file, tmp, ch1datablocklen - data_len)) {
-                    throw std::length_error("not enough data to read the chainhash data block 1");
-                }
-                copied = true;
-                chd1->addBytes(tmp);
-                data_len = ch1datablocklen;
-                break;
-            }
-
-        } catch (const std::length_error& ex) {
-            if (!copied) {
-                // readsome could not read the chainhash1 block
-                PLOG_ERROR << "not enough data to read the chainhash data block 1";
+        dh->dh.dec_data_blocks.reserve(data_block_count);
+        for (int i = 0; i < data_block_count; i++) {
+            unsigned char type;
+            unsigned char db_len;
+            if (!reader.readByte(type) || !reader.readByte(db_len) || reader.readBytes(db_len) == nullptr) {
+                PLOG_ERROR << "not enogh data to read the data block " << i;
                 err.errorCode = ERR_NOT_ENOUGH_DATA;
-                err.errorInfo = "Chainhash data block 1";
-                return err;
-            } else {
-                // adding to much bytes
-                PLOG_ERROR << "adding to much bytes to the chainhash data block 1 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_OUTOFRANGE;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
+                err.errorInfo = "Data block";
                 return err;
             }
-        } catch (const std::invalid_argument& ex) {
-            // the bytes have the wrong len
-            PLOG_ERROR << "invalid format of the chainhash data block 1 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH_DATAPART_INVALID;
-            err.errorInfo = tmp.toHex();
-            err.what = ex.what();
-            return err;
-        } catch (const std::logic_error& ex) {
-            // adding but its completed
-            PLOG_ERROR << "adding bytes to the chainhash data block 1 but its already completed (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH_DATABLOCK_ALREADY_COMPLETED;
-            err.errorInfo = tmp.toHex();
-            err.what = ex.what();
-            return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while reading the chainhash data block 1 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while reading the chainhash data block 1";
-            err.what = ex.what();
-            return err;
+            dh->addDataBlock(DataBlock::createView(DatablockType(type), source, reader.getPos() - db_len, db_len));
         }
-    }
-    assert(chd1->getLen() == ch1datablocklen);
-    assert(data_len == ch1datablocklen);
-    // chainhash 1
-    try {
-        dh->setChainHash1(ChainHash{CHModes(ch1mode), ch1iters, chd1});
-    } catch (const std::invalid_argument& ex) {
-        // the chainhash is invalid
-        PLOG_ERROR << "invalid chainhash 1 (error msg: " << ex.what() << ")";
-        err.success = FAIL;
-        err.errorCode = ERR_CHAINHASH1_INVALID;
-        err.what = ex.what();
-        return err;
-    } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while setting the chainhash 1 (error msg: " << ex.what() << ")";
-        err.success = FAIL;
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while setting the chainhash data block 1";
-        err.what = ex.what();
-        return err;
-    }
 
-    // ********************* CHAINHASH2 *********************
-    std::shared_ptr<Format> format2 = nullptr;
-    std::shared_ptr<ChainHashData> chd2 = nullptr;
-    unsigned char ch2mode;
-    // loading and setting chainhash2 mode
-    if (!readData(file, &ch2mode, 1)) {
-        // readsome could not read the hash mode
-        PLOG_ERROR << "not enogh data to read the chainhash2 mode";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash2 mode";
-        return err;
-    }
-    try {
-        format2 = std::make_shared<Format>(CHModes(ch2mode));
-        chd2 = std::make_shared<ChainHashData>(*format2);
-    } catch (const std::invalid_argument& ex) {
-        // the chainhash mode is invalid
-        PLOG_ERROR << "invalid chainhash mode 2 found in data (chainhash_mode 2: " << +ch2mode << ") (error msg: " << ex.what() << ")";
-        err.errorCode = ERR_CHAINHASHMODE_FORMAT_INVALID;
-        err.errorInfo = ch2mode;
-        err.what = ex.what();
-        return err;
-    } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while reading the chainhash mode 2 (error msg: " << ex.what() << ")";
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while reading the chainhash mode 2";
-        err.what = ex.what();
-        return err;
-    }
-    // chainhash 2 iters
-    u_int64_t ch2iters;
-    tmp = Bytes(8);
-    // loading and chainhash2 iters
-    if (!readData(file, tmp, 8)) {
-        // readsome could not read the chainhash2 iters
-        PLOG_ERROR << "not enogh data to read the chainhash2 iters";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash2 iters";
-        return err;
-    }
-    ch2iters = tmp.toLong();
-    // chainhash 2 data block len
-    unsigned char ch2datablocklen;
-    // loading and chainhash1 blocklen
-    if (!readData(file, &ch2datablocklen, 1)) {
-        // readsome could not read the chainhash2 blocklen
-        PLOG_ERROR << "not enogh data to read the chainhash2 blocklen";
-        err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Chainhash2 blocklen";
-        return err;
-    }
-    // chainhash 2 data block
-    data_len = 0;
-    copied = false;
-    tmp = Bytes(255);
-    for (NameLen nl : format2->getNameLenList()) {
+        // ********************* CHAINHASHES *********************
+        ChainHash chainhash;
+        if (!readChainHash(reader, 1, chainhash, err)) return err;
         try {
-            bool copied = false;
-            if (nl.len != 0) {
-                // got a data part with set length
-                tmp.setLen(0);  // clear tmp
-                if (!readData(file, tmp, nl.len)) {
-                    throw std::length_error("not enough data to read the chainhash data block 2");
-                }
-                copied = true;
-                chd2->addBytes(tmp);
-                data_len += nl.len;
-            } else {
-                // got a data parCHModest with * length (use the remaining bytes)
-                tmp.setLen(0);  // clear tmp
-                if (!readData(file, tmp, ch2datablocklen - data_len)) {
-                    throw std::length_error("not enough data to read the chainhash data block 2");
-                }
-                copied = true;
-                chd2->addBytes(tmp);
-                data_len = ch2datablocklen;
-                break;
-            }
-
-        } catch (const std::length_error& ex) {
-            if (!copied) {
-                // popFirstBytes returned an empty optional
-                PLOG_ERROR << "not enough data to read the chainhash data block 2 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_NOT_ENOUGH_DATA;
-                err.errorInfo = "Chainhash data block 2";
-                err.what = ex.what();
-                return err;
-            } else {
-                // adding to much bytes
-                PLOG_ERROR << "adding to much bytes to the chainhash data block 2 (error msg: " << ex.what() << ")";
-                err.errorCode = ERR_CHAINHASH_DATABLOCK_OUTOFRANGE;
-                err.errorInfo = tmp.toHex();
-                err.what = ex.what();
-                return err;
-            }
+            dh->setChainHash1(chainhash);
         } catch (const std::invalid_argument& ex) {
-            // the bytes have the wrong len
-            PLOG_ERROR << "invalid format of the chainhash data block 2 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH_DATAPART_INVALID;
-            err.errorInfo = tmp.toHex();
-            err.what = ex.what();
-            return err;
-        } catch (const std::logic_error& ex) {
-            // adding but its completed
-            PLOG_ERROR << "adding bytes to the chainhash data block 2 but its already completed (error msg: " << ex.what() << ")";
-            err.errorCode = ERR_CHAINHASH_DATABLOCK_ALREADY_COMPLETED;
-            err.errorInfo = tmp.toHex();
+            // the chainhash is invalid
+            PLOG_ERROR << "invalid chainhash 1 (error msg: " << ex.what() << ")";
+            err.errorCode = ERR_CHAINHASH1_INVALID;
             err.what = ex.what();
             return err;
-        } catch (const std::exception& ex) {
-            // some other error occurred
-            PLOG_ERROR << "An error occurred while reading the chainhash data block 2 (error msg: " << ex.what() << ")";
-            err.errorCode = ERR;
-            err.errorInfo = "An error occurred while reading the chainhash data block 2";
+        }
+        if (!readChainHash(reader, 2, chainhash, err)) return err;
+        try {
+            dh->setChainHash2(chainhash);
+        } catch (const std::invalid_argument& ex) {
+            // the chainhash is invalid
+            PLOG_ERROR << "invalid chainhash 2 (error msg: " << ex.what() << ")";
+            err.errorCode = ERR_CHAINHASH2_INVALID;
             err.what = ex.what();
             return err;
         }
-    }
-    assert(chd2->getLen() == ch2datablocklen);
-    assert(data_len == ch2datablocklen);
-    // chainhash 2
-    try {
-        dh->setChainHash2(ChainHash{CHModes(ch2mode), ch2iters, chd2});
-    } catch (const std::invalid_argument& ex) {
-        // the chainhash is invalid
-        PLOG_ERROR << "invalid chainhash 2 (error msg: " << ex.what() << ")";
-        err.success = FAIL;
-        err.errorCode = ERR_CHAINHASH2_INVALID;
-        err.what = ex.what();
-        return err;
-    } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while setting the chainhash 2 (error msg: " << ex.what() << ")";
-        err.success = FAIL;
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while setting the chainhash data block 2";
-        err.what = ex.what();
-        return err;
-    }
 
-    //********************* PASSWORD VALIDATOR HASH *********************
-    try {
-        Bytes tmp(dh->hash_size);
-        if (!readData(file, tmp, dh->hash_size)) {
-            // readsome could not read the password validator hash
-            PLOG_ERROR << "not enogh data to read the password validator hash";
+        //********************* PASSWORD VALIDATOR HASH AND ENCRYPTED SALT *********************
+        const unsigned char* validator = reader.readBytes(dh->hash_size);
+        const unsigned char* enc_salt = reader.readBytes(dh->hash_size);
+        if (validator == nullptr || enc_salt == nullptr) {
+            PLOG_ERROR << "not enogh data to read the password validator hash and the encrypted salt";
             err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Password validator hash";
+            err.errorInfo = validator == nullptr ? "Password validator hash" : "Encrypted salt";
             return err;
         }
+        Bytes tmp(dh->hash_size);
+        tmp.addBytes(validator, dh->hash_size);
         dh->setValidPasswordHashBytes(tmp);
-    } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while setting and reading the password validator hash (error msg: " << ex.what() << ")";
-        err.success = FAIL;
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while setting and reading the password validator hash";
-        err.what = ex.what();
-        return err;
-    }
+        tmp.setBytes(enc_salt, dh->hash_size);
+        dh->setEncSalt(tmp);
 
-    // encrypted salt
-    try {
-        Bytes tmp(dh->hash_size);
-        if (!readData(file, tmp, dh->hash_size)) {
-            // readsome could not read the encrypted salt
-            PLOG_ERROR << "not enogh data to read the encrypted salt";
+        // ********************* ENCRYPTED DATABLOCKS *********************
+        unsigned char enc_data_block_count;
+        if (!reader.readByte(enc_data_block_count)) {
+            PLOG_ERROR << "not enogh data to read the encrypted block count";
             err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Encrypted salt";
+            err.errorInfo = "Encrypted block count";
             return err;
         }
-        dh->setEncSalt(tmp);
+        dh->dh.enc_data_blocks.reserve(enc_data_block_count);
+        for (int i = 0; i < enc_data_block_count; i++) {
+            unsigned char type;
+            unsigned char enc_len;
+            if (!reader.readByte(type) || !reader.readByte(enc_len) || reader.readBytes(255) == nullptr) {
+                PLOG_ERROR << "not enogh data to read the enc data block " << i;
+                err.errorCode = ERR_NOT_ENOUGH_DATA;
+                err.errorInfo = "Enc datablock";
+                return err;
+            }
+            dh->addEncDataBlock(EncDataBlock::createEncView(type, source, reader.getPos() - 255, enc_len));
+        }
     } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while setting and reading the salt hash (error msg: " << ex.what() << ")";
-        err.success = FAIL;
+        PLOG_ERROR << "An error occurred while reading the header (error msg: " << ex.what() << ")";
         err.errorCode = ERR;
-        err.errorInfo = "An error occurred while setting and reading the salt hash";
+        err.errorInfo = "An error occurred while reading the header";
         err.what = ex.what();
         return err;
     }
+
+    if (reader.getPos() != header_size || dh->getHeaderLength() != header_size) {
+        // there are Bytes in the header that do not belong to any field
+        PLOG_ERROR << "the header size does not match with the read header (header_size: " << header_size << ", read: " << reader.getPos() << ")";
+        err.errorCode = ERR;
+        err.errorInfo = "the header size does not match with the read header (header_size: " + std::to_string(header_size) + ", read: " + std::to_string(reader.getPos()) + ")";
+        return err;
+    }
     try {
         dh->setFileSize(file_size);  // setting the file size
     } catch (const std::invalid_argument& ex) {
@@ -1086,61 +959,73 @@ ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(std::ifstrea
         err.what = ex.what();
         return err;
     }
+    // every field was read from the buffer, so serializing them again gives the same Bytes (the buffer is kept instead)
+    dh->read_header = std::move(source);
+    return ErrorStruct<std::unique_ptr<DataHeader>>::createMove(std::move(dh));
+}
 
-    // ********************* ENCRYPTED DATABLOCKS *********************
-    // loading encrypted data blocks
-    unsigned char enc_data_block_count;
-    if (!readData(file, &enc_data_block_count, 1)) {
-        // readsome could not read the encrypted block count
-        PLOG_ERROR << "not enogh data to read the encrypted block count";
+ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderBytes(std::ifstream& file) noexcept {
+    // sets the header bytes by taking the first bytes of the file
+    // the fixed prefix is read first to get the header size, then the header is read with one read call and parsed in place
+    ErrorStruct<std::unique_ptr<DataHeader>> err{FAIL, ERR, "An error occurred while reading the header", "setHeaderBytes"};
+    // get stream length
+    std::streampos start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streampos end = file.tellg();
+    file.seekg(start);
+    unsigned char prefix[16];
+    if (!file.read(reinterpret_cast<char*>(prefix), 16)) {
+        PLOG_ERROR << "not enogh data to read the file size and the header size";
         err.errorCode = ERR_NOT_ENOUGH_DATA;
-        err.errorInfo = "Encrypted block count";
+        err.errorInfo = "File size";
         return err;
     }
-
-    for (int i = 0; i < enc_data_block_count; i++) {
-        // enc data block type
-        unsigned char type;
-        if (!readData(file, &type, 1)) {
-            // readsome could not read the enc data block type
-            PLOG_ERROR << "not enogh data to read the enc data block type";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Enc datablock type";
-            return err;
-        }
-        // data block len
-        unsigned char len;
-        if (!readData(file, &len, 1)) {
-            // readsome could not read the enc data block len
-            PLOG_ERROR << "not enogh data to read the enc data block len";
-            err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Enc datablock len";
-            return err;
-        }
-        // data block data
-        Bytes data(255);
-        if (!readData(file, data, 255)) {
-            // readsome could not read the enc data block data
-            PLOG_ERROR << "not enogh data to read the enc data block data";
+    ErrorStruct<u_int64_t> err_prefix = DataHeader::checkHeaderPrefix(prefix, end - start);
+    if (!err_prefix.isSuccess()) return ErrorStruct<std::unique_ptr<DataHeader>>{err_prefix.success, err_prefix.errorCode, err_prefix.errorInfo, err_prefix.what};
+    u_int64_t header_size = err_prefix.returnValue();
+    try {
+        std::shared_ptr<Bytes> header = std::make_shared<Bytes>(header_size);
+        header->addBytes(prefix, 16);
+        if (!file.read(reinterpret_cast<char*>(header->getBytes() + 16), header_size - 16)) {
+            PLOG_ERROR << "not enogh data to read the header";
             err.errorCode = ERR_NOT_ENOUGH_DATA;
-            err.errorInfo = "Enc datablock data";
+            err.errorInfo = "Header";
             return err;
         }
-        dh->addEncDataBlock(EncDataBlock::createEncBlock(type, data, len));
-    }
-    try {
-        dh->calcHeaderBytes();
+        header->setLen(header_size);
+        return DataHeader::setHeaderBytes(std::move(header));
     } catch (const std::exception& ex) {
-        // some other error occurred
-        PLOG_ERROR << "An error occurred while calculating the header bytes (error msg: " << ex.what() << ")";
-        err.errorCode = ERR;
-        err.errorInfo = "An error occurred while calculating the header bytes";
+        PLOG_ERROR << "An error occurred while reading the header (error msg: " << ex.what() << ")";
         err.what = ex.what();
         return err;
     }
-    assert(file.tellg() - start == dh->getHeaderLength());
-    assert(dh->getHeaderLength() == header_size);
-    return ErrorStruct<std::unique_ptr<DataHeader>>::createMove(std::move(dh));
+}
+
+ErrorStruct<u_int64_t> DataHeader::checkHeaderPrefix(const unsigned char* prefix, const u_int64_t actual_file_size) noexcept {
+    // checks the sizes from the beginning of the header against the size of the file before the header is read
+    u_int64_t file_size;
+    u_int64_t header_size;
+    HeaderReader reader{prefix, 16};
+    reader.readLong(file_size);
+    reader.readLong(header_size);
+    if (actual_file_size != file_size) {
+        // file size is not equal to the stream size
+        PLOG_ERROR << "file size is not equal to the given stream size (file_size: " << file_size << ", stream size: " << actual_file_size << ")";
+        return ErrorStruct<u_int64_t>{FAIL, ERR_FILESIZE_INVALID,
+                                 "file size is not equal to the given stream size (file_size: " + std::to_string(file_size) + ", stream size: " + std::to_string(actual_file_size) + ")"};
+    }
+    if (header_size > file_size) {
+        // header size is bigger than the file size
+        PLOG_ERROR << "header size is bigger than the file size (header_size: " << header_size << ", file size: " << file_size << ")";
+        return ErrorStruct<u_int64_t>{FAIL, ERR_HEADERSIZE_FILESIZE_MISMATCH,
+                                 "header size is bigger than the file size (header_size: " + std::to_string(header_size) + ", file size: " + std::to_string(file_size) + ")"};
+    }
+    if (header_size < MIN_DATAHEADER_LEN) {
+        // the header cannot contain all required fields
+        PLOG_ERROR << "header size is too small (header_size: " << header_size << ")";
+        return ErrorStruct<u_int64_t>{FAIL, ERR_NOT_ENOUGH_DATA, "header size is too small (header_size: " + std::to_string(header_size) + ")"};
+    }
+    return ErrorStruct<u_int64_t>{header_size};
 }
 
 ErrorStruct<std::unique_ptr<DataHeader>> DataHeader::setHeaderParts(const DataHeaderParts& dhp) noexcept {
@@ -0,0 +1,94 @@
+/*
+implements the DecryptedReader class
+*/
+#include "decrypted_reader.h"
+
+#include "aead_chain.h"
+#include "api.h"
+#include "blockchain_decrypt.h"
+#include "hash_modes.h"
+#include "logger.h"
+
+DecryptedReader::DecryptedReader(const API* api, const u_int64_t chunk_len) : api(api), dh(api->dh.get()), generation(api->generation) {
+    // reads the layout of the content, the chunks are whole units of the format (blocks or AEAD chunks), so no unit is split between two chunks
+    if (chunk_len == 0) {
+        PLOG_ERROR << "The chunk length of a DecryptedReader cannot be 0";
+        throw std::invalid_argument("The chunk length of a DecryptedReader cannot be 0");
+    }
+    CipherFormat cipher = this->dh->getCipherFormat();
+    u_int64_t unit_len;
+    if (cipher.cipher_mode != CIPHERMODE_HASHCHAIN) {
+        this->aead = true;
+        this->content_len = AEADChain::getDecryptedLen(this->api->selected_file->getDataSize(), cipher.chunk_len);
+        unit_len = cipher.chunk_len;
+    } else {
+        if (this->dh->getShardLayout().shard_count != 0) {
+            this->shard_len = this->dh->getShardLayout().shard_len;
+            if (this->shard_len == 0) {
+                PLOG_ERROR << "The shard datablock does not contain a shard length";
+                throw std::logic_error("The shard datablock does not contain a shard length");
+            }
+        }
+        this->content_len = this->api->_getDataLayout().content_len;
+        unit_len = this->dh->getEffectiveBlockLen();
+    }
+    this->chunk_len = (chunk_len + unit_len - 1) / unit_len * unit_len;
+    PLOG_VERBOSE << "created new DecryptedReader (content_len: " << this->content_len << ", chunk_len: " << this->chunk_len << ")";
+}
+
+std::unique_ptr<Bytes> DecryptedReader::nextBlocks(const u_int64_t len) {
+    // every chain (the content or one shard) is continued with the state of the block the last chunk ended in
+    // that block is decrypted again, a chain can only be resumed at the start of a block
+    HModes hash_mode = this->dh->getDataHeaderParts().getHashMode();
+    std::unique_ptr<Bytes> result = std::make_unique<Bytes>(len);
+    u_int64_t pos = this->position;
+    u_int64_t end = this->position + len;
+    while (pos < end) {
+        // the chain that contains the position
+        u_int64_t chain_start = this->shard_len == 0 ? 0 : pos / this->shard_len * this->shard_len;
+        u_int64_t chain_end = this->shard_len == 0 ? this->content_len : std::min<u_int64_t>(chain_start + this->shard_len, this->content_len);
+        Bytes salt = this->shard_len == 0 ? this->dh->getDataHeaderParts().getEncSalt()
+                                          : BlockChain::getShardSalt(*HashModes::getHash(hash_mode), this->dh->getDataHeaderParts().getEncSalt(), pos / this->shard_len,
+                                                                     this->dh->getShardLayout().shard_count);
+        u_int64_t part_end = std::min<u_int64_t>(end, chain_end);
+        DecryptBlockChain dbc{HashModes::getHash(hash_mode), this->api->correct_password_hash, salt, this->dh->getBlockLen()};
+        if (this->state.getLen() != 0) dbc.resumeFromState(this->state, this->state_block);
+        u_int64_t start = chain_start + this->state_block * dbc.getBlockLen();
+        // the content of an unsharded file continues with the stored checkpoint states (the chain can be reseeded at them)
+        if (this->shard_len == 0) this->api->_setCheckpointStates(dbc, this->api->_getDataLayout(), start, part_end);
+        // only the encrypted Bytes of this part are read
+        dbc.addData(this->api->_readFileData(start, part_end - start));
+        std::unique_ptr<Bytes> decrypted = dbc.getResult();
+        result->addBytes(decrypted->getBytes() + (pos - start), part_end - pos);
+        if (part_end < chain_end) {
+            this->state = dbc.getResumeState();
+            this->state_block = (part_end - chain_start - 1) / dbc.getBlockLen();
+        } else {
+            // the next chunk starts a new shard
+            this->state = Bytes(0);
+            this->state_block = 0;
+        }
+        pos = part_end;
+    }
+    return result;
+}
+
+ErrorStruct<std::unique_ptr<Bytes>> DecryptedReader::next() noexcept {
+    // decrypts the next chunk, the position only moves if the chunk was decrypted
+    // the generation changes with every state transition, file selection and content change (a new data header at the same address is a new generation)
+    if (this->api->generation != this->generation || dynamic_cast<const API::PASSWORD_VERIFIED*>(this->api->current_state.get()) == nullptr) {
+        PLOG_ERROR << "The API of the DecryptedReader left the PASSWORD_VERIFIED state or the selected file was changed";
+        return ErrorStruct<std::unique_ptr<Bytes>>{FAIL, ERR_API_STATE_INVALID, "The DecryptedReader requires the API in the PASSWORD_VERIFIED state with the unchanged file"};
+    }
+    try {
+        if (this->isDone()) return ErrorStruct<std::unique_ptr<Bytes>>::createMove(std::make_unique<Bytes>(0));
+        u_int64_t len = std::min<u_int64_t>(this->chunk_len, this->content_len - this->position);
+        std::unique_ptr<Bytes> chunk = this->aead ? this->api->_decryptAEAD(this->position, len) : this->nextBlocks(len);
+        this->position += len;
+        return ErrorStruct<std::unique_ptr<Bytes>>::createMove(std::move(chunk));
+    } catch (const std::exception& e) {
+        // something went wrong inside of one of these functions, read what message for more information
+        PLOG_ERROR << "Something went wrong while decrypting the next chunk (DecryptedReader::next) (position: " << this->position << ", what: " << e.what() << ")";
+        return ErrorStruct<std::unique_ptr<Bytes>>{FAIL, ERR, "In DecryptedReader::next: Something went wrong while decrypting the next chunk", e.what()};
+    }
+}
@@ -4,13 +4,43 @@ implements the FileHandler class
 
 #include "filehandler.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
 
+#include "checksum.h"
 #include "logger.h"
 #include "utility.h"
 
 const std::string FileHandler::extension = ".enc";
 
+namespace {
+u_int64_t readLong(const unsigned char* data) noexcept {
+    // reads a big endian long from 8 Bytes
+    u_int64_t ret = 0;
+    for (int i = 0; i < 8; i++) ret = (ret << 8) | data[i];
+    return ret;
+}
+
+// the first 8 Bytes of a journal ("PMJRNL", the format version 1)
+const constexpr u_int64_t JOURNAL_MAGIC = 0x504D4A524E4C0001ULL;
+
+void syncDir(const std::filesystem::path& file) noexcept {
+    // a created or removed file is only durable after its directory is synced
+    std::filesystem::path dir = file.parent_path().empty() ? "." : file.parent_path();
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0 || fsync(dir_fd) != 0) PLOG_WARNING << "The directory could not be synced (dir: " << dir << ")";
+    if (dir_fd >= 0) close(dir_fd);
+}
+}  // namespace
+
 ErrorStruct<bool> FileHandler::isValidPath(const std::filesystem::path& file, bool should_exist) noexcept {
     // checks if the given file path is valid (file_path has to be not empty and have the right extension)
     // if should_exist is true, the file has to exist otherwise it has to not exist
@@ -36,8 +66,7 @@ ErrorStruct<bool> FileHandler::isValidPath(const std::filesystem::path& file, bo
             err.errorCode = ErrorCode::ERR_FILE_NOT_FOUND;
             return err;
         }
-        std::ifstream file_stream(file);  // create the file stream
-        if (!file_stream) {
+        if (access(file.c_str(), R_OK) != 0) {
             // cannot open the file
             PLOG_ERROR << "Cannot open the file (file path: " << file << ")";
             err.errorCode = ErrorCode::ERR_FILE_NOT_OPEN;
@@ -81,24 +110,105 @@ ErrorStruct<bool> FileHandler::createFile(const std::filesystem::path& file) noe
 }
 
 FileHandler::FileHandler(const std::filesystem::path& file) : filepath(file) {
-    // sets the filepath
+    // sets the filepath and opens the file
     if (!FileHandler::isValidPath(file, true).isSuccess()) {
         PLOG_FATAL << "The given file path is invalid (file path: " << file << ")";
         throw std::runtime_error("The given file path is invalid (file path: " + file.string() + ")");
     }
+    this->openFile();
+    this->replayJournal();
     this->update();
 }
 
+FileHandler::~FileHandler() {
+    // closes the file
+    if (this->fd >= 0 && close(this->fd) != 0) PLOG_ERROR << "The file could not be closed (file_path: " << this->filepath << ")";
+}
+
+void FileHandler::openFile() {
+    // opens the file for reading and writing, files without write permission are only opened for reading
+    int new_fd = open(this->filepath.c_str(), O_RDWR | O_CLOEXEC);
+    bool new_writable = new_fd >= 0;
+    if (new_fd < 0) new_fd = open(this->filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (new_fd < 0 || fstat(new_fd, &st) != 0) {
+        PLOG_ERROR << "The file could not be opened (file path: " << this->filepath << ")";
+        if (new_fd >= 0) close(new_fd);
+        throw std::runtime_error("The file could not be opened (file path: " + this->filepath.string() + ")");
+    }
+    if (this->fd >= 0) close(this->fd);
+    this->fd = new_fd;
+    this->writable = new_writable;
+    this->inode = st.st_ino;
+}
+
+void FileHandler::replayJournal() {
+    // a journal is only left behind if the program stopped during a journaled write
+    // a complete journal is applied again (the writes do not depend on the old content), a torn journal is removed because the file was not changed yet
+    std::filesystem::path journal_path = FileHandler::getJournalPath(this->filepath);
+    int journal_fd = open(journal_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (journal_fd < 0) return;
+    struct stat st;
+    Bytes journal = Bytes::withU64(0);
+    if (fstat(journal_fd, &st) == 0) {
+        journal = Bytes::withU64(st.st_size);
+        if (readDataAt(journal_fd, journal.getBytes(), st.st_size, 0) == (size_t)st.st_size) journal.setLen(st.st_size);
+    }
+    close(journal_fd);
+    if (!this->writable) {
+        PLOG_WARNING << "The journal of the file cannot be replayed, the file is not writable (file_path: " << this->filepath << ")";
+        return;
+    }
+    // magic, file size, number of writes, (offset, length, Bytes) of every write, checksum
+    const unsigned char* data = journal.getBytes();
+    u_int64_t len = journal.getLen();
+    bool complete = len >= 32 && readLong(data) == JOURNAL_MAGIC;
+    if (complete) {
+        Checksum checksum;
+        checksum.addData(data, len - 8);
+        complete = checksum.getResult() == readLong(data + len - 8);
+    }
+    std::vector<JournalWrite> writes;
+    u_int64_t pos = 24;
+    for (u_int64_t i = 0; complete && i < readLong(data + 16); i++) {
+        complete = pos + 16 <= len - 8 && readLong(data + pos + 8) <= len - 8 - pos - 16;
+        if (!complete) break;
+        writes.push_back(JournalWrite{readLong(data + pos), data + pos + 16, readLong(data + pos + 8)});
+        pos += 16 + writes.back().len;
+    }
+    if (!complete || pos != len - 8) {
+        PLOG_WARNING << "Removing the incomplete journal of the file (file_path: " << this->filepath << ")";
+        std::filesystem::remove(journal_path);
+        syncDir(journal_path);
+        return;
+    }
+    PLOG_WARNING << "Replaying the journal of the file (file_path: " << this->filepath << ", writes: " << writes.size() << ")";
+    ErrorStruct<bool> err = this->applyWrites(writes, readLong(data + 8));
+    if (!err.isSuccess()) {
+        PLOG_FATAL << "The journal of the file could not be replayed (file_path: " << this->filepath << ", what: " << err.what << ")";
+        throw std::runtime_error("The journal of the file could not be replayed (file path: " + this->filepath.string() + ")");
+    }
+}
+
+void FileHandler::statFile(struct stat& st) {
+    // one stat call on the path, the held descriptor is only used if the path was replaced or removed
+    if (stat(this->filepath.c_str(), &st) == 0 && st.st_ino == this->inode) return;
+    if (std::filesystem::exists(this->filepath)) this->openFile();
+    if (fstat(this->fd, &st) != 0) {
+        PLOG_ERROR << "The file could not be stat (file path: " << this->filepath << ")";
+        throw std::runtime_error("The file could not be stat (file path: " + this->filepath.string() + ")");
+    }
+}
+
 void FileHandler::update() {
-    std::ifstream filestream = this->getFileStream();
-    std::streampos begin = filestream.tellg();
-    filestream.seekg(0, std::ios::end);
-    std::streampos end = filestream.tellg();
-    this->file_size = end - begin;
+    // reads the file size with one stat and the file size and header size from the header with one pread
+    struct stat st;
+    this->statFile(st);
+    this->file_size = st.st_size;
     this->empty = (this->file_size == 0);
-    filestream.seekg(begin);
-    Bytes tmp(8);
-    if (!readData(filestream, tmp, 8)) {
+    unsigned char prefix[16];
+    size_t read = readDataAt(this->fd, prefix, 16, 0);
+    if (read < 8) {
         if (this->file_size == 0)
             this->header_size = 0;
         else {
@@ -106,18 +216,16 @@ void FileHandler::update() {
             throw std::length_error("The file is too small to contain a data header but is not empty");
         }
     } else {
-        if (tmp.toLong() != this->file_size) {
+        if (readLong(prefix) != this->file_size) {
             PLOG_ERROR << "The file size does not match with the file size in the data header";
             throw std::logic_error("The file size does not match with the file size in the data header");
         }
-        tmp.setLen(0);  // reset the length
-        if (!readData(filestream, tmp, 8)) {
+        if (read < 16) {
             PLOG_ERROR << "The file is too small to contain a data header but is not empty";
             throw std::length_error("The file is too small to contain a data header but is not empty");
         }
-        this->header_size = tmp.toLong();
+        this->header_size = readLong(prefix + 8);
     }
-    filestream.close();
     if (this->header_size > this->file_size) {
         PLOG_ERROR << "The file size is smaller than the given header size";
         throw std::logic_error("The file size is smaller than the given header size");
@@ -146,11 +254,40 @@ ErrorStruct<bool> FileHandler::isDataHeader(FModes exp_file_mode) noexcept {
 bool FileHandler::isEmtpy() const noexcept { return this->empty; }
 
 ErrorStruct<std::unique_ptr<DataHeader>> FileHandler::getDataHeader() noexcept {
-    // reads the data header from the file
-    std::ifstream filestream = this->getFileStream();
-    ErrorStruct<std::unique_ptr<DataHeader>> ret = DataHeader::setHeaderBytes(filestream);
-    filestream.close();
-    return ret;
+    // reads the data header with one pread of the header size (known from the last update) and parses it in place
+    // if the header size has changed since then, the missing Bytes are read with a second pread
+    ErrorStruct<std::unique_ptr<DataHeader>> err{FAIL, ERR_FILE_READ, this->filepath.c_str()};
+    struct stat st;
+    if (fstat(this->fd, &st) != 0) {
+        PLOG_ERROR << "The file could not be stat to read the data header (file_path: " << this->filepath << ")";
+        return err;
+    }
+    try {
+        // the buffer is kept by the header (its datablocks are views into it), so it is not copied again
+        std::shared_ptr<Bytes> header = std::make_shared<Bytes>(std::max<size_t>(this->header_size, 16));
+        size_t read = readDataAt(this->fd, header->getBytes(), header->getMaxLen(), 0);
+        header->setLen(read);
+        if (read < 16) {
+            PLOG_ERROR << "not enogh data to read the file size and the header size (file_path: " << this->filepath << ")";
+            err.errorCode = ERR_NOT_ENOUGH_DATA;
+            err.errorInfo = "File size";
+            return err;
+        }
+        ErrorStruct<u_int64_t> err_prefix = DataHeader::checkHeaderPrefix(header->getBytes(), st.st_size);
+        if (!err_prefix.isSuccess()) return ErrorStruct<std::unique_ptr<DataHeader>>{err_prefix.success, err_prefix.errorCode, err_prefix.errorInfo, err_prefix.what};
+        u_int64_t header_size = err_prefix.returnValue();
+        if (header_size > read) {
+            // the header got larger since the last update
+            header->addSize(header_size - header->getMaxLen());
+            read += readDataAt(this->fd, header->getBytes() + read, header_size - read, read);
+        }
+        header->setLen(std::min<size_t>(read, header_size));
+        return DataHeader::setHeaderBytes(std::move(header));
+    } catch (const std::exception& ex) {
+        PLOG_ERROR << "An error occurred while reading the data header (file_path: " << this->filepath << ", what: " << ex.what() << ")";
+        err.what = ex.what();
+        return err;
+    }
 }
 
 std::ifstream FileHandler::getFileStream() const noexcept {
@@ -160,17 +297,172 @@ std::ifstream FileHandler::getFileStream() const noexcept {
 
 std::ifstream FileHandler::getDataStream() const noexcept {
     // reads the data from the file (without the data header)
+    // prefer readAt or getDataMapping, the stream opens the file again
     std::ifstream file(this->filepath.c_str(), std::ios::binary);
     file.seekg(this->header_size, std::ios::beg);
     return file;
 }
 
+ErrorStruct<std::unique_ptr<FileMapping>> FileHandler::getDataMapping() const noexcept {
+    // maps the file read-only into memory and exposes the data region (without the data header)
+    // the caller should fall back to getDataStream if the mapping fails
+    ErrorStruct<std::unique_ptr<FileMapping>> err{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_MAPPED, this->filepath.c_str()};
+    if (this->getDataSize() == 0) {
+        // there is nothing to map (mmap does not support zero length mappings)
+        PLOG_WARNING << "The file does not contain any data to map (file_path: " << this->filepath << ")";
+        err.what = "no data to map";
+        return err;
+    }
+    struct stat st;
+    if (fstat(this->fd, &st) != 0 || static_cast<size_t>(st.st_size) != this->file_size) {
+        // the file changed since the last update, the mapping would not match with the header
+        PLOG_ERROR << "The file size does not match with the stored file size (file_path: " << this->filepath << ")";
+        err.what = "file size mismatch";
+        return err;
+    }
+    // the mapping stays valid if the file descriptor is closed before the mapping is released
+    void* base = mmap(nullptr, this->file_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (base == MAP_FAILED) {
+        PLOG_ERROR << "The file could not be mapped (file_path: " << this->filepath << ")";
+        err.what = "mmap failed";
+        return err;
+    }
+    // the data is consumed once from the front to the back
+    if (madvise(base, this->file_size, MADV_SEQUENTIAL) != 0) PLOG_WARNING << "madvise failed on the file mapping (file_path: " << this->filepath << ")";
+    return ErrorStruct<std::unique_ptr<FileMapping>>::createMove(std::make_unique<FileMapping>(base, this->file_size, this->header_size));
+}
+
 size_t FileHandler::getHeaderSize() const noexcept { return this->header_size; }
 
 size_t FileHandler::getFileSize() const noexcept { return this->file_size; }
 
 size_t FileHandler::getDataSize() const noexcept { return this->file_size - this->header_size; }
 
+ErrorStruct<IntegrityReport> FileHandler::verifyIntegrity(const size_t threads) noexcept {
+    // reads the integrity tree from the unencrypted datablocks of the header and hashes the mapped data against it
+    try {
+        this->update();
+    } catch (const std::exception& e) {
+        // the file was cut off or extended, the size does not match with the data header anymore
+        PLOG_ERROR << "The file size does not match with the data header (verifyIntegrity) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<IntegrityReport>{SuccessType::FAIL, ErrorCode::ERR_FILESIZE_INVALID, this->filepath.c_str(), e.what()};
+    }
+    ErrorStruct<std::unique_ptr<DataHeader>> err_dh = this->getDataHeader();
+    if (!err_dh.isSuccess()) {
+        PLOG_ERROR << "The data header could not be read (verifyIntegrity) (errorCode: " << +err_dh.errorCode << ", errorInfo: " << err_dh.errorInfo << ", what: " << err_dh.what << ")";
+        return ErrorStruct<IntegrityReport>{err_dh.success, err_dh.errorCode, err_dh.errorInfo, err_dh.what};
+    }
+    try {
+        IntegrityTree tree = err_dh.returnRef()->getIntegrityTree();
+        if (tree.leaf_len == 0) {
+            PLOG_WARNING << "The file has no integrity tree (file_path: " << this->filepath << ")";
+            return ErrorStruct<IntegrityReport>{SuccessType::FAIL, ErrorCode::ERR_INTEGRITY_TREE_MISSING, this->filepath.c_str()};
+        }
+        std::unique_ptr<Hash> hash = HashModes::getHash(err_dh.returnRef()->getDataHeaderParts().getHashMode());
+        IntegrityReport report;
+        u_int64_t leaf_table_len = err_dh.returnRef()->getLeafTableLen();
+        if (leaf_table_len != 0) {
+            // the tree covers the data in front of the leaf hash table, the table has to match with the hashed leaves
+            ErrorStruct<std::unique_ptr<FileMapping>> err_map = this->getDataMapping();
+            if (!err_map.isSuccess()) return ErrorStruct<IntegrityReport>{err_map.success, err_map.errorCode, err_map.errorInfo, err_map.what};
+            if (leaf_table_len > err_map.returnRef()->getLen()) throw std::length_error("The leaf hash table is longer than the data");
+            u_int64_t covered_len = err_map.returnRef()->getLen() - leaf_table_len;
+            std::vector<Bytes> leaves = MerkleTree::getLeafHashes(*hash, err_map.returnRef()->getData(), covered_len, tree.leaf_len, threads);
+            report = MerkleTree::verifyLeaves(*hash, tree, leaves, covered_len);
+            // since trailer version 4 the region hashes follow the leaf hashes
+            if (err_dh.returnRef()->getTrailerVersion() >= 4) {
+                for (Bytes& region : MerkleTree::getRegionHashesFromLeaves(*hash, leaves, covered_len, tree.leaf_len)) leaves.push_back(std::move(region));
+            }
+            bool table_valid = leaves.size() * hash->getHashSize() == leaf_table_len;
+            for (size_t i = 0; table_valid && i < leaves.size(); i++)
+                table_valid = std::memcmp(leaves[i].getBytes(), err_map.returnRef()->getData() + covered_len + i * hash->getHashSize(), hash->getHashSize()) == 0;
+            if (!table_valid) {
+                report.valid = false;
+                report.damaged.push_back({covered_len, leaf_table_len});
+            }
+        } else if (this->getDataSize() == 0) {
+            report = MerkleTree::verify(*hash, tree, nullptr, 0, threads);
+        } else {
+            ErrorStruct<std::unique_ptr<FileMapping>> err_map = this->getDataMapping();
+            if (!err_map.isSuccess()) return ErrorStruct<IntegrityReport>{err_map.success, err_map.errorCode, err_map.errorInfo, err_map.what};
+            report = MerkleTree::verify(*hash, tree, err_map.returnRef()->getData(), err_map.returnRef()->getLen(), threads);
+        }
+        for (std::pair<u_int64_t, u_int64_t>& range : report.damaged) range.first += this->header_size;
+        return ErrorStruct<IntegrityReport>{report};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The integrity tree could not be verified (verifyIntegrity) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<IntegrityReport>{SuccessType::FAIL, ErrorCode::ERR, "In verifyIntegrity: The integrity tree could not be verified", e.what()};
+    }
+}
+
+ErrorStruct<bool> FileHandler::verifyChecksum() noexcept {
+    // the header checksum also covers the stored data checksum, so it is checked first
+    ErrorStruct<bool> err = this->verifyHeaderChecksum();
+    if (!err.isSuccess()) return err;
+    return this->verifyDataChecksum();
+}
+
+ErrorStruct<bool> FileHandler::verifyHeaderChecksum() noexcept {
+    // finds the checksum in the unencrypted datablocks of the header and hashes the header
+    // the header is not parsed, so this is much faster than reading the data header or verifying the password
+    try {
+        this->update();
+    } catch (const std::exception& e) {
+        // the file was cut off or extended, the size does not match with the data header anymore
+        PLOG_ERROR << "The file size does not match with the data header (verifyHeaderChecksum) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILESIZE_INVALID, this->filepath.c_str(), e.what()};
+    }
+    try {
+        Bytes header = this->getFirstBytes(this->header_size);
+        size_t pos = DataHeader::getChecksumPos(header.getBytes(), header.getLen());
+        if (pos == 0) {
+            PLOG_DEBUG << "The file has no checksum (file_path: " << this->filepath << ")";
+            return ErrorStruct<bool>{true};
+        }
+        if (Checksum::calculateHeader(header.getBytes(), header.getLen(), pos) != header.copySubBytes(pos, pos + 8).toLong()) {
+            PLOG_ERROR << "The header checksum does not match (file_path: " << this->filepath << ")";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_CHECKSUM_MISMATCH, this->filepath.c_str()};
+        }
+        return ErrorStruct<bool>{true};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The header checksum could not be verified (verifyHeaderChecksum) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_CHECKSUM_MISMATCH, this->filepath.c_str(), e.what()};
+    }
+}
+
+ErrorStruct<bool> FileHandler::verifyDataChecksum() noexcept {
+    // hashes the mapped data and compares it with the data checksum of the header
+    try {
+        this->update();
+    } catch (const std::exception& e) {
+        // the file was cut off or extended, the size does not match with the data header anymore
+        PLOG_ERROR << "The file size does not match with the data header (verifyDataChecksum) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILESIZE_INVALID, this->filepath.c_str(), e.what()};
+    }
+    try {
+        Bytes header = this->getFirstBytes(this->header_size);
+        size_t pos = DataHeader::getChecksumPos(header.getBytes(), header.getLen());
+        if (pos == 0) {
+            PLOG_DEBUG << "The file has no checksum (file_path: " << this->filepath << ")";
+            return ErrorStruct<bool>{true};
+        }
+        u_int64_t data_checksum = 0;
+        if (this->getDataSize() != 0) {
+            ErrorStruct<std::unique_ptr<FileMapping>> err_map = this->getDataMapping();
+            if (!err_map.isSuccess()) return ErrorStruct<bool>{err_map.success, err_map.errorCode, err_map.errorInfo, err_map.what};
+            data_checksum = Checksum::calculateChunks({{err_map.returnRef()->getData(), err_map.returnRef()->getLen()}}, 0);
+        }
+        if (data_checksum != header.copySubBytes(pos + 8, pos + 16).toLong()) {
+            PLOG_ERROR << "The data checksum does not match (file_path: " << this->filepath << ")";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_CHECKSUM_MISMATCH, this->filepath.c_str()};
+        }
+        return ErrorStruct<bool>{true};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The data checksum could not be verified (verifyDataChecksum) (file_path: " << this->filepath << ", what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_CHECKSUM_MISMATCH, this->filepath.c_str(), e.what()};
+    }
+}
+
 // ErrorStruct<bool> FileHandler::writeBytes(Bytes& bytes) noexcept {
 //     // writes bytes to the file
 //     // overrides old content
@@ -191,6 +483,73 @@ size_t FileHandler::getDataSize() const noexcept { return this->file_size - this
 //     return ErrorStruct<bool>{true};
 // }
 
+ErrorStruct<bool> FileHandler::writeParts(const std::vector<std::pair<const unsigned char*, u_int64_t>>& parts) noexcept {
+    // the file is cut to zero and preallocated to the full length, so the file system can place the data in large extents
+    // writev is called until every part is written (a call can write less Bytes than requested)
+    PLOG_VERBOSE << "Writing parts to file (file_path: " << this->filepath.c_str() << ", parts: " << parts.size() << ")";
+    // checks if the file exists (it could be deleted in the meantime, the descriptor would write to the removed file)
+    ErrorStruct<bool> err_file = this->isValidPath(this->filepath, true);
+    if (!err_file.isSuccess()) {
+        PLOG_ERROR << "The provided file path is invalid (writeParts) (errorCode: " << +err_file.errorCode << ", errorInfo: " << err_file.errorInfo << ", what: " << err_file.what << ")";
+        return err_file;
+    }
+    ErrorStruct<bool> err{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str()};
+    try {
+        struct stat st;
+        this->statFile(st);
+    } catch (const std::exception& e) {
+        err.what = e.what();
+        return err;
+    }
+    if (!this->writable) {
+        PLOG_ERROR << "The file was not opened for writing (file_path: " << this->filepath << ")";
+        return err;
+    }
+    this->header_size = 0;
+    this->file_size = 0;
+    u_int64_t total = 0;
+    std::vector<struct iovec> iov;
+    iov.reserve(parts.size());
+    for (const std::pair<const unsigned char*, u_int64_t>& part : parts) {
+        if (part.second == 0) continue;
+        iov.push_back(iovec{const_cast<unsigned char*>(part.first), part.second});
+        total += part.second;
+    }
+    if (ftruncate(this->fd, 0) != 0) {
+        PLOG_ERROR << "The file could not be truncated (file_path: " << this->filepath << ")";
+        err.what = "ftruncate failed";
+        return err;
+    }
+    // not every file system supports preallocation, the write works without it
+    if (total != 0 && fallocate(this->fd, 0, 0, total) != 0) PLOG_DEBUG << "fallocate failed on the file (file_path: " << this->filepath << ")";
+    size_t index = 0;
+    u_int64_t written = 0;
+    while (index < iov.size()) {
+        ssize_t ret = pwritev(this->fd, iov.data() + index, std::min<size_t>(iov.size() - index, IOV_MAX), written);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) {
+            PLOG_ERROR << "Could not write to the file (file_path: " << this->filepath << ", written: " << written << ", len: " << total << ")";
+            err.what = "write failed";
+            return err;
+        }
+        written += ret;
+        // skip the written parts and move the start of a partially written part
+        size_t left = ret;
+        while (index < iov.size() && left >= iov[index].iov_len) left -= iov[index++].iov_len;
+        if (left > 0) {
+            iov[index].iov_base = static_cast<unsigned char*>(iov[index].iov_base) + left;
+            iov[index].iov_len -= left;
+        }
+    }
+    try {
+        this->update();
+    } catch (const std::exception& e) {
+        // the content is written, but it does not start with a valid header prefix
+        PLOG_WARNING << "The written file does not contain a valid header prefix (file_path: " << this->filepath << ", what: " << e.what() << ")";
+    }
+    return ErrorStruct<bool>{true};
+}
+
 ErrorStruct<std::ofstream> FileHandler::getWriteStream() noexcept {
     this->header_size = 0;
     this->file_size = 0;
@@ -225,6 +584,25 @@ ErrorStruct<std::ofstream> FileHandler::getWriteStreamIfEmpty() noexcept {
     }
 }
 
+ErrorStruct<std::ofstream> FileHandler::getUpdateStream() noexcept {
+    // returns a write stream to the file that keeps the old content
+    // the caller has to call update() after writing
+    PLOG_VERBOSE << "Getting update stream to file (file_path: " << this->filepath.c_str() << ")";
+    // checks if the selected file exists
+    ErrorStruct<bool> err_file = this->isValidPath(this->filepath, true);
+    if (!err_file.isSuccess()) {
+        PLOG_ERROR << "The provided file path is invalid (getUpdateStream) (errorCode: " << +err_file.errorCode << ", errorInfo: " << err_file.errorInfo << ", what: " << err_file.what << ")";
+        return ErrorStruct<std::ofstream>{err_file.success, err_file.errorCode, err_file.errorInfo, err_file.what};
+    }
+    // file path is valid, open without truncating
+    std::ofstream file(this->filepath.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        PLOG_ERROR << "The file could not be opened for updating (file_path: " << this->filepath.c_str() << ")";
+        return ErrorStruct<std::ofstream>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str()};
+    }
+    return ErrorStruct<std::ofstream>::createMove(std::move(file));
+}
+
 std::filesystem::path FileHandler::getPath() const noexcept { return this->filepath; }
 
 // ErrorStruct<bool> FileHandler::writeBytesIfEmpty(Bytes& bytes) noexcept {
@@ -246,38 +624,135 @@ std::filesystem::path FileHandler::getPath() const noexcept { return this->filep
 Bytes FileHandler::getAllBytes() const {
     // reads all Bytes from the file
     PLOG_VERBOSE << "Reading all Bytes from file (file_path: " << this->filepath.c_str() << ")";
-    std::ifstream file = this->getFileStream();  // create the file stream
-    if (!file) {
-        // the set encryption file does not exist on the system
-        throw std::runtime_error("file cannot be opened");
-    }
-    // get length of file:
-    file.seekg(0, file.end);                  // jump to the end
-    std::streampos file_size = file.tellg();  // saves the position
-    file.seekg(0, std::ios::beg);
-
-    // gets the Bytes
-    Bytes ret(file_size);
-    if (!readData(file, ret, file_size)) {
-        // not enough characters to read (file is not long enough)
-        throw std::length_error("File contains to few characters");
+    struct stat st;
+    if (fstat(this->fd, &st) != 0) {
+        // the file cannot be accessed anymore
+        throw std::runtime_error("file cannot be read");
     }
-    file.close();
-    return ret;
+    return this->getFirstBytes(st.st_size);
 }
 
 Bytes FileHandler::getFirstBytes(const size_t num) const {
     // reads the num first bytes of the encryption file
-    std::ifstream file = this->getFileStream();  // create the file stream
-    if (!file) {
-        // the set encryption file does not exist on the system
-        throw std::runtime_error("file cannot be opened");
-    }
-    Bytes b(num);                   // creates a buffer to hold the read bytes
-    if (!readData(file, b, num)) {  // reads into the buffer
+    Bytes b(num);  // creates a buffer to hold the read bytes
+    if (this->readAt(b.getBytes(), num, 0) != num) {
         // not enough characters to read (file is not long enough)
         throw std::length_error("File contains to few characters");
     }
-    file.close();
+    b.setLen(num);
     return b;
 }
+
+size_t FileHandler::readAt(unsigned char* data, const size_t len, const size_t offset) const noexcept {
+    // reads from the held descriptor, the file position is not used
+    return readDataAt(this->fd, data, len, offset);
+}
+
+ErrorStruct<bool> FileHandler::writeAt(const unsigned char* data, const size_t len, const size_t offset) noexcept {
+    // writes to the held descriptor, the Bytes behind the written range are kept
+    if (!this->writable) {
+        PLOG_ERROR << "The file was not opened for writing (file_path: " << this->filepath << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str()};
+    }
+    if (writeDataAt(this->fd, data, len, offset) != len) {
+        PLOG_ERROR << "Could not write to the file (file_path: " << this->filepath << ", offset: " << offset << ", len: " << len << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str(), "write failed"};
+    }
+    return ErrorStruct<bool>{true};
+}
+
+std::filesystem::path FileHandler::getJournalPath(const std::filesystem::path& file) {
+    // the journal is hidden and has no .enc extension, so it is not listed with the vaults (vault.enc -> .vault.enc.journal)
+    return file.parent_path() / ("." + file.filename().string() + JOURNAL_SUFFIX);
+}
+
+ErrorStruct<bool> FileHandler::writeJournal(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept {
+    // the journal is written next to the file and synced before the file is changed
+    // its checksum shows if it was written completely, a torn journal is never applied
+    if (!this->writable) {
+        PLOG_ERROR << "The file was not opened for writing (file_path: " << this->filepath << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str()};
+    }
+    std::filesystem::path journal_path = FileHandler::getJournalPath(this->filepath);
+    int journal_fd = open(journal_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (journal_fd < 0) {
+        PLOG_ERROR << "The journal could not be created (journal_path: " << journal_path << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_CREATED, journal_path.c_str()};
+    }
+    Checksum checksum;
+    u_int64_t pos = 0;
+    bool written = true;
+    auto append = [&](const unsigned char* data, const u_int64_t len) {
+        checksum.addData(data, len);
+        written = written && writeDataAt(journal_fd, data, len, pos) == len;
+        pos += len;
+    };
+    append(Bytes::fromLong(JOURNAL_MAGIC, true).getBytes(), 8);
+    append(Bytes::fromLong(new_file_size, true).getBytes(), 8);
+    append(Bytes::fromLong(writes.size(), true).getBytes(), 8);
+    for (const JournalWrite& write : writes) {
+        append(Bytes::fromLong(write.offset, true).getBytes(), 8);
+        append(Bytes::fromLong(write.len, true).getBytes(), 8);
+        append(write.data, write.len);
+    }
+    written = written && writeDataAt(journal_fd, Bytes::fromLong(checksum.getResult(), true).getBytes(), 8, pos) == 8;
+    written = written && fsync(journal_fd) == 0;
+    close(journal_fd);
+    if (!written) {
+        PLOG_ERROR << "The journal could not be written (journal_path: " << journal_path << ")";
+        std::filesystem::remove(journal_path);
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, journal_path.c_str(), "write failed"};
+    }
+    syncDir(journal_path);
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> FileHandler::applyWrites(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept {
+    // the journal is removed after the file is synced, until then a crash replays it
+    for (const JournalWrite& write : writes) {
+        if (writeDataAt(this->fd, write.data, write.len, write.offset) != write.len) {
+            PLOG_ERROR << "Could not write to the file (file_path: " << this->filepath << ", offset: " << write.offset << ", len: " << write.len << ")";
+            return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str(), "write failed"};
+        }
+    }
+    if (ftruncate(this->fd, new_file_size) != 0 || fsync(this->fd) != 0) {
+        PLOG_ERROR << "The file could not be truncated or synced (file_path: " << this->filepath << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_FILE_NOT_OPEN, this->filepath.c_str(), "ftruncate or fsync failed"};
+    }
+    std::filesystem::path journal_path = FileHandler::getJournalPath(this->filepath);
+    std::error_code ec;
+    std::filesystem::remove(journal_path, ec);
+    syncDir(journal_path);
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> FileHandler::writeJournaled(const std::vector<JournalWrite>& writes, const u_int64_t new_file_size) noexcept {
+    // the writes are applied after the journal is on the disk, so the file has either the old or the new content after a crash
+    ErrorStruct<bool> err = this->writeJournal(writes, new_file_size);
+    if (!err.isSuccess()) return err;
+    err = this->applyWrites(writes, new_file_size);
+    if (!err.isSuccess()) return err;
+    try {
+        this->update();
+    } catch (const std::exception& e) {
+        PLOG_WARNING << "The written file does not contain a valid header prefix (file_path: " << this->filepath << ", what: " << e.what() << ")";
+    }
+    return ErrorStruct<bool>{true};
+}
+
+void FileHandler::adviseReadahead(const size_t offset, const size_t len) const noexcept {
+    // the kernel starts reading the range into the page cache and returns at once
+    if (!FILE_READAHEAD || len == 0) return;
+    if (posix_fadvise(this->fd, offset, len, POSIX_FADV_WILLNEED) != 0) PLOG_WARNING << "posix_fadvise failed on the file (file_path: " << this->filepath << ")";
+}
+
+FileMapping::FileMapping(void* base, const size_t map_len, const size_t offset) noexcept : base(base), map_len(map_len), offset(offset) {}
+
+const unsigned char* FileMapping::getData() const noexcept { return static_cast<const unsigned char*>(this->base) + this->offset; }
+
+size_t FileMapping::getLen() const noexcept { return this->map_len - this->offset; }
+
+FileMapping::~FileMapping() {
+    // releases the mapping
+    if (this->base != nullptr && munmap(this->base, this->map_len) != 0) PLOG_ERROR << "munmap failed on the file mapping";
+}
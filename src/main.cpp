@@ -1,7 +1,10 @@
+#include <signal.h>
+
 #include <iostream>
 
 #include "api.h"
 #include "logger.h"
+#include "vault_agent.h"
 
 // temp
 // #include "password_data.h"
@@ -9,6 +12,30 @@
 #include "timer.h"
 // #include "utility.h"
 
+int runAgent(const std::filesystem::path& vault_path, const std::filesystem::path& socket_path) {
+    // pman agent <vault> <socket>: reads the master password from stdin and serves the vault until SIGINT or SIGTERM
+    // the signals are blocked before the agent threads are started, so they are only received by sigwait
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::string password;
+    std::getline(std::cin, password);
+    VaultAgent agent{vault_path, socket_path};
+    ErrorStruct<bool> err = agent.unlock(password);
+    if (err.isSuccess()) err = agent.start();
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "Failed to start the agent: " << getErrorMessage(err);
+        return 1;
+    }
+    int signal = 0;
+    sigwait(&signals, &signal);
+    PLOG_INFO << "Stopping the agent (signal: " << signal << ")";
+    agent.stop();
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     // for (int i = 0; i < argc; i++){
     //     std::cout << "a"<<argv[i]<<"b" << std::endl;
@@ -32,6 +59,8 @@ int main(int argc, char* argv[]) {
     static plog::RollingFileAppender<plog::TxtFormatter> fileAppender("data/log.txt", 1024 * 1024 * 10, 3);
     plog::init(plog::verbose, &consoleAppender).addAppender(&fileAppender);
 
+    if (argc == 4 && std::string(argv[1]) == "agent") return runAgent(argv[2], argv[3]);
+
     // test constants
     // std::filesystem::path FILE =  charVecToString(RNG::get_random_bytes(5)) + ".enc";
     std::filesystem::path FILE = "qqY�7.enc";
@@ -96,9 +125,6 @@ int main(int argc, char* argv[]) {
         }
         // sleep(sleepTime);
         // FILE_SELECTED
-        Bytes phash(0);
-        std::unique_ptr<DataHeader> dh;
-        ErrorStruct<Bytes> temp;
 
         switch (ACT2) {
             case DELETE:
@@ -121,24 +147,20 @@ int main(int argc, char* argv[]) {
 
             case VERPASS:
                 PLOG_DEBUG << "Verifying password";
-                temp = api.verifyPassword(PASS);
-                if (temp.isSuccess()) {
+                err = api.verifyPassword(PASS);
+                if (err.isSuccess())
                     PLOG_DEBUG << "Verified password successfully";
-                    phash = temp.returnValue();
-                    PLOG_DEBUG << "Password hash: " << phash.toHex();
-                } else
-                    PLOG_WARNING << "Failed to verify password: " << getErrorMessage(temp);
+                else
+                    PLOG_WARNING << "Failed to verify password: " << getErrorMessage(err);
                 break;
 
             case CREATEDH:
                 PLOG_DEBUG << "Creating data header";
-                ErrorStruct<std::unique_ptr<DataHeader>> temp = api.createDataHeader(PASS, dsi);
-                if (temp.isSuccess()) {
+                err = api.createDataHeader(PASS, dsi);
+                if (err.isSuccess())
                     PLOG_DEBUG << "Created data header successfully";
-                    dh = temp.returnMove();
-                    PLOG_DEBUG << "DataHeader: " << dh->getDataHeaderParts() << "\n Hex: " << dh->getHeaderBytes().toHex();
-                } else
-                    PLOG_WARNING << "Failed to create data header";
+                else
+                    PLOG_WARNING << "Failed to create data header: " << getErrorMessage(err);
                 break;
         }
 
@@ -161,9 +183,9 @@ int main(int argc, char* argv[]) {
         // change salt
         PLOG_DEBUG << "Changing salt";
         api.changeSalt();
-        ErrorStruct<Bytes> enc_err = api.getEncryptedData(std::move(fds));
+        ErrorStruct<bool> enc_err = api.encryptData(std::move(fds));
         if (enc_err.isSuccess())
-            PLOG_DEBUG << "Encrypted data successfully: " << enc_err.returnRef().toHex();
+            PLOG_DEBUG << "Encrypted data successfully";
         else
             PLOG_ERROR << "Failed to encrypt data: " << getErrorMessage(enc_err);
 
@@ -219,9 +241,6 @@ int main(int argc, char* argv[]) {
         }
         // sleep(sleepTime);
         // FILE_SELECTED
-        Bytes phash(0);
-        std::unique_ptr<DataHeader> dh;
-        ErrorStruct<Bytes> temp;
 
         switch (ACT2) {
             case DELETE:
@@ -244,24 +263,20 @@ int main(int argc, char* argv[]) {
 
             case VERPASS:
                 PLOG_DEBUG << "Verifying password";
-                temp = api.verifyPassword(PASS);
-                if (temp.isSuccess()) {
+                err = api.verifyPassword(PASS);
+                if (err.isSuccess())
                     PLOG_DEBUG << "Verified password successfully";
-                    phash = temp.returnValue();
-                    PLOG_DEBUG << "Password hash: " << phash.toHex();
-                } else
-                    PLOG_WARNING << "Failed to verify password: " << getErrorMessage(temp);
+                else
+                    PLOG_WARNING << "Failed to verify password: " << getErrorMessage(err);
                 break;
 
             case CREATEDH:
                 PLOG_DEBUG << "Creating data header";
-                ErrorStruct<std::unique_ptr<DataHeader>> temp = api.createDataHeader(PASS, dsi);
-                if (temp.isSuccess()) {
+                err = api.createDataHeader(PASS, dsi);
+                if (err.isSuccess())
                     PLOG_DEBUG << "Created data header successfully";
-                    dh = temp.returnMove();
-                    PLOG_DEBUG << "DataHeader: " << dh->getDataHeaderParts() << "\n Hex: " << dh->getHeaderBytes().toHex();
-                } else
-                    PLOG_WARNING << "Failed to create data header";
+                else
+                    PLOG_WARNING << "Failed to create data header: " << getErrorMessage(err);
                 break;
         }
 
@@ -289,9 +304,9 @@ int main(int argc, char* argv[]) {
         // change salt
         PLOG_DEBUG << "Changing salt";
         api.changeSalt();
-        ErrorStruct<Bytes> enc_err = api.getEncryptedData(fds.returnMove());
+        ErrorStruct<bool> enc_err = api.encryptData(fds.returnMove());
         if (enc_err.isSuccess())
-            PLOG_DEBUG << "Encrypted data successfully: " << enc_err.returnRef().toHex();
+            PLOG_DEBUG << "Encrypted data successfully";
         else
             PLOG_ERROR << "Failed to encrypt data: " << getErrorMessage(enc_err);
 
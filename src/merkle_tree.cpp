@@ -0,0 +1,204 @@
+#include "merkle_tree.h"
+
+#include <algorithm>
+#include <future>
+
+#include "logger.h"
+#include "thread_pool.h"
+
+namespace {
+IntegrityReport compareTrees(const IntegrityTree& tree, const IntegrityTree& actual, const u_int64_t data_len) {
+    // compares the regions and the root of the stored tree with the tree over the actual data
+    IntegrityReport report;
+    for (u_int64_t region = 0; region < actual.region_count; region++) {
+        if (region < tree.region_count && actual.regions[region] == tree.regions[region]) continue;
+        std::pair<u_int64_t, u_int64_t> range = MerkleTree::getRegionRange(data_len, tree.leaf_len, region);
+        // neighbouring damaged regions are reported as one range
+        if (!report.damaged.empty() && report.damaged.back().first + report.damaged.back().second == range.first)
+            report.damaged.back().second += range.second;
+        else
+            report.damaged.push_back(range);
+    }
+    report.valid = actual.region_count == tree.region_count && actual.root == tree.root;
+    if (!report.valid) PLOG_WARNING << "the data does not match with the integrity tree (damaged regions: " << report.damaged.size() << ")";
+    return report;
+}
+
+void checkLeafLen(const u_int64_t leaf_len) {
+    // the leaf length is stored in the header, it is checked before a tree is built
+    if (leaf_len < MIN_INTEGRITY_LEAF_LEN || leaf_len > MAX_INTEGRITY_LEAF_LEN) {
+        PLOG_ERROR << "the given integrity leaf length is not valid: " << leaf_len;
+        throw std::invalid_argument("integrity leaf length is not valid");
+    }
+}
+}  // namespace
+
+u_int64_t MerkleTree::getLeafCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept {
+    // every started leaf counts, empty data is one empty leaf
+    return std::max<u_int64_t>(1, (data_len + leaf_len - 1) / leaf_len);
+}
+
+u_int64_t MerkleTree::getRegionLeafCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept {
+    // the leaves are split into at most INTEGRITY_REGIONS regions with the same number of leaves
+    u_int64_t leaves = MerkleTree::getLeafCount(data_len, leaf_len);
+    u_int64_t regions = std::min<u_int64_t>(INTEGRITY_REGIONS, leaves);
+    return (leaves + regions - 1) / regions;
+}
+
+u_int64_t MerkleTree::getRegionCount(const u_int64_t data_len, const u_int64_t leaf_len) noexcept {
+    // the last region gets the remaining leaves
+    u_int64_t region_leaves = MerkleTree::getRegionLeafCount(data_len, leaf_len);
+    return (MerkleTree::getLeafCount(data_len, leaf_len) + region_leaves - 1) / region_leaves;
+}
+
+std::pair<u_int64_t, u_int64_t> MerkleTree::getRegionRange(const u_int64_t data_len, const u_int64_t leaf_len, const u_int64_t region) noexcept {
+    // a region covers whole leaves, the last region ends with the data
+    u_int64_t region_len = MerkleTree::getRegionLeafCount(data_len, leaf_len) * leaf_len;
+    u_int64_t start = std::min<u_int64_t>(region * region_len, data_len);
+    return {start, std::min<u_int64_t>(region_len, data_len - start)};
+}
+
+Bytes MerkleTree::getRoot(const Hash& hash, std::vector<Bytes> nodes) {
+    // hashes the nodes pairwise until one node is left, a node without a partner is moved up unchanged
+    if (nodes.empty()) {
+        PLOG_ERROR << "cannot calculate the root of an empty tree";
+        throw std::invalid_argument("cannot calculate the root of an empty tree");
+    }
+    Bytes input(1 + 2 * hash.getHashSize());
+    while (nodes.size() > 1) {
+        size_t next = 0;
+        for (size_t node = 0; node < nodes.size(); node += 2) {
+            if (node + 1 == nodes.size()) {
+                nodes[next++] = nodes[node];
+                continue;
+            }
+            input.setLen(0);
+            input.addByte(0x01);
+            nodes[node].addcopyToBytes(input);
+            nodes[node + 1].addcopyToBytes(input);
+            nodes[next++] = hash.hash(input);
+        }
+        nodes.erase(nodes.begin() + next, nodes.end());
+    }
+    return nodes[0];
+}
+
+Bytes MerkleTree::getRegionHash(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const u_int64_t region) {
+    // hashes every leaf of the region and returns the root of the subtree over these leaves
+    std::pair<u_int64_t, u_int64_t> range = MerkleTree::getRegionRange(data_len, leaf_len, region);
+    std::vector<Bytes> leaves;
+    Bytes input(1 + std::min<u_int64_t>(leaf_len, std::max<u_int64_t>(1, range.second)));
+    u_int64_t offset = range.first;
+    do {
+        u_int64_t len = std::min<u_int64_t>(leaf_len, range.first + range.second - offset);
+        input.setLen(0);
+        input.addByte(0x00);
+        if (len > 0) input.addBytes(data + offset, len);
+        leaves.push_back(hash.hash(input));
+        offset += len;
+    } while (offset < range.first + range.second);
+    return MerkleTree::getRoot(hash, std::move(leaves));
+}
+
+Bytes MerkleTree::getLeafHash(const Hash& hash, const unsigned char* leaf, const u_int64_t len) {
+    // a leaf is hashed with the 0x00 prefix, so it cannot be confused with a node
+    Bytes input(1 + len);
+    input.addByte(0x00);
+    if (len > 0) input.addBytes(leaf, len);
+    return hash.hash(input);
+}
+
+std::vector<Bytes> MerkleTree::getLeafHashes(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads) {
+    // the leaves are split into one slice of neighbouring leaves per thread, every slice is one task of the thread pool
+    u_int64_t leaf_count = MerkleTree::getLeafCount(data_len, leaf_len);
+    size_t used_threads = threads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : threads;
+    u_int64_t slice_len = (leaf_count + used_threads - 1) / used_threads;
+    ThreadPool pool(std::min<u_int64_t>(leaf_count, used_threads));
+    std::vector<std::future<std::vector<Bytes>>> results;
+    for (u_int64_t first = 0; first < leaf_count; first += slice_len) {
+        u_int64_t last = std::min<u_int64_t>(first + slice_len, leaf_count);
+        results.push_back(pool.submit([&hash, data, data_len, leaf_len, first, last]() {
+            std::vector<Bytes> leaves;
+            for (u_int64_t leaf = first; leaf < last; leaf++) {
+                u_int64_t offset = std::min<u_int64_t>(leaf * leaf_len, data_len);
+                leaves.push_back(MerkleTree::getLeafHash(hash, data + offset, std::min<u_int64_t>(leaf_len, data_len - offset)));
+            }
+            return leaves;
+        }));
+    }
+    std::vector<Bytes> leaves;
+    leaves.reserve(leaf_count);
+    for (std::future<std::vector<Bytes>>& result : results) {
+        for (Bytes& leaf : result.get()) leaves.push_back(std::move(leaf));
+    }
+    return leaves;
+}
+
+std::vector<Bytes> MerkleTree::getRegionHashes(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads) {
+    // the regions do not depend on each other, every region is hashed as one task of the thread pool
+    u_int64_t region_count = MerkleTree::getRegionCount(data_len, leaf_len);
+    size_t used_threads = threads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : threads;
+    ThreadPool pool(std::min<size_t>(region_count, used_threads));
+    std::vector<std::future<Bytes>> results;
+    for (u_int64_t region = 0; region < region_count; region++)
+        results.push_back(pool.submit([&hash, data, data_len, leaf_len, region]() { return MerkleTree::getRegionHash(hash, data, data_len, leaf_len, region); }));
+    std::vector<Bytes> regions;
+    for (std::future<Bytes>& result : results) regions.push_back(result.get());
+    return regions;
+}
+
+IntegrityTree MerkleTree::build(const Hash& hash, const unsigned char* data, const u_int64_t data_len, const u_int64_t leaf_len, const size_t threads) {
+    // calculates the region hashes and the root, only the beginning of every region hash is stored in the header
+    checkLeafLen(leaf_len);
+    IntegrityTree tree;
+    tree.leaf_len = leaf_len;
+    std::vector<Bytes> regions = MerkleTree::getRegionHashes(hash, data, data_len, leaf_len, threads);
+    tree.region_count = regions.size();
+    for (const Bytes& region : regions) tree.regions.push_back(region.copySubBytes(0, INTEGRITY_REGION_HASH_LEN));
+    tree.root = MerkleTree::getRoot(hash, std::move(regions));
+    return tree;
+}
+
+std::vector<Bytes> MerkleTree::getRegionHashesFromLeaves(const Hash& hash, const std::vector<Bytes>& leaves, const u_int64_t data_len, const u_int64_t leaf_len) {
+    // every region is the subtree over its leaf hashes, the nodes above the leaves only hash other hashes
+    if (leaves.size() != MerkleTree::getLeafCount(data_len, leaf_len)) {
+        PLOG_ERROR << "the number of leaf hashes does not match with the data (leaves: " << leaves.size() << ", data_len: " << data_len << ")";
+        throw std::invalid_argument("the number of leaf hashes does not match with the data");
+    }
+    u_int64_t region_leaves = MerkleTree::getRegionLeafCount(data_len, leaf_len);
+    std::vector<Bytes> regions;
+    for (u_int64_t first = 0; first < leaves.size(); first += region_leaves)
+        regions.push_back(MerkleTree::getRoot(hash, std::vector<Bytes>(leaves.begin() + first, leaves.begin() + std::min<u_int64_t>(first + region_leaves, leaves.size()))));
+    return regions;
+}
+
+IntegrityTree MerkleTree::buildFromLeaves(const Hash& hash, const std::vector<Bytes>& leaves, const u_int64_t data_len, const u_int64_t leaf_len) {
+    // the regions are built from the leaf hashes, the data is not needed
+    checkLeafLen(leaf_len);
+    return MerkleTree::buildFromRegions(hash, MerkleTree::getRegionHashesFromLeaves(hash, leaves, data_len, leaf_len), leaf_len);
+}
+
+IntegrityTree MerkleTree::buildFromRegions(const Hash& hash, std::vector<Bytes> regions, const u_int64_t leaf_len) {
+    // only the beginning of every region hash is stored in the header, the root is the tree over the full region hashes
+    checkLeafLen(leaf_len);
+    if (regions.empty() || regions.size() > INTEGRITY_REGIONS) {
+        PLOG_ERROR << "the number of region hashes is not valid (regions: " << regions.size() << ")";
+        throw std::invalid_argument("the number of region hashes is not valid");
+    }
+    IntegrityTree tree;
+    tree.leaf_len = leaf_len;
+    tree.region_count = regions.size();
+    for (const Bytes& region : regions) tree.regions.push_back(region.copySubBytes(0, INTEGRITY_REGION_HASH_LEN));
+    tree.root = MerkleTree::getRoot(hash, std::move(regions));
+    return tree;
+}
+
+IntegrityReport MerkleTree::verify(const Hash& hash, const IntegrityTree& tree, const unsigned char* data, const u_int64_t data_len, const size_t threads) {
+    // rebuilds the tree over the data and compares the regions and the root with the stored tree
+    return compareTrees(tree, MerkleTree::build(hash, data, data_len, tree.leaf_len, threads), data_len);
+}
+
+IntegrityReport MerkleTree::verifyLeaves(const Hash& hash, const IntegrityTree& tree, const std::vector<Bytes>& leaves, const u_int64_t data_len) {
+    // rebuilds the tree from the leaf hashes and compares the regions and the root with the stored tree
+    return compareTrees(tree, MerkleTree::buildFromLeaves(hash, leaves, data_len, tree.leaf_len), data_len);
+}
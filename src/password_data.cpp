@@ -8,107 +8,44 @@
 #include "settings.h"
 #include "utility.h"
 
+namespace {
+// the names of the strings of a password set (used in the error messages)
+const std::string SET_PARTS[4] = {"site", "user", "email", "password"};
+}  // namespace
+
 ErrorStruct<bool> PasswordData::constructFileData(FileDataStruct& file_data) noexcept {
     // constructs the file data object with the file data struct
     PLOG_VERBOSE << "Constructing PasswordData object";
     if (file_data.getFileMode() != FILEMODE_PASSWORD) {
         return ErrorStruct<bool>{FAIL, ERR_FILEMODE_INVALID, std::to_string(+file_data.getFileMode()), "The file mode is not FileMode::PASSWORD_DATA"};
     }
+    if (file_data.dec_data == nullptr) {
+        PLOG_ERROR << "The file data struct has no decrypted data";
+        return ErrorStruct<bool>{FAIL, ERR_FILEDATASTRUCT_NULL, ""};
+    }
     this->siteMap.clear();
-    while (true) {
-        // this loop iterates over the data sets
-        if (file_data.dec_data.getLen() == 0) {
-            // no more data sets
-            break;
-        }
-        std::string site = "";
+    const unsigned char* data = file_data.dec_data->getBytes();
+    const size_t len = file_data.dec_data->getLen();
+    size_t pos = 0;
+    while (pos < len) {
+        // this loop iterates over the data sets, one data set consists of 4 strings with a size byte in front of each
+        std::string parts[4];
         for (int i = 0; i < 4; i++) {
-            // this loop represents one data set
-            std::optional<Bytes> size;
-            try {
-                size = file_data.dec_data.popFirstBytes(1);
-            } catch (std::exception& e) {
-                // should not happen
-                PLOG_FATAL << "Something went wrong while getting the size byte: " << e.what();
-                return ErrorStruct<bool>{FAIL, ERR_BUG, "Something went wrong while getting the size byte", e.what()};
-            }
-            if (!size.has_value()) {
+            if (pos >= len) {
                 // some size byte is missing
-                std::string type;
-                switch (i) {
-                    case 0:
-                        type = "site";
-                        break;
-                    case 1:
-                        type = "user";
-                        break;
-                    case 2:
-                        type = "email";
-                        break;
-                    case 3:
-                        type = "password";
-                        break;
-                }
-                PLOG_ERROR << "The file data is not in the right format. Missing size byte for the " << type << " data";
-                return ErrorStruct<bool>{FAIL, ERR_FILEDATA_INVALID, "The file data is not in the right format. Missing size byte for the " + type + " data"};
-            }
-            // the size byte is there
-            unsigned char size_val = size.value().getBytes()[0];
-            std::optional<Bytes> data;
-            try {
-                data = file_data.dec_data.popFirstBytes(size_val);
-            } catch (std::exception& e) {
-                // should not happen
-                PLOG_FATAL << "Something went wrong while getting the data bytes: " << e.what();
-                return ErrorStruct<bool>{FAIL, ERR_BUG, "Something went wrong while getting the data bytes", e.what()};
+                PLOG_ERROR << "The file data is not in the right format. Missing size byte for the " << SET_PARTS[i] << " data";
+                return ErrorStruct<bool>{FAIL, ERR_FILEDATA_INVALID, "The file data is not in the right format. Missing size byte for the " + SET_PARTS[i] + " data"};
             }
-            if (!data.has_value()) {
+            unsigned char size = data[pos++];
+            if (len - pos < size) {
                 // some data is missing
-                std::string type;
-                switch (i) {
-                    case 0:
-                        type = "site";
-                        break;
-                    case 1:
-                        type = "user";
-                        break;
-                    case 2:
-                        type = "email";
-                        break;
-                    case 3:
-                        type = "password";
-                        break;
-                }
-                PLOG_ERROR << "The file data is not in the right format. Missing data for the " << type << " data";
-                return ErrorStruct<bool>{FAIL, ERR_FILEDATA_INVALID, "The file data is not in the right format. Missing data for the " + type + " data"};
-            }
-            // the data is there
-            std::string data_str = charVecToString(data.value().getBytes());
-            if (i == 0) {
-                site = data_str;
-                if (this->siteMap.count(site) == 0)
-                    this->siteMap[site] = std::vector<PasswordSiteSet>();
-                else
-                    this->siteMap[site].push_back(PasswordSiteSet{});
-            } else {
-                switch (i) {
-                    case 1:
-                        this->siteMap[site].back().setUsername(data_str);
-                        break;
-
-                    case 2:
-                        this->siteMap[site].back().setEmail(data_str);
-                        break;
-
-                    case 3:
-                        this->siteMap[site].back().setPassword(data_str);
-                        break;
-
-                    default:
-                        return ErrorStruct<bool>{FAIL, ERR_BUG, "Something went wrong while getting the data bytes", "The index is not valid: " + std::to_string(i)};
-                }
+                PLOG_ERROR << "The file data is not in the right format. Missing data for the " << SET_PARTS[i] << " data";
+                return ErrorStruct<bool>{FAIL, ERR_FILEDATA_INVALID, "The file data is not in the right format. Missing data for the " + SET_PARTS[i] + " data"};
             }
+            parts[i] = std::string(reinterpret_cast<const char*>(data + pos), size);
+            pos += size;
         }
+        this->siteMap[parts[0]].push_back(PasswordSiteSet{parts[1], parts[2], parts[3]});
     }
     return ErrorStruct<bool>{SUCCESS, NO_ERR, "", "", true};
 }
@@ -116,48 +53,33 @@ ErrorStruct<bool> PasswordData::constructFileData(FileDataStruct& file_data) noe
 FileDataStruct PasswordData::getFileData() const {
     // returns the file data struct
     PLOG_VERBOSE << "Getting FileDataStruct object";
-    FileDataStruct file_data{FILEMODE_PASSWORD, this->getBytes()};
-    return file_data;
+    return FileDataStruct{FILEMODE_PASSWORD, std::make_unique<Bytes>(this->getBytes())};
 }
 
-Bytes PasswordData::getBytes() const {
-    // returns the data in Bytes
-    Bytes ret{};
-    for (std::pair<std::string, std::vector<PasswordSiteSet>> item : this->siteMap) {
-        // iterate over all data sets
-        Bytes siteB{};
-        siteB.setBytes(std::vector<unsigned char>(item.first.begin(), item.first.end()));
-        // check if the data has the right length (note that one site can have multiple data sets, but each data set has to have the same length (3))
-        if (item.second.size() % 3 != 0) {
-            PLOG_FATAL << "The password data is not in the right format in the site: " << item.first;
-            throw std::runtime_error("The password data is not in the right format in the site: " + item.first);
-        }
-        int i = 0;
-        while (true) {
-            // iterate over all data sets of one site
-            ret.addByte(siteB.getLen());
-            ret.addBytes(siteB);
-
-            Bytes userB{};
-            userB.setBytes(std::vector<unsigned char>(item.second[i].getUsername().begin(), item.second[i].getUsername().begin()));
-            ret.addByte(userB.getLen());
-            ret.addBytes(userB);
-
-            Bytes emailB{};
-            emailB.setBytes(std::vector<unsigned char>(item.second[i].getEmail().begin(), item.second[i].getEmail().begin()));
-            ret.addByte(emailB.getLen());
-            ret.addBytes(emailB);
-
-            Bytes passwordB{};
-            passwordB.setBytes(std::vector<unsigned char>(item.second[i].getPassword().begin(), item.second[i].getPassword().begin()));
-            ret.addByte(passwordB.getLen());
-            ret.addBytes(passwordB);
-
-            i++;
+Bytes PasswordData::getSetBytes(const PasswordSet& pwset) {
+    // every string gets one size byte in front of it
+    if (!pwset.isValid()) throw std::invalid_argument("The given password set is not valid (at least one datapoint is too long)");
+    const std::string* parts[4] = {&pwset.site, &pwset.username, &pwset.email, &pwset.password};
+    Bytes ret(4 + pwset.site.size() + pwset.username.size() + pwset.email.size() + pwset.password.size());
+    for (const std::string* part : parts) {
+        ret.addByte(part->size());
+        ret.addBytes(reinterpret_cast<const unsigned char*>(part->data()), part->size());
+    }
+    return ret;
+}
 
-            if (i == item.second.size())
-                // all data sets of one site are processed
-                break;
+Bytes PasswordData::getBytes() const {
+    // returns the data in Bytes, the size is calculated first so the data is copied only once
+    size_t size = 0;
+    for (const std::pair<const std::string, std::vector<PasswordSiteSet>>& item : this->siteMap) {
+        for (const PasswordSiteSet& set : item.second) size += 4 + item.first.size() + set.getUsername().size() + set.getEmail().size() + set.getPassword().size();
+    }
+    Bytes ret(size);
+    for (const std::pair<const std::string, std::vector<PasswordSiteSet>>& item : this->siteMap) {
+        // iterate over all data sets of one site
+        for (const PasswordSiteSet& set : item.second) {
+            Bytes setB = PasswordData::getSetBytes(PasswordSet{item.first, set.getUsername(), set.getEmail(), set.getPassword()});
+            ret.addBytes(setB.getBytes(), setB.getLen());
         }
     }
     return ret;
@@ -196,16 +118,50 @@ std::vector<PasswordSet> PasswordData::getSets(const std::string substring, cons
     return passwordSets;
 }
 
+std::vector<PasswordSet> PasswordData::getSiteSets(const std::string& site) const noexcept {
+    // returns the password sets of exactly this site
+    std::vector<PasswordSet> passwordSets;
+    std::unordered_map<std::string, std::vector<PasswordSiteSet>>::const_iterator it = this->siteMap.find(site);
+    if (it == this->siteMap.end()) return passwordSets;
+    for (const PasswordSiteSet& siteSet : it->second) passwordSets.push_back(PasswordSet{site, siteSet.getUsername(), siteSet.getEmail(), siteSet.getPassword()});
+    return passwordSets;
+}
+
+size_t PasswordData::getSetCount() const noexcept {
+    // counts the sets of all sites
+    size_t count = 0;
+    for (const std::pair<const std::string, std::vector<PasswordSiteSet>>& item : this->siteMap) count += item.second.size();
+    return count;
+}
+
 void PasswordData::addPw(const PasswordSet pwset) {
     if (!pwset.isValid()) throw std::invalid_argument("The given password set is not valid (at least one datapoint is too long)");
     if (this->siteMap.count(pwset.site) == 0) this->siteMap[pwset.site] = std::vector<PasswordSiteSet>();
     this->siteMap[pwset.site].push_back(PasswordSiteSet{pwset.username, pwset.email, pwset.password});
 }
 
-void PasswordData::remPw(const PasswordSet pwset) const noexcept {
-    // WORK
+bool PasswordData::remPw(const PasswordSet pwset) noexcept {
+    // only the first matching set is removed, a site without sets is removed as well
+    std::unordered_map<std::string, std::vector<PasswordSiteSet>>::iterator it = this->siteMap.find(pwset.site);
+    if (it == this->siteMap.end()) return false;
+    std::vector<PasswordSiteSet>::iterator set = std::find_if(it->second.begin(), it->second.end(), [&pwset](const PasswordSiteSet& set) {
+        return set.getUsername() == pwset.username && set.getEmail() == pwset.email && set.getPassword() == pwset.password;
+    });
+    if (set == it->second.end()) return false;
+    it->second.erase(set);
+    if (it->second.empty()) this->siteMap.erase(it);
+    return true;
 }
 
-void PasswordData::editPw(const PasswordSet pwset) const noexcept {
-    // WORK
+bool PasswordData::editPw(const PasswordSet input) {
+    // the site and the username identify the set
+    if (!input.isValid()) throw std::invalid_argument("The given password set is not valid (at least one datapoint is too long)");
+    std::unordered_map<std::string, std::vector<PasswordSiteSet>>::iterator it = this->siteMap.find(input.site);
+    if (it == this->siteMap.end()) return false;
+    std::vector<PasswordSiteSet>::iterator set =
+        std::find_if(it->second.begin(), it->second.end(), [&input](const PasswordSiteSet& set) { return set.getUsername() == input.username; });
+    if (set == it->second.end()) return false;
+    set->setEmail(input.email);
+    set->setPassword(input.password);
+    return true;
 }
@@ -37,7 +37,16 @@ ErrorStruct<bool> PwFunc::isPasswordValid(const std::string& password) noexcept
     return ret;
 }
 
-PwFunc::PwFunc(std::shared_ptr<Hash> hash) noexcept { this->hash = std::move(hash); }
+PwFunc::PwFunc(std::shared_ptr<Hash> hash, ChainHashControl* control) noexcept : control(control) { this->hash = std::move(hash); }
+
+bool PwFunc::isCancelled(const u_int64_t iterations) const noexcept {
+    // called every TIMEOUT_ITERATIONS iterations, without a control the chainhash cannot be cancelled
+    if (this->control == nullptr) return false;
+    this->control->report(iterations);
+    if (!this->control->isCancelled()) return false;
+    PLOG_WARNING << "chainhash cancelled (iterations: " << iterations << ")";
+    return true;
+}
 
 ErrorStruct<Bytes> PwFunc::chainhash(const std::string& password, const u_int64_t iterations, const u_int64_t timeout) const noexcept {
     Timer timer;
@@ -46,11 +55,12 @@ ErrorStruct<Bytes> PwFunc::chainhash(const std::string& password, const u_int64_
     for (u_int64_t i = 1; i < iterations; i++) {
         // for iterations -1 the hash is hashed again
         ret = this->hash->hash(ret);
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -65,11 +75,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithConstantSalt(const std::string& password
         // for iterations -1 the salt is added to the current hash and the result is hashed again
         addStringToBytes(salt, ret);
         ret = this->hash->hash(ret, salt.length());
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -85,11 +96,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithCountSalt(const std::string& password, c
         salt_start++;
         addStringToBytes(std::to_string(salt_start), ret);
         ret = this->hash->hash(ret, 20);
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -107,11 +119,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithCountAndConstantSalt(const std::string&
         salt_start++;
         addStringToBytes(salt + std::to_string(salt_start), ret);
         ret = this->hash->hash(ret, salt.length() + 20);
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -128,11 +141,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithQuadraticCountSalt(const std::string& pa
         salt_start++;
         addStringToBytes(std::to_string(a * salt_start * salt_start + b * salt_start + c), ret);
         ret = this->hash->hash(ret, 20);
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -145,11 +159,12 @@ ErrorStruct<Bytes> PwFunc::chainhash(const Bytes& data, const u_int64_t iteratio
     for (u_int64_t i = 0; i < iterations; i++) {
         // for iterations the hash is hashed again
         ret = this->hash->hash(ret);
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -164,11 +179,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithConstantSalt(const Bytes& data, const u_
         // for iterations the salt is added to the current hash and the result is hashed again
         addStringToBytes(salt, ret);
         ret = this->hash->hash(ret, salt.length());
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -184,11 +200,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithCountSalt(const Bytes& data, const u_int
         addStringToBytes(std::to_string(salt_start), ret);
         ret = this->hash->hash(ret, 20);
         salt_start++;
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -204,11 +221,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithCountAndConstantSalt(const Bytes& data,
         addStringToBytes(salt + std::to_string(salt_start), ret);
         ret = this->hash->hash(ret, salt.length() + 20);
         salt_start++;
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -224,11 +242,12 @@ ErrorStruct<Bytes> PwFunc::chainhashWithQuadraticCountSalt(const Bytes& data, co
         addStringToBytes(std::to_string(a * salt_start * salt_start + b * salt_start + c), ret);
         ret = this->hash->hash(ret, 20);
         salt_start++;
-        if (timeout != 0 && i % TIMEOUT_ITERATIONS == 0) {
-            if (timeout <= timer.peekTime()) {
+        if (i % TIMEOUT_ITERATIONS == 0) {
+            if (timeout != 0 && timeout <= timer.peekTime()) {
                 PLOG_WARNING << "timeout reached (timeout: " << timeout << ", iterations: " << i << ")";
                 return ErrorStruct<Bytes>{TIMEOUT, ERR_TIMEOUT, "", ""};
             }
+            if (this->isCancelled(i)) return ErrorStruct<Bytes>{FAIL, ERR_CANCELLED, "", ""};
         }
     }
     return ErrorStruct<Bytes>{SUCCESS, NO_ERR, "", "", ret};
@@ -0,0 +1,287 @@
+/*
+implements the RotationJob class
+*/
+#include "rotation_job.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "filehandler.h"
+#include "logger.h"
+#include "thread_pool.h"
+
+u_int64_t RotationReport::getTotalTime() const noexcept {
+    // the steps run one after another
+    return this->unlock_time + this->decrypt_time + this->rekey_time + this->encrypt_time + this->write_time;
+}
+
+std::ostream& operator<<(std::ostream& os, const RotationReport& report) {
+    // one line per vault, so the reports of a job can be written to a csv file
+    os << report.file.string() << "," << (report.result.success == SUCCESS) << "," << +report.result.errorCode << "," << report.skipped << "," << report.bytes << ","
+       << report.unlock_time << "," << report.decrypt_time << "," << report.rekey_time << "," << report.encrypt_time << "," << report.write_time;
+    return os;
+}
+
+u_int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point& start) noexcept {
+    // returns the time since start and restarts it
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    u_int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+    start = now;
+    return time;
+}
+
+void prefetchFile(const std::filesystem::path& file) noexcept {
+    // hints the kernel to read the file in the background, it is read by a worker soon
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) != 0) PLOG_WARNING << "posix_fadvise failed on the file (file_path: " << file << ")";
+    ::close(fd);
+}
+
+std::filesystem::path RotationJob::getTempPath(const std::filesystem::path& file) {
+    // the temporary file is hidden and keeps the extension, so it can be written by the API but is not listed with the vaults (vault.enc -> .vault.rotating.enc)
+    return file.parent_path() / ("." + file.stem().string() + ROTATION_TMP_SUFFIX + file.extension().string());
+}
+
+ErrorStruct<bool> RotationJob::createTempFile(const std::filesystem::path& tmp_path, const std::filesystem::path& file) noexcept {
+    // the rename replaces the vault with the temporary file, so the temporary file gets the mode and the owner of the vault (not the umask)
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0) {
+        PLOG_ERROR << "The vault could not be stat (createTempFile) (file_path: " << file << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_FOUND, file.c_str()};
+    }
+    ErrorStruct<bool> err = FileHandler::isValidPath(tmp_path, false);
+    if (!err.isSuccess()) return err;
+    // the owner can write the file until it is committed (a read only vault gets its mode back in commit)
+    mode_t mode = (st.st_mode & 07777) | S_IWUSR;
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+    if (fd < 0) {
+        PLOG_ERROR << "The temporary file could not be created (createTempFile) (tmp_path: " << tmp_path << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_CREATED, tmp_path.c_str()};
+    }
+    struct stat tmp_st;
+    bool matched = ::fstat(fd, &tmp_st) == 0;
+    // the owner is changed first, fchown can clear the setuid and setgid bits
+    if (matched && (tmp_st.st_uid != st.st_uid || tmp_st.st_gid != st.st_gid)) matched = ::fchown(fd, st.st_uid, st.st_gid) == 0;
+    if (matched) matched = ::fchmod(fd, mode) == 0;
+    ::close(fd);
+    if (!matched) {
+        // a vault of another user would be replaced by a file of this user
+        PLOG_ERROR << "The temporary file could not get the mode and the owner of the vault (createTempFile) (file_path: " << file << ")";
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_CREATED, tmp_path.c_str(), "the mode and the owner of the vault could not be kept"};
+    }
+    return ErrorStruct<bool>{true};
+}
+
+std::string RotationJob::getJournalKey(const std::filesystem::path& file) noexcept {
+    // different spellings of one vault (relative, absolute, symlinks) get the same key
+    std::error_code ec;
+    std::filesystem::path key = std::filesystem::canonical(file, ec);
+    if (ec) key = std::filesystem::absolute(file, ec).lexically_normal();
+    return key.string();
+}
+
+ErrorStruct<bool> RotationJob::commit(const std::filesystem::path& tmp_path, const std::filesystem::path& file) noexcept {
+    // the content of the temporary file has to be on the disk before the rename, otherwise a crash could leave an empty vault behind
+    int fd = ::open(tmp_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PLOG_ERROR << "The temporary file could not be opened (commit) (tmp_path: " << tmp_path << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_OPEN, tmp_path.c_str()};
+    }
+    // the temporary file gets the exact mode of the vault it replaces (createTempFile keeps it writable for the owner)
+    struct stat st;
+    if (::stat(file.c_str(), &st) == 0 && ::fchmod(fd, st.st_mode & 07777) != 0) PLOG_WARNING << "The mode of the vault could not be kept (commit) (file_path: " << file << ")";
+    if (::fsync(fd) != 0) {
+        ::close(fd);
+        PLOG_ERROR << "The temporary file could not be synced (commit) (tmp_path: " << tmp_path << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_REPLACED, file.c_str(), "fsync failed"};
+    }
+    ::close(fd);
+    // the rename replaces the vault atomically
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, file, ec);
+    if (ec) {
+        PLOG_ERROR << "The vault could not be replaced (commit) (file_path: " << file << ", what: " << ec.message() << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILE_NOT_REPLACED, file.c_str(), ec.message()};
+    }
+    // the rename is only durable after the directory is synced
+    std::filesystem::path dir = file.parent_path().empty() ? "." : file.parent_path();
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0 || ::fsync(dir_fd) != 0) PLOG_WARNING << "The directory of the vault could not be synced (commit) (dir: " << dir << ")";
+    if (dir_fd >= 0) ::close(dir_fd);
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> RotationJob::replaceVault(API& api, const std::filesystem::path& file) noexcept {
+    // the new content is written to the temporary file and renamed over the vault, so a crash leaves the old or the complete new vault
+    std::filesystem::path tmp_path = RotationJob::getTempPath(file);
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);  // left by a crashed write
+    ErrorStruct<bool> err = RotationJob::createTempFile(tmp_path, file);
+    if (err.isSuccess()) err = api.writeToFile(tmp_path);
+    if (err.isSuccess()) err = RotationJob::commit(tmp_path, file);
+    if (!err.isSuccess()) std::filesystem::remove(tmp_path, ec);
+    return err;
+}
+
+RotationJob::RotationJob(const std::vector<std::filesystem::path>& files, const RotationSettings& settings, const std::filesystem::path& journal, const size_t threads)
+    : files(files), settings(settings), journal(journal), threads(threads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : threads) {
+    // the settings are checked once, so every vault fails or succeeds for its own reasons
+    if (!settings.new_password.empty() && !settings.settings.has_value()) {
+        PLOG_ERROR << "A RotationJob cannot change the password without new data header settings";
+        throw std::invalid_argument("A RotationJob cannot change the password without new data header settings");
+    }
+    PLOG_VERBOSE << "created new RotationJob (files: " << this->files.size() << ", threads: " << this->threads << ", journal: " << this->journal << ")";
+}
+
+void RotationJob::readJournal() noexcept {
+    // every line is the canonical path of one rotated vault, a line that was cut by a crash matches no vault
+    this->journaled.clear();
+    if (this->journal.empty()) return;
+    std::ifstream file(this->journal);
+    std::string line;
+    while (std::getline(file, line)) this->journaled.insert(line);
+}
+
+void RotationJob::addToJournal(const std::filesystem::path& file) noexcept {
+    // the journal is flushed after every vault, a lost entry is found by isRotated
+    std::string key = RotationJob::getJournalKey(file);
+    if (this->journal.empty() || key.find('\n') != std::string::npos) return;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::ofstream journal(this->journal, std::ios::app);
+    journal << key << "\n";
+    journal.flush();
+    if (!journal) PLOG_WARNING << "The vault could not be added to the journal (file_path: " << file << ", journal: " << this->journal << ")";
+}
+
+bool RotationJob::isRotated(const std::filesystem::path& file, ChainHashControl* control) noexcept {
+    // only a new password tells a rotated vault apart, a re-salted vault cannot be detected (it is rotated again)
+    if (this->settings.new_password.empty() || this->settings.new_password == this->settings.password) return false;
+    API api{this->settings.file_mode};
+    return api.selectFile(file).isSuccess() && api.verifyPassword(this->settings.new_password, 0, control).isSuccess();
+}
+
+RotationReport RotationJob::rotate(const std::filesystem::path& file) noexcept {
+    // select, verify, decrypt, rekey, encrypt and write, the vault is only replaced if every step succeeded
+    RotationReport report;
+    report.file = file;
+    ChainHashControl control;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->controls.insert(&control);
+        if (this->cancelled) control.cancel();
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    u_int64_t* step = &report.unlock_time;
+    auto finish = [this, &report, &control, &start, &step](const ErrorStruct<bool>& err) {
+        *step += elapsedMicroseconds(start);
+        report.result = err;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->controls.erase(&control);
+        return report;
+    };
+    if (control.isCancelled()) return finish(ErrorStruct<bool>{FAIL, ERR_CANCELLED, file.c_str()});
+    if (this->journaled.count(RotationJob::getJournalKey(file)) != 0) {
+        report.skipped = true;
+        return finish(ErrorStruct<bool>{true});
+    }
+
+    API api{this->settings.file_mode};
+    ErrorStruct<bool> err = api.selectFile(file);
+    if (err.isSuccess()) err = api.verifyPassword(this->settings.password, 0, &control);
+    if (err.errorCode == ERR_PASSWORD_INVALID && this->isRotated(file, &control)) {
+        // the vault was replaced by an earlier run that crashed before it was journaled
+        PLOG_INFO << "The vault was already rotated (file_path: " << file << ")";
+        this->addToJournal(file);
+        report.skipped = true;
+        return finish(ErrorStruct<bool>{true});
+    }
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The vault could not be unlocked (rotate) (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+        return finish(err);
+    }
+    report.unlock_time = elapsedMicroseconds(start);
+
+    step = &report.decrypt_time;
+    ErrorStruct<std::unique_ptr<FileDataStruct>> decrypted = api.getDecryptedData();
+    if (!decrypted.isSuccess()) {
+        PLOG_ERROR << "The vault could not be decrypted (rotate) (file_path: " << file << ", errorCode: " << +decrypted.errorCode << ", what: " << decrypted.what << ")";
+        return finish(ErrorStruct<bool>{decrypted.success, decrypted.errorCode, decrypted.errorInfo, decrypted.what});
+    }
+    report.decrypt_time = elapsedMicroseconds(start);
+
+    step = &report.rekey_time;
+    if (this->settings.settings.has_value()) {
+        const std::string& password = this->settings.new_password.empty() ? this->settings.password : this->settings.new_password;
+        err = api.createDataHeader(password, this->settings.settings.value(), 0, &control);
+    } else {
+        err = control.isCancelled() ? ErrorStruct<bool>{FAIL, ERR_CANCELLED, file.c_str()} : api.changeSalt();
+    }
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The data header of the vault could not be changed (rotate) (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+        return finish(err);
+    }
+    report.rekey_time = elapsedMicroseconds(start);
+
+    step = &report.encrypt_time;
+    err = api.encryptData(decrypted.returnMove());
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The vault could not be encrypted (rotate) (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+        return finish(err);
+    }
+    report.encrypt_time = elapsedMicroseconds(start);
+
+    // the last point the job can be cancelled, a written temporary file is committed
+    step = &report.write_time;
+    if (control.isCancelled()) return finish(ErrorStruct<bool>{FAIL, ERR_CANCELLED, file.c_str()});
+    err = RotationJob::replaceVault(api, file);
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The rotated vault could not be written (rotate) (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+        return finish(err);
+    }
+    this->addToJournal(file);
+    std::error_code ec;
+    report.bytes = std::filesystem::file_size(file, ec);
+    return finish(err);
+}
+
+std::vector<RotationReport> RotationJob::run(std::function<void(const RotationReport&)> progress) {
+    // every vault is one task of the pool, the pool starts them in the order of the files
+    this->readJournal();
+    this->progress = progress;
+    this->done = 0;
+    std::vector<std::future<RotationReport>> futures;
+    futures.reserve(this->files.size());
+    {
+        ThreadPool pool{std::min<size_t>(this->threads, std::max<size_t>(1, this->files.size()))};
+        for (size_t i = 0; i < this->files.size(); i++) {
+            futures.push_back(pool.submit([this, i]() {
+                // the vault that is started after the running ones is read ahead while this vault is hashed
+                if (i + this->threads < this->files.size() && this->journaled.count(RotationJob::getJournalKey(this->files[i + this->threads])) == 0 && !this->cancelled)
+                    prefetchFile(this->files[i + this->threads]);
+                RotationReport report = this->rotate(this->files[i]);
+                this->done++;
+                if (this->progress) this->progress(report);
+                return report;
+            }));
+        }
+    }
+    std::vector<RotationReport> reports;
+    reports.reserve(futures.size());
+    for (std::future<RotationReport>& future : futures) reports.push_back(future.get());
+    return reports;
+}
+
+void RotationJob::cancel() noexcept {
+    // the flag stops the vaults that are not started yet, the controls stop the running chainhashes
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->cancelled = true;
+    for (ChainHashControl* control : this->controls) control->cancel();
+}
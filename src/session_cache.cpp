@@ -0,0 +1,156 @@
+/*
+implements the SessionCache class
+*/
+#include "session_cache.h"
+
+#include <openssl/crypto.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "logger.h"
+
+SessionCache::LockedKey::LockedKey(const Bytes& key) : len(key.getLen()) {
+    // the key gets its own anonymous pages, so locking and wiping does not touch other data
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    this->map_len = std::max<size_t>(1, (this->len + page_size - 1) / page_size) * page_size;
+    void* base = mmap(nullptr, this->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        PLOG_ERROR << "The pages for the session key could not be mapped";
+        throw std::runtime_error("The pages for the session key could not be mapped");
+    }
+    if (mlock(base, this->map_len) != 0) {
+        // the key would be written to the swap space (RLIMIT_MEMLOCK reached)
+        PLOG_ERROR << "The pages for the session key could not be locked";
+        munmap(base, this->map_len);
+        throw std::runtime_error("The pages for the session key could not be locked");
+    }
+    // core dumps do not contain the key (not supported by every kernel, the key is locked nevertheless)
+    if (madvise(base, this->map_len, MADV_DONTDUMP) != 0) PLOG_WARNING << "madvise failed on the session key pages";
+    this->data = static_cast<unsigned char*>(base);
+    if (this->len > 0) std::memcpy(this->data, key.getBytes(), this->len);
+}
+
+Bytes SessionCache::LockedKey::getKey() const {
+    // copies the key out of the locked pages
+    Bytes ret(this->len);
+    ret.addBytes(this->data, this->len);
+    return ret;
+}
+
+SessionCache::LockedKey::~LockedKey() {
+    // the key is wiped before the pages are unlocked and released
+    if (this->data == nullptr) return;
+    OPENSSL_cleanse(this->data, this->map_len);
+    munlock(this->data, this->map_len);
+    if (munmap(this->data, this->map_len) != 0) PLOG_ERROR << "munmap failed on the session key pages";
+}
+
+SessionCache::SessionCache(const u_int64_t idle_ttl, const u_int64_t max_ttl) noexcept : idle_ttl(idle_ttl), max_ttl(max_ttl) {}
+
+std::string SessionCache::getKeyPath(const std::filesystem::path& file) noexcept {
+    // the same vault can be given with different relative paths
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(file, ec);
+    if (ec) return file.string();
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(absolute, ec);
+    return ec ? absolute.lexically_normal().string() : canonical.string();
+}
+
+bool SessionCache::isExpired(const Entry& entry, const std::chrono::steady_clock::time_point now) const noexcept {
+    // an entry expires after the idle ttl without use or after the absolute ttl
+    return now - entry.last_used >= this->idle_ttl || now - entry.created >= this->max_ttl;
+}
+
+void SessionCache::removeExpired(const std::chrono::steady_clock::time_point now) noexcept {
+    // erases the expired entries, their keys are wiped by the LockedKey destructor
+    for (std::unordered_map<std::string, Entry>::iterator it = this->entries.begin(); it != this->entries.end();) {
+        if (this->isExpired(it->second, now))
+            it = this->entries.erase(it);
+        else
+            it++;
+    }
+}
+
+ErrorStruct<bool> SessionCache::store(const std::filesystem::path& file, const Bytes& validator, const Bytes& password_hash) noexcept {
+    // the key is copied into locked memory before the lock is taken
+    std::string key_path = SessionCache::getKeyPath(file);
+    Entry entry;
+    try {
+        entry.key = std::make_unique<LockedKey>(password_hash);
+        entry.validator = validator;
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The password hash could not be stored in the session cache (file_path: " << key_path << ", what: " << e.what() << ")";
+        return ErrorStruct<bool>{SuccessType::FAIL, ErrorCode::ERR_MEMORY_NOT_LOCKED, key_path, e.what()};
+    }
+    entry.created = std::chrono::steady_clock::now();
+    entry.last_used = entry.created;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->removeExpired(entry.created);
+    this->entries[key_path] = std::move(entry);
+    PLOG_DEBUG << "Session stored (file_path: " << key_path << ")";
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<Bytes> SessionCache::lookup(const std::filesystem::path& file, const Bytes& validator) noexcept {
+    // a hit refreshes the idle time, a stale entry (expired or other data header) is removed
+    std::string key_path = SessionCache::getKeyPath(file);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->removeExpired(now);
+    std::unordered_map<std::string, Entry>::iterator it = this->entries.find(key_path);
+    if (it == this->entries.end()) {
+        PLOG_DEBUG << "No session for the file (file_path: " << key_path << ")";
+        return ErrorStruct<Bytes>{SuccessType::FAIL, ErrorCode::ERR_SESSION_NOT_FOUND, key_path};
+    }
+    if (it->second.validator != validator) {
+        // the data header was replaced (e.g. a new password), the key does not belong to it
+        PLOG_WARNING << "The session does not belong to the data header of the file (file_path: " << key_path << ")";
+        this->entries.erase(it);
+        return ErrorStruct<Bytes>{SuccessType::FAIL, ErrorCode::ERR_SESSION_NOT_FOUND, key_path, "data header changed"};
+    }
+    try {
+        Bytes key = it->second.key->getKey();
+        it->second.last_used = now;
+        return ErrorStruct<Bytes>{key};
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The session key could not be read (file_path: " << key_path << ", what: " << e.what() << ")";
+        return ErrorStruct<Bytes>{SuccessType::FAIL, ErrorCode::ERR, key_path, e.what()};
+    }
+}
+
+void SessionCache::remove(const std::filesystem::path& file) noexcept {
+    // removes the entry, the key is wiped
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.erase(SessionCache::getKeyPath(file));
+}
+
+void SessionCache::rename(const std::filesystem::path& from, const std::filesystem::path& to) noexcept {
+    // the entry keeps its times, so a rename does not extend the ttl
+    std::string from_path = SessionCache::getKeyPath(from);
+    std::string to_path = SessionCache::getKeyPath(to);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::unordered_map<std::string, Entry>::iterator it = this->entries.find(from_path);
+    if (it == this->entries.end()) {
+        PLOG_DEBUG << "No session to rename (file_path: " << from_path << ")";
+        return;
+    }
+    Entry entry = std::move(it->second);
+    this->entries.erase(it);
+    this->entries[to_path] = std::move(entry);
+}
+
+void SessionCache::clear() noexcept {
+    // removes all entries, the keys are wiped
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.clear();
+}
+
+size_t SessionCache::size() noexcept {
+    // expired entries are removed before counting
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->removeExpired(std::chrono::steady_clock::now());
+    return this->entries.size();
+}
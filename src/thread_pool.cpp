@@ -0,0 +1,43 @@
+/*
+implementation of thread_pool.h
+*/
+#include "thread_pool.h"
+
+#include "logger.h"
+
+ThreadPool::ThreadPool(const size_t threads) {
+    // starts the worker threads
+    size_t count = threads;
+    if (count == 0) count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    this->workers.reserve(count);
+    for (size_t i = 0; i < count; i++) this->workers.emplace_back(&ThreadPool::work, this);
+    PLOG_VERBOSE << "created thread pool with " << count << " threads";
+}
+
+ThreadPool::~ThreadPool() {
+    // lets the workers finish the remaining tasks and joins them
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->condition.notify_all();
+    for (std::thread& worker : this->workers) worker.join();
+}
+
+size_t ThreadPool::getThreadCount() const noexcept { return this->workers.size(); }
+
+void ThreadPool::work() {
+    // takes the next task from the queue and runs it until the pool is stopping and no task is left
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->condition.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+            if (this->tasks.empty()) return;
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+        }
+        // exceptions are stored in the future of the task
+        task();
+    }
+}
@@ -3,6 +3,9 @@ contains implementations of utility functions from utility.h
 */
 #include "utility.h"
 
+#include <unistd.h>
+
+#include <cerrno>
 #include <cstring>
 #include <vector>
 
@@ -120,3 +123,27 @@ bool readData(std::istream& stream, unsigned char* data, const unsigned int& siz
         }
     }
 }
+
+size_t readDataAt(const int fd, unsigned char* data, const size_t size, const size_t offset) noexcept {
+    // pread can return less bytes than requested, so it is called until all bytes are read
+    size_t read = 0;
+    while (read < size) {
+        ssize_t ret = pread(fd, data + read, size - read, offset + read);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) break;
+        read += ret;
+    }
+    return read;
+}
+
+size_t writeDataAt(const int fd, const unsigned char* data, const size_t size, const size_t offset) noexcept {
+    // pwrite can write less bytes than requested, so it is called until all bytes are written
+    size_t written = 0;
+    while (written < size) {
+        ssize_t ret = pwrite(fd, data + written, size - written, offset + written);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) break;
+        written += ret;
+    }
+    return written;
+}
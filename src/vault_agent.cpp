@@ -0,0 +1,539 @@
+/*
+implements the VaultAgent and the AgentClient class
+*/
+#include "vault_agent.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger.h"
+#include "rotation_job.h"
+#include "settings.h"
+
+namespace {
+// the length of the prefix of every message
+const constexpr size_t LEN_PREFIX = 4;
+
+void putU32(unsigned char* dest, const u_int32_t value) noexcept {
+    // stores the value big endian
+    for (int i = 0; i < 4; i++) dest[i] = (value >> (24 - 8 * i)) & 0xFF;
+}
+
+u_int32_t getU32(const unsigned char* src) noexcept {
+    // reads a big endian value
+    return (u_int32_t(src[0]) << 24) | (u_int32_t(src[1]) << 16) | (u_int32_t(src[2]) << 8) | u_int32_t(src[3]);
+}
+
+void addString(Bytes& message, const std::string& str) {
+    // adds the string with its length byte
+    message.addByte(str.size());
+    message.addBytes(reinterpret_cast<const unsigned char*>(str.data()), str.size());
+}
+
+bool readString(const Bytes& message, size_t& pos, std::string& str) noexcept {
+    // reads a string with its length byte at pos and moves pos behind it
+    if (pos >= message.getLen() || message.getLen() - pos - 1 < message.getBytes()[pos]) return false;
+    size_t len = message.getBytes()[pos];
+    str.assign(reinterpret_cast<const char*>(message.getBytes() + pos + 1), len);
+    pos += 1 + len;
+    return true;
+}
+
+bool sendAll(const int fd, const unsigned char* data, size_t len) noexcept {
+    // sends all Bytes (a closed connection does not raise SIGPIPE)
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+bool receiveAll(const int fd, unsigned char* data, size_t len) noexcept {
+    // receives exactly len Bytes, fails if the connection is closed before
+    while (len > 0) {
+        ssize_t received = recv(fd, data, len, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        len -= received;
+    }
+    return true;
+}
+
+Bytes createMessage(const size_t body_len) {
+    // creates a message with space for the body, the length prefix is set by sendMessage
+    Bytes message(LEN_PREFIX + body_len);
+    message.setLen(LEN_PREFIX);
+    return message;
+}
+
+bool sendMessage(const int fd, Bytes& message) noexcept {
+    // sets the length prefix and sends the message with one send call
+    putU32(message.getBytes(), message.getLen() - LEN_PREFIX);
+    return sendAll(fd, message.getBytes(), message.getLen());
+}
+
+ErrorStruct<Bytes> receiveMessage(const int fd, const u_int32_t max_len) noexcept {
+    // receives one message (without the length prefix)
+    unsigned char prefix[LEN_PREFIX];
+    if (!receiveAll(fd, prefix, LEN_PREFIX)) return ErrorStruct<Bytes>{FAIL, ERR_SOCKET, "connection closed"};
+    u_int32_t len = getU32(prefix);
+    if (len == 0 || len > max_len) return ErrorStruct<Bytes>{FAIL, ERR_MESSAGE_INVALID, "message length " + std::to_string(len)};
+    try {
+        Bytes message(len);
+        if (!receiveAll(fd, message.getBytes(), len)) return ErrorStruct<Bytes>{FAIL, ERR_SOCKET, "connection closed"};
+        message.setLen(len);
+        return ErrorStruct<Bytes>{message};
+    } catch (const std::exception& e) {
+        return ErrorStruct<Bytes>{FAIL, ERR, "message could not be received", e.what()};
+    }
+}
+
+Bytes createResponse(const ErrorCode code, const std::vector<PasswordSet>& sets) {
+    // the error code, the number of sets and the sets
+    size_t len = 5;
+    for (const PasswordSet& set : sets) len += 4 + set.site.size() + set.username.size() + set.email.size() + set.password.size();
+    if (code == NO_ERR && len > AGENT_MAX_RESPONSE_LEN) return createResponse(ERR_MESSAGE_INVALID, {});
+    Bytes response = createMessage(len);
+    response.addByte(code);
+    unsigned char count[4];
+    putU32(count, sets.size());
+    response.addBytes(count, 4);
+    for (const PasswordSet& set : sets) {
+        addString(response, set.site);
+        addString(response, set.username);
+        addString(response, set.email);
+        addString(response, set.password);
+    }
+    return response;
+}
+
+bool fillSocketAddress(const std::filesystem::path& socket_path, sockaddr_un& addr) noexcept {
+    // the path has to fit into the address (with the terminating null byte)
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.native().size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.native().size());
+    return true;
+}
+}  // namespace
+
+VaultAgent::VaultAgent(const std::filesystem::path& vault_path, const std::filesystem::path& socket_path, const u_int64_t idle_ttl, const u_int64_t max_ttl) noexcept
+    : vault_path(vault_path), socket_path(socket_path), session_cache(std::make_shared<SessionCache>(idle_ttl, max_ttl)) {}
+
+ErrorStruct<bool> VaultAgent::openWriter() noexcept {
+    // the session was stored by the last verifyPassword or writeToFile of an API with the same session cache
+    this->writer = std::make_unique<API>(FILEMODE_PASSWORD, this->session_cache);
+    ErrorStruct<bool> err = this->writer->selectFile(this->vault_path);
+    if (err.isSuccess()) err = this->writer->unlockFromSession();
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The vault could not be opened for writing (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
+        this->writer.reset();
+    }
+    return err;
+}
+
+ErrorStruct<bool> VaultAgent::unlock(const std::string& password, const u_int64_t timeout) noexcept {
+    // decrypts the vault with one API and keeps a second API unlocked for the writes
+    if (this->running) {
+        PLOG_ERROR << "The agent is already running (unlock)";
+        return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "unlock is not available while the agent is running"};
+    }
+    API reader{FILEMODE_PASSWORD, this->session_cache};
+    ErrorStruct<bool> err = reader.selectFile(this->vault_path);
+    if (!err.isSuccess()) return err;
+    err = reader.verifyPassword(password, timeout);
+    if (!err.isSuccess()) return err;
+    ErrorStruct<std::unique_ptr<FileDataStruct>> err_data = reader.getDecryptedData();
+    if (!err_data.isSuccess()) return ErrorStruct<bool>{err_data.success, err_data.errorCode, err_data.errorInfo, err_data.what};
+    PasswordData password_data;
+    err = password_data.constructFileData(*err_data.returnRef());
+    if (!err.isSuccess()) return err;
+    err = this->openWriter();
+    if (!err.isSuccess()) return err;
+    std::unique_lock<std::shared_mutex> lock(this->data_mutex);
+    this->data = std::move(password_data);
+    this->unlocked = true;
+    PLOG_INFO << "Vault unlocked by the agent (vault_path: " << this->vault_path << ", sets: " << this->data.getSetCount() << ")";
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> VaultAgent::start() noexcept {
+    // the socket is only accessible by the user, the socket of an old agent is replaced if no agent answers on it
+    if (!this->unlocked) {
+        PLOG_ERROR << "The vault is not unlocked (start)";
+        return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "start is only available after a successful unlock"};
+    }
+    if (this->running) {
+        PLOG_ERROR << "The agent is already running (start)";
+        return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "start is not available while the agent is running"};
+    }
+    sockaddr_un addr;
+    if (!fillSocketAddress(this->socket_path, addr)) {
+        PLOG_ERROR << "The socket path is empty or too long (start) (socket_path: " << this->socket_path << ")";
+        return ErrorStruct<bool>{FAIL, ERR_FILEPATH_INVALID, this->socket_path.c_str()};
+    }
+    std::error_code ec;
+    if (std::filesystem::is_socket(this->socket_path, ec)) {
+        // only the socket of an agent that is not running anymore is replaced
+        int probe_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool answered = probe_fd >= 0 && connect(probe_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        int probe_errno = errno;
+        if (probe_fd >= 0) close(probe_fd);
+        if (answered || (probe_errno != ECONNREFUSED && probe_errno != ENOENT)) {
+            PLOG_ERROR << "Another agent is running on the socket (start) (socket_path: " << this->socket_path << ")";
+            return ErrorStruct<bool>{FAIL, ERR_SOCKET, this->socket_path.c_str(), "another agent is running on the socket"};
+        }
+        std::filesystem::remove(this->socket_path, ec);
+    }
+    this->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // the socket is created with mode 0600 by the umask, so no other user can connect between bind and chmod
+    // the umask is process wide, a file that another thread creates meanwhile only gets a stricter mode
+    bool bound = false;
+    if (this->listen_fd >= 0) {
+        mode_t old_umask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+        bound = bind(this->listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        umask(old_umask);
+    }
+    if (!bound || chmod(this->socket_path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(this->listen_fd, AGENT_BACKLOG) != 0) {
+        std::string what = std::strerror(errno);
+        PLOG_ERROR << "The agent socket could not be created (start) (socket_path: " << this->socket_path << ", what: " << what << ")";
+        if (this->listen_fd >= 0) close(this->listen_fd);
+        this->listen_fd = -1;
+        return ErrorStruct<bool>{FAIL, ERR_SOCKET, this->socket_path.c_str(), what};
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->write_mutex);
+        this->stop_writer = false;
+    }
+    this->running = true;
+    this->write_thread = std::thread(&VaultAgent::writeLoop, this);
+    this->accept_thread = std::thread(&VaultAgent::acceptLoop, this);
+    PLOG_INFO << "Agent started (socket_path: " << this->socket_path << ")";
+    return ErrorStruct<bool>{true};
+}
+
+void VaultAgent::acceptLoop() noexcept {
+    // finished clients are joined before a new client is added
+    while (this->running) {
+        int client_fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (!this->running) break;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            // out of file descriptors, the waiting clients are accepted later
+            PLOG_WARNING << "A client could not be accepted (what: " << std::strerror(errno) << ")";
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        // the mode of the socket is not trusted alone, a client of another user is disconnected
+        ucred cred;
+        socklen_t cred_len = sizeof(cred);
+        bool known = getsockopt(client_fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == 0 && cred_len == sizeof(cred);
+        if (!known || cred.uid != getuid()) {
+            PLOG_WARNING << "A client of another user was rejected (uid: " << (known ? std::to_string(cred.uid) : "unknown") << ")";
+            close(client_fd);
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(this->clients_mutex);
+        for (std::list<Client>::iterator it = this->clients.begin(); it != this->clients.end();) {
+            if (it->done) {
+                it->thread.join();
+                close(it->fd);
+                it = this->clients.erase(it);
+            } else
+                it++;
+        }
+        if (!this->running) {
+            close(client_fd);
+            break;
+        }
+        this->clients.emplace_back();
+        Client& client = this->clients.back();
+        client.fd = client_fd;
+        client.thread = std::thread(&VaultAgent::serveClient, this, &client);
+    }
+}
+
+void VaultAgent::serveClient(Client* client) noexcept {
+    // the connection is shut down here, the socket is closed by the thread that joins this one (so its number cannot be reused while stop shuts it down)
+    while (true) {
+        ErrorStruct<Bytes> err = receiveMessage(client->fd, AGENT_MAX_REQUEST_LEN);
+        if (!err.isSuccess()) {
+            if (err.errorCode != ERR_SOCKET) PLOG_WARNING << "Invalid request, the client is disconnected (errorInfo: " << err.errorInfo << ")";
+            break;
+        }
+        Bytes response = this->handleRequest(err.returnRef());
+        if (!sendMessage(client->fd, response)) break;
+    }
+    shutdown(client->fd, SHUT_RDWR);
+    client->done = true;
+}
+
+Bytes VaultAgent::handleRequest(const Bytes& request) noexcept {
+    // lookups share the data lock, an added set is queued for the writer while the data is locked (keeps the order of the sets)
+    try {
+        std::vector<std::string> fields;
+        size_t pos = 1;
+        while (pos < request.getLen()) {
+            std::string field;
+            if (!readString(request, pos, field)) return createResponse(ERR_MESSAGE_INVALID, {});
+            fields.push_back(std::move(field));
+        }
+        switch (request.getBytes()[0]) {
+            case AGENT_GET:
+                if (fields.size() == 1) {
+                    std::shared_lock<std::shared_mutex> lock(this->data_mutex);
+                    return createResponse(NO_ERR, this->data.getSiteSets(fields[0]));
+                }
+                break;
+
+            case AGENT_SEARCH:
+                if (fields.size() == 1) {
+                    std::shared_lock<std::shared_mutex> lock(this->data_mutex);
+                    return createResponse(NO_ERR, this->data.getSets(fields[0], true));
+                }
+                break;
+
+            case AGENT_ADD:
+                if (fields.size() == 4) {
+                    PasswordSet set{fields[0], fields[1], fields[2], fields[3]};
+                    std::unique_lock<std::shared_mutex> lock(this->data_mutex);
+                    this->data.addPw(set);
+                    std::lock_guard<std::mutex> write_lock(this->write_mutex);
+                    this->pending.push_back(std::move(set));
+                    this->write_cv.notify_all();
+                    return createResponse(NO_ERR, {});
+                }
+                break;
+        }
+        return createResponse(ERR_MESSAGE_INVALID, {});
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The request could not be handled (what: " << e.what() << ")";
+        return createResponse(ERR, {});
+    }
+}
+
+void VaultAgent::writeLoop() noexcept {
+    // waits AGENT_WRITE_DELAY after the first pending set, so the sets of many requests are written together
+    std::unique_lock<std::mutex> lock(this->write_mutex);
+    while (true) {
+        this->write_cv.wait(lock, [this] { return !this->pending.empty() || this->stop_writer; });
+        if (this->pending.empty()) break;
+        if (!this->stop_writer) this->write_cv.wait_for(lock, std::chrono::milliseconds(AGENT_WRITE_DELAY), [this] { return this->stop_writer; });
+        std::vector<PasswordSet> batch;
+        batch.swap(this->pending);
+        this->writing = true;
+        lock.unlock();
+        ErrorStruct<bool> err = this->writeSets(batch);
+        lock.lock();
+        this->writing = false;
+        if (err.isSuccess())
+            this->write_count++;
+        else {
+            this->failed_writes++;
+            this->write_error = err;
+            if (this->stop_writer) {
+                PLOG_FATAL << "The agent stops without writing " << batch.size() + this->pending.size() << " password sets";
+                this->pending.clear();
+            } else {
+                // the sets are written with the next batch
+                PLOG_ERROR << "The password sets could not be written, retrying (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ")";
+                this->pending.insert(this->pending.begin(), batch.begin(), batch.end());
+                this->write_cv.notify_all();
+                this->write_cv.wait_for(lock, std::chrono::milliseconds(AGENT_WRITE_DELAY), [this] { return this->stop_writer; });
+            }
+        }
+        this->write_cv.notify_all();
+    }
+}
+
+ErrorStruct<bool> VaultAgent::writeSets(const std::vector<PasswordSet>& sets) noexcept {
+    // the sets are appended to the encrypted content, only the last block and the trailer are written again
+    try {
+        if (this->writer == nullptr) {
+            ErrorStruct<bool> err = this->openWriter();
+            if (!err.isSuccess()) return err;
+        }
+        if (this->append_supported) {
+            size_t len = 0;
+            std::vector<Bytes> set_bytes;
+            for (const PasswordSet& set : sets) {
+                set_bytes.push_back(PasswordData::getSetBytes(set));
+                len += set_bytes.back().getLen();
+            }
+            Bytes data(len);
+            for (const Bytes& bytes : set_bytes) data.addBytes(bytes.getBytes(), bytes.getLen());
+            ErrorStruct<bool> err = this->writer->appendData(data);
+            if (err.isSuccess() || err.errorCode != ERR_APPEND_NOT_SUPPORTED) return err;
+            // the whole data is written from now on, it contains every set that was added so far
+            PLOG_WARNING << "The vault does not support appending, the agent writes the whole vault (vault_path: " << this->vault_path << ")";
+            this->append_supported = false;
+        }
+        return this->rewriteVault();
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while writing the password sets (what: " << e.what() << ")";
+        return ErrorStruct<bool>{FAIL, ERR, "Some error occurred while writing the password sets", e.what()};
+    }
+}
+
+ErrorStruct<bool> VaultAgent::rewriteVault() noexcept {
+    // the writer API moves to DECRYPTED (decrypts the old content) to encrypt the current data with a new salt
+    // the vault is not written in place, the new content is written to the temporary file of the RotationJob and renamed over the vault
+    // the API is finished after the write, a new writer is unlocked from the session that writeToFile stored (moved to the vault by the rename)
+    std::filesystem::path tmp_path = RotationJob::getTempPath(this->vault_path);
+    ErrorStruct<std::unique_ptr<FileDataStruct>> err_data = this->writer->getDecryptedData();
+    ErrorStruct<bool> err{err_data.success, err_data.errorCode, err_data.errorInfo, err_data.what};
+    if (err.isSuccess()) err = this->writer->changeSalt();
+    if (err.isSuccess()) {
+        std::unique_ptr<FileDataStruct> fds;
+        {
+            std::shared_lock<std::shared_mutex> lock(this->data_mutex);
+            fds = std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(this->data.getFileData().dec_data));
+        }
+        err = this->writer->encryptData(std::move(fds));
+    }
+    if (err.isSuccess()) err = RotationJob::replaceVault(*this->writer, this->vault_path);
+    // the writer is not unlocked anymore (finished or in some state of the failed write)
+    this->writer.reset();
+    if (!err.isSuccess()) {
+        // the vault is unchanged
+        this->session_cache->remove(tmp_path);
+        return err;
+    }
+    this->session_cache->rename(tmp_path, this->vault_path);
+    if (!this->openWriter().isSuccess()) PLOG_WARNING << "The vault could not be opened for the next write, it is opened again before the next write";
+    return err;
+}
+
+ErrorStruct<bool> VaultAgent::flush() noexcept {
+    // waits until the writer is idle, a write that fails while waiting ends the wait
+    std::unique_lock<std::mutex> lock(this->write_mutex);
+    u_int64_t failed = this->failed_writes;
+    this->write_cv.wait(lock, [this, failed] { return (this->pending.empty() && !this->writing) || this->failed_writes != failed; });
+    if (this->failed_writes != failed) return this->write_error;
+    return ErrorStruct<bool>{true};
+}
+
+void VaultAgent::stop() noexcept {
+    // the accept loop and the clients are woken up by shutting their sockets down
+    if (!this->running.exchange(false)) return;
+    shutdown(this->listen_fd, SHUT_RDWR);
+    this->accept_thread.join();
+    close(this->listen_fd);
+    this->listen_fd = -1;
+    std::error_code ec;
+    std::filesystem::remove(this->socket_path, ec);
+    {
+        std::lock_guard<std::mutex> lock(this->clients_mutex);
+        for (Client& client : this->clients) shutdown(client.fd, SHUT_RDWR);
+    }
+    for (Client& client : this->clients) {
+        client.thread.join();
+        close(client.fd);
+    }
+    this->clients.clear();
+    {
+        std::lock_guard<std::mutex> lock(this->write_mutex);
+        this->stop_writer = true;
+        this->write_cv.notify_all();
+    }
+    this->write_thread.join();
+    PLOG_INFO << "Agent stopped (socket_path: " << this->socket_path << ", writes: " << this->write_count << ")";
+}
+
+size_t VaultAgent::getSetCount() noexcept {
+    // counts the sets in memory (written or not)
+    std::shared_lock<std::shared_mutex> lock(this->data_mutex);
+    return this->data.getSetCount();
+}
+
+u_int64_t VaultAgent::getWriteCount() noexcept {
+    // one write can contain the sets of many requests
+    std::lock_guard<std::mutex> lock(this->write_mutex);
+    return this->write_count;
+}
+
+VaultAgent::~VaultAgent() {
+    // the pending sets are written before the agent is destroyed
+    this->stop();
+}
+
+AgentClient::AgentClient(const std::filesystem::path& socket_path) {
+    // connects to the socket of the agent
+    sockaddr_un addr;
+    if (!fillSocketAddress(socket_path, addr)) {
+        PLOG_ERROR << "The socket path is empty or too long (socket_path: " << socket_path << ")";
+        throw std::invalid_argument("The socket path is empty or too long");
+    }
+    this->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->fd < 0 || connect(this->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::string what = std::strerror(errno);
+        PLOG_ERROR << "Could not connect to the agent (socket_path: " << socket_path << ", what: " << what << ")";
+        if (this->fd >= 0) close(this->fd);
+        throw std::runtime_error("Could not connect to the agent: " + what);
+    }
+}
+
+ErrorStruct<std::vector<PasswordSet>> AgentClient::request(const AgentOp op, const std::vector<std::string>& fields) noexcept {
+    // the response holds the error code of the agent and the password sets
+    try {
+        size_t len = 1;
+        for (const std::string& field : fields) {
+            if (field.size() > 255) return ErrorStruct<std::vector<PasswordSet>>{FAIL, ERR_ARGUMENT_INVALID, "a string is longer than 255 Bytes"};
+            len += 1 + field.size();
+        }
+        Bytes message = createMessage(len);
+        message.addByte(op);
+        for (const std::string& field : fields) addString(message, field);
+        if (!sendMessage(this->fd, message)) return ErrorStruct<std::vector<PasswordSet>>{FAIL, ERR_SOCKET, "request could not be sent"};
+        ErrorStruct<Bytes> err = receiveMessage(this->fd, AGENT_MAX_RESPONSE_LEN);
+        if (!err.isSuccess()) return ErrorStruct<std::vector<PasswordSet>>{err.success, err.errorCode, err.errorInfo, err.what};
+        const Bytes& response = err.returnRef();
+        if (response.getLen() < 5) return ErrorStruct<std::vector<PasswordSet>>{FAIL, ERR_MESSAGE_INVALID, "response too short"};
+        ErrorCode code = ErrorCode(response.getBytes()[0]);
+        if (code != NO_ERR) return ErrorStruct<std::vector<PasswordSet>>{FAIL, code, "the agent could not execute the request"};
+        u_int32_t count = getU32(response.getBytes() + 1);
+        std::vector<PasswordSet> sets;
+        size_t pos = 5;
+        for (u_int32_t i = 0; i < count; i++) {
+            PasswordSet set;
+            if (!readString(response, pos, set.site) || !readString(response, pos, set.username) || !readString(response, pos, set.email) || !readString(response, pos, set.password))
+                return ErrorStruct<std::vector<PasswordSet>>{FAIL, ERR_MESSAGE_INVALID, "response too short"};
+            sets.push_back(std::move(set));
+        }
+        return ErrorStruct<std::vector<PasswordSet>>::createMove(std::move(sets));
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The request could not be sent to the agent (what: " << e.what() << ")";
+        return ErrorStruct<std::vector<PasswordSet>>{FAIL, ERR, "The request could not be sent to the agent", e.what()};
+    }
+}
+
+ErrorStruct<std::vector<PasswordSet>> AgentClient::get(const std::string& site) noexcept {
+    // exact match of the site
+    return this->request(AGENT_GET, {site});
+}
+
+ErrorStruct<std::vector<PasswordSet>> AgentClient::search(const std::string& substring) noexcept {
+    // the agent ignores the case of the substring
+    return this->request(AGENT_SEARCH, {substring});
+}
+
+ErrorStruct<bool> AgentClient::add(const PasswordSet& pwset) noexcept {
+    // the set is written to the vault by the agent in the background
+    ErrorStruct<std::vector<PasswordSet>> err = this->request(AGENT_ADD, {pwset.site, pwset.username, pwset.email, pwset.password});
+    if (!err.isSuccess()) return ErrorStruct<bool>{err.success, err.errorCode, err.errorInfo, err.what};
+    return ErrorStruct<bool>{true};
+}
+
+AgentClient::~AgentClient() {
+    // closes the connection, the agent ends the thread of this client
+    if (this->fd >= 0) close(this->fd);
+}
@@ -0,0 +1,306 @@
+/*
+implements the VaultAutosave class
+*/
+#include "vault_autosave.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "logger.h"
+#include "rotation_job.h"
+
+VaultAutosave::VaultAutosave(const std::filesystem::path& vault_path, const u_int64_t delay, const u_int64_t max_delay, const u_int64_t max_edits,
+                             const u_int64_t idle_ttl, const u_int64_t max_ttl) noexcept
+    : vault_path(vault_path),
+      delay(delay),
+      max_delay(std::max(delay, max_delay)),
+      max_edits(std::max<u_int64_t>(1, max_edits)),
+      session_cache(std::make_shared<SessionCache>(idle_ttl, max_ttl)) {}
+
+ErrorStruct<bool> VaultAutosave::openWriter() noexcept {
+    // the session was stored by the last verifyPassword or writeToFile of an API with the same session cache
+    this->writer = std::make_unique<API>(FILEMODE_PASSWORD, this->session_cache);
+    ErrorStruct<bool> err = this->writer->selectFile(this->vault_path);
+    if (err.isSuccess()) err = this->writer->unlockFromSession();
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The vault could not be opened for writing (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ", what: " << err.what << ")";
+        this->writer.reset();
+    }
+    return err;
+}
+
+ErrorStruct<bool> VaultAutosave::unlock(const std::string& password, const u_int64_t timeout) noexcept {
+    // decrypts the vault with one API and keeps a second API unlocked for the writes
+    // the unlock mutex is held until the writer thread runs, so a second unlock (or a close) waits and sees the unlocked vault
+    std::lock_guard<std::mutex> unlock_lock(this->unlock_mutex);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->unlocked) {
+            PLOG_ERROR << "The vault is already unlocked (unlock)";
+            return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "unlock is not available while the vault is unlocked"};
+        }
+    }
+    API reader{FILEMODE_PASSWORD, this->session_cache};
+    ErrorStruct<bool> err = reader.selectFile(this->vault_path);
+    if (!err.isSuccess()) return err;
+    err = reader.verifyPassword(password, timeout);
+    if (!err.isSuccess()) return err;
+    ErrorStruct<std::unique_ptr<FileDataStruct>> err_data = reader.getDecryptedData();
+    if (!err_data.isSuccess()) return ErrorStruct<bool>{err_data.success, err_data.errorCode, err_data.errorInfo, err_data.what};
+    PasswordData password_data;
+    err = password_data.constructFileData(*err_data.returnRef());
+    if (!err.isSuccess()) return err;
+    err = this->openWriter();
+    if (!err.isSuccess()) return err;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->data = std::move(password_data);
+    this->added.clear();
+    this->rewrite = false;
+    this->edits = 0;
+    this->written_edits = this->edit_count;
+    this->flush_requested = false;
+    this->stop_writer = false;
+    this->unlocked = true;
+    this->write_thread = std::thread(&VaultAutosave::writeLoop, this);
+    PLOG_INFO << "Vault unlocked for autosave (vault_path: " << this->vault_path << ", sets: " << this->data.getSetCount() << ")";
+    return ErrorStruct<bool>{true};
+}
+
+void VaultAutosave::markEdit() noexcept {
+    // the first unwritten edit starts the max_delay, every edit restarts the delay
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (this->edits == 0) this->first_edit = now;
+    this->last_edit = now;
+    this->edits++;
+    this->edit_count++;
+    this->cv.notify_all();
+}
+
+ErrorStruct<bool> VaultAutosave::addPw(const PasswordSet& pwset) noexcept {
+    // the set is appended by the next write, unless the whole data is written anyway
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->unlocked) return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "addPw is only available after a successful unlock"};
+    if (!pwset.isValid()) return ErrorStruct<bool>{FAIL, ERR_ARGUMENT_INVALID, "The password set is not valid (at least one datapoint is too long)"};
+    this->data.addPw(pwset);
+    if (!this->rewrite) this->added.push_back(pwset);
+    this->markEdit();
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> VaultAutosave::remPw(const PasswordSet& pwset) noexcept {
+    // a set that is not written yet is only removed from the pending sets, a written set requires a rewrite
+    // sets with the same strings are equal, so it does not matter which one of them is removed
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->unlocked) return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "remPw is only available after a successful unlock"};
+    if (!this->data.remPw(pwset)) return ErrorStruct<bool>{FAIL, ERR_ARGUMENT_INVALID, "The password set is not stored"};
+    if (!this->rewrite) {
+        std::vector<PasswordSet>::iterator it = std::find_if(this->added.begin(), this->added.end(), [&pwset](const PasswordSet& set) {
+            return set.site == pwset.site && set.username == pwset.username && set.email == pwset.email && set.password == pwset.password;
+        });
+        if (it != this->added.end()) {
+            this->added.erase(it);
+        } else {
+            this->rewrite = true;
+            this->added.clear();
+        }
+    }
+    this->markEdit();
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> VaultAutosave::editPw(const PasswordSet& pwset) noexcept {
+    // the data edits the first set with the site and the username, it is pending if no written set of the site has the username
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->unlocked) return ErrorStruct<bool>{FAIL, ERR_API_STATE_INVALID, "editPw is only available after a successful unlock"};
+    if (!pwset.isValid()) return ErrorStruct<bool>{FAIL, ERR_ARGUMENT_INVALID, "The password set is not valid (at least one datapoint is too long)"};
+    std::vector<PasswordSet> site_sets = this->data.getSiteSets(pwset.site);
+    std::function<bool(const PasswordSet&)> same_user = [&pwset](const PasswordSet& set) { return set.site == pwset.site && set.username == pwset.username; };
+    size_t stored = std::count_if(site_sets.begin(), site_sets.end(), same_user);
+    if (stored == 0 || !this->data.editPw(pwset)) return ErrorStruct<bool>{FAIL, ERR_ARGUMENT_INVALID, "No password set of the site has the username"};
+    if (!this->rewrite) {
+        std::vector<PasswordSet>::iterator it = std::find_if(this->added.begin(), this->added.end(), same_user);
+        if (stored == static_cast<size_t>(std::count_if(this->added.begin(), this->added.end(), same_user))) {
+            // every set with the username is pending, the first one of them was edited
+            it->email = pwset.email;
+            it->password = pwset.password;
+        } else {
+            this->rewrite = true;
+            this->added.clear();
+        }
+    }
+    this->markEdit();
+    return ErrorStruct<bool>{true};
+}
+
+std::vector<PasswordSet> VaultAutosave::getSets(const std::string& substring, const bool sorted) noexcept {
+    // the data contains the unwritten edits
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->data.getSets(substring, sorted);
+}
+
+std::vector<PasswordSet> VaultAutosave::getSiteSets(const std::string& site) noexcept {
+    // the data contains the unwritten edits
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->data.getSiteSets(site);
+}
+
+size_t VaultAutosave::getSetCount() noexcept {
+    // counts the sets in memory (written or not)
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->data.getSetCount();
+}
+
+void VaultAutosave::writeLoop() noexcept {
+    // waits until the edits stop for delay ms (or max_delay, max_edits, a flush or the stop), so the edits of a burst are written together
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->cv.wait(lock, [this] { return this->edits != 0 || this->stop_writer; });
+        if (this->edits == 0) break;
+        while (!this->stop_writer && !this->flush_requested && this->edits < this->max_edits) {
+            std::chrono::steady_clock::time_point deadline =
+                std::min(this->last_edit + std::chrono::milliseconds(this->delay), this->first_edit + std::chrono::milliseconds(this->max_delay));
+            if (std::chrono::steady_clock::now() >= deadline) break;
+            this->cv.wait_until(lock, deadline);
+        }
+        // the batch is taken while the data is locked, the write runs without the lock
+        u_int64_t batch_edits = this->edits;
+        u_int64_t batch_end = this->edit_count;
+        bool batch_rewrite = this->rewrite || (!this->append_supported && !this->added.empty());
+        std::vector<PasswordSet> batch;
+        batch.swap(this->added);
+        std::unique_ptr<FileDataStruct> fds;
+        if (batch_rewrite) fds = std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::move(this->data.getFileData().dec_data));
+        this->rewrite = false;
+        this->edits = 0;
+        this->flush_requested = false;
+        lock.unlock();
+        ErrorStruct<bool> err{true};
+        if (batch_rewrite)
+            err = this->rewriteVault(std::move(fds));
+        else if (!batch.empty())
+            err = this->appendSets(batch);
+        lock.lock();
+        if (err.isSuccess()) {
+            if (batch_rewrite || !batch.empty()) this->write_count++;
+            this->written_edits = batch_end;
+        } else {
+            // the data in memory contains every edit, so the next write is a rewrite
+            this->rewrite = true;
+            this->added.clear();
+            this->edits += batch_edits;
+            if (err.errorCode == ERR_APPEND_NOT_SUPPORTED) {
+                PLOG_WARNING << "The vault does not support appending, every write rewrites the vault (vault_path: " << this->vault_path << ")";
+                this->append_supported = false;
+                this->flush_requested = true;
+                continue;
+            }
+            this->failed_writes++;
+            this->write_error = err;
+            if (this->stop_writer) {
+                PLOG_FATAL << "The autosave stops without writing " << this->edits << " edits";
+                this->edits = 0;
+                this->rewrite = false;
+            } else {
+                PLOG_ERROR << "The edits could not be written, retrying (errorCode: " << +err.errorCode << ", errorInfo: " << err.errorInfo << ")";
+                this->cv.notify_all();
+                this->cv.wait_for(lock, std::chrono::milliseconds(std::max<u_int64_t>(1, this->delay)), [this] { return this->stop_writer; });
+            }
+        }
+        this->cv.notify_all();
+    }
+}
+
+ErrorStruct<bool> VaultAutosave::appendSets(const std::vector<PasswordSet>& sets) noexcept {
+    // the sets of the batch are appended with one appendData, only the last block and the trailer are written again
+    try {
+        if (this->writer == nullptr) {
+            ErrorStruct<bool> err = this->openWriter();
+            if (!err.isSuccess()) return err;
+        }
+        size_t len = 0;
+        std::vector<Bytes> set_bytes;
+        for (const PasswordSet& set : sets) {
+            set_bytes.push_back(PasswordData::getSetBytes(set));
+            len += set_bytes.back().getLen();
+        }
+        Bytes data(len);
+        for (const Bytes& bytes : set_bytes) data.addBytes(bytes.getBytes(), bytes.getLen());
+        return this->writer->appendData(data);
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "Some error occurred while appending the password sets (what: " << e.what() << ")";
+        return ErrorStruct<bool>{FAIL, ERR, "Some error occurred while appending the password sets", e.what()};
+    }
+}
+
+ErrorStruct<bool> VaultAutosave::rewriteVault(std::unique_ptr<FileDataStruct>&& fds) noexcept {
+    // the writer API moves to DECRYPTED (decrypts the old content) to encrypt the current data with a new salt
+    // the vault is not written in place, the new content is written to the temporary file of the RotationJob and renamed over the vault
+    // the API is finished after the write, a new writer is unlocked from the session that writeToFile stored (moved to the vault by the rename)
+    if (this->writer == nullptr) {
+        ErrorStruct<bool> err = this->openWriter();
+        if (!err.isSuccess()) return err;
+    }
+    std::filesystem::path tmp_path = RotationJob::getTempPath(this->vault_path);
+    ErrorStruct<std::unique_ptr<FileDataStruct>> err_data = this->writer->getDecryptedData();
+    ErrorStruct<bool> err{err_data.success, err_data.errorCode, err_data.errorInfo, err_data.what};
+    if (err.isSuccess()) err = this->writer->changeSalt();
+    if (err.isSuccess()) err = this->writer->encryptData(std::move(fds));
+    if (err.isSuccess()) err = RotationJob::replaceVault(*this->writer, this->vault_path);
+    // the writer is not unlocked anymore (finished or in some state of the failed write)
+    this->writer.reset();
+    if (!err.isSuccess()) {
+        // the vault is unchanged
+        this->session_cache->remove(tmp_path);
+        return err;
+    }
+    this->session_cache->rename(tmp_path, this->vault_path);
+    if (!this->openWriter().isSuccess()) PLOG_WARNING << "The vault could not be opened for the next write, it is opened again before the next write";
+    return err;
+}
+
+ErrorStruct<bool> VaultAutosave::flush() noexcept {
+    // the writer skips the delay, a write that fails while waiting ends the wait
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (!this->unlocked) return ErrorStruct<bool>{true};
+    u_int64_t target = this->edit_count;
+    u_int64_t failed = this->failed_writes;
+    this->flush_requested = true;
+    this->cv.notify_all();
+    this->cv.wait(lock, [this, target, failed] { return this->written_edits >= target || this->failed_writes != failed; });
+    if (this->failed_writes != failed) return this->write_error;
+    return ErrorStruct<bool>{true};
+}
+
+ErrorStruct<bool> VaultAutosave::close() noexcept {
+    // the writer thread writes the unwritten edits before it stops
+    std::lock_guard<std::mutex> unlock_lock(this->unlock_mutex);
+    ErrorStruct<bool> err = this->flush();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->unlocked) return err;
+        this->stop_writer = true;
+        this->unlocked = false;
+        this->cv.notify_all();
+    }
+    this->write_thread.join();
+    this->writer.reset();
+    PLOG_INFO << "Autosave closed (vault_path: " << this->vault_path << ", edits: " << this->edit_count << ", writes: " << this->write_count << ")";
+    return err;
+}
+
+u_int64_t VaultAutosave::getWriteCount() noexcept {
+    // one write can contain many edits
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->write_count;
+}
+
+u_int64_t VaultAutosave::getEditCount() noexcept {
+    // counts the edits of all unlocks
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->edit_count;
+}
+
+VaultAutosave::~VaultAutosave() {
+    // the unwritten edits are written before the autosave is destroyed
+    this->close();
+}
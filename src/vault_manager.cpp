@@ -0,0 +1,165 @@
+/*
+implements the VaultSession and the VaultManager class
+*/
+#include "vault_manager.h"
+
+#include <unordered_map>
+
+#include "hash_modes.h"
+#include "logger.h"
+
+VaultSession::VaultSession(const std::filesystem::path& path, const FModes file_mode, std::shared_ptr<VaultPoolHandle> pool, std::shared_ptr<SessionCache> session_cache)
+    : path(path), api(file_mode, session_cache), pool(pool) {}
+
+std::filesystem::path VaultSession::getPath() const noexcept {
+    // the path is constant, no lock is needed
+    return this->path;
+}
+
+void VaultSession::drain() noexcept {
+    // runs on a worker of the pool, only one drain task per session exists at a time (guarded by the scheduled flag)
+    while (true) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->queue.empty()) {
+                this->scheduled = false;
+                return;
+            }
+            task = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+        // the packaged task stores a thrown exception in its future
+        task();
+    }
+}
+
+std::future<ErrorStruct<bool>> VaultSession::verifyPassword(const std::string& password, const u_int64_t timeout, std::shared_ptr<ChainHashControl> control) {
+    // the password is copied into the task, the task keeps the control alive (the API returns ERR_CANCELLED if it was cancelled while queued)
+    return this->call([password, timeout, control](API& api) { return api.verifyPassword(password, timeout, control.get()); });
+}
+
+std::future<ErrorStruct<bool>> VaultSession::createDataHeader(const std::string& password, const DataHeaderSettingsIters& ds, const u_int64_t timeout,
+                                                             std::shared_ptr<ChainHashControl> control) {
+    // the password and the settings are copied into the task, the task keeps the control alive
+    return this->call([password, ds, timeout, control](API& api) { return api.createDataHeader(password, ds, timeout, control.get()); });
+}
+
+std::future<ErrorStruct<std::unique_ptr<FileDataStruct>>> VaultSession::getDecryptedData() {
+    // the decrypted data is moved into the future
+    return this->call([](API& api) { return api.getDecryptedData(); });
+}
+
+std::future<ErrorStruct<bool>> VaultSession::encryptData(std::unique_ptr<FileDataStruct>&& file_data) {
+    // the file data is owned by the task until it runs (a std::function has to be copyable, so it is held by a shared_ptr)
+    std::shared_ptr<std::unique_ptr<FileDataStruct>> data = std::make_shared<std::unique_ptr<FileDataStruct>>(std::move(file_data));
+    return this->call([data](API& api) { return api.encryptData(std::move(*data)); });
+}
+
+std::future<ErrorStruct<bool>> VaultSession::writeToFile() {
+    // writes the encrypted data to the selected vault
+    return this->call([](API& api) { return api.writeToFile(); });
+}
+
+VaultManager::VaultManager(const size_t threads, std::shared_ptr<SessionCache> session_cache)
+    : pool(std::make_unique<ThreadPool>(threads)), handle(std::make_shared<VaultPoolHandle>()), session_cache(session_cache) {
+    this->handle->pool = this->pool.get();
+}
+
+ErrorStruct<std::shared_ptr<VaultSession>> VaultManager::open(const std::filesystem::path& file, const FModes file_mode, const bool create) noexcept {
+    // selecting a vault only reads its data header, so it is done on the calling thread
+    std::shared_ptr<VaultSession> session;
+    try {
+        session = std::make_shared<VaultSession>(file, file_mode, this->handle, this->session_cache);
+    } catch (const std::exception& e) {
+        PLOG_ERROR << "The vault session could not be created (file_path: " << file << ", what: " << e.what() << ")";
+        return ErrorStruct<std::shared_ptr<VaultSession>>{FAIL, ERR, file.string(), e.what()};
+    }
+    if (create) {
+        ErrorStruct<bool> err = session->api.createFile(file);
+        if (!err.isSuccess()) {
+            PLOG_ERROR << "The vault could not be created (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+            return ErrorStruct<std::shared_ptr<VaultSession>>{err.success, err.errorCode, err.errorInfo, err.what};
+        }
+    }
+    ErrorStruct<bool> err = session->api.selectFile(file);
+    if (!err.isSuccess()) {
+        PLOG_ERROR << "The vault could not be selected (file_path: " << file << ", errorCode: " << +err.errorCode << ", what: " << err.what << ")";
+        return ErrorStruct<std::shared_ptr<VaultSession>>{err.success, err.errorCode, err.errorInfo, err.what};
+    }
+    return ErrorStruct<std::shared_ptr<VaultSession>>{session};
+}
+
+std::vector<ErrorStruct<bool>> VaultManager::unlockAll(const std::vector<std::shared_ptr<VaultSession>>& sessions, const std::string& password) {
+    // the settings are read in the queues of the sessions, so calls that were made before are done first
+    std::vector<std::future<ErrorStruct<PasswordHashSettings>>> settings_futures;
+    for (const std::shared_ptr<VaultSession>& session : sessions) settings_futures.push_back(session->call([](API& api) { return api.getPasswordHashSettings(); }));
+    std::vector<ErrorStruct<bool>> results(sessions.size(), ErrorStruct<bool>{FAIL, ERR, "not verified"});
+    std::vector<std::string> keys;                                   // the keys of the groups in the order they were found
+    std::unordered_map<std::string, std::vector<size_t>> groups;     // the indices of the sessions by the key of their settings
+    std::unordered_map<std::string, PasswordHashSettings> settings;  // the settings of every group
+    for (size_t i = 0; i < sessions.size(); i++) {
+        ErrorStruct<PasswordHashSettings> err = settings_futures[i].get();
+        if (!err.isSuccess()) {
+            results[i] = ErrorStruct<bool>{err.success, err.errorCode, err.errorInfo, err.what};
+            continue;
+        }
+        std::string key = err.returnRef().getKey();
+        if (groups.find(key) == groups.end()) {
+            keys.push_back(key);
+            settings[key] = err.returnRef();
+        }
+        groups[key].push_back(i);
+    }
+    PLOG_VERBOSE << "Unlocking vaults (sessions: " << sessions.size() << ", groups: " << keys.size() << ")";
+    // one first chainhash per group, the groups run in parallel
+    if (this->pool == nullptr) throw std::logic_error("the vault manager was shut down");
+    std::vector<std::future<ErrorStruct<Bytes>>> hashes;
+    for (const std::string& key : keys) {
+        hashes.push_back(this->pool->submit([group_settings = settings[key], password]() {
+            try {
+                return ChainHashModes::performChainHash(group_settings.chainhash1, HashModes::getHash(group_settings.hash_mode), password);
+            } catch (const std::exception& e) {
+                PLOG_ERROR << "The first chainhash failed (unlockAll) (what: " << e.what() << ")";
+                return ErrorStruct<Bytes>{FAIL, ERR, "The first chainhash failed", e.what()};
+            }
+        }));
+    }
+    // the second chainhashes run in the queues of the sessions, a group is queued as soon as its password hash is ready
+    std::vector<std::future<ErrorStruct<bool>>> checks(sessions.size());
+    for (size_t g = 0; g < keys.size(); g++) {
+        ErrorStruct<Bytes> hash = hashes[g].get();
+        for (size_t i : groups[keys[g]]) {
+            if (!hash.isSuccess())
+                results[i] = ErrorStruct<bool>{hash.success, hash.errorCode, hash.errorInfo, hash.what};
+            else
+                checks[i] = sessions[i]->call([password_hash = hash.returnRef()](API& api) { return api.verifyPasswordHash(password_hash); });
+        }
+    }
+    for (size_t i = 0; i < sessions.size(); i++) {
+        if (checks[i].valid()) results[i] = checks[i].get();
+    }
+    return results;
+}
+
+void VaultManager::shutdown() noexcept {
+    // the sessions lose the pool first, so no call submits a task to the stopping pool and no worker ever holds the pool
+    {
+        std::unique_lock<std::shared_mutex> lock(this->handle->mutex);
+        this->handle->pool = nullptr;
+    }
+    // the pool waits for the queued calls and joins the workers on this thread
+    // a drain task runs the calls that are queued while it runs, so no call is lost
+    this->pool.reset();
+}
+
+size_t VaultManager::getThreadCount() const noexcept {
+    // the pool is created by the constructor and destroyed by the shutdown
+    if (this->pool == nullptr) return 0;
+    return this->pool->getThreadCount();
+}
+
+VaultManager::~VaultManager() {
+    // the pool is joined before the members are destroyed
+    this->shutdown();
+}
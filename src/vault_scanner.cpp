@@ -0,0 +1,197 @@
+/*
+implements the VaultScanner class
+*/
+#include "vault_scanner.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <sstream>
+
+#include "dataheader.h"
+#include "file_modes.h"
+#include "filehandler.h"
+#include "hash_modes.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include "utility.h"
+
+const std::string VaultScanner::cache_name = ".pman_scan_cache";
+
+namespace {
+// the first line of the cache file, the cache is ignored if the format changes
+const std::string CACHE_VERSION = "pman-scan-cache 1";
+}  // namespace
+
+VaultInfo VaultScanner::readPrefix(const std::filesystem::path& file, const u_int64_t file_size) noexcept {
+    // reads the file size, the header size, the file mode and the hash mode with one pread
+    VaultInfo info;
+    info.file_name = file.filename().string();
+    if (file_size == 0) {
+        // a new file without a data header
+        info.empty = true;
+        info.valid = true;
+        return info;
+    }
+    unsigned char prefix[HEADER_PREFIX_LEN];
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PLOG_WARNING << "The file could not be opened to read the header prefix (file_path: " << file << ")";
+        return info;
+    }
+    size_t read = readDataAt(fd, prefix, HEADER_PREFIX_LEN, 0);
+    close(fd);
+    if (read != HEADER_PREFIX_LEN) {
+        PLOG_WARNING << "The file is too small to contain a data header (file_path: " << file << ")";
+        return info;
+    }
+    ErrorStruct<u_int64_t> err = DataHeader::checkHeaderPrefix(prefix, file_size);
+    if (!err.isSuccess()) {
+        PLOG_WARNING << "The header prefix does not match with the file (file_path: " << file << ", errorInfo: " << err.errorInfo << ")";
+        return info;
+    }
+    info.header_size = err.returnValue();
+    info.file_mode = prefix[16];
+    info.hash_mode = prefix[17];
+    info.valid = FileModes::isModeValid(FModes(info.file_mode)) && HashModes::isModeValid(HModes(info.hash_mode));
+    return info;
+}
+
+VaultScanner::VaultScanner(const std::filesystem::path& dir, const size_t threads) noexcept : dir(dir), threads(threads) {}
+
+void VaultScanner::loadCache() noexcept {
+    // every line stores: inode size mtime empty valid header_size file_mode hash_mode name
+    this->cache.clear();
+    std::ifstream file(this->dir / VaultScanner::cache_name);
+    std::string line;
+    if (!file || !std::getline(file, line) || line != CACHE_VERSION) return;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        CacheEntry entry;
+        int empty, valid, file_mode, hash_mode;
+        if (!(stream >> entry.inode >> entry.size >> entry.mtime >> empty >> valid >> entry.info.header_size >> file_mode >> hash_mode) || stream.get() != ' ' ||
+            !std::getline(stream, entry.info.file_name) || entry.info.file_name.empty()) {
+            // the cache is broken, every file is read again
+            PLOG_WARNING << "The scan cache is broken and is ignored (dir: " << this->dir << ")";
+            this->cache.clear();
+            return;
+        }
+        entry.info.empty = empty != 0;
+        entry.info.valid = valid != 0;
+        entry.info.file_mode = file_mode;
+        entry.info.hash_mode = hash_mode;
+        this->cache[entry.info.file_name] = entry;
+    }
+}
+
+void VaultScanner::storeCache() const noexcept {
+    // writes a unique temporary file first, so a reader never sees a partially written cache and concurrent scans do not share a temporary file
+    std::filesystem::path path = this->dir / VaultScanner::cache_name;
+    std::ostringstream content;
+    content << CACHE_VERSION << "\n";
+    for (const std::pair<const std::string, CacheEntry>& pair : this->cache) {
+        const CacheEntry& entry = pair.second;
+        if (entry.info.file_name.find('\n') != std::string::npos) continue;  // cannot be stored in one line
+        content << entry.inode << " " << entry.size << " " << entry.mtime << " " << entry.info.empty << " " << entry.info.valid << " " << entry.info.header_size << " "
+                << +entry.info.file_mode << " " << +entry.info.hash_mode << " " << entry.info.file_name << "\n";
+    }
+    const std::string data = content.str();
+    std::string tmp_name = (this->dir / (VaultScanner::cache_name + ".XXXXXX")).string();
+    int fd = mkstemp(tmp_name.data());
+    if (fd < 0) {
+        PLOG_WARNING << "The scan cache could not be written (dir: " << this->dir << ")";
+        return;
+    }
+    bool written = writeDataAt(fd, reinterpret_cast<const unsigned char*>(data.data()), data.size(), 0) == data.size();
+    if (close(fd) != 0) written = false;
+    std::error_code ec;
+    if (!written) {
+        PLOG_WARNING << "The scan cache could not be written (dir: " << this->dir << ")";
+        std::filesystem::remove(tmp_name, ec);
+        return;
+    }
+    std::filesystem::rename(tmp_name, path, ec);
+    if (ec) {
+        PLOG_WARNING << "The scan cache could not be replaced (dir: " << this->dir << ", what: " << ec.message() << ")";
+        std::filesystem::remove(tmp_name, ec);
+    }
+}
+
+ErrorStruct<std::vector<VaultInfo>> VaultScanner::scan() noexcept {
+    // stats every encryption file, only files that are not in the cache (or changed) are read on the thread pool
+    ErrorStruct<std::vector<VaultInfo>> err{SuccessType::FAIL, ErrorCode::ERR_FILEPATH_INVALID, this->dir.c_str()};
+    if (this->dir.empty()) {
+        PLOG_ERROR << "The given path is empty (scan)";
+        err.errorCode = ErrorCode::ERR_EMPTY_FILEPATH;
+        return err;
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_directory(this->dir, ec)) {
+        PLOG_ERROR << "The given path is not a directory (scan) (dir: " << this->dir << ")";
+        return err;
+    }
+    this->loadCache();
+    std::vector<CacheEntry> entries;
+    std::vector<size_t> changed;  // indices of the entries that have to be read
+    for (std::filesystem::directory_iterator it(this->dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::filesystem::path& path = it->path();
+        if (path.extension() != FileHandler::extension) continue;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        CacheEntry entry;
+        entry.inode = st.st_ino;
+        entry.size = st.st_size;
+        entry.mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        entry.info.file_name = path.filename().string();
+        std::unordered_map<std::string, CacheEntry>::const_iterator cached = this->cache.find(entry.info.file_name);
+        if (cached != this->cache.end() && cached->second.inode == entry.inode && cached->second.size == entry.size && cached->second.mtime == entry.mtime)
+            entry.info = cached->second.info;
+        else
+            changed.push_back(entries.size());
+        entries.push_back(entry);
+    }
+    if (ec) {
+        PLOG_ERROR << "The directory could not be read (scan) (dir: " << this->dir << ", what: " << ec.message() << ")";
+        err.errorCode = ErrorCode::ERR_FILE_READ;
+        err.what = ec.message();
+        return err;
+    }
+    this->read_count = changed.size();
+    if (!changed.empty()) {
+        try {
+            size_t used_threads = this->threads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : this->threads;
+            ThreadPool pool(std::min<size_t>(changed.size(), used_threads));
+            std::vector<std::future<VaultInfo>> results;
+            for (size_t index : changed) {
+                std::filesystem::path path = this->dir / entries[index].info.file_name;
+                u_int64_t size = entries[index].size;
+                results.push_back(pool.submit([path, size]() { return VaultScanner::readPrefix(path, size); }));
+            }
+            for (size_t i = 0; i < changed.size(); i++) entries[changed[i]].info = results[i].get();
+        } catch (const std::exception& ex) {
+            PLOG_ERROR << "The header prefixes could not be read (scan) (dir: " << this->dir << ", what: " << ex.what() << ")";
+            err.errorCode = ErrorCode::ERR;
+            err.what = ex.what();
+            return err;
+        }
+    }
+    // the cache only has to be written if a file was added, changed or removed
+    bool store = !changed.empty() || entries.size() != this->cache.size();
+    this->cache.clear();
+    std::vector<VaultInfo> infos;
+    infos.reserve(entries.size());
+    for (const CacheEntry& entry : entries) {
+        this->cache[entry.info.file_name] = entry;
+        infos.push_back(entry.info);
+    }
+    if (store) this->storeCache();
+    std::sort(infos.begin(), infos.end(), [](const VaultInfo& a, const VaultInfo& b) { return a.file_name < b.file_name; });
+    return ErrorStruct<std::vector<VaultInfo>>{infos};
+}
+
+size_t VaultScanner::getReadCount() const noexcept { return this->read_count; }
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "aead_chain.h"
+#include "settings.h"
+#include "sha256.h"
+#include "sha512.h"
+
+TEST(AEADChainClass, roundtrip) {
+    // encrypts and decrypts data of different lengths with both cipher modes
+    const size_t chunk_len = 100;
+    Bytes key(32);
+    key.fillrandom();
+    for (CModes cipher_mode : {CIPHERMODE_AES256GCM, CIPHERMODE_CHACHA20POLY1305}) {
+        for (size_t len : {0, 1, 99, 100, 101, 250, 1000}) {
+            Bytes data(len);
+            data.fillrandom();
+            EncryptAEADChain eac{cipher_mode, key, chunk_len};
+            // add the data in parts that do not match with the chunks
+            eac.addData(data.getBytes(), len / 3);
+            eac.addData(data.getBytes() + len / 3, len - len / 3);
+            std::unique_ptr<Bytes> encrypted = eac.getResult();
+            EXPECT_EQ(encrypted->getLen(), AEADChain::getEncryptedLen(len, chunk_len));
+            EXPECT_EQ(AEADChain::getDecryptedLen(encrypted->getLen(), chunk_len), len);
+            DecryptAEADChain dac{cipher_mode, key, chunk_len};
+            dac.addData(*encrypted);
+            EXPECT_EQ(*dac.getResult(), data);
+        }
+    }
+}
+
+TEST(AEADChainClass, chunks) {
+    // decrypts a part of the chunks with a chain that starts at a later chunk
+    const size_t chunk_len = 64;
+    Bytes key(32);
+    key.fillrandom();
+    Bytes data(64 * 10);
+    data.fillrandom();
+    EncryptAEADChain eac{CIPHERMODE_AES256GCM, key, chunk_len};
+    eac.addData(data);
+    std::unique_ptr<Bytes> encrypted = eac.getResult();
+    const size_t enc_chunk_len = chunk_len + AEAD_TAG_LEN;
+    // chunks 3 and 4 are not the last chunks
+    DecryptAEADChain dac{CIPHERMODE_AES256GCM, key, chunk_len, 3};
+    dac.addData(encrypted->getBytes() + 3 * enc_chunk_len, 2 * enc_chunk_len);
+    EXPECT_EQ(*dac.getResult(false), data.copySubBytes(3 * chunk_len, 5 * chunk_len));
+    // the last chunk has to be verified as the last chunk
+    DecryptAEADChain dac2{CIPHERMODE_AES256GCM, key, chunk_len, 9};
+    dac2.addData(encrypted->getBytes() + 9 * enc_chunk_len, enc_chunk_len);
+    EXPECT_THROW(dac2.getResult(false), std::runtime_error);
+    // the same chunks with the wrong index
+    DecryptAEADChain dac3{CIPHERMODE_AES256GCM, key, chunk_len, 2};
+    dac3.addData(encrypted->getBytes() + 3 * enc_chunk_len, enc_chunk_len);
+    EXPECT_THROW(dac3.getResult(false), std::runtime_error);
+}
+
+TEST(AEADChainClass, authentication) {
+    // modified, cut off data or a wrong key are detected
+    const size_t chunk_len = 64;
+    Bytes key(32);
+    key.fillrandom();
+    Bytes data(200);
+    data.fillrandom();
+    for (CModes cipher_mode : {CIPHERMODE_AES256GCM, CIPHERMODE_CHACHA20POLY1305}) {
+        EncryptAEADChain eac{cipher_mode, key, chunk_len};
+        eac.addData(data);
+        std::unique_ptr<Bytes> encrypted = eac.getResult();
+        // flip one bit
+        Bytes modified = *encrypted;
+        modified.getBytes()[70] ^= 1;
+        DecryptAEADChain dac{cipher_mode, key, chunk_len};
+        EXPECT_THROW(
+            {
+                dac.addData(modified);
+                dac.getResult();
+            },
+            std::runtime_error);
+        // cut off the last chunk
+        DecryptAEADChain dac2{cipher_mode, key, chunk_len};
+        dac2.addData(encrypted->getBytes(), 3 * (chunk_len + AEAD_TAG_LEN));
+        EXPECT_THROW(dac2.getResult(), std::runtime_error);
+        // wrong key
+        Bytes key2(32);
+        key2.fillrandom();
+        DecryptAEADChain dac3{cipher_mode, key2, chunk_len};
+        EXPECT_THROW(
+            {
+                dac3.addData(*encrypted);
+                dac3.getResult();
+            },
+            std::runtime_error);
+    }
+}
+
+TEST(AEADChainClass, deriveKey) {
+    // the key depends on every input and is 32 Bytes long
+    sha256 hash;
+    sha512 hash2;
+    Bytes pwhash(64);
+    Bytes enc_salt(64);
+    Bytes key_salt(AEAD_KEY_SALT_LEN);
+    pwhash.fillrandom();
+    enc_salt.fillrandom();
+    key_salt.fillrandom();
+    Bytes key = AEADChain::deriveKey(hash2, pwhash, enc_salt, key_salt);
+    EXPECT_EQ(key.getLen(), 32);
+    EXPECT_EQ(AEADChain::deriveKey(hash, pwhash.copySubBytes(0, 32), enc_salt.copySubBytes(0, 32), key_salt).getLen(), 32);
+    EXPECT_EQ(key, AEADChain::deriveKey(hash2, pwhash, enc_salt, key_salt));
+    Bytes key_salt2(AEAD_KEY_SALT_LEN);
+    key_salt2.fillrandom();
+    EXPECT_NE(key, AEADChain::deriveKey(hash2, pwhash, enc_salt, key_salt2));
+    EXPECT_THROW(AEADChain::getDecryptedLen(AEAD_TAG_LEN - 1, 64), std::length_error);
+    EXPECT_THROW(AEADChain::getDecryptedLen(0, 64), std::length_error);
+    EXPECT_THROW(EncryptAEADChain(CIPHERMODE_HASHCHAIN, key, 64), std::invalid_argument);
+    EXPECT_THROW(EncryptAEADChain(CIPHERMODE_AES256GCM, pwhash, 64), std::invalid_argument);
+}
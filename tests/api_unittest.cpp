@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "api.h"
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+namespace {
+Bytes toBytes(const std::vector<unsigned char>& content) {
+    // copies the expected content into a Bytes object
+    Bytes ret(content.size());
+    if (!content.empty()) ret.addBytes(content.data(), content.size());
+    return ret;
+}
+
+void expectContent(API& api, const std::vector<unsigned char>& content) {
+    // the ranges are decrypted from the checkpoints, the whole content from the start
+    Bytes expected = toBytes(content);
+    for (u_int64_t offset : {u_int64_t(0), u_int64_t(content.size() / 3), u_int64_t(content.size() - 100)}) {
+        ErrorStruct<std::unique_ptr<Bytes>> err = api.decryptRange(offset, 100);
+        ASSERT_TRUE(err.isSuccess());
+        EXPECT_EQ(*err.returnRef(), expected.copySubBytes(offset, offset + 100));
+    }
+    ErrorStruct<std::unique_ptr<Bytes>> err = api.decryptRange(0, content.size());
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_EQ(*err.returnRef(), expected);
+}
+}  // namespace
+
+TEST(APIClass, append_edit_roundtrip) {
+    // appends and edits are written through the journal, every state of the file can be decrypted and passes the checksum and the integrity tree
+    std::vector<DataHeaderSettingsIters> settings{getTestVaultSettings(), getTestVaultSettings(), getTestVaultSettings()};
+    settings[1].setBlockLen(256);
+    settings[2].setIntegrityLeafLen(MIN_INTEGRITY_LEAF_LEN);
+    for (const DataHeaderSettingsIters& ds : settings) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        Bytes data(300000);
+        data.fillrandom();
+        writeTestVault(file, ds, data);
+        std::vector<unsigned char> content(data.getBytes(), data.getBytes() + data.getLen());
+        API api{FILEMODE_PASSWORD};
+        ASSERT_TRUE(api.selectFile(file).isSuccess());
+        ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+
+        // the content grows behind the last checkpoint
+        Bytes appended(5000);
+        appended.fillrandom();
+        ASSERT_TRUE(api.appendData(appended).isSuccess());
+        content.insert(content.end(), appended.getBytes(), appended.getBytes() + appended.getLen());
+        expectContent(api, content);
+
+        // a range in front of the first checkpoint is replaced by a longer one
+        Bytes inserted(300);
+        inserted.fillrandom();
+        ASSERT_TRUE(api.editData(100, 50, inserted).isSuccess());
+        content.erase(content.begin() + 100, content.begin() + 150);
+        content.insert(content.begin() + 100, inserted.getBytes(), inserted.getBytes() + inserted.getLen());
+        expectContent(api, content);
+
+        // the content shrinks, the old end of the file is cut off
+        ASSERT_TRUE(api.editData(200000, 100000, Bytes(0)).isSuccess());
+        content.erase(content.begin() + 200000, content.begin() + 300000);
+        expectContent(api, content);
+
+        // the file is complete on the disk, a new API reads the same content
+        EXPECT_FALSE(std::filesystem::exists(FileHandler::getJournalPath(file)));
+        FileHandler file_handler(file);
+        EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+        if (ds.isIntegrityLeafLenSet()) EXPECT_TRUE(file_handler.verifyIntegrity().returnRef().damaged.empty());
+        EXPECT_TRUE(checkTestVault(file, "password", toBytes(content)).isSuccess());
+        if (ds.isIntegrityLeafLenSet()) {
+            // the leaf hash table is at the end of the file, a changed table is reported even if the tree matches with the data
+            u_int64_t leaf_table_len = file_handler.getDataHeader().returnRef()->getLeafTableLen();
+            EXPECT_GT(leaf_table_len, 0);
+            Bytes last = file_handler.getAllBytes().copySubBytes(file_handler.getFileSize() - 1, file_handler.getFileSize());
+            last.getBytes()[0] ^= 1;
+            ASSERT_TRUE(file_handler.writeAt(last.getBytes(), 1, file_handler.getFileSize() - 1).isSuccess());
+            IntegrityReport report = file_handler.verifyIntegrity().returnRef();
+            EXPECT_FALSE(report.valid);
+            ASSERT_EQ(report.damaged.size(), 1);
+            EXPECT_EQ(report.damaged[0].first, file_handler.getFileSize() - leaf_table_len);
+        }
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(APIClass, append_in_place) {
+    // the content and the checkpoint table have room to grow, an append that fits writes only the changed Bytes and the file keeps its size
+    // a content that outgrows the room is laid out again
+    DataHeaderSettingsIters ds = getTestVaultSettings();
+    ds.setIntegrityLeafLen(MIN_INTEGRITY_LEAF_LEN);
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(300000);
+    data.fillrandom();
+    writeTestVault(file, ds, data);
+    std::vector<unsigned char> content(data.getBytes(), data.getBytes() + data.getLen());
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    Bytes old_file = FileHandler(file).getAllBytes();
+    Bytes appended(100);
+    appended.fillrandom();
+    ASSERT_TRUE(api.appendData(appended).isSuccess());
+    content.insert(content.end(), appended.getBytes(), appended.getBytes() + appended.getLen());
+    {
+        FileHandler file_handler(file);
+        Bytes new_file = file_handler.getAllBytes();
+        ASSERT_EQ(new_file.getLen(), old_file.getLen());
+        // the last block, the resume state, a few leaf hashes, the region hashes and the header
+        u_int64_t changed = 0;
+        for (size_t i = 0; i < new_file.getLen(); i++) changed += new_file.getBytes()[i] != old_file.getBytes()[i];
+        EXPECT_LT(changed, 2000);
+        EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+        EXPECT_TRUE(file_handler.verifyIntegrity().returnRef().valid);
+    }
+    expectContent(api, content);
+    // the content shrinks in its room, the cut off Bytes are cleared
+    ASSERT_TRUE(api.editData(content.size() - 1000, 1000, Bytes(0)).isSuccess());
+    content.resize(content.size() - 1000);
+    expectContent(api, content);
+    // the content outgrows its room
+    Bytes grown(100000);
+    grown.fillrandom();
+    ASSERT_TRUE(api.appendData(grown).isSuccess());
+    content.insert(content.end(), grown.getBytes(), grown.getBytes() + grown.getLen());
+    expectContent(api, content);
+    {
+        FileHandler file_handler(file);
+        EXPECT_GT(file_handler.getFileSize(), old_file.getLen());
+        EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+        EXPECT_TRUE(file_handler.verifyIntegrity().returnRef().valid);
+    }
+    EXPECT_TRUE(checkTestVault(file, "password", toBytes(content)).isSuccess());
+    std::filesystem::remove(file);
+}
+
+TEST(APIClass, edit_reseeds_the_chain) {
+    // the encryption adds the block salts to the plaintext, an edited block that got its old salt again would give away the difference of both plaintexts
+    // an edit behind a checkpoint reseeds the chain there (the prefix is kept), an edit in front of the first checkpoint changes the encrypted salt
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data = writeRandomTestVault(file, "password", 300000);
+    std::vector<unsigned char> content(data.getBytes(), data.getBytes() + data.getLen());
+    auto readContent = [&]() {
+        // the encrypted content (the trailer is behind it)
+        FileHandler file_handler(file);
+        return file_handler.getAllBytes().copySubBytes(file_handler.getHeaderSize(), file_handler.getHeaderSize() + content.size());
+    };
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    for (u_int64_t offset : {u_int64_t(200000), u_int64_t(270000), u_int64_t(100)}) {
+        Bytes old_cipher = readContent();
+        Bytes old_plain = toBytes(content).copySubBytes(offset, offset + 64);
+        Bytes new_plain(64);
+        new_plain.fillrandom();
+        ASSERT_TRUE(api.editData(offset, 64, new_plain).isSuccess());
+        std::memcpy(content.data() + offset, new_plain.getBytes(), 64);
+        Bytes new_cipher = readContent();
+        EXPECT_NE(new_cipher.copySubBytes(offset, offset + 64), old_cipher.copySubBytes(offset, offset + 64) - old_plain + new_plain);
+        // the blocks in front of the checkpoint keep their encrypted Bytes, a new encrypted salt changes all of them
+        if (offset > 200000)
+            EXPECT_EQ(new_cipher.copySubBytes(0, 1000), old_cipher.copySubBytes(0, 1000));
+        else if (offset == 100)
+            EXPECT_NE(new_cipher.copySubBytes(0, 64), old_cipher.copySubBytes(0, 64));
+        expectContent(api, content);
+        // the reader continues its chain with the stored checkpoint states
+        ErrorStruct<std::unique_ptr<DecryptedReader>> reader = api.getDecryptedReader(50000);
+        ASSERT_TRUE(reader.isSuccess());
+        Bytes read(content.size());
+        while (!reader.returnRef()->isDone()) reader.returnRef()->next().returnRef()->addcopyToBytes(read);
+        EXPECT_EQ(read, toBytes(content));
+    }
+    EXPECT_TRUE(checkTestVault(file, "password", toBytes(content)).isSuccess());
+    std::filesystem::remove(file);
+}
+
+TEST(APIClass, lazy_data_checksum) {
+    // selectFile only verifies the header checksum, the data checksum is verified when the data is decrypted
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(100000);
+    data.fillrandom();
+    writeTestVault(file, getTestVaultSettings(), data);
+    u_int64_t pos = std::filesystem::file_size(file) - 5000;
+    FileHandler file_handler(file);
+    unsigned char byte;
+    ASSERT_EQ(file_handler.readAt(&byte, 1, pos), 1);
+    byte ^= 1;
+    ASSERT_TRUE(file_handler.writeAt(&byte, 1, pos).isSuccess());
+    {
+        API api{FILEMODE_PASSWORD};
+        ASSERT_TRUE(api.selectFile(file).isSuccess());
+        ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+        EXPECT_EQ(api.decryptRange(0, 100).errorCode, ERR_CHECKSUM_MISMATCH);
+        EXPECT_EQ(api.getDecryptedData().errorCode, ERR_CHECKSUM_MISMATCH);
+    }
+    // the repaired file is decrypted, a damaged header is still rejected by selectFile
+    byte ^= 1;
+    ASSERT_TRUE(file_handler.writeAt(&byte, 1, pos).isSuccess());
+    {
+        API api{FILEMODE_PASSWORD};
+        ASSERT_TRUE(api.selectFile(file).isSuccess());
+        ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+        EXPECT_EQ(*api.decryptRange(0, 100).returnRef(), data.copySubBytes(0, 100));
+    }
+    file_handler.update();
+    pos = file_handler.getHeaderSize() - 10;
+    ASSERT_EQ(file_handler.readAt(&byte, 1, pos), 1);
+    byte ^= 1;
+    ASSERT_TRUE(file_handler.writeAt(&byte, 1, pos).isSuccess());
+    API api{FILEMODE_PASSWORD};
+    EXPECT_EQ(api.selectFile(file).errorCode, ERR_CHECKSUM_MISMATCH);
+    std::filesystem::remove(file);
+}
+
+TEST(APIClass, trailer_version) {
+    // an INDEX datablock without the trailer version (or with an unknown version) is rejected when the file is selected
+    // the files of the older versions (without the content capacity, version 1 without the leaf hash table) are still read,
+    // an edit encrypts them again with the current version
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data = writeRandomTestVault(file, "password", 10000);
+    Bytes file_data(0);
+    std::unique_ptr<DataHeader> dh;
+    {
+        FileHandler file_handler(file);
+        file_data = file_handler.getAllBytes().copySubBytes(file_handler.getHeaderSize(), file_handler.getFileSize());
+        dh = file_handler.getDataHeader().returnMove();
+    }
+    Bytes index = dh->findDataBlock(DatablockType::INDEX)->getData();
+    EXPECT_EQ(index.getLen(), 33);
+    EXPECT_EQ(index.getBytes()[0], TRAILER_VERSION);
+    u_int64_t content_len = index.copySubBytes(9, 17).toLong();
+    u_int64_t content_cap = index.copySubBytes(17, 25).toLong();
+    EXPECT_EQ(content_len, data.getLen());
+    EXPECT_GT(content_cap, content_len);
+
+    auto writeIndex = [&](const Bytes& new_index, const Bytes& new_data) {
+        // the header is written again with the given INDEX datablock and data
+        dh->setOrReplaceDataBlock(DataBlock(DatablockType::INDEX, new_index));
+        dh->setDataSize(new_data.getLen());
+        dh->calcHeaderBytes();
+        dh->setChecksum(new_data.getBytes(), new_data.getLen());
+        FileHandler file_handler(file);
+        ASSERT_TRUE(file_handler.writeParts({{dh->getHeaderBytes().getBytes(), dh->getHeaderLength()}, {new_data.getBytes(), new_data.getLen()}}).isSuccess());
+    };
+    // the layout of the files that were written before the version was added
+    writeIndex(index.copySubBytes(1, 17), file_data);
+    API api{FILEMODE_PASSWORD};
+    EXPECT_EQ(api.selectFile(file).errorCode, ERR_TRAILER_VERSION_INVALID);
+    // an unknown version
+    Bytes future = index;
+    future.getBytes()[0] = TRAILER_VERSION + 1;
+    writeIndex(future, file_data);
+    EXPECT_EQ(api.selectFile(file).errorCode, ERR_TRAILER_VERSION_INVALID);
+    // the current version is accepted again
+    writeIndex(index, file_data);
+    EXPECT_TRUE(checkTestVault(file, "password", data).isSuccess());
+
+    // the content is too short for a checkpoint, the older layouts are the content followed by the resume state
+    u_int64_t state_len = 2 * dh->getHashSize();
+    ASSERT_EQ(file_data.getLen(), content_cap + state_len);
+    Bytes old_data(content_len + state_len);
+    file_data.copySubBytes(0, content_len).addcopyToBytes(old_data);
+    file_data.copySubBytes(content_cap, content_cap + state_len).addcopyToBytes(old_data);
+    // version 3 has no content capacity, version 1 has no leaf table length (the file has no integrity tree)
+    Bytes v3(25);
+    v3.addByte(3);
+    index.copySubBytes(1, 17).addcopyToBytes(v3);
+    Bytes::fromLong(0, true).addcopyToBytes(v3);
+    writeIndex(v3, old_data);
+    EXPECT_TRUE(checkTestVault(file, "password", data).isSuccess());
+    Bytes v1(17);
+    v1.addByte(1);
+    index.copySubBytes(1, 17).addcopyToBytes(v1);
+    writeIndex(v1, old_data);
+    EXPECT_TRUE(checkTestVault(file, "password", data).isSuccess());
+    {
+        API v1_api{FILEMODE_PASSWORD};
+        ASSERT_TRUE(v1_api.selectFile(file).isSuccess());
+        ASSERT_TRUE(v1_api.verifyPassword("password").isSuccess());
+        ASSERT_TRUE(v1_api.appendData(data).isSuccess());
+    }
+    {
+        // the edited file has the current version (its header grew)
+        FileHandler file_handler(file);
+        Bytes edited = file_handler.getDataHeader().returnRef()->findDataBlock(DatablockType::INDEX)->getData();
+        EXPECT_EQ(edited.getLen(), 33);
+        EXPECT_EQ(edited.getBytes()[0], TRAILER_VERSION);
+        EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+    }
+    Bytes appended(data, data.getLen());
+    data.addcopyToBytes(appended);
+    EXPECT_TRUE(checkTestVault(file, "password", appended).isSuccess());
+    std::filesystem::remove(file);
+}
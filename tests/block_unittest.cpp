@@ -2,6 +2,7 @@
 
 #include "block_decrypt.h"
 #include "block_encrypt.h"
+#include "fixed_block.h"
 #include "sha256.h"
 #include "sha384.h"
 #include "sha512.h"
@@ -167,3 +168,87 @@ TEST(BlockClass, EncryptBlock) {
     b5.addcopyToBytes(b3);
     EXPECT_THROW(EncryptBlock block16(hash3, b3), std::length_error);
 }
+
+TEST(BlockClass, KeystreamBlock) {
+    // test the keystream block format (salt expanded to a larger block length)
+    std::shared_ptr<Hash> hash = std::make_shared<sha256>();
+    Bytes salt(32);
+    salt.fillrandom();
+    EXPECT_THROW(EncryptBlock(hash, Bytes(10), 4096), std::length_error);
+    EXPECT_THROW(EncryptBlock(hash, salt, 0), std::invalid_argument);
+
+    // the keystream is the hash of the salt and the counter
+    Bytes keystream = Block::expandSalt(*hash, salt, 100);
+    EXPECT_EQ(keystream.getLen(), 100);
+    for (u_int64_t part = 0; part < 4; part++) {
+        Bytes input(salt, 8);
+        Bytes::fromLong(part, true).addcopyToBytes(input);
+        u_int64_t end = std::min<u_int64_t>(32 * (part + 1), 100);
+        EXPECT_EQ(keystream.copySubBytes(32 * part, end), hash->hash(input).copySubBytes(0, end - 32 * part));
+    }
+
+    for (size_t block_len : {64, 100, 4096}) {
+        Bytes data(block_len);
+        data.fillrandom();
+        EncryptBlock enc_block(hash, salt, block_len);
+        DecryptBlock dec_block(hash, salt, block_len);
+        EXPECT_EQ(enc_block.getFreeSpace(), block_len);
+        // partial block
+        enc_block.addData(data.copySubBytes(0, 10));
+        EXPECT_EQ(enc_block.getFreeSpace(), block_len - 10);
+        EXPECT_THROW(enc_block.getHash(), std::length_error);
+        EXPECT_EQ(enc_block.getResult(), data.copySubBytes(0, 10) + Block::expandSalt(*hash, salt, 10));
+        // complete block
+        enc_block.addData(data.copySubBytes(10, block_len));
+        EXPECT_EQ(enc_block.getFreeSpace(), 0);
+        EXPECT_EQ(enc_block.getHash(), hash->hash(data));
+        EXPECT_EQ(enc_block.getResult(), data + Block::expandSalt(*hash, salt, block_len));
+        Bytes extra(1);
+        extra.fillrandom();
+        EXPECT_THROW(enc_block.addData(extra), std::length_error);
+        // decrypt it again
+        dec_block.addData(enc_block.getResult());
+        EXPECT_EQ(dec_block.getFreeSpace(), 0);
+        EXPECT_EQ(dec_block.getResult(), data);
+        EXPECT_EQ(dec_block.getHash(), enc_block.getHash());
+    }
+}
+
+Bytes toBytes(const unsigned char* data, const size_t len) {
+    // copies a raw buffer into a new Bytes object
+    Bytes ret(len);
+    ret.addBytes(data, len);
+    return ret;
+}
+
+template <size_t HS>
+void testFixedBlock() {
+    // the fixed block has to produce the same result and hash as the Block objects
+    std::shared_ptr<Hash> hash = std::make_shared<typename FixedHash<HS>::HashType>();
+    EXPECT_TRUE(FixedBlock<HS>::matches(*hash));
+    Bytes data(HS);
+    Bytes salt(HS);
+    data.fillrandom();
+    salt.fillrandom();
+    typename FixedBlock<HS>::Array salt_arr;
+    typename FixedBlock<HS>::Array block_hash;
+    salt.copyToArray(salt_arr.data(), HS);
+    unsigned char enc_data[HS];
+    unsigned char dec_data[HS];
+    EncryptBlock enc_block(hash, salt);
+    enc_block.addData(data);
+    FixedBlock<HS>::encrypt(data.getBytes(), salt_arr, enc_data, block_hash);
+    EXPECT_EQ(toBytes(enc_data, HS), enc_block.getResult());
+    EXPECT_EQ(toBytes(block_hash.data(), HS), enc_block.getHash());
+    FixedBlock<HS>::decrypt(enc_data, salt_arr, dec_data, block_hash);
+    EXPECT_EQ(toBytes(dec_data, HS), data);
+    EXPECT_EQ(toBytes(block_hash.data(), HS), enc_block.getHash());
+}
+
+TEST(BlockClass, FixedBlock) {
+    testFixedBlock<32>();
+    testFixedBlock<48>();
+    testFixedBlock<64>();
+    EXPECT_FALSE(FixedBlock<32>::matches(sha512()));
+    EXPECT_FALSE(FixedBlock<64>::matches(sha256()));
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "bytes.h"
+#include "checksum.h"
+#include "settings.h"
+
+namespace {
+u_int64_t checksumOf(const std::string& str) {
+    // checksum over the characters of the string in one part
+    Checksum checksum;
+    checksum.addData(reinterpret_cast<const unsigned char*>(str.data()), str.size());
+    return checksum.getResult();
+}
+}  // namespace
+
+TEST(ChecksumClass, vectors) {
+    // the checksum is xxHash64 with seed 0
+    EXPECT_EQ(checksumOf(""), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(checksumOf("a"), 0xD24EC4F1A98C6E5BULL);
+    EXPECT_EQ(checksumOf("abc"), 0x44BC2CF5AD770999ULL);
+    EXPECT_EQ(checksumOf("The quick brown fox jumps over the lazy dog"), 0x0B242D361FDA71BCULL);
+    unsigned char data[100];
+    for (int i = 0; i < 100; i++) data[i] = i;
+    Checksum checksum;
+    checksum.addData(data, 100);
+    EXPECT_EQ(checksum.getResult(), 0x6AC1E58032166597ULL);
+}
+
+TEST(ChecksumClass, parts) {
+    // the result does not depend on how the data is split into parts
+    Bytes data(1000);
+    data.fillrandom();
+    for (size_t len : {0, 1, 31, 32, 33, 100, 1000}) {
+        Checksum whole;
+        whole.addData(data.getBytes(), len);
+        for (size_t part : {1, 7, 32, 50}) {
+            Checksum parts;
+            for (size_t pos = 0; pos < len; pos += part) parts.addData(data.getBytes() + pos, std::min(part, len - pos));
+            EXPECT_EQ(parts.getResult(), whole.getResult());
+        }
+    }
+    // zeros are the same as zero Bytes
+    unsigned char zeros[70] = {0};
+    Checksum checksum;
+    checksum.addData(zeros, 70);
+    Checksum checksum2;
+    checksum2.addZeros(70);
+    EXPECT_EQ(checksum.getResult(), checksum2.getResult());
+}
+
+TEST(ChecksumClass, seed) {
+    // the seed is the seed of xxHash64
+    Checksum checksum{1};
+    EXPECT_EQ(checksum.getResult(), 0xD5AFBA1336A3BE4BULL);
+    unsigned char data[100];
+    for (int i = 0; i < 100; i++) data[i] = i;
+    Checksum checksum2{1};
+    checksum2.addData(data, 100);
+    EXPECT_EQ(checksum2.getResult(), 0x3D19A3A2098A7023ULL);
+}
+
+TEST(ChecksumClass, calculateHeader) {
+    // the checksum Bytes inside of the header are ignored, every other Byte changes the result
+    Bytes header(100);
+    header.fillrandom();
+    u_int64_t result = Checksum::calculateHeader(header.getBytes(), 100, 40);
+    Bytes zeroed = header;
+    std::memset(zeroed.getBytes() + 40, 0, 8);
+    Checksum checksum;
+    checksum.addData(zeroed.getBytes(), 100);
+    EXPECT_EQ(result, checksum.getResult());
+    header.getBytes()[45] ^= 1;
+    EXPECT_EQ(Checksum::calculateHeader(header.getBytes(), 100, 40), result);
+    header.getBytes()[48] ^= 1;
+    EXPECT_NE(Checksum::calculateHeader(header.getBytes(), 100, 40), result);
+}
+
+TEST(ChecksumClass, calculateChunks) {
+    // the result is the sum of the chunk checksums, every chunk is seeded with its index
+    Bytes data(3 * CHECKSUM_CHUNK_LEN + 100);
+    data.fillrandom();
+    u_int64_t expected = 0;
+    for (u_int64_t chunk = 0; chunk < 4; chunk++) {
+        Checksum checksum{chunk};
+        checksum.addData(data.getBytes() + chunk * CHECKSUM_CHUNK_LEN, chunk == 3 ? 100 : CHECKSUM_CHUNK_LEN);
+        expected += checksum.getResult();
+    }
+    u_int64_t result = Checksum::calculateChunks({{data.getBytes(), data.getLen()}}, 0);
+    EXPECT_EQ(result, expected);
+    EXPECT_EQ(Checksum::calculateChunks({}, 0), 0);
+    // the parts do not have to end at a chunk end
+    EXPECT_EQ(Checksum::calculateChunks({{data.getBytes(), 10}, {data.getBytes() + 10, CHECKSUM_CHUNK_LEN}, {data.getBytes() + 10 + CHECKSUM_CHUNK_LEN, data.getLen() - 10 - CHECKSUM_CHUNK_LEN}}, 0),
+              result);
+    // the same chunk at another index has another checksum
+    EXPECT_NE(Checksum::calculateChunks({{data.getBytes(), CHECKSUM_CHUNK_LEN}}, 0), Checksum::calculateChunks({{data.getBytes(), CHECKSUM_CHUNK_LEN}}, CHECKSUM_CHUNK_LEN));
+}
+
+TEST(ChecksumClass, calculateChunksUpdate) {
+    // replacing the data from an offset to the end only needs the chunks from the chunk of the offset
+    Bytes data(3 * CHECKSUM_CHUNK_LEN + 100);
+    data.fillrandom();
+    u_int64_t checksum = Checksum::calculateChunks({{data.getBytes(), data.getLen()}}, 0);
+    u_int64_t offset = CHECKSUM_CHUNK_LEN + 500;
+    u_int64_t chunk_start = offset - offset % CHECKSUM_CHUNK_LEN;
+    Bytes suffix(CHECKSUM_CHUNK_LEN + 7);
+    suffix.fillrandom();
+    checksum -= Checksum::calculateChunks({{data.getBytes() + chunk_start, data.getLen() - chunk_start}}, chunk_start);
+    checksum += Checksum::calculateChunks({{data.getBytes() + chunk_start, offset - chunk_start}, {suffix.getBytes(), suffix.getLen()}}, chunk_start);
+    Bytes edited(offset + suffix.getLen());
+    data.copySubBytes(0, offset).addcopyToBytes(edited);
+    suffix.addcopyToBytes(edited);
+    EXPECT_EQ(checksum, Checksum::calculateChunks({{edited.getBytes(), edited.getLen()}}, 0));
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "chainhash_data.h"
 #include "dataheader_generator.h"
+#include "hash_modes.h"
 #include "rng.h"
 #include "settings.h"
 #include "test_settings.cpp"
@@ -382,3 +383,221 @@ TEST(DataHeaderClass, datablocks) {
         EXPECT_EQ(dh->getHeaderBytes(), dh2->getHeaderBytes());
     }
 }
+
+TEST(DataHeaderClass, block_len) {
+    // the effective block length is the hash size for the legacy format and the stored block length otherwise
+    for (HModes hash_mode : {HASHMODE_SHA256, HASHMODE_SHA384, HASHMODE_SHA512}) {
+        Bytes dhb = DataHeaderGen::generateDH(DataHeaderGenSet{.hashmode = hash_mode, .datablocknum = 0, .decdatablocknum = 0});
+        std::unique_ptr<DataHeader> dh = DataHeader::setHeaderBytes(dhb).returnMove();
+        EXPECT_EQ(dh->getBlockLen(), 0);
+        EXPECT_EQ(dh->getEffectiveBlockLen(), dh->getHashSize());
+        dh->addDataBlock(DataHeader::createBlockFormatDataBlock(4096));
+        EXPECT_EQ(dh->getBlockLen(), 4096);
+        EXPECT_EQ(dh->getEffectiveBlockLen(), 4096);
+    }
+}
+
+TEST(DataHeaderClass, replace_datablocks) {
+    // a datablock that is set again replaces every datablock of its type
+    DataHeaderSettingsIters ds;
+    Bytes first(4);
+    first.addrandom(4);
+    Bytes second(8);
+    second.addrandom(8);
+    ds.dec_data_blocks.push_back(DataBlock(DatablockType::INDEX, first));
+    ds.dec_data_blocks.push_back(DataBlock(DatablockType::INDEX, first));
+    ds.setOrReplaceDataBlock(DatablockType::INDEX, second);
+    ASSERT_EQ(ds.dec_data_blocks.size(), 1);
+    EXPECT_EQ(ds.dec_data_blocks[0].getData(), second);
+    ds.removeDataBlocks(DatablockType::INDEX);
+    EXPECT_TRUE(ds.dec_data_blocks.empty());
+
+    Bytes dhb = DataHeaderGen::generateDH(DataHeaderGenSet{.datablocknum = 0, .decdatablocknum = 0});
+    std::unique_ptr<DataHeader> dh = DataHeader::setHeaderBytes(dhb).returnMove();
+    dh->addDataBlock(DataBlock(DatablockType::INDEX, first));
+    dh->setOrReplaceDataBlock(DataBlock(DatablockType::INDEX, second));
+    EXPECT_EQ(dh->getDataHeaderParts().dec_data_blocks.size(), 1);
+    EXPECT_EQ(dh->findDataBlock(DatablockType::INDEX)->getData(), second);
+    EXPECT_EQ(dh->getHeaderLength(), dhb.getLen() + 2 + second.getLen());
+}
+
+TEST(DataHeaderClass, serializer) {
+    // the header is written in one pass into one buffer, the buffer is reused if the header gets smaller
+    for (unsigned char hash_mode = 1; hash_mode < MAX_HASHMODE_NUMBER; hash_mode++) {
+        // the parsed header bytes are serialized again without any change
+        Bytes dhb = DataHeaderGen::generateDH(DataHeaderGenSet{
+            .hashmode = HModes(hash_mode),
+            .datablocknum = 0,
+            .decdatablocknum = 0,
+            .chainhashlen1 = 0,
+            .chainhashlen2 = 0,
+        });
+        std::unique_ptr<DataHeader> dh = DataHeader::setHeaderBytes(dhb).returnMove();
+        dh->setFileSize(100000);
+        dh->calcHeaderBytes();
+        Bytes first = dh->getHeaderBytes();
+        std::unique_ptr<DataHeader> dh2 = DataHeader::setHeaderBytes(first).returnMove();
+        dh2->calcHeaderBytes();
+        EXPECT_EQ(dh2->getHeaderBytes(), first);
+        unsigned int len = dh->getHeaderLength();
+        // the header gets larger
+        Bytes data(255);
+        data.fillrandom();
+        dh->addDataBlock(DataBlock(DatablockType::DEFAULT, data));
+        dh->calcHeaderBytes();
+        EXPECT_EQ(dh->getHeaderBytes().getLen(), len + 257);
+        Bytes larger = dh->getHeaderBytes();
+        EXPECT_EQ(DataHeader::setHeaderBytes(larger).returnRef()->getHeaderBytes(), dh->getHeaderBytes());
+        // the header gets smaller again, the same Bytes are written
+        dh->removeDataBlocks(DatablockType::DEFAULT);
+        EXPECT_THROW(dh->getHeaderBytes(), std::logic_error);
+        dh->calcHeaderBytes();
+        EXPECT_EQ(dh->getHeaderBytes().getLen(), len);
+        EXPECT_EQ(dh->getHeaderBytes(), first);
+    }
+}
+
+TEST(DataHeaderClass, parser) {
+    // the header is parsed in place from one buffer, the parsed header has the same Bytes as the buffer
+    for (int k = 0; k < 100; k++) {
+        Bytes dhb = DataHeaderGen::generateDH();
+        ErrorStruct<std::unique_ptr<DataHeader>> err = DataHeader::setHeaderBytes(dhb.getBytes(), dhb.getLen());
+        ASSERT_TRUE(err.isSuccess());
+        std::unique_ptr<DataHeader> dh = err.returnMove();
+        EXPECT_EQ(dh->getHeaderBytes(), dhb);
+        dh->calcHeaderBytes();
+        EXPECT_EQ(dh->getHeaderBytes(), dhb);
+        // the buffer can be longer than the header (e.g. a mapped file)
+        Bytes longer(dhb, 10);
+        longer.addrandom(10);
+        EXPECT_EQ(DataHeader::setHeaderBytes(longer.getBytes(), longer.getLen()).returnRef()->getHeaderBytes(), dhb);
+        // every cut off header is rejected
+        for (size_t len : {size_t(0), size_t(15), size_t(16), size_t(MIN_DATAHEADER_LEN - 1), dhb.getLen() - 1}) {
+            EXPECT_EQ(DataHeader::setHeaderBytes(dhb.getBytes(), len).errorCode, ERR_NOT_ENOUGH_DATA);
+        }
+        // a header size that is larger than the fields of the header is rejected
+        Bytes header_size = Bytes::fromLong(dhb.getLen() + 10, true);
+        std::memcpy(longer.getBytes() + 8, header_size.getBytes(), 8);
+        EXPECT_FALSE(DataHeader::setHeaderBytes(longer.getBytes(), longer.getLen()).isSuccess());
+        // a header size that is smaller than the fields that are already read is rejected (the bounds checks would wrap around)
+        for (u_int64_t small_size : {u_int64_t(0), u_int64_t(15), u_int64_t(16), u_int64_t(MIN_DATAHEADER_LEN - 1)}) {
+            Bytes small = dhb;
+            Bytes small_size_bytes = Bytes::fromLong(small_size, true);
+            std::memcpy(small.getBytes() + 8, small_size_bytes.getBytes(), 8);
+            EXPECT_EQ(DataHeader::setHeaderBytes(small.getBytes(), small.getLen()).errorCode, ERR_NOT_ENOUGH_DATA);
+            EXPECT_EQ(DataHeader::setHeaderBytes(std::make_shared<Bytes>(small)).errorCode, ERR_NOT_ENOUGH_DATA);
+        }
+    }
+    // the sizes at the beginning of the header are checked against the file
+    Bytes dhb = DataHeaderGen::generateDH();
+    EXPECT_EQ(DataHeader::checkHeaderPrefix(dhb.getBytes(), dhb.getLen()).returnValue(), dhb.getLen());
+    EXPECT_EQ(DataHeader::checkHeaderPrefix(dhb.getBytes(), dhb.getLen() + 1).errorCode, ERR_FILESIZE_INVALID);
+}
+
+TEST(DataHeaderClass, key_slots) {
+    // the data key is only unwrapped with the password hash of the slot, the slots are stored in the order of the header
+    for (HModes hash_mode : {HASHMODE_SHA256, HASHMODE_SHA384, HASHMODE_SHA512}) {
+        std::unique_ptr<Hash> hash = HashModes::getHash(hash_mode);
+        Bytes password_hash(hash->getHashSize()), validator(hash->getHashSize()), data_key(hash->getHashSize());
+        password_hash.fillrandom();
+        validator.fillrandom();
+        data_key.fillrandom();
+        KeySlot slot = DataHeader::createKeySlot(*hash, password_hash, validator, data_key);
+        EXPECT_FALSE(slot.isFree());
+        EXPECT_EQ(slot.validator, validator);
+        EXPECT_NE(slot.wrapped_key, data_key);
+        EXPECT_EQ(DataHeader::unwrapKeySlot(*hash, password_hash, slot), data_key);
+        EXPECT_NE(DataHeader::unwrapKeySlot(*hash, validator, slot), data_key);
+        EXPECT_THROW(DataHeader::createKeySlot(*hash, password_hash, validator, Bytes(0)), std::invalid_argument);
+
+        Bytes dhb = DataHeaderGen::generateDH(DataHeaderGenSet{.hashmode = hash_mode, .datablocknum = 0, .decdatablocknum = 0});
+        std::unique_ptr<DataHeader> dh = DataHeader::setHeaderBytes(dhb).returnMove();
+        EXPECT_TRUE(dh->getKeySlots().empty());
+        dh->addDataBlock(DataHeader::createKeySlotDataBlock(DataHeader::createFreeKeySlot(hash->getHashSize())));
+        dh->addDataBlock(DataHeader::createKeySlotDataBlock(slot));
+        std::vector<KeySlot> slots = dh->getKeySlots();
+        ASSERT_EQ(slots.size(), 2);
+        EXPECT_TRUE(slots[0].isFree());
+        EXPECT_EQ(slots[1].validator, slot.validator);
+        EXPECT_EQ(slots[1].wrapped_key, slot.wrapped_key);
+        // a datablock with the wrong length is rejected
+        dh->addDataBlock(DataBlock(DatablockType::KEYSLOT, validator));
+        EXPECT_THROW(dh->getKeySlots(), std::invalid_argument);
+    }
+}
+
+TEST(DataHeaderClass, lazy_datablocks) {
+    // the datablocks of a read header are views into its header bytes, they are only copied or decrypted when they are accessed
+    for (HModes hash_mode : {HASHMODE_SHA256, HASHMODE_SHA384, HASHMODE_SHA512}) {
+        std::unique_ptr<Hash> hash = HashModes::getHash(hash_mode);
+        Bytes pwhash(hash->getHashSize());
+        pwhash.fillrandom();
+        Bytes dhb = DataHeaderGen::generateDH(DataHeaderGenSet{.hashmode = hash_mode, .datablocknum = 0, .decdatablocknum = 0});
+        std::unique_ptr<DataHeader> dh = DataHeader::setHeaderBytes(dhb).returnMove();
+        Bytes index(16);
+        Bytes::fromLong(1024, true).addcopyToBytes(index);
+        Bytes::fromLong(4096, true).addcopyToBytes(index);
+        Bytes filename(8);
+        filename.addrandom(8);
+        dh->addDataBlock(DataBlock(DatablockType::INDEX, index));
+        dh->addEncDataBlock(EncDataBlock(DataBlock(DatablockType::FILENAME, filename), HashModes::getHash(hash_mode), pwhash, dh->getDataHeaderParts().getEncSalt()));
+        dh->addDataBlock(DataHeader::createChecksumDataBlock());
+        dh->setFileSize(100000);
+        dh->calcHeaderBytes();
+        Bytes header = dh->getHeaderBytes();
+
+        // the header is copied once, the buffer can be changed after the call
+        Bytes buffer = header;
+        std::unique_ptr<DataHeader> read = DataHeader::setHeaderBytes(buffer.getBytes(), buffer.getLen()).returnMove();
+        buffer.fillrandom();
+        const Bytes& read_bytes = read->getHeaderBytes();
+        EXPECT_EQ(read_bytes, header);
+        DataHeaderParts parts = read->getDataHeaderParts();
+        ASSERT_EQ(parts.dec_data_blocks.size(), 2);
+        ASSERT_EQ(parts.enc_data_blocks.size(), 1);
+        for (const DataBlock& datablock : parts.dec_data_blocks) {
+            EXPECT_TRUE(datablock.isView());
+            EXPECT_GE(datablock.getBytes(), read_bytes.getBytes());
+            EXPECT_LE(datablock.getBytes() + datablock.getLen(), read_bytes.getBytes() + read_bytes.getLen());
+        }
+        EXPECT_TRUE(parts.enc_data_blocks[0].getEncBlock().isView());
+        // the views are decoded on access
+        EXPECT_EQ(read->findDataBlock(DatablockType::INDEX)->getData(), index);
+        EXPECT_EQ(read->findDataBlock(DatablockType::INDEX)->copySubBytes(8, 16).toLong(), 4096);
+        EXPECT_THROW(read->findDataBlock(DatablockType::INDEX)->copySubBytes(8, 17), std::length_error);
+        EXPECT_EQ(read->findDataBlock(DatablockType::FILENAME), nullptr);
+        EXPECT_EQ(parts.enc_data_blocks[0].getDecType(HashModes::getHash(hash_mode), pwhash), DatablockType::FILENAME);
+        EXPECT_EQ(parts.enc_data_blocks[0].getDec(HashModes::getHash(hash_mode), pwhash, parts.getEncSalt()), filename);
+
+        // copies of the views keep the header bytes alive
+        read.reset();
+        EXPECT_EQ(parts.dec_data_blocks[0].getData(), index);
+        EXPECT_EQ(parts.enc_data_blocks[0].getDec(HashModes::getHash(hash_mode), pwhash, parts.getEncSalt()), filename);
+
+        // a changed header is serialized again, the views are written from the read header bytes
+        read = DataHeader::setHeaderBytes(header).returnMove();
+        read->addDataBlock(DataBlock(DatablockType::TIMESTAMP, Bytes::fromLong(1234, true)));
+        EXPECT_THROW(read->getHeaderBytes(), std::logic_error);
+        read->removeDataBlocks(DatablockType::TIMESTAMP);
+        read->calcHeaderBytes();
+        EXPECT_EQ(read->getHeaderBytes(), header);
+        // the checksum is written into a copy of the read header bytes, the views are not changed
+        read = DataHeader::setHeaderBytes(header).returnMove();
+        parts = read->getDataHeaderParts();
+        Bytes data(10);
+        data.fillrandom();
+        read->setChecksum(data.getBytes(), data.getLen());
+        dh->setChecksum(data.getBytes(), data.getLen());
+        EXPECT_EQ(read->getHeaderBytes(), dh->getHeaderBytes());
+        EXPECT_EQ(parts.dec_data_blocks[1].getData(), DataHeader::createChecksumDataBlock().getData());
+        EXPECT_FALSE(read->findDataBlock(DatablockType::CHECKSUM)->isView());
+
+        // a kept buffer is shortened to the header and not copied
+        std::shared_ptr<Bytes> kept = std::make_shared<Bytes>(header, 10);
+        kept->addrandom(10);
+        read = DataHeader::setHeaderBytes(kept).returnMove();
+        EXPECT_EQ(&read->getHeaderBytes(), kept.get());
+        EXPECT_EQ(kept->getLen(), header.getLen());
+        EXPECT_FALSE(DataHeader::setHeaderBytes(std::shared_ptr<Bytes>(nullptr)).isSuccess());
+    }
+}
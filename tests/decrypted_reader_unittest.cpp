@@ -0,0 +1,90 @@
+#include "decrypted_reader.h"
+
+#include <gtest/gtest.h>
+
+#include "api.h"
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+void checkReader(const DataHeaderSettingsIters& ds, const u_int64_t data_len, const u_int64_t chunk_len) {
+    // the chunks of the reader are the decrypted content
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(data_len);
+    data.fillrandom();
+    writeTestVault(file, ds, data);
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    ErrorStruct<std::unique_ptr<DecryptedReader>> err = api.getDecryptedReader(chunk_len);
+    ASSERT_TRUE(err.isSuccess());
+    std::unique_ptr<DecryptedReader> reader = err.returnMove();
+    EXPECT_EQ(reader->getContentLen(), data_len);
+    EXPECT_GE(reader->getChunkLen(), chunk_len);
+    Bytes read(data_len);
+    while (!reader->isDone()) {
+        ErrorStruct<std::unique_ptr<Bytes>> chunk = reader->next();
+        ASSERT_TRUE(chunk.isSuccess());
+        EXPECT_EQ(chunk.returnRef()->getLen(), std::min<u_int64_t>(reader->getChunkLen(), data_len - read.getLen()));
+        chunk.returnRef()->addcopyToBytes(read);
+        EXPECT_EQ(reader->getPosition(), read.getLen());
+    }
+    EXPECT_EQ(read, data);
+    EXPECT_EQ(reader->next().returnRef()->getLen(), 0);
+    std::filesystem::remove(file);
+}
+
+TEST(DecryptedReaderClass, formats) {
+    // the chains are continued between the chunks in every format
+    DataHeaderSettingsIters ds = getTestVaultSettings();
+    checkReader(ds, 10000, 1000);
+    checkReader(ds, 10000, 1);
+    checkReader(ds, 10000, 20000);
+    checkReader(ds, 0, 1000);
+    ds.setBlockLen(256);
+    checkReader(ds, 10000, 1000);
+    DataHeaderSettingsIters shards = getTestVaultSettings();
+    shards.setShardCount(4);
+    checkReader(shards, 10001, 1000);
+    checkReader(shards, 10001, 3000);
+    DataHeaderSettingsIters aead = getTestVaultSettings();
+    aead.setCipherMode(CIPHERMODE_AES256GCM);
+    checkReader(aead, 3 * AEAD_CHUNK_LEN + 5, AEAD_CHUNK_LEN / 2);
+}
+
+TEST(DecryptedReaderClass, state) {
+    // a reader is only created in the PASSWORD_VERIFIED state and fails after the API left it
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(1000);
+    data.fillrandom();
+    writeTestVault(file, getTestVaultSettings(), data);
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    EXPECT_EQ(api.getDecryptedReader().errorCode, ERR_API_STATE_INVALID);
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    EXPECT_EQ(api.getDecryptedReader(0).errorCode, ERR_ARGUMENT_INVALID);
+    std::unique_ptr<DecryptedReader> reader = api.getDecryptedReader(64).returnMove();
+    EXPECT_EQ(*reader->next().returnRef(), data.copySubBytes(0, 64));
+    // the reader can be dropped early, the API is not changed
+    std::unique_ptr<DecryptedReader> other = api.getDecryptedReader(64).returnMove();
+    other.reset();
+    EXPECT_EQ(*api.decryptRange(64, 64).returnRef(), data.copySubBytes(64, 128));
+    EXPECT_EQ(*reader->next().returnRef(), data.copySubBytes(64, 128));
+    // a change of the content invalidates the reader, a new reader reads the new content
+    ASSERT_TRUE(api.appendData(data).isSuccess());
+    EXPECT_EQ(reader->next().errorCode, ERR_API_STATE_INVALID);
+    EXPECT_EQ(reader->getPosition(), 128);
+    reader = api.getDecryptedReader(64).returnMove();
+    EXPECT_EQ(reader->getContentLen(), 2000);
+    ASSERT_TRUE(api.getDecryptedData().isSuccess());
+    EXPECT_EQ(reader->next().errorCode, ERR_API_STATE_INVALID);
+    // the API comes back to the PASSWORD_VERIFIED state with the same file (the new data header can get the address of the old one)
+    api.logout();
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    reader = api.getDecryptedReader(64).returnMove();
+    api.logout();
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    EXPECT_EQ(reader->next().errorCode, ERR_API_STATE_INVALID);
+    std::filesystem::remove(file);
+}
@@ -2,10 +2,13 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 #include <sstream>
 
 #include "dataheader_generator.h"
 #include "rng.h"
+#include "sha512.h"
 
 TEST(FileHandlerClass, statics) {
     EXPECT_EQ(FileHandler::extension, ".enc");
@@ -183,3 +186,344 @@ TEST(FileHandlerClass, complex_filled) {
         EXPECT_EQ(dh->getFileSize(), file_handler.getHeaderSize());
     }
 }
+
+TEST(FileHandlerClass, data_mapping) {
+    for (int i = 0; i < 10; i++) {
+        Bytes tmp(64);
+        tmp.fillrandom();
+        Bytes data(1000 + i * 4096);
+        data.fillrandom();
+        std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+        FileHandler::createFile(path);
+        DataHeaderParts dhp;
+        dhp.setHashMode(HASHMODE_SHA512);
+        dhp.setFileDataMode(FILEMODE_PASSWORD);
+        dhp.setEncSalt(tmp);
+        dhp.setValidPasswordHash(tmp);
+        CHModes chm1 = CHAINHASH_CONSTANT_COUNT_SALT;
+        CHModes chm2 = CHAINHASH_QUADRATIC;
+        std::unique_ptr<ChainHashData> chd1 = std::make_unique<ChainHashData>(Format(chm1));
+        std::unique_ptr<ChainHashData> chd2 = std::make_unique<ChainHashData>(Format(chm2));
+        chd1->generateRandomData();
+        chd2->generateRandomData();
+        dhp.chainhash1 = ChainHash(chm1, 1000, std::move(chd1));
+        dhp.chainhash2 = ChainHash(chm2, 1000, std::move(chd2));
+        std::unique_ptr<DataHeader> dh = DataHeader::setHeaderParts(dhp).returnMove();
+        dh->setDataSize(data.getLen());
+        EXPECT_NO_THROW(dh->calcHeaderBytes());
+        FileHandler file_handler(path);
+        // no data to map
+        ErrorStruct<std::unique_ptr<FileMapping>> err = file_handler.getDataMapping();
+        EXPECT_FALSE(err.isSuccess());
+        EXPECT_EQ(err.errorCode, ERR_FILE_NOT_MAPPED);
+
+        std::ofstream file = file_handler.getWriteStreamIfEmpty().returnMove();
+        file << dh->getHeaderBytes();
+        file << data;
+        file.close();
+        EXPECT_NO_THROW(file_handler.update());
+        // the mapping exposes exactly the data without the header
+        err = file_handler.getDataMapping();
+        EXPECT_TRUE(err.isSuccess());
+        EXPECT_EQ(err.returnRef()->getLen(), data.getLen());
+        EXPECT_EQ(err.returnRef()->getLen(), file_handler.getDataSize());
+        EXPECT_TRUE(std::memcmp(err.returnRef()->getData(), data.getBytes(), data.getLen()) == 0);
+    }
+}
+
+TEST(FileHandlerClass, update_stream) {
+    Bytes data(1000);
+    data.fillrandom();
+    Bytes patch(100);
+    patch.fillrandom();
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    FileHandler::createFile(path);
+    FileHandler file_handler(path);
+    std::ofstream file = file_handler.getWriteStream().returnMove();
+    file << data;
+    file.close();
+    // the update stream keeps the old content and can write behind the end
+    ErrorStruct<std::ofstream> err = file_handler.getUpdateStream();
+    EXPECT_TRUE(err.isSuccess());
+    file = err.returnMove();
+    file.seekp(950, std::ios::beg);
+    file << patch;
+    file.close();
+    std::ifstream read_file = file_handler.getFileStream();
+    std::vector<unsigned char> content((std::istreambuf_iterator<char>(read_file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content.size(), 1050);
+    EXPECT_TRUE(std::memcmp(content.data(), data.getBytes(), 950) == 0);
+    EXPECT_TRUE(std::memcmp(content.data() + 950, patch.getBytes(), 100) == 0);
+    std::filesystem::remove(path);
+    // a missing file can not be updated
+    EXPECT_FALSE(file_handler.getUpdateStream().isSuccess());
+}
+
+TEST(FileHandlerClass, positional) {
+    // reads and writes at file offsets with the descriptor that is held by the file handler
+    Bytes data(1000);
+    data.fillrandom();
+    Bytes patch(100);
+    patch.fillrandom();
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    FileHandler::createFile(path);
+    FileHandler file_handler(path);
+    EXPECT_TRUE(file_handler.writeAt(data.getBytes(), data.getLen(), 0).isSuccess());
+    // the write can go behind the end of the file and keeps the old content
+    EXPECT_TRUE(file_handler.writeAt(patch.getBytes(), patch.getLen(), 950).isSuccess());
+    EXPECT_EQ(std::filesystem::file_size(path), 1050);
+    unsigned char read[1050];
+    EXPECT_EQ(file_handler.readAt(read, 1050, 0), 1050);
+    EXPECT_TRUE(std::memcmp(read, data.getBytes(), 950) == 0);
+    EXPECT_TRUE(std::memcmp(read + 950, patch.getBytes(), 100) == 0);
+    EXPECT_EQ(file_handler.readAt(read, 100, 1000), 50);
+    EXPECT_EQ(file_handler.getFirstBytes(950), data.copySubBytes(0, 950));
+    EXPECT_EQ(file_handler.getAllBytes().getLen(), 1050);
+    file_handler.adviseReadahead(0, 1050);
+
+    // the path is replaced by a new file, update opens the new file
+    std::filesystem::remove(path);
+    FileHandler::createFile(path);
+    EXPECT_NO_THROW(file_handler.update());
+    EXPECT_TRUE(file_handler.isEmtpy());
+    EXPECT_EQ(file_handler.readAt(read, 10, 0), 0);
+
+    // a read only file can be read but not written
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read, std::filesystem::perm_options::replace);
+    if (access(path.c_str(), W_OK) != 0) {
+        // root can write to every file
+        FileHandler read_only(path);
+        EXPECT_EQ(read_only.writeAt(data.getBytes(), 10, 0).errorCode, ERR_FILE_NOT_OPEN);
+        EXPECT_TRUE(read_only.isEmtpy());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(FileHandlerClass, write_parts) {
+    // replaces the content of the file with parts that are written from their own buffers
+    Bytes header = DataHeaderGen::generateDH();
+    Bytes data(100000);
+    data.fillrandom();
+    // the header stores the size of the whole file
+    Bytes file_size = Bytes::fromLong(header.getLen() + data.getLen(), true);
+    std::memcpy(header.getBytes(), file_size.getBytes(), 8);
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    FileHandler::createFile(path);
+    FileHandler file_handler(path);
+    std::ofstream file = file_handler.getWriteStream().returnMove();
+    file << data;
+    file << data;
+    file.close();
+    EXPECT_TRUE(file_handler.writeParts({{header.getBytes(), 10}, {nullptr, 0}, {header.getBytes() + 10, header.getLen() - 10}, {data.getBytes(), data.getLen()}}).isSuccess());
+    // the old content is cut off and the sizes are updated
+    EXPECT_EQ(std::filesystem::file_size(path), header.getLen() + data.getLen());
+    EXPECT_EQ(file_handler.getFileSize(), header.getLen() + data.getLen());
+    EXPECT_EQ(file_handler.getHeaderSize(), header.getLen());
+    EXPECT_EQ(file_handler.getFirstBytes(header.getLen()), header);
+    Bytes read(data.getLen());
+    EXPECT_EQ(file_handler.readAt(read.getBytes(), data.getLen(), header.getLen()), data.getLen());
+    read.setLen(data.getLen());
+    EXPECT_EQ(read, data);
+    // no parts empty the file
+    EXPECT_TRUE(file_handler.writeParts({}).isSuccess());
+    EXPECT_TRUE(file_handler.isEmtpy());
+    // a removed file is not written
+    std::filesystem::remove(path);
+    EXPECT_EQ(file_handler.writeParts({{data.getBytes(), data.getLen()}}).errorCode, ERR_FILE_NOT_FOUND);
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(FileHandlerClass, journal) {
+    // the journaled writes go through a journal next to the file, the next FileHandler replays a complete journal and removes a torn one
+    Bytes header = DataHeaderGen::generateDH();
+    Bytes data(100000);
+    data.fillrandom();
+    std::memcpy(header.getBytes(), Bytes::fromLong(header.getLen() + data.getLen(), true).getBytes(), 8);
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    std::filesystem::path journal_path = FileHandler::getJournalPath(path);
+    EXPECT_EQ(journal_path.filename().string(), "." + path.filename().string() + JOURNAL_SUFFIX);
+    FileHandler::createFile(path);
+    FileHandler file_handler(path);
+    EXPECT_TRUE(file_handler.writeParts({{header.getBytes(), header.getLen()}, {data.getBytes(), data.getLen()}}).isSuccess());
+
+    // the file is cut and patched, the journal is removed afterwards
+    Bytes patch(100);
+    patch.fillrandom();
+    std::memcpy(header.getBytes(), Bytes::fromLong(header.getLen() + 50000, true).getBytes(), 8);
+    EXPECT_TRUE(file_handler.writeJournaled({JournalWrite{0, header.getBytes(), header.getLen()}, JournalWrite{header.getLen() + 10, patch.getBytes(), patch.getLen()}}, header.getLen() + 50000).isSuccess());
+    EXPECT_FALSE(std::filesystem::exists(journal_path));
+    EXPECT_EQ(file_handler.getFileSize(), header.getLen() + 50000);
+    std::memcpy(data.getBytes() + 10, patch.getBytes(), patch.getLen());
+    Bytes expected(header.getLen() + 60000);
+    header.addcopyToBytes(expected);
+    data.copySubBytes(0, 50000).addcopyToBytes(expected);
+    EXPECT_EQ(file_handler.getAllBytes(), expected);
+
+    // the program stops after the journal is written, the next FileHandler applies it
+    patch = Bytes(10000);
+    patch.fillrandom();
+    std::memcpy(header.getBytes(), Bytes::fromLong(header.getLen() + 60000, true).getBytes(), 8);
+    EXPECT_TRUE(file_handler.writeJournal({JournalWrite{0, header.getBytes(), header.getLen()}, JournalWrite{header.getLen() + 50000, patch.getBytes(), patch.getLen()}}, header.getLen() + 60000).isSuccess());
+    EXPECT_TRUE(std::filesystem::exists(journal_path));
+    EXPECT_EQ(std::filesystem::file_size(path), header.getLen() + 50000);
+    {
+        FileHandler replayed(path);
+        EXPECT_FALSE(std::filesystem::exists(journal_path));
+        EXPECT_EQ(replayed.getFileSize(), header.getLen() + 60000);
+        std::memcpy(expected.getBytes(), header.getBytes(), header.getLen());
+        patch.addcopyToBytes(expected);
+        EXPECT_EQ(replayed.getAllBytes(), expected);
+    }
+
+    // the program stops while the journal is written, the journal is removed and the file keeps its content
+    Bytes torn_header = header;
+    std::memcpy(torn_header.getBytes(), Bytes::fromLong(header.getLen(), true).getBytes(), 8);
+    EXPECT_TRUE(file_handler.writeJournal({JournalWrite{0, torn_header.getBytes(), torn_header.getLen()}}, torn_header.getLen()).isSuccess());
+    std::filesystem::resize_file(journal_path, std::filesystem::file_size(journal_path) - 1);
+    {
+        FileHandler torn(path);
+        EXPECT_FALSE(std::filesystem::exists(journal_path));
+        EXPECT_EQ(torn.getAllBytes(), expected);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(FileHandlerClass, integrity) {
+    // verifies the data with the integrity tree of the header, damaged Bytes are reported as file offsets
+    Bytes tmp(64);
+    tmp.fillrandom();
+    Bytes data(10 * MIN_INTEGRITY_LEAF_LEN + 100);
+    data.fillrandom();
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    FileHandler::createFile(path);
+    DataHeaderParts dhp;
+    dhp.setHashMode(HASHMODE_SHA512);
+    dhp.setFileDataMode(FILEMODE_PASSWORD);
+    dhp.setEncSalt(tmp);
+    dhp.setValidPasswordHash(tmp);
+    CHModes chm1 = CHAINHASH_CONSTANT_COUNT_SALT;
+    CHModes chm2 = CHAINHASH_QUADRATIC;
+    std::unique_ptr<ChainHashData> chd1 = std::make_unique<ChainHashData>(Format(chm1));
+    std::unique_ptr<ChainHashData> chd2 = std::make_unique<ChainHashData>(Format(chm2));
+    chd1->generateRandomData();
+    chd2->generateRandomData();
+    dhp.chainhash1 = ChainHash(chm1, 1000, std::move(chd1));
+    dhp.chainhash2 = ChainHash(chm2, 1000, std::move(chd2));
+    std::unique_ptr<DataHeader> dh = DataHeader::setHeaderParts(dhp).returnMove();
+    dh->setDataSize(data.getLen());
+    EXPECT_NO_THROW(dh->calcHeaderBytes());
+    FileHandler file_handler(path);
+    std::ofstream file = file_handler.getWriteStreamIfEmpty().returnMove();
+    file << dh->getHeaderBytes();
+    file << data;
+    file.close();
+    // no integrity tree in the header
+    ErrorStruct<IntegrityReport> err = file_handler.verifyIntegrity();
+    EXPECT_FALSE(err.isSuccess());
+    EXPECT_EQ(err.errorCode, ERR_INTEGRITY_TREE_MISSING);
+
+    // the datablock keeps its length if the tree changes
+    IntegrityTree tree = MerkleTree::build(sha512(), data.getBytes(), data.getLen(), MIN_INTEGRITY_LEAF_LEN);
+    EXPECT_EQ(DataHeader::createIntegrityDataBlock(tree).getData().getLen(), DataHeader::createIntegrityDataBlock(MerkleTree::build(sha512(), nullptr, 0, MIN_INTEGRITY_LEAF_LEN)).getData().getLen());
+    dh->addDataBlock(DataHeader::createIntegrityDataBlock(tree));
+    dh->setDataSize(data.getLen());
+    EXPECT_NO_THROW(dh->calcHeaderBytes());
+    EXPECT_EQ(dh->getIntegrityTree().root, tree.root);
+    file = file_handler.getWriteStream().returnMove();
+    file << dh->getHeaderBytes();
+    file << data;
+    file.close();
+    err = file_handler.verifyIntegrity(2);
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_TRUE(err.returnRef().valid);
+
+    // damage one Byte of the data
+    u_int64_t pos = dh->getHeaderLength() + 5 * MIN_INTEGRITY_LEAF_LEN + 3;
+    file = file_handler.getUpdateStream().returnMove();
+    file.seekp(pos, std::ios::beg);
+    file << (unsigned char)(data.getBytes()[pos - dh->getHeaderLength()] ^ 1);
+    file.close();
+    err = file_handler.verifyIntegrity();
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_FALSE(err.returnRef().valid);
+    ASSERT_EQ(err.returnRef().damaged.size(), 1);
+    EXPECT_EQ(err.returnRef().damaged[0].first, dh->getHeaderLength() + 5 * MIN_INTEGRITY_LEAF_LEN);
+    EXPECT_EQ(err.returnRef().damaged[0].second, MIN_INTEGRITY_LEAF_LEN);
+    std::filesystem::remove(path);
+}
+
+TEST(FileHandlerClass, checksum) {
+    // verifies the checksum over the header and the data, files without a checksum datablock are accepted
+    Bytes tmp(64);
+    tmp.fillrandom();
+    Bytes data(5000);
+    data.fillrandom();
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    FileHandler::createFile(path);
+    DataHeaderParts dhp;
+    dhp.setHashMode(HASHMODE_SHA512);
+    dhp.setFileDataMode(FILEMODE_PASSWORD);
+    dhp.setEncSalt(tmp);
+    dhp.setValidPasswordHash(tmp);
+    CHModes chm1 = CHAINHASH_CONSTANT_COUNT_SALT;
+    CHModes chm2 = CHAINHASH_QUADRATIC;
+    std::unique_ptr<ChainHashData> chd1 = std::make_unique<ChainHashData>(Format(chm1));
+    std::unique_ptr<ChainHashData> chd2 = std::make_unique<ChainHashData>(Format(chm2));
+    chd1->generateRandomData();
+    chd2->generateRandomData();
+    dhp.chainhash1 = ChainHash(chm1, 1000, std::move(chd1));
+    dhp.chainhash2 = ChainHash(chm2, 1000, std::move(chd2));
+    std::unique_ptr<DataHeader> dh = DataHeader::setHeaderParts(dhp).returnMove();
+    dh->setDataSize(data.getLen());
+    EXPECT_NO_THROW(dh->calcHeaderBytes());
+    FileHandler file_handler(path);
+    std::ofstream file = file_handler.getWriteStreamIfEmpty().returnMove();
+    file << dh->getHeaderBytes();
+    file << data;
+    file.close();
+    // no checksum in the header
+    EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+
+    dh->addDataBlock(DataHeader::createChecksumDataBlock());
+    dh->setDataSize(data.getLen());
+    EXPECT_NO_THROW(dh->calcHeaderBytes());
+    EXPECT_NO_THROW(dh->setChecksum(data.getBytes(), data.getLen()));
+    EXPECT_EQ(dh->getHeaderBytes().getLen(), dh->getHeaderLength());
+    file = file_handler.getWriteStream().returnMove();
+    file << dh->getHeaderBytes();
+    file << data;
+    file.close();
+    EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+    // the parsed header stores the same checksum
+    std::unique_ptr<DataHeader> dh2 = file_handler.getDataHeader().returnMove();
+    EXPECT_TRUE(dh2->hasDataBlock(DatablockType::CHECKSUM));
+    EXPECT_EQ(dh2->getHeaderBytes(), dh->getHeaderBytes());
+
+    // damage one Byte of the data and one Byte of the header
+    for (u_int64_t pos : {(u_int64_t)dh->getHeaderLength() + 1234, (u_int64_t)dh->getHeaderLength() - 10}) {
+        unsigned char old = dh->getHeaderBytes().getLen() > pos ? dh->getHeaderBytes().getBytes()[pos] : data.getBytes()[pos - dh->getHeaderLength()];
+        file = file_handler.getUpdateStream().returnMove();
+        file.seekp(pos, std::ios::beg);
+        file << (unsigned char)(old ^ 1);
+        file.close();
+        ErrorStruct<bool> err = file_handler.verifyChecksum();
+        EXPECT_FALSE(err.isSuccess());
+        EXPECT_EQ(err.errorCode, ERR_CHECKSUM_MISMATCH);
+        // the header checksum does not hash the data, the data checksum does not check the header
+        bool header_damaged = pos < dh->getHeaderLength();
+        EXPECT_EQ(file_handler.verifyHeaderChecksum().isSuccess(), !header_damaged);
+        EXPECT_EQ(file_handler.verifyDataChecksum().isSuccess(), header_damaged);
+        file = file_handler.getUpdateStream().returnMove();
+        file.seekp(pos, std::ios::beg);
+        file << old;
+        file.close();
+        EXPECT_TRUE(file_handler.verifyChecksum().isSuccess());
+    }
+
+    // cut off the file
+    std::filesystem::resize_file(path, dh->getHeaderLength() + data.getLen() - 1);
+    ErrorStruct<bool> err = file_handler.verifyChecksum();
+    EXPECT_FALSE(err.isSuccess());
+    EXPECT_EQ(err.errorCode, ERR_FILESIZE_INVALID);
+    std::filesystem::remove(path);
+}
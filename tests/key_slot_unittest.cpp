@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "api.h"
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+DataHeaderSettingsIters getKeySlotSettings() {
+    // cheap chainhashes with four key slots
+    DataHeaderSettingsIters ds = getTestVaultSettings();
+    ds.setKeySlotCount(4);
+    return ds;
+}
+
+TEST(KeySlotClass, passwords) {
+    // every password of a slot unlocks the same content, the content is not written again
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data(10000);
+    data.fillrandom();
+    writeTestVault(file, getKeySlotSettings(), data);
+    u_int64_t file_size = std::filesystem::file_size(file);
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    EXPECT_EQ(api.addPassword("other").errorCode, ERR_API_STATE_INVALID);
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    EXPECT_EQ(*api.getDecryptedReader().returnRef()->next().returnRef(), data);
+
+    ASSERT_TRUE(api.addPassword("second").isSuccess());
+    ASSERT_TRUE(api.addPassword("third").isSuccess());
+    EXPECT_EQ(api.addPassword("second").errorCode, ERR_ARGUMENT_INVALID);
+    EXPECT_EQ(std::filesystem::file_size(file), file_size);
+    EXPECT_TRUE(checkTestVault(file, "password", data).isSuccess());
+    EXPECT_TRUE(checkTestVault(file, "second", data).isSuccess());
+    EXPECT_TRUE(checkTestVault(file, "third", data).isSuccess());
+    EXPECT_EQ(checkTestVault(file, "wrong", data).errorCode, ERR_PASSWORD_INVALID);
+
+    // the first password is changed, the header validator moves to the new password
+    EXPECT_EQ(api.changePassword("wrong", "new").errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_EQ(api.changePassword("password", "second").errorCode, ERR_ARGUMENT_INVALID);
+    ASSERT_TRUE(api.changePassword("password", "new").isSuccess());
+    EXPECT_FALSE(std::filesystem::exists(FileHandler::getJournalPath(file)));
+    EXPECT_EQ(checkTestVault(file, "password", data).errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_TRUE(checkTestVault(file, "new", data).isSuccess());
+    EXPECT_TRUE(checkTestVault(file, "second", data).isSuccess());
+    ASSERT_TRUE(api.addPassword("fourth").isSuccess());
+    EXPECT_EQ(api.addPassword("fifth").errorCode, ERR_KEYSLOTS_FULL);
+
+    // the API stays unlocked, the content can be read and changed
+    EXPECT_EQ(*api.decryptRange(100, 100).returnRef(), data.copySubBytes(100, 200));
+    ASSERT_TRUE(api.appendData(data).isSuccess());
+    Bytes appended(20000);
+    data.addcopyToBytes(appended);
+    data.addcopyToBytes(appended);
+    EXPECT_TRUE(checkTestVault(file, "fourth", appended).isSuccess());
+    file_size = std::filesystem::file_size(file);
+
+    // a password is removed, the last one is kept
+    ASSERT_TRUE(api.removePassword("new").isSuccess());
+    ASSERT_TRUE(api.removePassword("third").isSuccess());
+    ASSERT_TRUE(api.removePassword("fourth").isSuccess());
+    EXPECT_EQ(api.removePassword("second").errorCode, ERR_KEYSLOT_LAST);
+    EXPECT_EQ(api.removePassword("new").errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_EQ(checkTestVault(file, "new", appended).errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_TRUE(checkTestVault(file, "second", appended).isSuccess());
+    EXPECT_EQ(std::filesystem::file_size(file), file_size);
+    std::filesystem::remove(file);
+}
+
+TEST(KeySlotClass, formats) {
+    // the key slots work with every content format and the session cache
+    for (int format = 0; format < 3; format++) {
+        std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+        DataHeaderSettingsIters ds = getKeySlotSettings();
+        if (format == 1) ds.setShardCount(4);
+        if (format == 2) ds.setCipherMode(CIPHERMODE_AES256GCM);
+        Bytes data(5000);
+        data.fillrandom();
+        writeTestVault(file, ds, data);
+        std::shared_ptr<SessionCache> cache = std::make_shared<SessionCache>();
+        {
+            API api{FILEMODE_PASSWORD, cache};
+            ASSERT_TRUE(api.selectFile(file).isSuccess());
+            ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+            ASSERT_TRUE(api.changePassword("password", "new").isSuccess());
+        }
+        API api{FILEMODE_PASSWORD, cache};
+        ASSERT_TRUE(api.selectFile(file).isSuccess());
+        ASSERT_TRUE(api.unlockFromSession().isSuccess());
+        EXPECT_EQ(*api.getDecryptedData().returnRef()->dec_data, data);
+        EXPECT_TRUE(checkTestVault(file, "new", data).isSuccess());
+        std::filesystem::remove(file);
+    }
+}
+
+TEST(KeySlotClass, without_slots) {
+    // files without key slots use the password hash as the content key, the password cannot be changed in place
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    DataHeaderSettingsIters ds = getKeySlotSettings();
+    DataHeaderSettingsIters legacy;
+    legacy.setFileDataMode(FILEMODE_PASSWORD);
+    legacy.setHashMode(HASHMODE_SHA256);
+    legacy.setChainHash1Mode(CHAINHASH_NORMAL);
+    legacy.setChainHash2Mode(CHAINHASH_NORMAL);
+    legacy.setChainHash1Iters(10);
+    legacy.setChainHash2Iters(10);
+    Bytes data(100);
+    data.fillrandom();
+    writeTestVault(file, legacy, data);
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword("password").isSuccess());
+    EXPECT_EQ(api.addPassword("other").errorCode, ERR_KEYSLOTS_NOT_SUPPORTED);
+    EXPECT_EQ(api.changePassword("password", "other").errorCode, ERR_KEYSLOTS_NOT_SUPPORTED);
+    EXPECT_EQ(api.removePassword("password").errorCode, ERR_KEYSLOTS_NOT_SUPPORTED);
+    EXPECT_THROW(ds.setKeySlotCount(0), std::invalid_argument);
+    EXPECT_THROW(ds.setKeySlotCount(MAX_KEY_SLOTS + 1), std::invalid_argument);
+
+    // a cancelled control stops the call before the header is written
+    std::filesystem::path slots_file = RNG::get_random_string(10) + ".enc";
+    writeTestVault(slots_file, ds, data);
+    API slots_api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(slots_api.selectFile(slots_file).isSuccess());
+    ASSERT_TRUE(slots_api.verifyPassword("password").isSuccess());
+    ChainHashControl control;
+    control.cancel();
+    EXPECT_EQ(slots_api.addPassword("other", &control).errorCode, ERR_CANCELLED);
+    EXPECT_EQ(checkTestVault(slots_file, "other", data).errorCode, ERR_PASSWORD_INVALID);
+    std::filesystem::remove(file);
+    std::filesystem::remove(slots_file);
+}
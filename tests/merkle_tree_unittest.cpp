@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "merkle_tree.h"
+#include "sha256.h"
+#include "sha512.h"
+
+TEST(MerkleTreeClass, layout) {
+    // the leaves are grouped into at most INTEGRITY_REGIONS regions that cover the whole data
+    const u_int64_t leaf_len = MIN_INTEGRITY_LEAF_LEN;
+    EXPECT_EQ(MerkleTree::getLeafCount(0, leaf_len), 1);
+    EXPECT_EQ(MerkleTree::getLeafCount(leaf_len, leaf_len), 1);
+    EXPECT_EQ(MerkleTree::getLeafCount(leaf_len + 1, leaf_len), 2);
+    EXPECT_EQ(MerkleTree::getRegionCount(0, leaf_len), 1);
+    EXPECT_EQ(MerkleTree::getRegionCount(3 * leaf_len, leaf_len), 3);
+    EXPECT_EQ(MerkleTree::getRegionCount(1000 * leaf_len, leaf_len), INTEGRITY_REGIONS);
+    for (u_int64_t data_len : {u_int64_t(0), u_int64_t(1), leaf_len, 5 * leaf_len + 7, 100 * leaf_len + 1, 1000 * leaf_len}) {
+        u_int64_t region_count = MerkleTree::getRegionCount(data_len, leaf_len);
+        EXPECT_LE(region_count, INTEGRITY_REGIONS);
+        u_int64_t covered = 0;
+        for (u_int64_t region = 0; region < region_count; region++) {
+            std::pair<u_int64_t, u_int64_t> range = MerkleTree::getRegionRange(data_len, leaf_len, region);
+            EXPECT_EQ(range.first, covered);
+            EXPECT_EQ(range.first % leaf_len, 0);
+            if (data_len != 0) EXPECT_GT(range.second, 0);
+            covered += range.second;
+        }
+        EXPECT_EQ(covered, data_len);
+    }
+}
+
+TEST(MerkleTreeClass, root) {
+    // the root of three leaves is H(0x01 | H(0x01 | l0 | l1) | l2)
+    sha256 hash;
+    std::vector<Bytes> nodes;
+    for (int i = 0; i < 3; i++) {
+        Bytes node(32);
+        node.fillrandom();
+        nodes.push_back(node);
+    }
+    Bytes input(65);
+    input.addByte(0x01);
+    nodes[0].addcopyToBytes(input);
+    nodes[1].addcopyToBytes(input);
+    Bytes left = hash.hash(input);
+    input.setLen(0);
+    input.addByte(0x01);
+    left.addcopyToBytes(input);
+    nodes[2].addcopyToBytes(input);
+    EXPECT_EQ(MerkleTree::getRoot(hash, nodes), hash.hash(input));
+    EXPECT_EQ(MerkleTree::getRoot(hash, {nodes[0]}), nodes[0]);
+    EXPECT_THROW(MerkleTree::getRoot(hash, {}), std::invalid_argument);
+
+    // one leaf is H(0x00 | data)
+    Bytes data(100);
+    data.fillrandom();
+    Bytes leaf(101);
+    leaf.addByte(0x00);
+    data.addcopyToBytes(leaf);
+    EXPECT_EQ(MerkleTree::build(hash, data.getBytes(), data.getLen(), MIN_INTEGRITY_LEAF_LEN).root, hash.hash(leaf));
+    EXPECT_THROW(MerkleTree::build(hash, data.getBytes(), data.getLen(), MIN_INTEGRITY_LEAF_LEN - 1), std::invalid_argument);
+}
+
+TEST(MerkleTreeClass, verify) {
+    // the tree does not depend on the number of threads, damaged Bytes are reported with their region
+    sha512 hash;
+    const u_int64_t leaf_len = MIN_INTEGRITY_LEAF_LEN;
+    for (u_int64_t data_len : {u_int64_t(0), u_int64_t(10), 3 * leaf_len + 5, 40 * leaf_len}) {
+        Bytes data(data_len);
+        data.fillrandom();
+        IntegrityTree tree = MerkleTree::build(hash, data.getBytes(), data_len, leaf_len, 1);
+        EXPECT_EQ(tree.root.getLen(), 64);
+        EXPECT_EQ(tree.regions.size(), tree.region_count);
+        IntegrityTree tree2 = MerkleTree::build(hash, data.getBytes(), data_len, leaf_len, 4);
+        EXPECT_EQ(tree.root, tree2.root);
+        IntegrityReport report = MerkleTree::verify(hash, tree, data.getBytes(), data_len, 3);
+        EXPECT_TRUE(report.valid);
+        EXPECT_TRUE(report.damaged.empty());
+        if (data_len == 0) continue;
+
+        // flip one Byte in the last region
+        u_int64_t pos = data_len - 1;
+        data.getBytes()[pos] ^= 1;
+        report = MerkleTree::verify(hash, tree, data.getBytes(), data_len);
+        EXPECT_FALSE(report.valid);
+        ASSERT_EQ(report.damaged.size(), 1);
+        EXPECT_LE(report.damaged[0].first, pos);
+        EXPECT_GT(report.damaged[0].first + report.damaged[0].second, pos);
+        EXPECT_EQ(report.damaged[0], MerkleTree::getRegionRange(data_len, leaf_len, tree.region_count - 1));
+        data.getBytes()[pos] ^= 1;
+
+        // cut off data
+        report = MerkleTree::verify(hash, tree, data.getBytes(), data_len - 1);
+        EXPECT_FALSE(report.valid);
+        EXPECT_FALSE(report.damaged.empty());
+    }
+}
+
+TEST(MerkleTreeClass, leaves) {
+    // the tree built from the leaf hashes is the same as the tree built from the data, one leaf hash is H(0x00 | leaf)
+    sha256 hash;
+    const u_int64_t leaf_len = MIN_INTEGRITY_LEAF_LEN;
+    for (u_int64_t data_len : {u_int64_t(0), u_int64_t(10), 3 * leaf_len + 5, 40 * leaf_len, 1000 * leaf_len + 1}) {
+        Bytes data(data_len);
+        data.fillrandom();
+        std::vector<Bytes> leaves = MerkleTree::getLeafHashes(hash, data.getBytes(), data_len, leaf_len, 3);
+        ASSERT_EQ(leaves.size(), MerkleTree::getLeafCount(data_len, leaf_len));
+        EXPECT_EQ(leaves.back(), MerkleTree::getLeafHash(hash, data.getBytes() + (leaves.size() - 1) * leaf_len, data_len - (leaves.size() - 1) * leaf_len));
+        IntegrityTree tree = MerkleTree::build(hash, data.getBytes(), data_len, leaf_len);
+        IntegrityTree tree2 = MerkleTree::buildFromLeaves(hash, leaves, data_len, leaf_len);
+        EXPECT_EQ(tree.root, tree2.root);
+        EXPECT_EQ(tree.regions, tree2.regions);
+        EXPECT_TRUE(MerkleTree::verifyLeaves(hash, tree, leaves, data_len).valid);
+        // the full region hashes are the regions of the data, the tree can be built from them alone
+        std::vector<Bytes> regions = MerkleTree::getRegionHashesFromLeaves(hash, leaves, data_len, leaf_len);
+        EXPECT_EQ(regions, MerkleTree::getRegionHashes(hash, data.getBytes(), data_len, leaf_len));
+        EXPECT_EQ(MerkleTree::buildFromRegions(hash, regions, leaf_len).root, tree.root);
+
+        // a changed leaf hash is reported with its region
+        leaves[0].getBytes()[0] ^= 1;
+        IntegrityReport report = MerkleTree::verifyLeaves(hash, tree, leaves, data_len);
+        EXPECT_FALSE(report.valid);
+        ASSERT_EQ(report.damaged.size(), 1);
+        EXPECT_EQ(report.damaged[0], MerkleTree::getRegionRange(data_len, leaf_len, 0));
+        leaves.pop_back();
+        EXPECT_THROW(MerkleTree::buildFromLeaves(hash, leaves, data_len, leaf_len), std::invalid_argument);
+    }
+}
@@ -0,0 +1,74 @@
+#include "password_data.h"
+
+#include <gtest/gtest.h>
+
+TEST(PasswordDataClass, bytes) {
+    // the sets are stored with one length byte in front of every string
+    PasswordData data;
+    data.addPw(PasswordSet{"site", "user", "mail", "pass"});
+    data.addPw(PasswordSet{"site", "user2", "", "pass2"});
+    data.addPw(PasswordSet{"Other", "", "mail3", std::string(255, 'x')});
+    EXPECT_EQ(data.getSetCount(), 3);
+    EXPECT_THROW(data.addPw(PasswordSet{std::string(256, 's'), "", "", ""}), std::invalid_argument);
+
+    Bytes set = PasswordData::getSetBytes(PasswordSet{"ab", "c", "", "d"});
+    ASSERT_EQ(set.getLen(), 8);
+    EXPECT_EQ(set.getBytes()[0], 2);
+    EXPECT_EQ(set.getBytes()[1], 'a');
+    EXPECT_EQ(set.getBytes()[3], 1);
+    EXPECT_EQ(set.getBytes()[5], 0);
+    EXPECT_EQ(set.getBytes()[6], 1);
+
+    FileDataStruct fds = data.getFileData();
+    EXPECT_EQ(fds.getFileMode(), FILEMODE_PASSWORD);
+    PasswordData data2;
+    ASSERT_TRUE(data2.constructFileData(fds).isSuccess());
+    EXPECT_EQ(data2.getSetCount(), 3);
+    std::vector<PasswordSet> sets = data2.getSiteSets("site");
+    ASSERT_EQ(sets.size(), 2);
+    EXPECT_EQ(sets[0].username, "user");
+    EXPECT_EQ(sets[1].password, "pass2");
+    EXPECT_TRUE(data2.getSiteSets("other").empty());
+    sets = data2.getSets("OTH", true);
+    ASSERT_EQ(sets.size(), 1);
+    EXPECT_EQ(sets[0].email, "mail3");
+    EXPECT_EQ(sets[0].password, std::string(255, 'x'));
+    EXPECT_EQ(data2.getSets("", true).size(), 3);
+
+    // an appended set is part of the data
+    Bytes appended(fds.dec_data->getLen() + set.getLen());
+    fds.dec_data->addcopyToBytes(appended);
+    appended.addBytes(set.getBytes(), set.getLen());
+    FileDataStruct fds2{FILEMODE_PASSWORD, std::make_unique<Bytes>(appended)};
+    ASSERT_TRUE(data2.constructFileData(fds2).isSuccess());
+    EXPECT_EQ(data2.getSetCount(), 4);
+    EXPECT_EQ(data2.getSiteSets("ab").size(), 1);
+
+    // missing Bytes
+    FileDataStruct fds3{FILEMODE_PASSWORD, std::make_unique<Bytes>(set.copySubBytes(0, 7))};
+    EXPECT_EQ(data2.constructFileData(fds3).errorCode, ERR_FILEDATA_INVALID);
+    FileDataStruct fds4{FILEMODE_PASSWORD, std::make_unique<Bytes>(set.copySubBytes(0, 4))};
+    EXPECT_EQ(data2.constructFileData(fds4).errorCode, ERR_FILEDATA_INVALID);
+}
+
+TEST(PasswordDataClass, edit) {
+    // a set is removed by all of its strings and edited by its site and username
+    PasswordData data;
+    data.addPw(PasswordSet{"site", "user", "mail", "pass"});
+    data.addPw(PasswordSet{"site", "user2", "", "pass2"});
+    data.addPw(PasswordSet{"other", "user", "mail", "pass"});
+    EXPECT_FALSE(data.remPw(PasswordSet{"site", "user", "mail", "wrong"}));
+    EXPECT_FALSE(data.remPw(PasswordSet{"missing", "user", "mail", "pass"}));
+    EXPECT_TRUE(data.remPw(PasswordSet{"site", "user", "mail", "pass"}));
+    EXPECT_EQ(data.getSetCount(), 2);
+    EXPECT_TRUE(data.remPw(PasswordSet{"other", "user", "mail", "pass"}));
+    EXPECT_TRUE(data.getSets("other", false).empty());
+
+    EXPECT_FALSE(data.editPw(PasswordSet{"site", "user", "new_mail", "new_pass"}));
+    EXPECT_TRUE(data.editPw(PasswordSet{"site", "user2", "new_mail", "new_pass"}));
+    EXPECT_THROW(data.editPw(PasswordSet{"site", "user2", "", std::string(256, 'p')}), std::invalid_argument);
+    std::vector<PasswordSet> sets = data.getSiteSets("site");
+    ASSERT_EQ(sets.size(), 1);
+    EXPECT_EQ(sets[0].email, "new_mail");
+    EXPECT_EQ(sets[0].password, "new_pass");
+}
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "rng.h"
 #include "settings.h"
 #include "sha256.h"
@@ -477,3 +479,34 @@ TEST(PWFUNCClass, timedIters) {
         EXPECT_EQ(tmp[4].result, pwf.chainhashWithQuadraticCountSalt(passwordbytes, tmp[4].iterations, l2, l3, l4, l5).returnValue());
     }
 }
+
+TEST(PWFUNCClass, control) {
+    // the chainhashes report their progress to the control and stop after it was cancelled
+    ChainHashControl control;
+    PwFunc pwf = PwFunc(std::make_shared<sha256>(), &control);
+    PwFunc pwf_plain = PwFunc(std::make_shared<sha256>());
+    EXPECT_EQ(control.getProgress(), 0);
+    control.start(10 * TIMEOUT_ITERATIONS);
+    ErrorStruct<Bytes> err = pwf.chainhashWithCountSalt("password", 5 * TIMEOUT_ITERATIONS + 1, 3);
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_EQ(err.returnRef(), pwf_plain.chainhashWithCountSalt("password", 5 * TIMEOUT_ITERATIONS + 1, 3).returnRef());
+    EXPECT_EQ(control.getDone(), 5 * TIMEOUT_ITERATIONS);
+    control.finishChainHash(5 * TIMEOUT_ITERATIONS);
+    EXPECT_DOUBLE_EQ(control.getProgress(), 0.5);
+
+    // a cancelled chainhash stops at its next check
+    std::thread canceller([&control]() {
+        while (control.getDone() < 6 * TIMEOUT_ITERATIONS) std::this_thread::yield();
+        control.cancel();
+    });
+    err = pwf.chainhashWithQuadraticCountSalt(Bytes(10), 1000000000, 1, 2, 3, 4);
+    canceller.join();
+    EXPECT_EQ(err.errorCode, ERR_CANCELLED);
+    EXPECT_LT(control.getDone(), 100 * TIMEOUT_ITERATIONS);
+    EXPECT_EQ(pwf.chainhash("password", TIMEOUT_ITERATIONS + 1).errorCode, ERR_CANCELLED);
+    // a short chainhash does not reach a check
+    EXPECT_TRUE(pwf.chainhash("password", TIMEOUT_ITERATIONS).isSuccess());
+    // the cancel is kept by a new start
+    control.start(1);
+    EXPECT_TRUE(control.isCancelled());
+}
@@ -0,0 +1,146 @@
+#include "rotation_job.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+TEST(RotationJobClass, rekey) {
+    // every vault gets the new password, a failed vault is not changed
+    std::vector<std::filesystem::path> files;
+    std::vector<Bytes> contents;
+    for (int i = 0; i < 8; i++) {
+        files.push_back(RNG::get_random_string(10) + ".enc");
+        contents.push_back(writeRandomTestVault(files.back(), i == 3 ? "other" : "password"));
+    }
+    std::filesystem::path missing = RNG::get_random_string(10) + ".enc";
+    files.push_back(missing);
+    RotationSettings settings;
+    settings.password = "password";
+    settings.new_password = "new_password";
+    EXPECT_THROW(RotationJob(files, settings), std::invalid_argument);
+    settings.settings = getTestVaultSettings();
+    settings.settings->setKeySlotCount(2);
+
+    RotationJob job{files, settings, "", 3};
+    EXPECT_EQ(job.getTotal(), 9);
+    std::atomic<size_t> progress{0};
+    std::vector<RotationReport> reports = job.run([&progress](const RotationReport& report) { progress++; });
+    ASSERT_EQ(reports.size(), 9);
+    EXPECT_EQ(progress, 9);
+    EXPECT_EQ(job.getDone(), 9);
+    for (size_t i = 0; i < contents.size(); i++) {
+        EXPECT_EQ(reports[i].file, files[i]);
+        EXPECT_FALSE(std::filesystem::exists(RotationJob::getTempPath(files[i])));
+        if (i == 3) {
+            EXPECT_EQ(reports[i].result.errorCode, ERR_PASSWORD_INVALID);
+            EXPECT_TRUE(checkTestVault(files[i], "other", contents[i]).isSuccess());
+            continue;
+        }
+        EXPECT_TRUE(reports[i].result.isSuccess());
+        EXPECT_FALSE(reports[i].skipped);
+        EXPECT_EQ(reports[i].bytes, std::filesystem::file_size(files[i]));
+        EXPECT_GT(reports[i].getTotalTime(), 0);
+        EXPECT_EQ(checkTestVault(files[i], "password", contents[i]).errorCode, ERR_PASSWORD_INVALID);
+        EXPECT_TRUE(checkTestVault(files[i], "new_password", contents[i]).isSuccess());
+    }
+    EXPECT_EQ(reports[8].result.errorCode, ERR_FILE_NOT_FOUND);
+    EXPECT_EQ(RotationJob::getTempPath("dir/vault.enc"), std::filesystem::path("dir/.vault" + ROTATION_TMP_SUFFIX + ".enc"));
+    for (size_t i = 0; i < contents.size(); i++) std::filesystem::remove(files[i]);
+}
+
+TEST(RotationJobClass, resalt) {
+    // without new settings only the salts are changed, the password stays the same
+    std::filesystem::path file = RNG::get_random_string(10) + ".enc";
+    Bytes data = writeRandomTestVault(file, "password");
+    std::ifstream before(file, std::ios::binary);
+    std::string content_before{std::istreambuf_iterator<char>(before), std::istreambuf_iterator<char>()};
+    // the rotated vault keeps the mode of the vault (not the mode of the umask), a read only vault stays read only
+    std::filesystem::permissions(file, std::filesystem::perms::owner_read | std::filesystem::perms::group_read);
+    RotationSettings settings;
+    settings.password = "password";
+    RotationJob job{{file}, settings};
+    std::vector<RotationReport> reports = job.run();
+    ASSERT_TRUE(reports[0].result.isSuccess());
+    EXPECT_TRUE(checkTestVault(file, "password", data).isSuccess());
+    EXPECT_EQ(std::filesystem::status(file).permissions(), std::filesystem::perms::owner_read | std::filesystem::perms::group_read);
+    // the salts and so the whole encrypted content changed, the size did not
+    std::ifstream after(file, std::ios::binary);
+    std::string content_after{std::istreambuf_iterator<char>(after), std::istreambuf_iterator<char>()};
+    EXPECT_EQ(content_after.size(), content_before.size());
+    EXPECT_NE(content_after, content_before);
+    std::filesystem::remove(file);
+}
+
+TEST(RotationJobClass, resume) {
+    // a second run skips the journaled vaults and the vaults that were replaced before they were journaled
+    std::filesystem::path journal = RNG::get_random_string(10) + ".journal";
+    std::vector<std::filesystem::path> files;
+    std::vector<Bytes> contents;
+    for (int i = 0; i < 4; i++) {
+        files.push_back(RNG::get_random_string(10) + ".enc");
+        contents.push_back(writeRandomTestVault(files.back(), "password"));
+    }
+    RotationSettings settings;
+    settings.password = "password";
+    settings.new_password = "new_password";
+    settings.settings = getTestVaultSettings();
+    {
+        // the first run is interrupted after two vaults, the second one is not journaled (the crash was right after its rename)
+        RotationJob job{{files[0], files[1]}, settings, journal, 1};
+        ASSERT_TRUE(job.run()[1].result.isSuccess());
+        std::ofstream file(journal, std::ios::trunc);
+        file << std::filesystem::canonical(files[0]).string() << "\n" << std::filesystem::canonical(files[1]).string().substr(0, 3);
+    }
+    // a temporary file of the crashed run is left behind
+    std::ofstream(RotationJob::getTempPath(files[2])) << "partial";
+
+    RotationJob job{files, settings, journal, 2};
+    std::vector<RotationReport> reports = job.run();
+    EXPECT_TRUE(reports[0].skipped);
+    EXPECT_TRUE(reports[1].skipped);
+    for (size_t i = 0; i < files.size(); i++) {
+        EXPECT_TRUE(reports[i].result.isSuccess());
+        EXPECT_EQ(reports[i].skipped, i < 2);
+        EXPECT_TRUE(checkTestVault(files[i], "new_password", contents[i]).isSuccess());
+    }
+    EXPECT_FALSE(std::filesystem::exists(RotationJob::getTempPath(files[2])));
+    // every vault is journaled now, a third run does nothing
+    // the journal is keyed by the canonical path, another spelling of a vault is skipped as well
+    std::vector<std::filesystem::path> spelled;
+    for (const std::filesystem::path& file : files) spelled.push_back(std::filesystem::path(".") / file);
+    RotationJob again{spelled, settings, journal};
+    for (const RotationReport& report : again.run()) EXPECT_TRUE(report.skipped);
+    for (const std::filesystem::path& file : files) std::filesystem::remove(file);
+    std::filesystem::remove(journal);
+}
+
+TEST(RotationJobClass, cancel) {
+    // the running chainhash and the queued vaults are cancelled, the cancelled vaults are not changed
+    std::vector<std::filesystem::path> files;
+    std::vector<Bytes> contents;
+    for (int i = 0; i < 3; i++) {
+        files.push_back(RNG::get_random_string(10) + ".enc");
+        contents.push_back(writeRandomTestVault(files.back(), "password"));
+    }
+    RotationSettings settings;
+    settings.password = "password";
+    settings.new_password = "new_password";
+    settings.settings = getTestVaultSettings();
+    settings.settings->setChainHash1Iters(1000000000);
+    RotationJob job{files, settings, "", 1};
+    std::thread canceller([&job]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        job.cancel();
+    });
+    std::vector<RotationReport> reports = job.run();
+    canceller.join();
+    for (size_t i = 0; i < files.size(); i++) {
+        EXPECT_EQ(reports[i].result.errorCode, ERR_CANCELLED);
+        EXPECT_TRUE(checkTestVault(files[i], "password", contents[i]).isSuccess());
+        std::filesystem::remove(files[i]);
+    }
+}
@@ -0,0 +1,103 @@
+#include "session_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "rng.h"
+
+Bytes randomBytes(const size_t len) {
+    // returns len random bytes
+    Bytes ret(len);
+    RNG::fill_random_bytes(ret, len);
+    return ret;
+}
+
+TEST(SessionCacheClass, store_lookup) {
+    // the stored key is returned as long as the validator matches
+    SessionCache cache;
+    Bytes validator = randomBytes(32);
+    Bytes key = randomBytes(64);
+    EXPECT_EQ(cache.lookup("vault.enc", validator).errorCode, ERR_SESSION_NOT_FOUND);
+    ASSERT_TRUE(cache.store("vault.enc", validator, key).isSuccess());
+    EXPECT_EQ(cache.size(), 1);
+    ErrorStruct<Bytes> err = cache.lookup("vault.enc", validator);
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_EQ(err.returnValue(), key);
+    // the same file given with another relative path
+    EXPECT_EQ(cache.lookup("./vault.enc", validator).returnValue(), key);
+    EXPECT_EQ(cache.lookup(std::filesystem::current_path() / "vault.enc", validator).returnValue(), key);
+    EXPECT_FALSE(cache.lookup("other.enc", validator).isSuccess());
+
+    // a new key replaces the old entry
+    Bytes key2 = randomBytes(64);
+    ASSERT_TRUE(cache.store("vault.enc", validator, key2).isSuccess());
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.lookup("vault.enc", validator).returnValue(), key2);
+
+    // another data header removes the entry
+    err = cache.lookup("vault.enc", randomBytes(32));
+    EXPECT_EQ(err.errorCode, ERR_SESSION_NOT_FOUND);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_FALSE(cache.lookup("vault.enc", validator).isSuccess());
+
+    ASSERT_TRUE(cache.store("vault.enc", validator, key).isSuccess());
+    ASSERT_TRUE(cache.store("vault2.enc", validator, key2).isSuccess());
+    EXPECT_EQ(cache.size(), 2);
+    cache.remove("vault.enc");
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_FALSE(cache.lookup("vault.enc", validator).isSuccess());
+    EXPECT_EQ(cache.lookup("vault2.enc", validator).returnValue(), key2);
+    // a file renamed over the vault takes its entry with it
+    cache.rename("vault2.enc", "vault.enc");
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_FALSE(cache.lookup("vault2.enc", validator).isSuccess());
+    EXPECT_EQ(cache.lookup("vault.enc", validator).returnValue(), key2);
+    cache.rename("vault2.enc", "vault.enc");
+    EXPECT_EQ(cache.lookup("vault.enc", validator).returnValue(), key2);
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(SessionCacheClass, ttl) {
+    // entries expire after the idle ttl without use and after the absolute ttl
+    Bytes validator = randomBytes(32);
+    Bytes key = randomBytes(64);
+    SessionCache idle_cache{100, 100000};
+    ASSERT_TRUE(idle_cache.store("vault.enc", validator, key).isSuccess());
+    for (int i = 0; i < 4; i++) {
+        // every lookup refreshes the idle time
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        EXPECT_TRUE(idle_cache.lookup("vault.enc", validator).isSuccess());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_EQ(idle_cache.lookup("vault.enc", validator).errorCode, ERR_SESSION_NOT_FOUND);
+    EXPECT_EQ(idle_cache.size(), 0);
+
+    SessionCache max_cache{100000, 150};
+    ASSERT_TRUE(max_cache.store("vault.enc", validator, key).isSuccess());
+    EXPECT_TRUE(max_cache.lookup("vault.enc", validator).isSuccess());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(max_cache.lookup("vault.enc", validator).isSuccess());
+    EXPECT_EQ(max_cache.size(), 0);
+}
+
+TEST(SessionCacheClass, threads) {
+    // the cache can be shared between threads
+    SessionCache cache;
+    Bytes validator = randomBytes(32);
+    std::vector<Bytes> keys;
+    for (int i = 0; i < 8; i++) keys.push_back(randomBytes(64));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&cache, &validator, &keys, i]() {
+            std::string path = "vault" + std::to_string(i) + ".enc";
+            for (int j = 0; j < 50; j++) {
+                EXPECT_TRUE(cache.store(path, validator, keys[i]).isSuccess());
+                EXPECT_EQ(cache.lookup(path, validator).returnValue(), keys[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_EQ(cache.size(), 8);
+}
@@ -0,0 +1,63 @@
+/*
+implements the vault helpers of the tests
+*/
+#include "test_vault_fixture.h"
+
+#include <gtest/gtest.h>
+
+DataHeaderSettingsIters getTestVaultSettings(const CModes cipher_mode) {
+    // cheap chainhashes, so many vaults can be created
+    DataHeaderSettingsIters ds;
+    ds.setFileDataMode(FILEMODE_PASSWORD);
+    ds.setHashMode(HASHMODE_SHA256);
+    ds.setChainHash1Mode(CHAINHASH_NORMAL);
+    ds.setChainHash2Mode(CHAINHASH_NORMAL);
+    ds.setChainHash1Iters(10);
+    ds.setChainHash2Iters(10);
+    ds.setCipherMode(cipher_mode);
+    return ds;
+}
+
+void writeTestVault(const std::filesystem::path& file, const DataHeaderSettingsIters& ds, const Bytes& data, const std::string& password) {
+    // creates the file and writes the encrypted content
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.createFile(file).isSuccess());
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.createDataHeader(password, ds).isSuccess());
+    ASSERT_TRUE(api.encryptData(std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::make_unique<Bytes>(data))).isSuccess());
+    ASSERT_TRUE(api.writeToFile().isSuccess());
+}
+
+void writeTestVault(const std::filesystem::path& file, const DataHeaderSettingsIters& ds, const FileData& data, const std::string& password) {
+    // the content is the serialized file data object
+    writeTestVault(file, ds, *data.getFileData().dec_data, password);
+}
+
+Bytes writeRandomTestVault(const std::filesystem::path& file, const std::string& password, const u_int64_t len) {
+    // the content is random
+    Bytes data(len);
+    data.fillrandom();
+    writeTestVault(file, getTestVaultSettings(), data, password);
+    return data;
+}
+
+ErrorStruct<bool> checkTestVault(const std::filesystem::path& file, const std::string& password, const Bytes& data) {
+    // a wrong password is returned as an error, so the tests can check it
+    API api{FILEMODE_PASSWORD};
+    ErrorStruct<bool> err = api.selectFile(file);
+    if (!err.isSuccess()) return err;
+    err = api.verifyPassword(password);
+    if (!err.isSuccess()) return err;
+    EXPECT_EQ(*api.getDecryptedData().returnRef()->dec_data, data);
+    return err;
+}
+
+void readTestVault(const std::filesystem::path& file, FileData& data, const std::string& password) {
+    // constructs the file data object from the decrypted content
+    API api{FILEMODE_PASSWORD};
+    ASSERT_TRUE(api.selectFile(file).isSuccess());
+    ASSERT_TRUE(api.verifyPassword(password).isSuccess());
+    ErrorStruct<std::unique_ptr<FileDataStruct>> err = api.getDecryptedData();
+    ASSERT_TRUE(err.isSuccess());
+    EXPECT_TRUE(data.constructFileData(*err.returnRef()).isSuccess());
+}
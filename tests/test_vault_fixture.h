@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "api.h"
+#include "file_data.h"
+
+// helpers that create and read vaults with cheap chainhashes, so the tests can create many vaults
+
+// the settings of a vault with cheap chainhashes, the format is set by the tests
+DataHeaderSettingsIters getTestVaultSettings(const CModes cipher_mode = CIPHERMODE_HASHCHAIN);
+
+// creates a vault with the content, the test fails if the vault cannot be written
+void writeTestVault(const std::filesystem::path& file, const DataHeaderSettingsIters& ds, const Bytes& data, const std::string& password = "password");
+// creates a vault with the content of the file data object
+void writeTestVault(const std::filesystem::path& file, const DataHeaderSettingsIters& ds, const FileData& data, const std::string& password = "password");
+// creates a vault with random content of the given length and returns the content
+Bytes writeRandomTestVault(const std::filesystem::path& file, const std::string& password, const u_int64_t len = 1000);
+
+// unlocks the vault with a new API and checks the content (the error of selectFile or verifyPassword is returned)
+ErrorStruct<bool> checkTestVault(const std::filesystem::path& file, const std::string& password, const Bytes& data);
+// decrypts the vault with a new API into the file data object, the test fails if the vault cannot be decrypted
+void readTestVault(const std::filesystem::path& file, FileData& data, const std::string& password = "password");
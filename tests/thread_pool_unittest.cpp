@@ -0,0 +1,47 @@
+#include "thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+TEST(ThreadPoolClass, threads) {
+    // test the number of worker threads
+    EXPECT_EQ(ThreadPool(3).getThreadCount(), 3);
+    EXPECT_GE(ThreadPool().getThreadCount(), 1);
+}
+
+TEST(ThreadPoolClass, results) {
+    // test that every task runs once and returns its result
+    std::atomic<int> runs(0);
+    std::vector<std::future<int>> results;
+    {
+        ThreadPool pool(4);
+        for (int i = 0; i < 100; i++) {
+            results.push_back(pool.submit([i, &runs]() {
+                runs++;
+                return i * i;
+            }));
+        }
+        for (int i = 0; i < 100; i++) EXPECT_EQ(results[i].get(), i * i);
+    }
+    EXPECT_EQ(runs, 100);
+}
+
+TEST(ThreadPoolClass, exceptions) {
+    // test that an exception of a task is passed to the future
+    ThreadPool pool(2);
+    std::future<void> failing = pool.submit([]() { throw std::runtime_error("task failed"); });
+    std::future<int> working = pool.submit([]() { return 1; });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+    EXPECT_EQ(working.get(), 1);
+}
+
+TEST(ThreadPoolClass, destructor) {
+    // test that the destructor waits for the submitted tasks
+    std::atomic<int> runs(0);
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 10; i++) pool.submit([&runs]() { runs++; });
+    }
+    EXPECT_EQ(runs, 10);
+}
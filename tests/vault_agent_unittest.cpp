@@ -0,0 +1,125 @@
+#include "vault_agent.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+TEST(VaultAgentClass, requests) {
+    // the clients see the sets of the vault and the added sets, the added sets are written to the vault
+    for (CModes cipher_mode : {CIPHERMODE_HASHCHAIN, CIPHERMODE_AES256GCM}) {
+        std::filesystem::path vault = RNG::get_random_string(10) + ".enc";
+        std::filesystem::path socket_path = RNG::get_random_string(10) + ".sock";
+        PasswordData data;
+        data.addPw(PasswordSet{"github.com", "user", "user@mail.com", "secret"});
+        data.addPw(PasswordSet{"gitlab.com", "user2", "", "secret2"});
+        writeTestVault(vault, getTestVaultSettings(cipher_mode), data);
+        {
+            VaultAgent agent{vault, socket_path};
+            EXPECT_EQ(agent.start().errorCode, ERR_API_STATE_INVALID);
+            EXPECT_FALSE(agent.unlock("wrong").isSuccess());
+            ASSERT_TRUE(agent.unlock("password").isSuccess());
+            EXPECT_EQ(agent.getSetCount(), 2);
+            ASSERT_TRUE(agent.start().isSuccess());
+            EXPECT_FALSE(agent.start().isSuccess());
+
+            AgentClient client{socket_path};
+            ErrorStruct<std::vector<PasswordSet>> err = client.get("github.com");
+            ASSERT_TRUE(err.isSuccess());
+            ASSERT_EQ(err.returnRef().size(), 1);
+            EXPECT_EQ(err.returnRef()[0].email, "user@mail.com");
+            EXPECT_EQ(err.returnRef()[0].password, "secret");
+            EXPECT_TRUE(client.get("GitHub.com").returnRef().empty());
+            EXPECT_EQ(client.search("GIT").returnRef().size(), 2);
+            EXPECT_FALSE(client.add(PasswordSet{std::string(256, 's'), "", "", ""}).isSuccess());
+
+            // many clients add and read at the same time
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 8; i++) {
+                threads.emplace_back([&socket_path, i]() {
+                    AgentClient thread_client{socket_path};
+                    for (int j = 0; j < 10; j++) {
+                        std::string site = "site" + std::to_string(i);
+                        EXPECT_TRUE(thread_client.add(PasswordSet{site, "user" + std::to_string(j), "", "pw"}).isSuccess());
+                        EXPECT_EQ(thread_client.get(site).returnRef().size(), j + 1);
+                        EXPECT_TRUE(thread_client.search("github").isSuccess());
+                    }
+                });
+            }
+            for (std::thread& thread : threads) thread.join();
+            EXPECT_EQ(agent.getSetCount(), 82);
+            EXPECT_EQ(client.search("site").returnRef().size(), 80);
+            ASSERT_TRUE(agent.flush().isSuccess());
+            EXPECT_GE(agent.getWriteCount(), 1);
+            EXPECT_LE(agent.getWriteCount(), 80);
+            ASSERT_TRUE(client.add(PasswordSet{"last", "", "", ""}).isSuccess());
+            agent.stop();
+            EXPECT_FALSE(std::filesystem::exists(socket_path));
+            EXPECT_FALSE(client.get("github.com").isSuccess());
+            EXPECT_THROW(AgentClient{socket_path}, std::runtime_error);
+        }
+
+        // the added sets are in the vault
+        VaultAgent agent{vault, socket_path};
+        ASSERT_TRUE(agent.unlock("password").isSuccess());
+        EXPECT_EQ(agent.getSetCount(), 83);
+        ASSERT_TRUE(agent.start().isSuccess());
+        AgentClient client{socket_path};
+        EXPECT_EQ(client.get("site3").returnRef().size(), 10);
+        EXPECT_EQ(client.get("last").returnRef().size(), 1);
+        agent.stop();
+        std::filesystem::remove(vault);
+    }
+}
+
+TEST(VaultAgentClass, protocol) {
+    // invalid requests are answered with an error or end the connection
+    std::filesystem::path vault = RNG::get_random_string(10) + ".enc";
+    std::filesystem::path socket_path = RNG::get_random_string(10) + ".sock";
+    writeTestVault(vault, getTestVaultSettings(), PasswordData{});
+    VaultAgent agent{vault, socket_path};
+    ASSERT_TRUE(agent.unlock("password").isSuccess());
+    EXPECT_EQ(agent.getSetCount(), 0);
+
+    // a socket that nobody listens on is left by a crashed agent and replaced
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, socket_path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    close(fd);
+    ASSERT_TRUE(agent.start().isSuccess());
+    EXPECT_EQ(std::filesystem::status(socket_path).permissions(), std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+    // the socket of a running agent is not taken over
+    VaultAgent second{vault, socket_path};
+    ASSERT_TRUE(second.unlock("password").isSuccess());
+    EXPECT_EQ(second.start().errorCode, ERR_SOCKET);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    // unknown operation and a wrong number of strings
+    for (std::vector<unsigned char> request : {std::vector<unsigned char>{0, 0, 0, 2, 9, 0}, std::vector<unsigned char>{0, 0, 0, 3, AGENT_ADD, 1, 'a'}}) {
+        ASSERT_EQ(send(fd, request.data(), request.size(), 0), request.size());
+        unsigned char response[9];
+        ASSERT_EQ(recv(fd, response, 9, MSG_WAITALL), 9);
+        EXPECT_EQ(response[3], 5);
+        EXPECT_EQ(response[4], ERR_MESSAGE_INVALID);
+    }
+    // a too long request ends the connection
+    unsigned char request[4] = {0, 1, 0, 0};
+    ASSERT_EQ(send(fd, request, 4, 0), 4);
+    unsigned char response[1];
+    EXPECT_EQ(recv(fd, response, 1, 0), 0);
+    close(fd);
+
+    AgentClient client{socket_path};
+    EXPECT_TRUE(client.add(PasswordSet{"site", "", "", ""}).isSuccess());
+    EXPECT_EQ(client.get("site").returnRef().size(), 1);
+    agent.stop();
+    std::filesystem::remove(vault);
+}
@@ -0,0 +1,125 @@
+#include "vault_autosave.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "rng.h"
+#include "rotation_job.h"
+#include "test_vault_fixture.h"
+
+PasswordData readAutosaveVault(const std::filesystem::path& path) {
+    // decrypts the vault with a new API
+    PasswordData data;
+    readTestVault(path, data);
+    return data;
+}
+
+TEST(VaultAutosaveClass, coalescing) {
+    // a burst of edits is written with one write, the edits are visible before they are written
+    for (CModes cipher_mode : {CIPHERMODE_HASHCHAIN, CIPHERMODE_AES256GCM}) {
+        std::filesystem::path vault = RNG::get_random_string(10) + ".enc";
+        PasswordData data;
+        data.addPw(PasswordSet{"github.com", "user", "user@mail.com", "secret"});
+        writeTestVault(vault, getTestVaultSettings(cipher_mode), data);
+        VaultAutosave autosave{vault, 10000, 10000};
+        EXPECT_EQ(autosave.addPw(PasswordSet{"site", "", "", ""}).errorCode, ERR_API_STATE_INVALID);
+        EXPECT_FALSE(autosave.unlock("wrong").isSuccess());
+        ASSERT_TRUE(autosave.unlock("password").isSuccess());
+        EXPECT_EQ(autosave.unlock("password").errorCode, ERR_API_STATE_INVALID);
+        EXPECT_EQ(autosave.addPw(PasswordSet{std::string(256, 's'), "", "", ""}).errorCode, ERR_ARGUMENT_INVALID);
+
+        // only added sets are appended, a pending set that is removed or edited again is not written
+        for (int i = 0; i < 100; i++) ASSERT_TRUE(autosave.addPw(PasswordSet{"site" + std::to_string(i), "user", "", "pass"}).isSuccess());
+        ASSERT_TRUE(autosave.remPw(PasswordSet{"site0", "user", "", "pass"}).isSuccess());
+        ASSERT_TRUE(autosave.editPw(PasswordSet{"site1", "user", "mail", "new"}).isSuccess());
+        EXPECT_EQ(autosave.remPw(PasswordSet{"site0", "user", "", "pass"}).errorCode, ERR_ARGUMENT_INVALID);
+        EXPECT_EQ(autosave.editPw(PasswordSet{"site1", "other", "", ""}).errorCode, ERR_ARGUMENT_INVALID);
+        EXPECT_EQ(autosave.getSetCount(), 100);
+        EXPECT_EQ(autosave.getSiteSets("site1")[0].password, "new");
+        EXPECT_EQ(autosave.getWriteCount(), 0);
+        EXPECT_EQ(readAutosaveVault(vault).getSetCount(), 1);
+        ASSERT_TRUE(autosave.flush().isSuccess());
+        EXPECT_EQ(autosave.getWriteCount(), 1);
+        EXPECT_EQ(autosave.getEditCount(), 102);
+        PasswordData written = readAutosaveVault(vault);
+        EXPECT_EQ(written.getSetCount(), 100);
+        EXPECT_TRUE(written.getSiteSets("site0").empty());
+        EXPECT_EQ(written.getSiteSets("site1")[0].email, "mail");
+
+        // an add followed by its remove writes nothing, an edit of a written set rewrites the vault once
+        ASSERT_TRUE(autosave.addPw(PasswordSet{"temp", "", "", ""}).isSuccess());
+        ASSERT_TRUE(autosave.remPw(PasswordSet{"temp", "", "", ""}).isSuccess());
+        ASSERT_TRUE(autosave.flush().isSuccess());
+        EXPECT_EQ(autosave.getWriteCount(), 1);
+        // the rewrite replaces the vault with a temporary file that keeps the mode of the vault
+        std::filesystem::permissions(vault, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write | std::filesystem::perms::group_read);
+        ASSERT_TRUE(autosave.editPw(PasswordSet{"github.com", "user", "", "changed"}).isSuccess());
+        ASSERT_TRUE(autosave.remPw(PasswordSet{"site2", "user", "", "pass"}).isSuccess());
+        ASSERT_TRUE(autosave.addPw(PasswordSet{"new", "user", "", "pass"}).isSuccess());
+        ASSERT_TRUE(autosave.close().isSuccess());
+        EXPECT_EQ(autosave.getWriteCount(), 2);
+        EXPECT_EQ(autosave.addPw(PasswordSet{"site", "", "", ""}).errorCode, ERR_API_STATE_INVALID);
+        written = readAutosaveVault(vault);
+        EXPECT_EQ(written.getSetCount(), 100);
+        EXPECT_EQ(written.getSiteSets("github.com")[0].password, "changed");
+        EXPECT_TRUE(written.getSiteSets("site2").empty());
+        EXPECT_EQ(written.getSiteSets("new").size(), 1);
+        EXPECT_EQ(std::filesystem::status(vault).permissions(),
+                  std::filesystem::perms::owner_read | std::filesystem::perms::owner_write | std::filesystem::perms::group_read);
+        EXPECT_FALSE(std::filesystem::exists(RotationJob::getTempPath(vault)));
+
+        // the vault can be unlocked again after close
+        ASSERT_TRUE(autosave.unlock("password").isSuccess());
+        EXPECT_EQ(autosave.getSetCount(), 100);
+        std::filesystem::remove(vault);
+    }
+}
+
+TEST(VaultAutosaveClass, triggers) {
+    // the edits are written after the delay or after max_edits edits without a flush
+    std::filesystem::path vault = RNG::get_random_string(10) + ".enc";
+    writeTestVault(vault, getTestVaultSettings(), PasswordData{});
+    {
+        VaultAutosave autosave{vault, 20, 10000};
+        ASSERT_TRUE(autosave.unlock("password").isSuccess());
+        ASSERT_TRUE(autosave.addPw(PasswordSet{"site", "", "", ""}).isSuccess());
+        for (int i = 0; i < 500 && autosave.getWriteCount() == 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(autosave.getWriteCount(), 1);
+    }
+    {
+        VaultAutosave autosave{vault, 100000, 100000, 10};
+        ASSERT_TRUE(autosave.unlock("password").isSuccess());
+        for (int i = 0; i < 10; i++) ASSERT_TRUE(autosave.addPw(PasswordSet{"site" + std::to_string(i), "", "", ""}).isSuccess());
+        for (int i = 0; i < 500 && autosave.getWriteCount() == 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(autosave.getWriteCount(), 1);
+        // the destructor writes the unwritten edits
+        ASSERT_TRUE(autosave.addPw(PasswordSet{"last", "", "", ""}).isSuccess());
+    }
+    EXPECT_EQ(readAutosaveVault(vault).getSetCount(), 12);
+    std::filesystem::remove(vault);
+}
+
+TEST(VaultAutosaveClass, threads) {
+    // edits of many threads are written together, flush waits for the edits of its thread
+    std::filesystem::path vault = RNG::get_random_string(10) + ".enc";
+    writeTestVault(vault, getTestVaultSettings(), PasswordData{});
+    VaultAutosave autosave{vault, 5, 50};
+    ASSERT_TRUE(autosave.unlock("password").isSuccess());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&autosave, t]() {
+            for (int i = 0; i < 50; i++) {
+                EXPECT_TRUE(autosave.addPw(PasswordSet{"site" + std::to_string(t), std::to_string(i), "", ""}).isSuccess());
+                if (i % 10 == 0) EXPECT_TRUE(autosave.editPw(PasswordSet{"site" + std::to_string(t), std::to_string(i), "mail", "pass"}).isSuccess());
+            }
+            EXPECT_TRUE(autosave.flush().isSuccess());
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_LT(autosave.getWriteCount(), 200);
+    PasswordData written = readAutosaveVault(vault);
+    EXPECT_EQ(written.getSetCount(), 200);
+    EXPECT_EQ(written.getSiteSets("site3")[10].email, "mail");
+    std::filesystem::remove(vault);
+}
@@ -0,0 +1,227 @@
+#include "vault_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "rng.h"
+#include "test_vault_fixture.h"
+
+std::unique_ptr<FileDataStruct> getManagerData(const std::string& content) {
+    // the content of a vault
+    Bytes data(content.size());
+    data.addBytes(reinterpret_cast<const unsigned char*>(content.data()), content.size());
+    return std::make_unique<FileDataStruct>(FILEMODE_PASSWORD, std::make_unique<Bytes>(data));
+}
+
+TEST(VaultManagerClass, sessions) {
+    // every session works on its own vault, the calls of a session run in order
+    std::vector<std::filesystem::path> paths;
+    {
+        VaultManager manager{4};
+        EXPECT_EQ(manager.getThreadCount(), 4);
+        EXPECT_FALSE(manager.open(RNG::get_random_string(10) + ".enc", FILEMODE_PASSWORD).isSuccess());
+        std::vector<std::shared_ptr<VaultSession>> sessions;
+        for (int i = 0; i < 8; i++) {
+            paths.push_back(RNG::get_random_string(10) + ".enc");
+            ErrorStruct<std::shared_ptr<VaultSession>> err = manager.open(paths.back(), FILEMODE_PASSWORD, true);
+            ASSERT_TRUE(err.isSuccess());
+            sessions.push_back(err.returnValue());
+            EXPECT_EQ(sessions.back()->getPath(), paths.back());
+        }
+        // the calls are queued without waiting for the previous ones
+        std::vector<std::future<ErrorStruct<bool>>> headers, encrypts, writes;
+        for (size_t i = 0; i < sessions.size(); i++) {
+            headers.push_back(sessions[i]->createDataHeader("password" + std::to_string(i), getTestVaultSettings()));
+            encrypts.push_back(sessions[i]->encryptData(getManagerData("content" + std::to_string(i))));
+            writes.push_back(sessions[i]->writeToFile());
+        }
+        for (size_t i = 0; i < sessions.size(); i++) {
+            EXPECT_TRUE(headers[i].get().isSuccess());
+            EXPECT_TRUE(encrypts[i].get().isSuccess());
+            EXPECT_TRUE(writes[i].get().isSuccess());
+        }
+        // a call in the wrong state fails with its error code
+        EXPECT_EQ(sessions[0]->getDecryptedData().get().errorCode, ERR_API_STATE_INVALID);
+    }
+    // reopens the vaults with a new manager and decrypts them from many threads
+    VaultManager manager{2};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < paths.size(); i++) {
+        threads.emplace_back([&manager, &paths, i]() {
+            ErrorStruct<std::shared_ptr<VaultSession>> err = manager.open(paths[i], FILEMODE_PASSWORD);
+            ASSERT_TRUE(err.isSuccess());
+            std::shared_ptr<VaultSession> session = err.returnValue();
+            EXPECT_FALSE(session->verifyPassword("wrong").get().isSuccess());
+            std::future<ErrorStruct<bool>> verify = session->verifyPassword("password" + std::to_string(i));
+            std::future<ErrorStruct<std::unique_ptr<FileDataStruct>>> decrypted = session->getDecryptedData();
+            EXPECT_TRUE(verify.get().isSuccess());
+            ErrorStruct<std::unique_ptr<FileDataStruct>> data = decrypted.get();
+            ASSERT_TRUE(data.isSuccess());
+            EXPECT_EQ(*data.returnRef()->dec_data, *getManagerData("content" + std::to_string(i))->dec_data);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const std::filesystem::path& path : paths) std::filesystem::remove(path);
+}
+
+TEST(VaultManagerClass, lifetime) {
+    // queued calls are done before the manager is destroyed, later calls throw
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    std::shared_ptr<VaultSession> session;
+    std::future<ErrorStruct<bool>> header;
+    std::future<int> order;
+    std::atomic<int> counter{0};
+    {
+        VaultManager manager{1};
+        session = manager.open(path, FILEMODE_PASSWORD, true).returnValue();
+        header = session->createDataHeader("password", getTestVaultSettings());
+        order = session->call([&counter](API& api) { return counter++; });
+        EXPECT_THROW(session->call([](API& api) -> int { throw std::runtime_error("error"); }).get(), std::runtime_error);
+        // the shutdown waits for the queued calls, a second shutdown (by the destructor) does nothing
+        manager.shutdown();
+        EXPECT_EQ(manager.getThreadCount(), 0);
+        EXPECT_EQ(order.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    }
+    EXPECT_TRUE(header.get().isSuccess());
+    EXPECT_EQ(order.get(), 0);
+    EXPECT_THROW(session->writeToFile(), std::logic_error);
+    session.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(VaultManagerClass, shutdown_with_calls_in_flight) {
+    // the manager is destroyed while calls run, queue calls of other sessions and other threads make new calls
+    // the workers are joined by the destructor, every call that was queued is done and the later calls throw
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::shared_ptr<VaultSession>> sessions;
+    std::vector<std::future<int>> futures;
+    std::mutex futures_mutex;
+    std::atomic<int> runs{0};
+    std::atomic<bool> rejected{false};
+    std::thread caller;
+    // every call queues a call on the next session from its worker
+    std::function<int(size_t)> chain = [&](size_t i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::future<int> next = sessions[(i + 1) % sessions.size()]->call([&runs](API& api) { return runs++; });
+        std::lock_guard<std::mutex> lock(futures_mutex);
+        futures.push_back(std::move(next));
+        return runs++;
+    };
+    {
+        VaultManager manager{2};
+        for (int i = 0; i < 4; i++) {
+            paths.push_back(RNG::get_random_string(10) + ".enc");
+            sessions.push_back(manager.open(paths.back(), FILEMODE_PASSWORD, true).returnValue());
+        }
+        for (size_t i = 0; i < sessions.size(); i++) {
+            for (int j = 0; j < 10; j++) {
+                std::future<int> future = sessions[i]->call([&chain, i](API& api) { return chain(i); });
+                std::lock_guard<std::mutex> lock(futures_mutex);
+                futures.push_back(std::move(future));
+            }
+        }
+        caller = std::thread([&]() {
+            while (true) {
+                try {
+                    std::future<int> future = sessions[0]->call([&runs](API& api) { return runs++; });
+                    std::lock_guard<std::mutex> lock(futures_mutex);
+                    futures.push_back(std::move(future));
+                } catch (const std::logic_error&) {
+                    rejected = true;
+                    return;
+                }
+            }
+        });
+        while (runs < 5) std::this_thread::yield();
+    }
+    caller.join();
+    EXPECT_TRUE(rejected);
+    std::lock_guard<std::mutex> lock(futures_mutex);
+    for (std::future<int>& future : futures) {
+        // the call ran or it queued a call after the shutdown (its future holds the logic_error)
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        try {
+            future.get();
+        } catch (const std::logic_error&) {
+        }
+    }
+    EXPECT_THROW(sessions[1]->call([](API& api) { return 0; }), std::logic_error);
+    sessions.clear();
+    for (const std::filesystem::path& path : paths) std::filesystem::remove(path);
+}
+
+TEST(VaultManagerClass, cancel) {
+    // a running or queued chainhash is cancelled by its control, the session can be used again afterwards
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    VaultManager manager{1};
+    std::shared_ptr<VaultSession> session = manager.open(path, FILEMODE_PASSWORD, true).returnValue();
+    DataHeaderSettingsIters ds = getTestVaultSettings();
+    ds.setChainHash1Iters(1000000000);
+    std::shared_ptr<ChainHashControl> control = std::make_shared<ChainHashControl>();
+    std::shared_ptr<ChainHashControl> queued_control = std::make_shared<ChainHashControl>();
+    std::future<ErrorStruct<bool>> running = session->createDataHeader("password", ds, 0, control);
+    std::future<ErrorStruct<bool>> queued = session->createDataHeader("password", ds, 0, queued_control);
+    queued_control->cancel();
+    while (control->getDone() == 0) std::this_thread::yield();
+    EXPECT_EQ(control->getTotal(), 1000000010);
+    EXPECT_GT(control->getProgress(), 0);
+    control->cancel();
+    EXPECT_EQ(running.get().errorCode, ERR_CANCELLED);
+    EXPECT_EQ(queued.get().errorCode, ERR_CANCELLED);
+    EXPECT_EQ(queued_control->getDone(), 0);
+
+    control = std::make_shared<ChainHashControl>();
+    EXPECT_TRUE(session->createDataHeader("password", getTestVaultSettings(), 0, control).get().isSuccess());
+    EXPECT_EQ(control->getProgress(), 1);
+    std::filesystem::remove(path);
+}
+
+TEST(VaultManagerClass, unlockAll) {
+    // vaults with the same first chainhash share one password hash, the others get their own
+    std::shared_ptr<ChainHashData> chainhash1_data = std::make_shared<ChainHashData>(Format{CHAINHASH_CONSTANT_COUNT_SALT});
+    chainhash1_data->generateRandomData();
+    DataHeaderSettingsIters shared = getTestVaultSettings();
+    shared.setChainHash1Mode(CHAINHASH_CONSTANT_COUNT_SALT);
+    shared.setChainHash1Data(chainhash1_data);
+    DataHeaderSettingsIters wrong_mode = getTestVaultSettings();
+    wrong_mode.setChainHash1Data(chainhash1_data);
+    std::vector<std::filesystem::path> paths;
+    {
+        VaultManager manager{2};
+        for (int i = 0; i < 6; i++) {
+            paths.push_back(RNG::get_random_string(10) + ".enc");
+            std::shared_ptr<VaultSession> session = manager.open(paths.back(), FILEMODE_PASSWORD, true).returnValue();
+            if (i == 0) EXPECT_EQ(session->createDataHeader("password", wrong_mode).get().errorCode, ERR);
+            ASSERT_TRUE(session->createDataHeader(i == 5 ? "other" : "password", i < 4 ? shared : getTestVaultSettings()).get().isSuccess());
+            ASSERT_TRUE(session->encryptData(getManagerData("content" + std::to_string(i))).get().isSuccess());
+            ASSERT_TRUE(session->writeToFile().get().isSuccess());
+        }
+    }
+    VaultManager manager{2};
+    std::vector<std::shared_ptr<VaultSession>> sessions;
+    for (const std::filesystem::path& path : paths) sessions.push_back(manager.open(path, FILEMODE_PASSWORD).returnValue());
+    std::filesystem::path empty = RNG::get_random_string(10) + ".enc";
+    sessions.push_back(manager.open(empty, FILEMODE_PASSWORD, true).returnValue());
+    ErrorStruct<PasswordHashSettings> settings0 = sessions[0]->call([](API& api) { return api.getPasswordHashSettings(); }).get();
+    ErrorStruct<PasswordHashSettings> settings3 = sessions[3]->call([](API& api) { return api.getPasswordHashSettings(); }).get();
+    ErrorStruct<PasswordHashSettings> settings4 = sessions[4]->call([](API& api) { return api.getPasswordHashSettings(); }).get();
+    ASSERT_TRUE(settings0.isSuccess() && settings3.isSuccess() && settings4.isSuccess());
+    EXPECT_EQ(settings0.returnRef().getKey(), settings3.returnRef().getKey());
+    EXPECT_NE(settings0.returnRef().getKey(), settings4.returnRef().getKey());
+
+    std::vector<ErrorStruct<bool>> results = manager.unlockAll(sessions, "password");
+    ASSERT_EQ(results.size(), 7);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(results[i].isSuccess());
+        ErrorStruct<std::unique_ptr<FileDataStruct>> data = sessions[i]->getDecryptedData().get();
+        ASSERT_TRUE(data.isSuccess());
+        EXPECT_EQ(*data.returnRef()->dec_data, *getManagerData("content" + std::to_string(i))->dec_data);
+    }
+    EXPECT_EQ(results[5].errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_EQ(results[6].errorCode, ERR_API_STATE_INVALID);
+    EXPECT_EQ(sessions[5]->call([](API& api) { return api.verifyPasswordHash(Bytes(1)); }).get().errorCode, ERR_PASSWORD_INVALID);
+    EXPECT_TRUE(sessions[5]->verifyPassword("other").get().isSuccess());
+    for (const std::filesystem::path& path : paths) std::filesystem::remove(path);
+    std::filesystem::remove(empty);
+}
@@ -0,0 +1,115 @@
+#include "vault_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include "dataheader_generator.h"
+#include "filehandler.h"
+#include "rng.h"
+
+void writeScanFile(const std::filesystem::path& path, const Bytes& data) {
+    // writes the data as the whole content of the file
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << data;
+    file.close();
+}
+
+TEST(VaultScannerClass, readPrefix) {
+    // only the sizes and the modes at the beginning of the header are checked
+    std::filesystem::path path = RNG::get_random_string(10) + ".enc";
+    Bytes header = DataHeaderGen::generateDH();
+    writeScanFile(path, header);
+    VaultInfo info = VaultScanner::readPrefix(path, header.getLen());
+    EXPECT_EQ(info.file_name, path.filename().string());
+    EXPECT_TRUE(info.valid);
+    EXPECT_FALSE(info.empty);
+    EXPECT_EQ(info.header_size, header.getLen());
+    EXPECT_EQ(info.file_mode, header.getBytes()[16]);
+    EXPECT_EQ(info.hash_mode, header.getBytes()[17]);
+    // the file size does not match with the header
+    EXPECT_FALSE(VaultScanner::readPrefix(path, header.getLen() + 1).valid);
+    // invalid file mode
+    header.getBytes()[16] = 0;
+    writeScanFile(path, header);
+    EXPECT_FALSE(VaultScanner::readPrefix(path, header.getLen()).valid);
+    // too small
+    writeScanFile(path, header.copySubBytes(0, HEADER_PREFIX_LEN - 1));
+    EXPECT_FALSE(VaultScanner::readPrefix(path, HEADER_PREFIX_LEN - 1).valid);
+    // empty files are valid new vaults
+    info = VaultScanner::readPrefix(path, 0);
+    EXPECT_TRUE(info.valid);
+    EXPECT_TRUE(info.empty);
+    std::filesystem::remove(path);
+    EXPECT_FALSE(VaultScanner::readPrefix(path, 10).valid);
+}
+
+TEST(VaultScannerClass, scan) {
+    // lists the encryption files of a directory, unchanged files are taken from the cache
+    std::filesystem::path dir = RNG::get_random_string(10);
+    std::filesystem::create_directory(dir);
+    std::vector<Bytes> headers;
+    for (int i = 0; i < 20; i++) {
+        headers.push_back(DataHeaderGen::generateDH());
+        writeScanFile(dir / ("vault" + std::to_string(100 + i) + ".enc"), headers.back());
+    }
+    FileHandler::createFile(dir / "empty.enc");
+    writeScanFile(dir / "broken.enc", headers[0].copySubBytes(0, 50));
+    writeScanFile(dir / "other.txt", headers[0]);
+
+    VaultScanner scanner{dir, 4};
+    ErrorStruct<std::vector<VaultInfo>> err = scanner.scan();
+    ASSERT_TRUE(err.isSuccess());
+    std::vector<VaultInfo> infos = err.returnValue();
+    ASSERT_EQ(infos.size(), 22);
+    EXPECT_EQ(scanner.getReadCount(), 22);
+    EXPECT_TRUE(std::filesystem::exists(dir / VaultScanner::cache_name));
+    // the temporary cache file is renamed, nothing is left behind
+    size_t dir_files = 0;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) {
+        (void)entry;
+        dir_files++;
+    }
+    EXPECT_EQ(dir_files, 24);
+    // sorted by name
+    EXPECT_EQ(infos[0].file_name, "broken.enc");
+    EXPECT_FALSE(infos[0].valid);
+    EXPECT_EQ(infos[1].file_name, "empty.enc");
+    EXPECT_TRUE(infos[1].empty);
+    for (int i = 0; i < 20; i++) {
+        EXPECT_EQ(infos[i + 2].file_name, "vault" + std::to_string(100 + i) + ".enc");
+        EXPECT_TRUE(infos[i + 2].valid);
+        EXPECT_EQ(infos[i + 2].header_size, headers[i].getLen());
+        EXPECT_EQ(infos[i + 2].hash_mode, headers[i].getBytes()[17]);
+    }
+
+    // a new scanner on the same directory only reads the changed files
+    VaultScanner scanner2{dir};
+    std::vector<VaultInfo> infos2 = scanner2.scan().returnValue();
+    EXPECT_EQ(scanner2.getReadCount(), 0);
+    ASSERT_EQ(infos2.size(), infos.size());
+    for (size_t i = 0; i < infos.size(); i++) {
+        EXPECT_EQ(infos2[i].file_name, infos[i].file_name);
+        EXPECT_EQ(infos2[i].valid, infos[i].valid);
+        EXPECT_EQ(infos2[i].empty, infos[i].empty);
+        EXPECT_EQ(infos2[i].header_size, infos[i].header_size);
+    }
+    writeScanFile(dir / "empty.enc", headers[1]);
+    std::filesystem::remove(dir / "vault100.enc");
+    infos2 = scanner2.scan().returnValue();
+    EXPECT_EQ(scanner2.getReadCount(), 1);
+    ASSERT_EQ(infos2.size(), 21);
+    EXPECT_FALSE(infos2[1].empty);
+    EXPECT_TRUE(infos2[1].valid);
+    EXPECT_EQ(infos2[1].header_size, headers[1].getLen());
+    EXPECT_EQ(infos2[2].file_name, "vault101.enc");
+
+    // a broken cache is ignored
+    writeScanFile(dir / VaultScanner::cache_name, headers[2]);
+    EXPECT_EQ(scanner2.scan().returnRef().size(), 21);
+    EXPECT_EQ(scanner2.getReadCount(), 21);
+    scanner2.scan();
+    EXPECT_EQ(scanner2.getReadCount(), 0);
+
+    std::filesystem::remove_all(dir);
+    EXPECT_FALSE(scanner2.scan().isSuccess());
+    EXPECT_EQ(VaultScanner{""}.scan().errorCode, ERR_EMPTY_FILEPATH);
+}